@@ -131,6 +131,8 @@ public:
     [[nodiscard]] luisa::string_view name() const noexcept;
     /// Return debug name
     [[nodiscard]] luisa::string debug_name() const noexcept;
+    /// Return whether the callable should be kept out of line
+    [[nodiscard]] bool outlined() const noexcept;
     /// Return function tag
     [[nodiscard]] Tag tag() const noexcept;
     /// Return return type
@@ -85,8 +85,13 @@ public:
 private:
     ScopeStmt _body;
     luisa::optional<const Type *> _return_type;
-    luisa::vector<luisa::unique_ptr<Expression>> _all_expressions;
-    luisa::vector<luisa::unique_ptr<Statement>> _all_statements;
+    // expressions and statements are allocated from a per-builder monotonic arena
+    // and destroyed all at once with the builder
+    luisa::vector<Expression *> _all_expressions;
+    luisa::vector<Statement *> _all_statements;
+    luisa::vector<std::pair<std::byte *, size_t /* size */>> _node_arena_pages;
+    std::byte *_node_arena_cursor{nullptr};
+    std::byte *_node_arena_end{nullptr};
     luisa::vector<ScopeStmt *> _scope_stack;
     luisa::vector<Variable> _builtin_variables;
     luisa::vector<Constant> _captured_constants;
@@ -115,6 +120,7 @@ private:
     bool _hash_computed{false};
     bool _requires_atomic_float{false};
     bool _requires_printing{false};
+    bool _outlined{false};
     luisa::string _name;
 
 protected:
@@ -127,22 +133,23 @@ protected:
     [[nodiscard]] const RefExpr *_ref(Variable v) noexcept;
     void _void_expr(const Expression *expr) noexcept;
     void _compute_hash() noexcept;
+    [[nodiscard]] void *_allocate_node(size_t size, size_t alignment) noexcept;
 
     template<typename Stmt, typename... Args>
     auto _create_and_append_statement(Args &&...args) noexcept {
-        auto stmt = luisa::make_unique<Stmt>(std::forward<Args>(args)...);
-        auto p = stmt.get();
-        _all_statements.emplace_back(std::move(stmt));
-        _append(p);
-        return p;
+        auto stmt = std::construct_at(static_cast<Stmt *>(_allocate_node(sizeof(Stmt), alignof(Stmt))),
+                                      std::forward<Args>(args)...);
+        _all_statements.emplace_back(stmt);
+        _append(stmt);
+        return stmt;
     }
 
     template<typename Expr, typename... Args>
     [[nodiscard]] auto _create_expression(Args &&...args) noexcept {
-        auto expr = luisa::make_unique<Expr>(std::forward<Args>(args)...);
-        auto p = expr.get();
-        _all_expressions.emplace_back(std::move(expr));
-        return p;
+        auto expr = std::construct_at(static_cast<Expr *>(_allocate_node(sizeof(Expr), alignof(Expr))),
+                                      std::forward<Args>(args)...);
+        _all_expressions.emplace_back(expr);
+        return expr;
     }
 
 private:
@@ -232,6 +239,8 @@ public:
     [[nodiscard]] auto name() const noexcept { return luisa::string_view{_name}; }
     /// Return a name suitable for debugging
     [[nodiscard]] luisa::string debug_name() const noexcept;
+    /// Return if the callable should be kept out of line.
+    [[nodiscard]] auto outlined() const noexcept { return _outlined; }
     /// Return hash.
     [[nodiscard]] uint64_t hash() const noexcept;
     /// Return if is raytracing.
@@ -273,6 +282,8 @@ public:
 
     /// Set name
     void set_name(luisa::string_view name) noexcept;
+    /// Mark the callable to be kept out of line, i.e., not inlined into its callers
+    void mark_outlined() noexcept;
 
     // built-in variables
     /// Return thread id.
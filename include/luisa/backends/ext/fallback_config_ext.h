@@ -0,0 +1,26 @@
+#pragma once
+
+#include <luisa/core/stl/string.h>
+#include <luisa/runtime/rhi/device_interface.h>
+
+namespace luisa::compute {
+
+struct FallbackDeviceConfigExt : public DeviceConfigExt {
+    // The instruction set used by the JIT and Embree. Supported values are
+    // "auto" (detect from the host), "generic" (baseline x86-64), "sse4", "avx2",
+    // "avx512" and "neon". Requests beyond what the host supports are clamped to
+    // the host ISA, and hosts without SSE4.1/4.2 use "generic".
+    [[nodiscard]] virtual luisa::string_view isa() const noexcept { return "auto"; }
+    // Vector width hinted to LLVM's loop vectorizer for the per-block thread loop.
+    // 0 derives it from the ISA's vector width and 1 disables the hints. Kernels are
+    // not lowered to SIMT warps: the warp size stays 1 regardless of this value.
+    [[nodiscard]] virtual uint32_t simd_lane_count() const noexcept { return 0u; }
+    // Whether kernels that trace rays suspend their threads at each trace, so that
+    // the rays of a block are traced together in Embree packets. This only pays off
+    // for coherent rays, so it is off by default. LUISA_FALLBACK_RAY_PACKETS=1 or 0
+    // overrides this value.
+    [[nodiscard]] virtual bool ray_packets() const noexcept { return false; }
+    ~FallbackDeviceConfigExt() noexcept override = default;
+};
+
+}// namespace luisa::compute
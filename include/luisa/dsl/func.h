@@ -604,23 +604,25 @@ Kernel3D(T &&) -> Kernel3D<detail::dsl_function_t<std::remove_cvref_t<T>>>;
 template<typename T>
 Callable(T &&) -> Callable<detail::dsl_function_t<std::remove_cvref_t<T>>>;
 
+/// Call the body as a callable that is kept out of line, i.e., not inlined by the XIR inliner
+template<typename F>
+void outline(F &&f) noexcept {
+    Callable callable{[&f]() noexcept {
+        detail::FunctionBuilder::current()->mark_outlined();
+        f();
+    }};
+    callable();
+}
+
 namespace detail {
 
 struct CallableOutliner {
     template<typename F>
     void operator%(F &&body) && noexcept {
-        return Callable{std::forward<F>(body)}();
+        outline(std::forward<F>(body));
     }
 };
 
-}// namespace detail
-
-template<typename F>
-void outline(F &&f) noexcept {
-    return Callable{std::forward<F>(f)}();
-}
-
-namespace detail {
 template<typename S>
 [[nodiscard]] inline auto outliner_with_comment(S &&s) noexcept {
     comment(std::forward<S>(s));
@@ -653,16 +655,16 @@ public:
     auto operator()(Args &&...args) const noexcept {
         using Ret = decltype(_f(std::forward<Args>(args)...));
         if constexpr (std::is_same_v<Ret, void>) {
-            outline([&] {
+            Callable{[&] {
                 if (!_comment.empty()) { detail::comment(_comment); }
                 _f(std::forward<Args>(args)...);
-            });
+            }}();
         } else {
             luisa::optional<Ret> ret;
-            outline([&] {
+            Callable{[&] {
                 if (!_comment.empty()) { detail::comment(_comment); }
                 ret.emplace(_f(std::forward<Args>(args)...));
-            });
+            }}();
             return std::move(ret).value();
         }
     }
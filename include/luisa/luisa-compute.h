@@ -238,10 +238,16 @@
 #include <luisa/xir/metadata/name.h>
 #include <luisa/xir/module.h>
 #include <luisa/xir/passes/aggregate_field_bitmask.h>
+#include <luisa/xir/passes/const_fold.h>
 #include <luisa/xir/passes/dce.h>
 #include <luisa/xir/passes/dom_tree.h>
+#include <luisa/xir/passes/gvn.h>
+#include <luisa/xir/passes/inline.h>
+#include <luisa/xir/passes/licm.h>
 #include <luisa/xir/passes/local_load_elimination.h>
 #include <luisa/xir/passes/local_store_forward.h>
+#include <luisa/xir/passes/loop_info.h>
+#include <luisa/xir/passes/mem2reg.h>
 #include <luisa/xir/passes/outline.h>
 #include <luisa/xir/passes/pointer_usage.h>
 #include <luisa/xir/passes/sink_alloca.h>
@@ -250,7 +256,9 @@
 #include <luisa/xir/pool.h>
 #include <luisa/xir/special_register.h>
 #include <luisa/xir/translators/ast2xir.h>
+#include <luisa/xir/translators/binary2xir.h>
 #include <luisa/xir/translators/json2xir.h>
+#include <luisa/xir/translators/xir2binary.h>
 #include <luisa/xir/translators/xir2json.h>
 #include <luisa/xir/translators/xir2text.h>
 #include <luisa/xir/use.h>
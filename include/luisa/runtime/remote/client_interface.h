@@ -2,15 +2,52 @@
 #include <luisa/runtime/rhi/device_interface.h>
 #include <luisa/core/stl/functional.h>
 #include <luisa/core/stl/unordered_map.h>
+#include <luisa/core/stl/optional.h>
 #include <luisa/core/spin_mutex.h>
 #include <luisa/vstl/lockfree_array_queue.h>
 namespace luisa::compute {
+template<typename T>
+class DeltaCodec;
+enum class RemoteCompression : uint32_t {
+    NONE,
+    ZLIB,
+};
 class ClientCallback {
 protected:
     ~ClientCallback() = default;
 
+public:
+    // A block of host memory spliced into a message at `offset` bytes of the serialized data.
+    // The memory is owned by the caller of the device (e.g., the source of an upload command)
+    // and stays valid until the stream that the message was dispatched to is synchronized.
+    struct Payload {
+        size_t offset;
+        luisa::span<const std::byte> data;
+    };
+
 public:
     virtual void async_send(luisa::vector<std::byte> data) noexcept = 0;
+    // Sends `data` with the `payloads` (sorted by offset) spliced in, so that transports
+    // supporting scatter-gather I/O can send large payloads without copying them.
+    // The default implementation gathers everything into a single buffer.
+    virtual void async_send_gather(luisa::vector<std::byte> data, luisa::vector<Payload> payloads) noexcept {
+        if (payloads.empty()) {
+            async_send(std::move(data));
+            return;
+        }
+        auto size = data.size();
+        for (auto &&p : payloads) { size += p.data.size(); }
+        luisa::vector<std::byte> gathered;
+        gathered.reserve(size);
+        auto last_offset = static_cast<size_t>(0u);
+        for (auto &&p : payloads) {
+            gathered.insert(gathered.end(), data.begin() + last_offset, data.begin() + p.offset);
+            gathered.insert(gathered.end(), p.data.begin(), p.data.end());
+            last_offset = p.offset;
+        }
+        gathered.insert(gathered.end(), data.begin() + last_offset, data.end());
+        async_send(std::move(gathered));
+    }
     virtual void sync_send(luisa::span<const std::byte> send, luisa::vector<std::byte> &received) noexcept = 0;
 };
 class LC_RUNTIME_API ClientInterface : public DeviceInterface {
@@ -22,6 +59,12 @@ private:
     ClientCallback *_callback;
     luisa::vector<std::byte> _receive_bytes;
     luisa::vector<std::byte> _send_bytes;
+    luisa::vector<ClientCallback::Payload> _send_payloads;
+    luisa::optional<uint32_t> _server_capabilities;// queried on first use
+    RemoteCompression _compression{RemoteCompression::NONE};
+    size_t _compression_threshold{};
+    luisa::unique_ptr<DeltaCodec<BindlessArrayUpdateCommand::Modification>> _bindless_codec;
+    luisa::unique_ptr<DeltaCodec<AccelBuildCommand::Modification>> _accel_codec;
     luisa::spin_mutex _stream_map_mtx;
     mutable luisa::spin_mutex _evt_mtx;
     luisa::unordered_map<uint64_t, vstd::SingleThreadArrayQueue<DispatchFeedback>> _unfinished_stream;
@@ -29,11 +72,18 @@ private:
     uint64_t _flag{0};
     [[nodiscard]] void *native_handle() const noexcept override { return nullptr; }
     [[nodiscard]] uint compute_warp_size() const noexcept override { return 0; }
+    void _ser_payload(luisa::span<const std::byte> data) noexcept;
+    void _async_send() noexcept;
+    [[nodiscard]] uint32_t _query_server_capabilities() noexcept;
 
 public:
     explicit ClientInterface(
         Context ctx,
         ClientCallback *callback) noexcept;
+    ~ClientInterface() noexcept override;
+    // Negotiates the compression of messages of at least `threshold` bytes with the server.
+    // Returns false, leaving the messages uncompressed, if either side does not support the mode.
+    bool set_compression(RemoteCompression mode, size_t threshold = 64u * 1024u) noexcept;
     [[nodiscard]] BufferCreationInfo create_buffer(const Type *element,
                                                    size_t elem_count,
                                                    void *external_memory /* nullptr if now imported from external memory */) noexcept override;
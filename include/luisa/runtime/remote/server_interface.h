@@ -2,9 +2,48 @@
 #include <luisa/runtime/rhi/device_interface.h>
 #include <luisa/core/stl/functional.h>
 #include <luisa/core/stl/unordered_map.h>
+#include <luisa/core/stl/memory.h>
 #include <luisa/core/spin_mutex.h>
 #include <luisa/core/logging.h>
 namespace luisa::compute {
+template<typename T>
+class DeltaCodec;
+// Compiled shaders keyed by the hash of the kernel and the options affecting code generation.
+// A cache can be shared by the server interfaces of several client sessions on the same device,
+// so that a client creating a kernel that is already compiled skips sending its AST. The cache
+// owns the shaders inserted into it and destroys them when it is destroyed.
+// Cached shaders may be in use by any session, so they are never evicted. Instead, the cache
+// holds at most `capacity` shaders, and shaders created after that stay private to their
+// sessions and are destroyed with them as if there were no cache.
+class LC_RUNTIME_API ServerShaderCache {
+public:
+    using Handle = luisa::shared_ptr<DeviceInterface>;
+    static constexpr size_t default_capacity = 1024u;
+
+private:
+    Handle _device;
+    size_t _capacity;
+    mutable luisa::spin_mutex _mtx;
+    luisa::unordered_map<uint64_t, uint64_t> _shaders;// key -> backend handle
+    luisa::unordered_set<uint64_t> _handles;
+
+public:
+    explicit ServerShaderCache(Handle device, size_t capacity = default_capacity) noexcept;
+    ~ServerShaderCache() noexcept;
+    ServerShaderCache(ServerShaderCache const &) = delete;
+    ServerShaderCache &operator=(ServerShaderCache const &) = delete;
+    [[nodiscard]] auto const &device() const noexcept { return _device; }
+    [[nodiscard]] auto capacity() const noexcept { return _capacity; }
+    [[nodiscard]] size_t size() const noexcept;
+    // returns the backend handle of the shader, or invalid_resource_handle on miss
+    [[nodiscard]] uint64_t find(uint64_t key) const noexcept;
+    // returns the handle to use for the key: the previously inserted shader if another session won the race,
+    // in which case the caller should destroy its own, or `handle` otherwise; when the cache is full, the
+    // shader is not inserted and the caller keeps the ownership
+    [[nodiscard]] uint64_t insert(uint64_t key, uint64_t handle) noexcept;
+    [[nodiscard]] bool contains_handle(uint64_t handle) const noexcept;
+};
+
 class LC_RUNTIME_API ServerInterface {
 public:
     using Handle = luisa::shared_ptr<DeviceInterface>;
@@ -15,6 +54,10 @@ private:
     mutable luisa::spin_mutex _handle_mtx;
     luisa::unordered_map<uint64_t, uint64_t> _handle_map;
     SendMsgFunc _send_msg;
+    luisa::shared_ptr<ServerShaderCache> _shader_cache;
+    // mirrors of the delta-encoded resource modifications sent by the client, keyed by frontend handles
+    luisa::unique_ptr<DeltaCodec<BindlessArrayUpdateCommand::Modification>> _bindless_codec;
+    luisa::unique_ptr<DeltaCodec<AccelBuildCommand::Modification>> _accel_codec;
     [[nodiscard]] uint64_t native_handle(uint64_t handle) const;
     void insert_handle(uint64_t frontend_handle, uint64_t backend_handle);
     [[nodiscard]] uint64_t remove_handle(uint64_t frontend_handle);
@@ -22,7 +65,9 @@ private:
 public:
     explicit ServerInterface(
         Handle device_impl,
-        SendMsgFunc &&send_msg) noexcept;
+        SendMsgFunc &&send_msg,
+        luisa::shared_ptr<ServerShaderCache> shader_cache = nullptr) noexcept;
+    ~ServerInterface() noexcept;
     void execute(luisa::span<const std::byte> data, luisa::vector<std::byte> &result) noexcept;
     void create_buffer_ast(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
     // void create_buffer_ir(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
@@ -36,6 +81,8 @@ public:
     void dispatch(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
     void create_swap_chain(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
     void create_shader_ast(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
+    void lookup_shader_cache(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
+    void query_capabilities(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
     // void create_shader_ir(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
     // void create_shader_ir_v2(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
     void load_shader(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept;
@@ -155,8 +155,15 @@ public:
 };
 
 class LC_XIR_API CallableFunction final : public DerivedFunction<DerivedFunctionTag::CALLABLE, FunctionDefinition> {
+
+private:
+    bool _noinline{false};
+
 public:
     using DerivedFunction::DerivedFunction;
+    // noinline callables are kept out of line, e.g., the ones created by `$outline` in the DSL
+    void set_noinline(bool noinline) noexcept { _noinline = noinline; }
+    [[nodiscard]] bool is_noinline() const noexcept { return _noinline; }
 };
 
 class LC_XIR_API KernelFunction final : public DerivedFunction<DerivedFunctionTag::KERNEL, FunctionDefinition> {
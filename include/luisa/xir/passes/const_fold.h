@@ -0,0 +1,33 @@
+#pragma once
+
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+class Instruction;
+
+// This pass folds arithmetic and cast instructions whose operands are constants,
+// and applies simple algebraic simplifications to the remaining ones.
+//
+// Folded operations include the element-wise unary, binary and comparison operators,
+// select, min/max/abs, vector aggregates and element extraction, and static/bitwise
+// casts on scalars and vectors. Integer arithmetic wraps around, while divisions by
+// zero and out-of-range shifts or float-to-integer conversions are left untouched.
+//
+// The simplifications only apply the identities that hold for all inputs, e.g.,
+// x + 0 => x and x * 0 => 0 (integers only), x * 1 => x, x - x => 0 (integers only),
+// x & x => x, -(-x) => x, select(x, x, c) => x, extract(aggregate(..., e, ...), i) => e,
+// and bitcast(bitcast(x)) => x. Floating-point identities that depend on the sign of
+// zero or on NaNs are not applied.
+//
+// Each folded instruction is mapped to its replacement in the returned info.
+
+struct ConstFoldInfo {
+    luisa::unordered_map<Instruction *, Value *> folded_instructions;
+};
+
+[[nodiscard]] LC_XIR_API ConstFoldInfo const_fold_pass_run_on_function(Module *module, Function *function) noexcept;
+[[nodiscard]] LC_XIR_API ConstFoldInfo const_fold_pass_run_on_module(Module *module) noexcept;
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+class Instruction;
+
+// This pass implements dominator-scoped global value numbering (GVN), i.e.,
+// common subexpression elimination across basic blocks. Pure instructions
+// (arithmetic, casts and GEPs) are numbered by their opcode, type and operands
+// while walking the dominator tree; an instruction equivalent to one in a
+// dominating position is replaced with the earlier instruction.
+//
+// Operands are compared by identity, except that constants with the same type
+// and data, and special registers with the same tag, are treated as equal.
+// The operands of commutative operations are ordered before numbering.
+//
+// Note: the pass is best run after const_fold, so that folded expressions can
+// be numbered, and before the load/store forwarding passes.
+
+struct GVNInfo {
+    luisa::unordered_map<Instruction *, Instruction *> eliminated_instructions;
+};
+
+[[nodiscard]] LC_XIR_API GVNInfo gvn_pass_run_on_function(Function *function) noexcept;
+[[nodiscard]] LC_XIR_API GVNInfo gvn_pass_run_on_module(Module *module) noexcept;
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+class CallInst;
+
+// This pass inlines calls to small callables. The cost of a callable is the number
+// of instructions in its body, not counting the ones that are free after lowering
+// (phi nodes, plain branches and local variable declarations); calls to callables
+// whose cost does not exceed the threshold are replaced with a copy of the callee
+// body. Callees are processed before their callers, so the cost of a callable is
+// measured after its own small callees have been inlined. Callables marked noinline
+// (e.g., the ones created by `$outline` in the DSL or by the outline pass) are never inlined, except for
+// callables that synchronize the block, which are always inlined: some backends
+// implement barriers by suspending the kernel (e.g., the fallback backend), which is
+// not possible from a callable. Since callees are processed first, this also applies
+// to callables that only synchronize through their callees.
+//
+// For example,
+// callable f(x) { return x * 2 }
+// ...
+// y = call f(a)
+// z = y + 1
+//
+// will be transformed to
+// r = alloca local
+// ...
+// outline body {
+//   t = a * 2
+//   store(r, t)
+//   br merge
+// }, merge {
+//   y = load(r)
+//   z = y + 1
+// }
+//
+// Note: the inlined body is wrapped in an outline instruction to keep the control
+// flow structured, so the outline pass should run before this pass (otherwise it
+// would move the inlined bodies back into new callables). Return values are
+// passed through local variables, so running sroa and mem2reg afterwards is
+// recommended. Callables that are no longer referenced after inlining are removed
+// from the module by inline_pass_run_on_module.
+
+static constexpr size_t inline_pass_default_max_callee_cost = 32u;
+
+struct InlineInfo {
+    luisa::unordered_map<CallInst *, Function *> inlined_calls;
+    luisa::unordered_set<Function *> removed_functions;
+};
+
+[[nodiscard]] LC_XIR_API InlineInfo inline_pass_run_on_function(Function *function, size_t max_callee_cost = inline_pass_default_max_callee_cost) noexcept;
+[[nodiscard]] LC_XIR_API InlineInfo inline_pass_run_on_module(Module *module, size_t max_callee_cost = inline_pass_default_max_callee_cost) noexcept;
+
+}// namespace luisa::compute::xir
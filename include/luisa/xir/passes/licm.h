@@ -0,0 +1,42 @@
+#pragma once
+
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+class Instruction;
+
+// This pass implements loop-invariant code motion (LICM). Instructions in a loop
+// whose operands are all defined outside the loop (or are loop-invariant themselves)
+// are moved to the preheader of the loop, i.e., right before the loop instruction.
+// Loops are processed from the innermost to the outermost, so an invariant
+// expression may be hoisted through several levels of nested loops.
+//
+// The following instructions are considered:
+// - arithmetic, casts, GEPs, and size/address queries of buffer and texture
+//   arguments: pure and safe to execute speculatively, so they are hoisted from
+//   anywhere in the loop (except for integer division and modulo by a divisor
+//   that is not a known-safe constant);
+// - bindless slot queries (buffer/texture sizes and buffer device addresses)
+//   and texture sampling: pure, but they decode a slot index that might be
+//   invalid if the loop would not have executed them, so they are only hoisted
+//   from blocks that are executed whenever the loop is entered (i.e., that
+//   dominate all exits of the loop);
+// - resource reads: like the above, and only if the loop writes no resources
+//   and contains no calls;
+// - loads: like the above, and only if the loop writes no memory that the
+//   loaded variable may refer to.
+//
+// Note: this pass is best run after mem2reg and gvn, so that most local variable
+// accesses are promoted to SSA values and redundant expressions are removed.
+
+struct LICMInfo {
+    // hoisted instruction -> the (outermost) loop instruction it was hoisted out of
+    luisa::unordered_map<Instruction *, Instruction *> hoisted_instructions;
+};
+
+[[nodiscard]] LC_XIR_API LICMInfo licm_pass_run_on_function(Function *function) noexcept;
+[[nodiscard]] LC_XIR_API LICMInfo licm_pass_run_on_module(Module *module) noexcept;
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <luisa/core/stl/memory.h>
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/function.h>
+
+namespace luisa::compute::xir {
+
+class TerminatorInstruction;
+
+// A structured loop, i.e., a loop or simple loop instruction together with the blocks
+// reachable from its header (the prepare block of loops, or the body block of simple
+// loops) without passing through its merge block. The block holding the loop
+// instruction is the preheader: it is executed exactly once before the loop is entered.
+// Note: ray query loops are not considered as loops.
+class LC_XIR_API Loop : public concepts::Noncopyable {
+
+private:
+    TerminatorInstruction *_instruction;
+    BasicBlock *_header;
+    const Loop *_parent;
+    luisa::vector<const Loop *> _children;
+    luisa::vector<BasicBlock *> _blocks;
+    luisa::unordered_set<BasicBlock *> _block_set;
+    luisa::vector<BasicBlock *> _exiting_blocks;
+
+public:
+    explicit Loop(TerminatorInstruction *instruction) noexcept;
+    void add_block(BasicBlock *block) noexcept;
+    void add_exiting_block(BasicBlock *block) noexcept;
+    void add_child(Loop *child) noexcept;
+
+public:
+    [[nodiscard]] auto instruction() const noexcept { return _instruction; }
+    [[nodiscard]] auto header() const noexcept { return _header; }
+    [[nodiscard]] auto parent() const noexcept { return _parent; }
+    [[nodiscard]] auto children() const noexcept { return luisa::span{_children}; }
+    [[nodiscard]] auto blocks() const noexcept { return luisa::span{_blocks}; }
+    // blocks that may leave the loop, through either a branch to a block outside or a return
+    [[nodiscard]] auto exiting_blocks() const noexcept { return luisa::span{_exiting_blocks}; }
+    [[nodiscard]] BasicBlock *preheader() const noexcept;
+    [[nodiscard]] BasicBlock *merge_block() const noexcept;
+    [[nodiscard]] size_t depth() const noexcept;
+    [[nodiscard]] bool contains(const BasicBlock *block) const noexcept;
+    [[nodiscard]] bool contains(const Instruction *inst) const noexcept;
+};
+
+class LC_XIR_API LoopInfo : public concepts::Noncopyable {
+
+private:
+    luisa::vector<luisa::unique_ptr<Loop>> _loops;
+    luisa::vector<const Loop *> _top_level_loops;
+    luisa::unordered_map<const BasicBlock *, const Loop *> _innermost_loops;
+
+public: /* for internal usage only */
+    LoopInfo() noexcept;
+    Loop *add_loop(TerminatorInstruction *instruction) noexcept;
+    void add_top_level_loop(Loop *loop) noexcept;
+    void set_innermost_loop(BasicBlock *block, Loop *loop) noexcept;
+    void sort_loops_by_depth() noexcept;
+
+public:
+    // all loops in the function, outer loops before inner ones
+    [[nodiscard]] auto loops() const noexcept { return luisa::span{_loops}; }
+    [[nodiscard]] auto top_level_loops() const noexcept { return luisa::span{_top_level_loops}; }
+    // the innermost loop containing the block, or nullptr if the block is not in any loop
+    [[nodiscard]] const Loop *loop(const BasicBlock *block) const noexcept;
+    [[nodiscard]] size_t loop_depth(const BasicBlock *block) const noexcept;
+};
+
+[[nodiscard]] LC_XIR_API LoopInfo compute_loop_info(Function *function) noexcept;
+
+}// namespace luisa::compute::xir
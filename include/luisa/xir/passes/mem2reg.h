@@ -0,0 +1,44 @@
+#pragma once
+
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+class AllocaInst;
+class PhiInst;
+
+// This pass promotes local variables to SSA values (mem2reg). Local alloca's of
+// basic types that are only loaded and stored as a whole are removed: phi nodes
+// are inserted at the iterated dominance frontiers of the stores, and each load
+// is replaced with the reaching definition found by walking the dominator tree
+// [Cytron et al. 1991]. Variables read before any store are zero-initialized.
+//
+// For example,
+// x = alloca float
+// if (c) {
+//   store(x, 1)
+// } else {
+//   store(x, 2)
+// }
+// r = load(x)
+//
+// will be transformed to
+// if (c) {
+// } else {
+// }
+// r = phi([1, true_block], [2, false_block])
+//
+// Note: variables accessed in ray query dispatch blocks and candidate blocks are
+// kept in memory, as the backends may outline the candidates into callbacks.
+// The pass is best run after sroa so that aggregates are already split into scalars.
+
+struct Mem2RegInfo {
+    luisa::unordered_set<AllocaInst *> promoted_allocas;
+    luisa::unordered_set<PhiInst *> inserted_phis;
+};
+
+[[nodiscard]] LC_XIR_API Mem2RegInfo mem2reg_pass_run_on_function(Module *module, Function *function) noexcept;
+[[nodiscard]] LC_XIR_API Mem2RegInfo mem2reg_pass_run_on_module(Module *module) noexcept;
+
+}// namespace luisa::compute::xir
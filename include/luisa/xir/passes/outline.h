@@ -8,6 +8,45 @@ namespace luisa::compute::xir {
 
 // This pass will outline all outline instructions in the module.
 // Information about the outlined functions will be returned.
+//
+// The body region of an outline instruction (i.e., the blocks reachable from its
+// target block without passing through its merge block) is moved into a new
+// callable. Values defined outside the region are passed as arguments (lvalues
+// by reference), and values defined in the region but used after it are written
+// back through extra reference arguments to local variables of the caller.
+// The new callables are marked noinline, so that the inline pass does not copy
+// the regions back into their callers.
+//
+// For example,
+// outline body {
+//   x = a + b
+//   store(v, x)
+//   br merge
+// }, merge {
+//   y = x * 2
+// }
+//
+// will be transformed to
+// callable f(a, b, &v, &out) {
+//   x = a + b
+//   store(v, x)
+//   store(out, x)
+//   return
+// }
+// t = alloca local
+// outline body {
+//   call f(a, b, v, t)
+//   x' = load(t)
+//   br merge
+// }, merge {
+//   y = x' * 2
+// }
+//
+// Note: regions that return from the function, leave it through break/continue
+// to enclosing loops, synchronize the block (directly or through the callables
+// they call), or trace rays (which may suspend the kernel on some backends) are
+// left in place. This pass only outlines the regions that are already wrapped in
+// outline instructions; it does not look for cold regions by itself.
 
 struct OutlineInfo {
     luisa::unordered_map<OutlineInst *, Function *> outlines;
@@ -1,6 +1,44 @@
 #pragma once
 
+#include <luisa/core/stl/vector.h>
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/xir/module.h>
+
 namespace luisa::compute::xir {
 
+class AllocaInst;
+
+// This pass implements scalar replacement of aggregates (SROA). Local alloca's of
+// structure and (small) array types that are only accessed through GEPs with
+// constant leading indices, or loaded/stored as a whole, are split into one alloca
+// per accessed field. Whole-aggregate loads are rebuilt from the field loads and
+// whole-aggregate stores are decomposed into per-field stores. The split fields
+// are processed recursively, so nested aggregates are flattened as far as possible.
+//
+// For example,
+// a = alloca Ray
+// p = gep(a, 1)
+// store(p, v)
+// r = load(a)
+//
+// will be transformed to
+// a.0 = alloca float3
+// a.1 = alloca float
+// ...
+// store(a.1, v)
+// x0 = load(a.0)
+// x1 = load(a.1)
+// ...
+// r = aggregate(x0, x1, ...)
+//
+// Note: the pass is best run after trace_gep and before local_store_forward, so that
+// GEP chains are flattened and the forwarding passes can see the scalar variables.
+
+struct SROAInfo {
+    luisa::unordered_map<AllocaInst *, luisa::vector<AllocaInst *>> split_allocas;
+};
+
+[[nodiscard]] LC_XIR_API SROAInfo sroa_pass_run_on_function(Module *module, Function *function) noexcept;
+[[nodiscard]] LC_XIR_API SROAInfo sroa_pass_run_on_module(Module *module) noexcept;
 
-}
+}// namespace luisa::compute::xir
@@ -25,10 +25,25 @@ public:
     PooledObject &operator=(const PooledObject &) noexcept = delete;
 };
 
+// Pooled objects are bump-allocated from fixed-size pages, so that creating them is
+// cheap and objects created together (e.g., the instructions of a block and their
+// uses) are close in memory. Objects larger than a quarter of the page size get
+// dedicated allocations. All objects are destroyed and all pages freed at once
+// when the pool is destroyed.
 class LC_XIR_API Pool : public concepts::Noncopyable {
 
+public:
+    static constexpr auto page_size = static_cast<size_t>(64u * 1024u);
+    static constexpr auto page_alignment = static_cast<size_t>(16u);
+
 private:
     luisa::vector<PooledObject *> _objects;
+    luisa::vector<std::byte *> _pages;// also holds the dedicated allocations of large objects
+    std::byte *_page_cursor{nullptr};
+    std::byte *_page_end{nullptr};
+
+private:
+    [[nodiscard]] void *_allocate(size_t size, size_t alignment) noexcept;
 
 public:
     explicit Pool(size_t init_cap = 0u) noexcept;
@@ -46,7 +61,9 @@ public:
     template<typename T, typename... Args>
         requires std::derived_from<T, PooledObject>
     [[nodiscard]] T *create(Args &&...args) {
-        auto object = luisa::new_with_allocator<T>(std::forward<Args>(args)...);
+        static_assert(alignof(T) <= page_alignment, "Over-aligned types are not supported by the pool.");
+        auto object = std::construct_at(static_cast<T *>(_allocate(sizeof(T), alignof(T))),
+                                        std::forward<Args>(args)...);
         _objects.emplace_back(object);
         return object;
     }
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <luisa/core/stl/memory.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+// Loads a module serialized by `xir_to_binary_translate` into the current pool.
+// Returns nullptr if the data is truncated or malformed, or was written by an incompatible
+// version of the format.
+[[nodiscard]] LC_XIR_API Module *binary_to_xir_translate(luisa::span<const std::byte> data) noexcept;
+
+}// namespace luisa::compute::xir
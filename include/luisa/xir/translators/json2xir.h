@@ -1,8 +1,11 @@
-//
-// Created by Mike on 2024/11/10.
-//
+#pragma once
 
-#ifndef JSON2XIR_H
-#define JSON2XIR_H
+#include <luisa/xir/module.h>
 
-#endif //JSON2XIR_H
+namespace luisa::compute::xir {
+
+// Loads a module from the JSON produced by `xir_to_json_translate` into the current pool.
+// Returns nullptr if the JSON is malformed, or was written by an incompatible version of the format.
+[[nodiscard]] LC_XIR_API Module *json_to_xir_translate(luisa::string_view json) noexcept;
+
+}// namespace luisa::compute::xir
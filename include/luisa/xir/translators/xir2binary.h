@@ -0,0 +1,14 @@
+#pragma once
+
+#include <luisa/core/stl/vector.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir {
+
+// Serializes the module into a compact binary blob that can be loaded with
+// `binary_to_xir_translate`, e.g., to cache optimized modules across processes.
+// Types are stored by description, so custom struct types must be registered
+// before loading. Auto-diff instructions are not supported.
+[[nodiscard]] LC_XIR_API luisa::vector<std::byte> xir_to_binary_translate(const Module *module) noexcept;
+
+}// namespace luisa::compute::xir
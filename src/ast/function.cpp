@@ -132,6 +132,10 @@ bool Function::requires_autodiff() const noexcept {
     return _builder->requires_autodiff();
 }
 
+bool Function::outlined() const noexcept {
+    return _builder->outlined();
+}
+
 bool Function::requires_printing() const noexcept {
     return _builder->requires_printing();
 }
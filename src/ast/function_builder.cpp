@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <luisa/core/logging.h>
 #include <luisa/ast/function_builder.h>
 
@@ -501,7 +503,39 @@ void FunctionBuilder::mark_variable_usage(uint32_t uid, Usage usage) noexcept {
     _variable_usages[uid] = u;
 }
 
-FunctionBuilder::~FunctionBuilder() noexcept = default;
+FunctionBuilder::~FunctionBuilder() noexcept {
+    for (auto s : _all_statements) { s->~Statement(); }
+    for (auto e : _all_expressions) { e->~Expression(); }
+    for (auto [page, size] : _node_arena_pages) {
+        luisa::detail::allocator_deallocate(page, alignof(std::max_align_t));
+    }
+}
+
+void *FunctionBuilder::_allocate_node(size_t size, size_t alignment) noexcept {
+    // pages grow geometrically so that small callables do not waste memory
+    static constexpr auto min_page_size = static_cast<size_t>(4u * 1024u);
+    static constexpr auto max_page_size = static_cast<size_t>(64u * 1024u);
+    LUISA_DEBUG_ASSERT(alignment <= alignof(std::max_align_t),
+                       "Over-aligned AST nodes are not supported.");
+    if (_node_arena_cursor != nullptr) {
+        auto padding = (alignment - reinterpret_cast<uintptr_t>(_node_arena_cursor) % alignment) % alignment;
+        if (padding + size <= static_cast<size_t>(_node_arena_end - _node_arena_cursor)) {
+            auto p = _node_arena_cursor + padding;
+            _node_arena_cursor = p + size;
+            return p;
+        }
+    }
+    auto page_size = _node_arena_pages.empty() ?
+                         min_page_size :
+                         std::min(_node_arena_pages.back().second * 2u, max_page_size);
+    page_size = std::max(page_size, size);
+    auto page = static_cast<std::byte *>(
+        luisa::detail::allocator_allocate(page_size, alignof(std::max_align_t)));
+    _node_arena_pages.emplace_back(page, page_size);
+    _node_arena_cursor = page + size;
+    _node_arena_end = page + page_size;
+    return page;
+}
 
 FunctionBuilder::FunctionBuilder(FunctionBuilder::Tag tag) noexcept
     : _hash{0ul}, _tag{tag} {}
@@ -576,6 +610,8 @@ void FunctionBuilder::_compute_hash() noexcept {
     for (auto &&c : _captured_constants) { hashes.emplace_back(hash_value(c)); }
     hashes.emplace_back(hash_value(_block_size));
     hashes.emplace_back(_required_curve_bases.hash());
+    // only hashed when set so that the hashes of the other functions stay the same
+    if (_outlined) { hashes.emplace_back(hash_value("__outlined"sv)); }
     _hash = hash64(hashes.data(), hashes.size() * sizeof(uint64_t), seed);
     _hash_computed = true;
 }
@@ -874,6 +910,16 @@ void FunctionBuilder::set_block_size(uint3 size) noexcept {
     }
 }
 
+void FunctionBuilder::mark_outlined() noexcept {
+    if (_tag != Tag::CALLABLE) [[unlikely]] {
+        LUISA_WARNING_WITH_LOCATION(
+            "Only callables can be outlined. "
+            "Ignoring the `mark_outlined()` call.");
+        return;
+    }
+    _outlined = true;
+}
+
 void FunctionBuilder::set_name(luisa::string_view name) noexcept {
     _name = name;
     // canonicalize the name
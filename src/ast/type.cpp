@@ -1,3 +1,5 @@
+#include <array>
+#include <atomic>
 #include <bit>
 #include <charconv>
 #include <utility>
@@ -42,32 +44,34 @@ struct TypeImpl final : public Type {
     luisa::vector<Attribute> member_attributes;
 };
 
+static constexpr auto type_registry_thread_local_cache_size = static_cast<size_t>(64u);
+
+[[nodiscard]] static auto &type_registry_thread_local_cache() noexcept {
+    static thread_local std::array<const TypeImpl *, type_registry_thread_local_cache_size> cache{};
+    return cache;
+}
+
 /// Type registry class
 class LC_AST_API TypeRegistry {
 
-public:
-    struct TypeDescAndHash {
-        string_view desc;
-        uint64_t hash;
-        [[nodiscard]] auto operator==(TypeDescAndHash rhs) const noexcept {
-            return hash == rhs.hash && desc == rhs.desc;
-        }
-        [[nodiscard]] auto operator==(const TypeImpl *rhs) const noexcept {
-            return *this == TypeDescAndHash{rhs->description, rhs->hash};
-        }
-    };
-
-    struct TypeHash {
-        using is_avalanching = void;
-        using is_transparent = void;
-        [[nodiscard]] uint64_t operator()(const Type *type) const noexcept { return type->hash(); }
-        [[nodiscard]] uint64_t operator()(TypeDescAndHash const &desc) const noexcept { return desc.hash; }
+private:
+    // An insert-only open-addressing hash table of the registered types. Readers probe
+    // the current table without locking, while writers insert under the mutex and publish
+    // new entries with release stores. On growth, the entries are rehashed into a larger
+    // table that is then published atomically. Retired tables are kept alive until the
+    // registry is destroyed, so that concurrent readers never access freed memory.
+    struct TypeTable {
+        size_t mask;
+        std::atomic<const TypeImpl *> *slots;
     };
+    static constexpr auto initial_table_capacity = static_cast<size_t>(256u);
 
 private:
     luisa::Pool<TypeImpl, false, false> _type_pool;
     luisa::vector<TypeImpl *> _types;
-    luisa::unordered_set<const TypeImpl *, TypeHash> _type_set;
+    luisa::vector<TypeTable *> _tables;// the last one is the current table
+    std::atomic<const TypeTable *> _current_table{nullptr};
+    std::atomic<size_t> _type_count{0u};
     mutable std::recursive_mutex _mutex;
 
 private:
@@ -77,15 +81,59 @@ private:
         static auto seed = hash_value("__hash_type"sv);
         return hash_value(desc, seed);
     };
-    [[nodiscard]] auto _register(TypeImpl *type) noexcept {
-        type->index = static_cast<uint32_t>(_types.size());
-        auto ret = _type_set.emplace(type);
-        if (ret.second) [[likely]] {
-            _types.emplace_back(type);
-        } else {
+    [[nodiscard]] const TypeImpl *_find(luisa::string_view desc, uint64_t hash) const noexcept {
+        auto table = _current_table.load(std::memory_order_acquire);
+        if (table == nullptr) { return nullptr; }
+        for (auto i = hash & table->mask;; i = (i + 1u) & table->mask) {
+            auto t = table->slots[i].load(std::memory_order_acquire);
+            if (t == nullptr) { return nullptr; }
+            if (t->hash == hash && t->description == desc) { return t; }
+        }
+    }
+    // lock-free lookup, with a small direct-mapped per-thread cache in front of the shared
+    // table so that hot types are found without touching shared cache lines
+    [[nodiscard]] const TypeImpl *_lookup(luisa::string_view desc, uint64_t hash) const noexcept {
+        auto &&cache = type_registry_thread_local_cache();
+        auto &&entry = cache[hash % type_registry_thread_local_cache_size];
+        if (auto t = entry; t != nullptr && t->hash == hash && t->description == desc) { return t; }
+        auto t = _find(desc, hash);
+        if (t != nullptr) { entry = t; }
+        return t;
+    }
+    static void _insert_into(TypeTable *table, const TypeImpl *type) noexcept {
+        for (auto i = type->hash & table->mask;; i = (i + 1u) & table->mask) {
+            if (table->slots[i].load(std::memory_order_relaxed) == nullptr) {
+                table->slots[i].store(type, std::memory_order_release);
+                return;
+            }
+        }
+    }
+    // must be called with the mutex held
+    void _insert(const TypeImpl *type) noexcept {
+        auto table = _tables.empty() ? nullptr : _tables.back();
+        // keep the load factor at most 1/2 so that probe sequences stay short
+        if (table == nullptr || (_types.size() + 1u) * 2u > table->mask + 1u) {
+            auto capacity = table == nullptr ? initial_table_capacity : (table->mask + 1u) * 2u;
+            auto slots = luisa::allocate_with_allocator<std::atomic<const TypeImpl *>>(capacity);
+            for (auto i = 0u; i < capacity; i++) { std::construct_at(slots + i, nullptr); }
+            table = luisa::new_with_allocator<TypeTable>(TypeTable{capacity - 1u, slots});
+            for (auto t : _types) { _insert_into(table, t); }
+            _tables.emplace_back(table);
+            _current_table.store(table, std::memory_order_release);
+        }
+        _insert_into(table, type);
+    }
+    // must be called with the mutex held
+    [[nodiscard]] const TypeImpl *_register(TypeImpl *type) noexcept {
+        if (auto existing = _find(type->description, type->hash)) [[unlikely]] {
             _type_pool.destroy(type);
+            return existing;
         }
-        return *ret.first;
+        type->index = static_cast<uint32_t>(_types.size());
+        _insert(type);
+        _types.emplace_back(type);
+        _type_count.store(_types.size(), std::memory_order_release);
+        return type;
     }
 
 public:
@@ -93,6 +141,10 @@ public:
         for (auto t : _types) {
             std::destroy_at(t);
         }
+        for (auto table : _tables) {
+            luisa::deallocate_with_allocator(table->slots);
+            luisa::delete_with_allocator(table);
+        }
     }
     /// Get registry instance
     [[nodiscard]] static TypeRegistry &instance() noexcept {
@@ -112,6 +164,8 @@ public:
 const Type *TypeRegistry::decode_type(luisa::string_view desc) noexcept {
     using namespace std::literals;
     if (desc == "void"sv) { return nullptr; }
+    // fast path: the type is already registered
+    if (auto t = _lookup(desc, _compute_hash(desc))) { return t; }
     std::lock_guard lock{_mutex};
     return _decode(desc);
 }
@@ -145,10 +199,10 @@ const Type *TypeRegistry::custom_type(luisa::string_view name) noexcept {
     LUISA_ASSERT(std::all_of(name.cbegin(), name.cend(),
                              [](char c) { return isalnum(c) || c == '_'; }),
                  "Invalid custom type name: {}", name);
-    std::lock_guard lock{_mutex};
     auto h = _compute_hash(name);
-    if (auto iter = _type_set.find(TypeDescAndHash{name, h});
-        iter != _type_set.end()) { return *iter; }
+    if (auto t = _lookup(name, h)) { return t; }
+    std::lock_guard lock{_mutex};
+    if (auto t = _find(name, h)) { return t; }
 
     auto t = _type_pool.create();
     t->hash = h;
@@ -161,8 +215,7 @@ const Type *TypeRegistry::custom_type(luisa::string_view name) noexcept {
 }
 
 size_t TypeRegistry::type_count() const noexcept {
-    std::lock_guard lock{_mutex};
-    return _types.size();
+    return _type_count.load(std::memory_order_acquire);
 }
 
 void TypeRegistry::traverse(TypeVisitor &visitor) const noexcept {
@@ -177,8 +230,7 @@ const TypeImpl *TypeRegistry::_decode(luisa::string_view desc) noexcept {
         return nullptr;
     }
     auto hash = _compute_hash(desc);
-    if (auto iter = _type_set.find(TypeDescAndHash{desc, hash});
-        iter != _type_set.cend()) { return *iter; }
+    if (auto t = _find(desc, hash)) { return t; }
 
     using namespace std::string_view_literals;
     auto read_identifier = [&desc]() noexcept {
@@ -5,28 +5,34 @@
 #include <luisa/core/stl.h>
 #include <luisa/core/logging.h>
 
-#include "fallback_mesh.h"
+#include "fallback_primitive.h"
+#include "fallback_motion_instance.h"
 #include "fallback_accel.h"
 #include "fallback_command_queue.h"
 
 namespace luisa::compute::fallback {
 
 FallbackAccel::FallbackAccel(RTCDevice device, const AccelOption &option) noexcept
-    : _handle{rtcNewScene(device)} { luisa_fallback_accel_set_flags(_handle, option); }
+    : _handle{rtcNewScene(device)},
+      _build_quality{luisa_fallback_accel_build_quality(option)},
+      _allow_update{option.allow_update} { luisa_fallback_accel_set_flags(_handle, option); }
 
 FallbackAccel::~FallbackAccel() noexcept { rtcReleaseScene(_handle); }
 
 void FallbackAccel::build(luisa::unique_ptr<AccelBuildCommand> cmd) noexcept {
-    LUISA_ASSERT(!cmd->update_instance_buffer_only(),
-                 "FallbackAccel does not support update_instance_buffer_only.");
-    if (auto n = cmd->instance_count(); n < _instances.size()) {
+    // adding or removing instances changes the top-level topology
+    auto n = cmd->instance_count();
+    if (n != _instances.size()) { _requires_rebuild = true; }
+    if (n < _instances.size()) {
         // remove redundant geometries
         for (auto i = n; i < _instances.size(); i++) { rtcDetachGeometry(_handle, i); }
         _instances.resize(n);
+        _primitives.resize(n);
     } else {
         // create new geometries
         auto device = rtcGetSceneDevice(_handle);
         _instances.reserve(next_pow2(n));
+        _primitives.resize(n, nullptr);
         for (auto i = _instances.size(); i < n; i++) {
             auto geometry = rtcNewGeometry(device, RTC_GEOMETRY_TYPE_INSTANCE);
             rtcSetGeometryBuildQuality(geometry, RTC_BUILD_QUALITY_HIGH);
@@ -39,9 +45,14 @@ void FallbackAccel::build(luisa::unique_ptr<AccelBuildCommand> cmd) noexcept {
     for (auto m : cmd->modifications()) {
         using Mod = AccelBuildCommand::Modification;
         if (m.flags & Mod::flag_primitive) {
-            auto geometry = _instances[m.index].geometry;
-            auto mesh = reinterpret_cast<const FallbackMesh *>(m.primitive);
-            rtcSetGeometryInstancedScene(geometry, mesh->handle());
+            auto primitive = reinterpret_cast<const FallbackPrimitive *>(m.primitive);
+            // motion instances set up their child scene along with the keyframes
+            if (primitive->tag() != FallbackPrimitive::Tag::MOTION_INSTANCE) {
+                rtcSetGeometryInstancedScene(_instances[m.index].geometry, primitive->handle());
+            }
+            // closest-hit queries find the primitive type of the hit instance through the user data
+            rtcSetGeometryUserData(_instances[m.index].geometry, const_cast<FallbackPrimitive *>(primitive));
+            _primitives[m.index] = primitive;
         }
         if (m.flags & Mod::flag_transform) {
             std::memcpy(_instances[m.index].affine, m.affine, sizeof(m.affine));
@@ -57,17 +68,35 @@ void FallbackAccel::build(luisa::unique_ptr<AccelBuildCommand> cmd) noexcept {
         }
         _instances[m.index].dirty = true;
     }
-    for (auto &&instance : _instances) {
-        if (instance.dirty) {
+    // kernels already see the updated instances, while the
+    // dirty geometries are committed by the next build
+    if (cmd->update_instance_buffer_only()) { return; }
+    for (auto i = 0u; i < _instances.size(); i++) {
+        auto &&instance = _instances[i];
+        auto primitive = _primitives[i];
+        // keyframes may change without touching the instance, so motion instances are always re-applied
+        auto is_motion = primitive != nullptr &&
+                         primitive->tag() == FallbackPrimitive::Tag::MOTION_INSTANCE;
+        if (instance.dirty || is_motion) {
             auto geometry = instance.geometry;
-            rtcSetGeometryTransform(geometry, 0u, RTC_FORMAT_FLOAT3X4_ROW_MAJOR, instance.affine);
+            if (is_motion) {
+                static_cast<const FallbackMotionInstance *>(primitive)->apply(geometry, instance.affine);
+            } else {
+                rtcSetGeometryTimeStepCount(geometry, 1u);
+                rtcSetGeometryTransform(geometry, 0u, RTC_FORMAT_FLOAT3X4_ROW_MAJOR, instance.affine);
+            }
             rtcSetGeometryMask(geometry, instance.mask);
             rtcCommitGeometry(geometry);
             instance.dirty = false;
         }
     }
-    // TODO: support update?
+    // embree only rebuilds the BVHs of modified geometries, and a low-quality
+    // top-level build is the closest to an update for the instance level
+    auto update = _allow_update && !_requires_rebuild &&
+                  cmd->request() == AccelBuildRequest::PREFER_UPDATE;
+    rtcSetSceneBuildQuality(_handle, update ? RTC_BUILD_QUALITY_LOW : _build_quality);
     rtcCommitScene(_handle);
+    _requires_rebuild = false;
 }
 
 }// namespace luisa::compute::fallback
@@ -19,7 +19,7 @@ class ThreadPool;
 namespace luisa::compute::fallback {
 
 class FallbackCommandQueue;
-class FallbackMesh;
+class FallbackPrimitive;
 
 class alignas(16) FallbackAccel {
 
@@ -41,7 +41,11 @@ public:
 
 private:
     RTCScene _handle;
+    RTCBuildQuality _build_quality;
+    bool _allow_update;
+    bool _requires_rebuild{true};
     luisa::vector<Instance> _instances;
+    luisa::vector<const FallbackPrimitive *> _primitives;
 
 public:
     [[nodiscard]] RTCScene handle() const noexcept { return _handle; }
@@ -6,6 +6,7 @@
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/MatrixBuilder.h>
 #include <llvm/IR/Metadata.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/TargetSelect.h>
@@ -14,6 +15,8 @@
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/Transforms/IPO.h>
+#include <llvm/Transforms/Utils/BasicBlockUtils.h>
+#include <llvm/Transforms/Utils/CodeExtractor.h>
 #include <llvm/MC/TargetRegistry.h>
 
 #include <luisa/core/stl/unordered_map.h>
@@ -31,6 +34,7 @@
 #include "fallback_bindless_array.h"
 #include "fallback_buffer.h"
 #include "fallback_texture.h"
+#include "fallback_device_api.h"
 
 namespace luisa::compute::fallback {
 
@@ -59,15 +63,52 @@ private:
 #undef LUISA_FALLBACK_BACKEND_DECL_BUILTIN_VARIABLE
         static constexpr size_t builtin_variable_count = 5;
         llvm::Value *builtin_variables[builtin_variable_count] = {};
+
+        // block-shared storage of kernels, laid out as shared allocas are translated
+        llvm::Value *shared_memory = nullptr;
+        size_t shared_memory_size = 0u;
+
+        // coroutine states of kernels that synchronize the block
+        llvm::Value *coro_id = nullptr;
+        llvm::Value *coro_handle = nullptr;
+        llvm::BasicBlock *coro_begin_block = nullptr;
+        llvm::BasicBlock *coro_final_block = nullptr;
+        llvm::BasicBlock *coro_cleanup_block = nullptr;
+        llvm::BasicBlock *coro_suspend_block = nullptr;
+
+        // per-thread slot that publishes ray queries to the kernel wrapper for batched tracing
+        llvm::Value *ray_query_slot = nullptr;
+
+        // ray query dispatches, whose candidate blocks are translated in place and
+        // outlined into the callbacks of the traversal after the body is translated
+        struct RayQueryDispatch {
+            llvm::SwitchInst *switch_inst;
+            llvm::CallInst *placeholder;
+            llvm::Value *query;
+            llvm::BasicBlock *surface_block;
+            llvm::BasicBlock *procedural_block;
+            llvm::BasicBlock *exit_block;
+            llvm::BasicBlock *dispatch_block;
+        };
+        luisa::vector<RayQueryDispatch> ray_query_dispatches;
+        uint ray_query_depth = 0u;
+
+        // phi nodes, whose incomings are resolved after the whole body is translated
+        luisa::vector<std::pair<const xir::PhiInst *, llvm::PHINode *>> phi_nodes;
     };
 
+    static constexpr size_t shared_memory_alignment = 16u;
+
 private:
     llvm::LLVMContext &_llvm_context;
+    FallbackCodeGenConfig _config;
     llvm::Module *_llvm_module = nullptr;
     luisa::unordered_map<const Type *, luisa::unique_ptr<LLVMStruct>> _llvm_struct_types;
     luisa::unordered_map<const xir::Constant *, llvm::Constant *> _llvm_constants;
     luisa::unordered_map<const xir::Function *, llvm::Function *> _llvm_functions;
     FallbackCodeGenFeedback::PrintInstMap _print_inst_map;
+    size_t _kernel_shared_memory_size = 0u;
+    bool _kernel_batches_ray_queries = false;
 
 private:
     void _reset() noexcept {
@@ -75,6 +116,8 @@ private:
         _llvm_struct_types.clear();
         _llvm_constants.clear();
         _llvm_functions.clear();
+        _kernel_shared_memory_size = 0u;
+        _kernel_batches_ray_queries = false;
     }
 
 private:
@@ -83,6 +126,12 @@ private:
         return name_md ? llvm::StringRef{name_md->name()} : fallback;
     }
 
+    [[nodiscard]] static bool _is_ray_query_type(const Type *t) noexcept {
+        return t->is_custom() &&
+               (t->description() == "LC_RayQueryAll" ||
+                t->description() == "LC_RayQueryAny");
+    }
+
     [[nodiscard]] static size_t _get_type_size(const Type *t) noexcept {
         LUISA_ASSERT(t != nullptr, "Type is nullptr.");
         if (!t->is_resource() && !t->is_custom()) {
@@ -93,7 +142,10 @@ private:
             case Type::Tag::TEXTURE: return sizeof(FallbackTextureView);
             case Type::Tag::BINDLESS_ARRAY: return sizeof(FallbackBindlessArrayView);
             case Type::Tag::ACCEL: return sizeof(FallbackAccelView);
-            case Type::Tag::CUSTOM: LUISA_NOT_IMPLEMENTED();
+            case Type::Tag::CUSTOM: {
+                if (_is_ray_query_type(t)) { return sizeof(api::RayQueryObject); }
+                LUISA_NOT_IMPLEMENTED();
+            }
             default: break;
         }
         LUISA_ERROR_WITH_LOCATION("Invalid type: {}.", t->description());
@@ -109,7 +161,10 @@ private:
             case Type::Tag::TEXTURE: return alignof(FallbackTextureView);
             case Type::Tag::BINDLESS_ARRAY: return alignof(FallbackBindlessArrayView);
             case Type::Tag::ACCEL: return alignof(FallbackAccelView);
-            case Type::Tag::CUSTOM: LUISA_NOT_IMPLEMENTED();
+            case Type::Tag::CUSTOM: {
+                if (_is_ray_query_type(t)) { return alignof(api::RayQueryObject); }
+                LUISA_NOT_IMPLEMENTED();
+            }
             default: break;
         }
         LUISA_ERROR_WITH_LOCATION("Invalid type: {}.", t->description());
@@ -197,7 +252,14 @@ private:
                 auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
                 return llvm::StructType::get(_llvm_context, {llvm_ptr_type, llvm_ptr_type});
             }
-            case Type::Tag::CUSTOM: LUISA_NOT_IMPLEMENTED();
+            case Type::Tag::CUSTOM: {
+                // ray query objects are opaque to kernels and only accessed through their pointers
+                if (_is_ray_query_type(t)) {
+                    auto llvm_byte_type = llvm::Type::getInt8Ty(_llvm_context);
+                    return llvm::ArrayType::get(llvm_byte_type, sizeof(api::RayQueryObject));
+                }
+                LUISA_NOT_IMPLEMENTED();
+            }
         }
         LUISA_ERROR_WITH_LOCATION("Invalid type: {}.", t->description());
     }
@@ -1294,6 +1356,24 @@ private:
     [[nodiscard]] llvm::Value *_translate_aggregate(CurrentFunction &current, IRBuilder &b,
                                                     const xir::ArithmeticInst *inst) noexcept {
         auto type = inst->type();
+        // structures and arrays are assembled in memory, like in insert and extract
+        if (type->is_structure() || type->is_array()) {
+            auto llvm_type = _translate_type(type, false);
+            auto alignment = _get_type_alignment(type);
+            auto llvm_temp = b.CreateAlloca(llvm_type);
+            if (llvm_temp->getAlign() < alignment) {
+                llvm_temp->setAlignment(llvm::Align{alignment});
+            }
+            for (auto i = 0u; i < inst->operand_count(); i++) {
+                auto field = inst->operand(i);
+                auto llvm_field = _lookup_value(current, b, field);
+                auto llvm_gep = type->is_structure() ?
+                                    b.CreateStructGEP(llvm_type, llvm_temp, _translate_struct_type(type)->padded_field_indices[i]) :
+                                    b.CreateConstInBoundsGEP2_32(llvm_type, llvm_temp, 0u, i);
+                b.CreateAlignedStore(llvm_field, llvm_gep, llvm::MaybeAlign{_get_type_alignment(field->type())});
+            }
+            return b.CreateAlignedLoad(llvm_type, llvm_temp, llvm::MaybeAlign{alignment});
+        }
         auto elem_type = type->element();
         auto dim = type->dimension();
         if (type->is_vector()) {
@@ -1774,6 +1854,261 @@ private:
         return b.CreateCall(llvm_func, llvm_args);
     }
 
+    [[nodiscard]] llvm::StructType *_ray_query_slot_type() noexcept {
+        // matches api::RayQuerySlot
+        auto llvm_i32_type = llvm::Type::getInt32Ty(_llvm_context);
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_float_type = llvm::Type::getFloatTy(_llvm_context);
+        return llvm::StructType::get(_llvm_context, {llvm_i32_type, llvm_i32_type, llvm_ptr_type, llvm_ptr_type, llvm_ptr_type, llvm_float_type});
+    }
+
+    [[nodiscard]] llvm::Value *_translate_batched_trace(CurrentFunction &current, IRBuilder &b,
+                                                        api::RayQuerySlotKind kind,
+                                                        const xir::Instruction *inst,
+                                                        bool motion_blur) noexcept {
+        // publish the query in the slot of the thread and suspend; the kernel wrapper
+        // traces the pending queries of the block in packets and resumes the thread
+        // operands: accel, ray, [time,] mask
+        auto llvm_accel = _lookup_value(current, b, inst->operand(0u));
+        auto llvm_accel_alloca = b.CreateAlloca(llvm_accel->getType(), nullptr, "trace.accel");
+        b.CreateStore(llvm_accel, llvm_accel_alloca);
+        auto llvm_ray = _lookup_value(current, b, inst->operand(1u));
+        auto llvm_ray_alloca = b.CreateAlloca(llvm_ray->getType(), nullptr, "trace.ray");
+        b.CreateStore(llvm_ray, llvm_ray_alloca);
+        auto llvm_time = motion_blur ?
+                             _lookup_value(current, b, inst->operand(2u)) :
+                             llvm::ConstantFP::get(b.getFloatTy(), 0.);
+        auto llvm_mask = b.CreateZExtOrTrunc(_lookup_value(current, b, inst->operand(motion_blur ? 3u : 2u)), b.getInt32Ty());
+        auto llvm_result_type = _translate_type(inst->type(), true);
+        auto llvm_result_alloca = b.CreateAlloca(llvm_result_type, nullptr, "trace.result");
+        auto llvm_slot_type = _ray_query_slot_type();
+        auto store_slot_field = [&](uint index, llvm::Value *value) noexcept {
+            b.CreateStore(value, b.CreateStructGEP(llvm_slot_type, current.ray_query_slot, index));
+        };
+        store_slot_field(1u, llvm_mask);
+        store_slot_field(2u, llvm_accel_alloca);
+        store_slot_field(3u, llvm_ray_alloca);
+        store_slot_field(4u, llvm_result_alloca);
+        store_slot_field(5u, llvm_time);
+        store_slot_field(0u, b.getInt32(kind));
+        // the allocas live in the coroutine frame, so they stay valid while suspended
+        _suspend_coroutine(current, b, "trace.resume");
+        return b.CreateLoad(llvm_result_type, llvm_result_alloca);
+    }
+
+    [[nodiscard]] llvm::Value *_translate_trace(CurrentFunction &current, IRBuilder &b,
+                                                llvm::StringRef llvm_func_name,
+                                                api::RayQuerySlotKind kind,
+                                                const xir::Instruction *inst,
+                                                bool motion_blur = false) noexcept {
+        // traces in callables, in ray query candidates, and in kernels without batching take the scalar path
+        return current.ray_query_slot != nullptr && current.ray_query_depth == 0u ?
+                   _translate_batched_trace(current, b, kind, inst, motion_blur) :
+                   _translate_accel_access(current, b, llvm_func_name, inst);
+    }
+
+    [[nodiscard]] llvm::Value *_translate_ray_query_object(CurrentFunction &current, IRBuilder &b,
+                                                           const xir::ResourceQueryInst *inst,
+                                                           bool terminate_on_first, bool motion_blur) noexcept {
+        // operands: accel, ray, [time,] mask
+        auto llvm_accel = _lookup_value(current, b, inst->operand(0u));
+        auto llvm_accel_alloca = b.CreateAlloca(llvm_accel->getType(), nullptr, "ray_query.accel");
+        b.CreateStore(llvm_accel, llvm_accel_alloca);
+        auto llvm_ray = _lookup_value(current, b, inst->operand(1u));
+        auto llvm_ray_alloca = b.CreateAlloca(llvm_ray->getType(), nullptr, "ray_query.ray");
+        llvm_ray_alloca->setAlignment(llvm::Align{alignof(api::Ray)});
+        b.CreateStore(llvm_ray, llvm_ray_alloca);
+        auto llvm_time = motion_blur ?
+                             _lookup_value(current, b, inst->operand(2u)) :
+                             llvm::ConstantFP::get(b.getFloatTy(), 0.);
+        auto llvm_mask = b.CreateZExtOrTrunc(_lookup_value(current, b, inst->operand(motion_blur ? 3u : 2u)), b.getInt32Ty());
+        auto llvm_query_type = _translate_type(inst->type(), true);
+        auto llvm_query_alloca = b.CreateAlloca(llvm_query_type, nullptr, "ray_query.object");
+        llvm_query_alloca->setAlignment(llvm::Align{alignof(api::RayQueryObject)});
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_init_type = llvm::FunctionType::get(b.getVoidTy(),
+                                                      {llvm_ptr_type, llvm_ptr_type, llvm_ptr_type,
+                                                       b.getInt32Ty(), b.getFloatTy(), b.getInt32Ty()},
+                                                      false);
+        auto llvm_init_func = _llvm_module->getOrInsertFunction("luisa.ray.query.init", llvm_init_type);
+        auto flags = terminate_on_first ? api::RAY_QUERY_FLAG_TERMINATE_ON_FIRST_HIT : 0u;
+        b.CreateCall(llvm_init_func, {llvm_query_alloca, llvm_accel_alloca, llvm_ray_alloca,
+                                      llvm_mask, llvm_time, b.getInt32(flags)});
+        return b.CreateAlignedLoad(llvm_query_type, llvm_query_alloca, llvm::MaybeAlign{alignof(api::RayQueryObject)});
+    }
+
+    [[nodiscard]] llvm::Value *_translate_ray_query_object_read(CurrentFunction &current, IRBuilder &b,
+                                                                const xir::RayQueryObjectReadInst *inst) noexcept {
+        // the operand is the pointer to the query object, whose fields are laid out as api::RayQueryObject
+        auto llvm_query = _lookup_value(current, b, inst->operand(0u));
+        auto load_field = [&](size_t offset) noexcept -> llvm::Value * {
+            auto llvm_type = _translate_type(inst->type(), true);
+            auto llvm_ptr = b.CreateConstInBoundsGEP1_64(b.getInt8Ty(), llvm_query, offset);
+            return b.CreateAlignedLoad(llvm_type, llvm_ptr, llvm::MaybeAlign{_get_type_alignment(inst->type())});
+        };
+        auto load_uint = [&](size_t offset) noexcept -> llvm::Value * {
+            auto llvm_ptr = b.CreateConstInBoundsGEP1_64(b.getInt8Ty(), llvm_query, offset);
+            return b.CreateAlignedLoad(b.getInt32Ty(), llvm_ptr, llvm::MaybeAlign{alignof(uint)});
+        };
+        auto is_candidate_type = [&](api::RayQueryCandidateType type) noexcept -> llvm::Value * {
+            auto llvm_type = load_uint(offsetof(api::RayQueryObject, candidate_type));
+            return b.CreateZExt(b.CreateICmpEQ(llvm_type, b.getInt32(type)), b.getInt8Ty());
+        };
+        switch (inst->op()) {
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_WORLD_SPACE_RAY: return load_field(offsetof(api::RayQueryObject, ray));
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_PROCEDURAL_CANDIDATE_HIT: return load_field(offsetof(api::RayQueryObject, candidate));
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_TRIANGLE_CANDIDATE_HIT: return load_field(offsetof(api::RayQueryObject, candidate));
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_COMMITTED_HIT: return load_field(offsetof(api::RayQueryObject, committed));
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_IS_TRIANGLE_CANDIDATE: return is_candidate_type(api::RAY_QUERY_CANDIDATE_SURFACE);
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_IS_PROCEDURAL_CANDIDATE: return is_candidate_type(api::RAY_QUERY_CANDIDATE_PROCEDURAL);
+            case xir::RayQueryObjectReadOp::RAY_QUERY_OBJECT_IS_TERMINATED: {
+                auto llvm_flags = load_uint(offsetof(api::RayQueryObject, flags));
+                auto llvm_terminated = b.CreateAnd(llvm_flags, b.getInt32(api::RAY_QUERY_FLAG_TERMINATED));
+                return b.CreateZExt(b.CreateICmpNE(llvm_terminated, b.getInt32(0)), b.getInt8Ty());
+            }
+        }
+        LUISA_ERROR_WITH_LOCATION("Invalid ray query object read operation.");
+    }
+
+    [[nodiscard]] llvm::Value *_translate_ray_query_object_write(CurrentFunction &current, IRBuilder &b,
+                                                                 const xir::RayQueryObjectWriteInst *inst) noexcept {
+        auto llvm_query = _lookup_value(current, b, inst->operand(0u));
+        auto set_flag = [&](api::RayQueryFlag flag) noexcept -> llvm::Value * {
+            auto llvm_ptr = b.CreateConstInBoundsGEP1_64(b.getInt8Ty(), llvm_query, offsetof(api::RayQueryObject, flags));
+            auto llvm_flags = b.CreateAlignedLoad(b.getInt32Ty(), llvm_ptr, llvm::MaybeAlign{alignof(uint)});
+            return b.CreateAlignedStore(b.CreateOr(llvm_flags, b.getInt32(flag)), llvm_ptr, llvm::MaybeAlign{alignof(uint)});
+        };
+        switch (inst->op()) {
+            case xir::RayQueryObjectWriteOp::RAY_QUERY_OBJECT_COMMIT_TRIANGLE: return set_flag(api::RAY_QUERY_FLAG_COMMITTED);
+            case xir::RayQueryObjectWriteOp::RAY_QUERY_OBJECT_COMMIT_PROCEDURAL: {
+                // the runtime checks the committed distance against the current ray interval
+                auto llvm_t = _lookup_value(current, b, inst->operand(1u));
+                auto offset = offsetof(api::RayQueryObject, candidate) + offsetof(api::SurfaceHit, committed_ray_t);
+                auto llvm_ptr = b.CreateConstInBoundsGEP1_64(b.getInt8Ty(), llvm_query, offset);
+                b.CreateAlignedStore(llvm_t, llvm_ptr, llvm::MaybeAlign{alignof(float)});
+                return set_flag(api::RAY_QUERY_FLAG_COMMITTED);
+            }
+            case xir::RayQueryObjectWriteOp::RAY_QUERY_OBJECT_TERMINATE: return set_flag(api::RAY_QUERY_FLAG_TERMINATED);
+            case xir::RayQueryObjectWriteOp::RAY_QUERY_OBJECT_PROCEED: {
+                LUISA_ERROR_WITH_LOCATION("Ray query proceed is not supported on the fallback backend.");
+            }
+        }
+        LUISA_ERROR_WITH_LOCATION("Invalid ray query object write operation.");
+    }
+
+    [[nodiscard]] llvm::Value *_translate_ray_query_dispatch(CurrentFunction &current, IRBuilder &b,
+                                                             const xir::RayQueryDispatchInst *inst) noexcept {
+        // dispatch:
+        //   switch (luisa.ray.query.dispatch(query)) { default: exit; 1: surface; 2: procedural }
+        // the placeholder only keeps the candidate blocks in the CFG until they are
+        // outlined and the switch is replaced with luisa.ray.query.trace(query, callbacks...)
+        auto llvm_query = _lookup_value(current, b, inst->query_object());
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_placeholder_type = llvm::FunctionType::get(b.getInt32Ty(), {llvm_ptr_type}, false);
+        auto llvm_placeholder_func = _llvm_module->getOrInsertFunction("luisa.ray.query.dispatch", llvm_placeholder_type);
+        auto llvm_placeholder = b.CreateCall(llvm_placeholder_func, {llvm_query});
+        auto llvm_exit_block = _find_or_create_basic_block(current, inst->exit_block());
+        auto llvm_surface_block = _find_or_create_basic_block(current, inst->on_surface_candidate_block());
+        auto llvm_procedural_block = _find_or_create_basic_block(current, inst->on_procedural_candidate_block());
+        auto llvm_switch = b.CreateSwitch(llvm_placeholder, llvm_exit_block, 2u);
+        llvm_switch->addCase(b.getInt32(api::RAY_QUERY_CANDIDATE_SURFACE), llvm_surface_block);
+        llvm_switch->addCase(b.getInt32(api::RAY_QUERY_CANDIDATE_PROCEDURAL), llvm_procedural_block);
+        current.ray_query_depth++;
+        _translate_instructions_in_basic_block(current, llvm_surface_block, inst->on_surface_candidate_block());
+        _translate_instructions_in_basic_block(current, llvm_procedural_block, inst->on_procedural_candidate_block());
+        current.ray_query_depth--;
+        // recorded after the candidates so that nested dispatches are outlined first
+        current.ray_query_dispatches.emplace_back(CurrentFunction::RayQueryDispatch{
+            .switch_inst = llvm_switch,
+            .placeholder = llvm_placeholder,
+            .query = llvm_query,
+            .surface_block = llvm_surface_block,
+            .procedural_block = llvm_procedural_block,
+            .exit_block = llvm_exit_block,
+            .dispatch_block = _find_or_create_basic_block(current, inst->parent_block())});
+        return llvm_switch;
+    }
+
+    // outlines the blocks reachable from the candidate entry without passing the dispatch block,
+    // and returns a thunk that calls the outlined function with the inputs packed in a context
+    [[nodiscard]] std::pair<llvm::Value *, llvm::Value *> _outline_ray_query_candidate(CurrentFunction &current, IRBuilder &b,
+                                                                                       llvm::BasicBlock *llvm_entry_block,
+                                                                                       llvm::BasicBlock *llvm_dispatch_block) noexcept {
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_null = llvm::ConstantPointerNull::get(llvm_ptr_type);
+        // empty candidate blocks commit nothing, so they need no callback
+        if (llvm_entry_block->size() == 1u && llvm::isa<llvm::BranchInst>(llvm_entry_block->front())) {
+            return std::make_pair(llvm_null, llvm_null);
+        }
+        llvm::SmallVector<llvm::BasicBlock *, 16u> llvm_blocks{llvm_entry_block};
+        llvm::SmallPtrSet<llvm::BasicBlock *, 16u> visited{llvm_entry_block, llvm_dispatch_block};
+        for (auto i = 0u; i < llvm_blocks.size(); i++) {
+            for (auto llvm_succ : llvm::successors(llvm_blocks[i])) {
+                if (visited.insert(llvm_succ).second) { llvm_blocks.emplace_back(llvm_succ); }
+            }
+        }
+        llvm::CodeExtractor extractor{llvm_blocks, nullptr, false, nullptr, nullptr, nullptr, false, true};
+        LUISA_ASSERT(extractor.isEligible(), "Ray query candidate blocks cannot be outlined.");
+        llvm::SetVector<llvm::Value *> llvm_inputs, llvm_outputs, llvm_allocas;
+        extractor.findInputsOutputs(llvm_inputs, llvm_outputs, llvm_allocas);
+        LUISA_ASSERT(llvm_outputs.empty(), "Ray query candidate blocks should not define values used outside.");
+        llvm::CodeExtractorAnalysisCache cache{*current.func};
+        auto llvm_callee = extractor.extractCodeRegion(cache);
+        LUISA_ASSERT(llvm_callee != nullptr && llvm_callee->hasOneUse(), "Failed to outline ray query candidate blocks.");
+        // the callbacks run inside the traversal and never suspend
+        llvm_callee->removeFnAttr(llvm::Attribute::PresplitCoroutine);
+        auto llvm_call = llvm::cast<llvm::CallInst>(llvm_callee->user_back());
+        // pack the inputs before the dispatch; the call site becomes unreachable once the switch is replaced
+        llvm::SmallVector<llvm::Type *, 16u> llvm_ctx_field_types;
+        for (auto &&llvm_arg : llvm_call->args()) { llvm_ctx_field_types.emplace_back(llvm_arg->getType()); }
+        auto llvm_ctx_type = llvm::StructType::get(_llvm_context, llvm_ctx_field_types);
+        auto &llvm_func_entry = current.func->getEntryBlock();
+        IRBuilder b_entry{&llvm_func_entry, llvm_func_entry.begin()};
+        auto llvm_ctx = b_entry.CreateAlloca(llvm_ctx_type, nullptr, "ray_query.ctx");
+        for (auto i = 0u; i < llvm_call->arg_size(); i++) {
+            b.CreateStore(llvm_call->getArgOperand(i), b.CreateStructGEP(llvm_ctx_type, llvm_ctx, i));
+        }
+        auto llvm_thunk_type = llvm::FunctionType::get(b.getVoidTy(), {llvm_ptr_type}, false);
+        auto llvm_thunk = llvm::Function::Create(llvm_thunk_type, llvm::Function::PrivateLinkage,
+                                                 llvm::Twine{llvm_callee->getName()}.concat(".thunk"), _llvm_module);
+        IRBuilder b_thunk{llvm::BasicBlock::Create(_llvm_context, "entry", llvm_thunk)};
+        llvm::SmallVector<llvm::Value *, 16u> llvm_args;
+        for (auto i = 0u; i < llvm_ctx_field_types.size(); i++) {
+            auto llvm_field = b_thunk.CreateStructGEP(llvm_ctx_type, llvm_thunk->getArg(0), i);
+            llvm_args.emplace_back(b_thunk.CreateLoad(llvm_ctx_field_types[i], llvm_field));
+        }
+        auto llvm_thunk_call = b_thunk.CreateCall(llvm_callee, llvm_args);
+        llvm_thunk_call->setCallingConv(llvm_callee->getCallingConv());
+        b_thunk.CreateRetVoid();
+        return std::make_pair(llvm_thunk, llvm_ctx);
+    }
+
+    void _outline_ray_query_dispatches(CurrentFunction &current) noexcept {
+        if (current.ray_query_dispatches.empty()) { return; }
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_void_type = llvm::Type::getVoidTy(_llvm_context);
+        auto llvm_trace_type = llvm::FunctionType::get(llvm_void_type,
+                                                       {llvm_ptr_type, llvm_ptr_type, llvm_ptr_type, llvm_ptr_type, llvm_ptr_type},
+                                                       false);
+        auto llvm_trace_func = _llvm_module->getOrInsertFunction("luisa.ray.query.trace", llvm_trace_type);
+        for (auto &&d : current.ray_query_dispatches) {
+            IRBuilder b{d.switch_inst};
+            auto [llvm_surface_thunk, llvm_surface_ctx] = _outline_ray_query_candidate(current, b, d.surface_block, d.dispatch_block);
+            auto [llvm_procedural_thunk, llvm_procedural_ctx] = _outline_ray_query_candidate(current, b, d.procedural_block, d.dispatch_block);
+            b.CreateCall(llvm_trace_func, {d.query, llvm_surface_thunk, llvm_surface_ctx, llvm_procedural_thunk, llvm_procedural_ctx});
+            b.CreateBr(d.exit_block);
+            d.switch_inst->eraseFromParent();
+            d.placeholder->eraseFromParent();
+            // drop the call sites of the outlined candidates
+            llvm::EliminateUnreachableBlocks(*current.func);
+        }
+        current.ray_query_dispatches.clear();
+        if (auto llvm_placeholder_func = _llvm_module->getFunction("luisa.ray.query.dispatch");
+            llvm_placeholder_func != nullptr && llvm_placeholder_func->use_empty()) {
+            llvm_placeholder_func->eraseFromParent();
+        }
+    }
+
     [[nodiscard]] llvm::Value *_translate_atomic_op(CurrentFunction &current, IRBuilder &b,
                                                     const char *op_name, const xir::AtomicInst *inst,
                                                     bool byte_address = false) noexcept {
@@ -2372,16 +2707,16 @@ private:
             case xir::ResourceQueryOp::RAY_TRACING_INSTANCE_TRANSFORM: return _translate_accel_access(current, b, "luisa.accel.instance.transform", inst);
             case xir::ResourceQueryOp::RAY_TRACING_INSTANCE_USER_ID: return _translate_accel_access(current, b, "luisa.accel.instance.user.id", inst);
             case xir::ResourceQueryOp::RAY_TRACING_INSTANCE_VISIBILITY_MASK: return _translate_accel_access(current, b, "luisa.accel.instance.visibility.mask", inst);
-            case xir::ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST: return _translate_accel_access(current, b, "luisa.accel.trace.closest", inst);
-            case xir::ResourceQueryOp::RAY_TRACING_TRACE_ANY: return _translate_accel_access(current, b, "luisa.accel.trace.any", inst);
+            case xir::ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST: return _translate_trace(current, b, "luisa.accel.trace.closest", api::RAY_QUERY_SLOT_TRACE_CLOSEST, inst);
+            case xir::ResourceQueryOp::RAY_TRACING_TRACE_ANY: return _translate_trace(current, b, "luisa.accel.trace.any", api::RAY_QUERY_SLOT_TRACE_ANY, inst);
             case xir::ResourceQueryOp::RAY_TRACING_INSTANCE_MOTION_MATRIX: return _translate_accel_access(current, b, "luisa.accel.instance.motion.matrix", inst);
             case xir::ResourceQueryOp::RAY_TRACING_INSTANCE_MOTION_SRT: return _translate_accel_access(current, b, "luisa.accel.instance.motion.srt", inst);
-            case xir::ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST_MOTION_BLUR: return _translate_accel_access(current, b, "luisa.accel.trace.closest.motion", inst);
-            case xir::ResourceQueryOp::RAY_TRACING_TRACE_ANY_MOTION_BLUR: return _translate_accel_access(current, b, "luisa.accel.trace.any.motion", inst);
-            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ALL: break;
-            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ANY: break;
-            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ALL_MOTION_BLUR: break;
-            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ANY_MOTION_BLUR: break;
+            case xir::ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST_MOTION_BLUR: return _translate_trace(current, b, "luisa.accel.trace.closest.motion", api::RAY_QUERY_SLOT_TRACE_CLOSEST, inst, true);
+            case xir::ResourceQueryOp::RAY_TRACING_TRACE_ANY_MOTION_BLUR: return _translate_trace(current, b, "luisa.accel.trace.any.motion", api::RAY_QUERY_SLOT_TRACE_ANY, inst, true);
+            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ALL: return _translate_ray_query_object(current, b, inst, false, false);
+            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ANY: return _translate_ray_query_object(current, b, inst, true, false);
+            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ALL_MOTION_BLUR: return _translate_ray_query_object(current, b, inst, false, true);
+            case xir::ResourceQueryOp::RAY_TRACING_QUERY_ANY_MOTION_BLUR: return _translate_ray_query_object(current, b, inst, true, true);
         }
         LUISA_ERROR_WITH_LOCATION("Unexpected resource query operation: {}.", xir::to_string(inst->op()));
     }
@@ -2566,14 +2901,51 @@ private:
         return llvm_call;
     }
 
+    void _suspend_coroutine(CurrentFunction &current, IRBuilder &b, llvm::StringRef resume_block_name) noexcept {
+        // suspend the thread and return to the kernel wrapper:
+        // 0 - resumed by the kernel wrapper, 1 - destroyed, default - suspended
+        auto llvm_state = b.CreateIntrinsic(llvm::Intrinsic::coro_suspend, {},
+                                            {llvm::ConstantTokenNone::get(_llvm_context), b.getFalse()});
+        auto llvm_resume_block = llvm::BasicBlock::Create(_llvm_context, resume_block_name, current.func);
+        auto llvm_switch = b.CreateSwitch(llvm_state, current.coro_suspend_block, 2u);
+        llvm_switch->addCase(b.getInt8(0), llvm_resume_block);
+        llvm_switch->addCase(b.getInt8(1), current.coro_cleanup_block);
+        // the following instructions go to the resume block
+        b.SetInsertPoint(llvm_resume_block);
+    }
+
+    [[nodiscard]] llvm::Value *_translate_synchronize_block(CurrentFunction &current, IRBuilder &b) noexcept {
+        // callables that synchronize are inlined into the kernel, and rejected by _translate_callable_function otherwise
+        if (current.ray_query_depth != 0u) {
+            LUISA_ERROR_WITH_LOCATION("Block synchronization in ray query candidate "
+                                      "callbacks is not supported on the fallback backend.");
+        }
+        LUISA_ASSERT(current.coro_handle != nullptr, "Block synchronization outside coroutine kernels.");
+        // suspend the thread until all threads in the block reach the barrier
+        _suspend_coroutine(current, b, "block.sync.resume");
+        return nullptr;
+    }
+
     [[nodiscard]] llvm::Value *_translate_thread_group_inst(CurrentFunction &current, IRBuilder &b,
                                                             const xir::ThreadGroupInst *inst) noexcept {
-        if (inst->op() == xir::ThreadGroupOp::SHADER_EXECUTION_REORDER) {
-            return nullptr;
+        switch (inst->op()) {
+            case xir::ThreadGroupOp::SHADER_EXECUTION_REORDER: return nullptr;
+            case xir::ThreadGroupOp::SYNCHRONIZE_BLOCK: return _translate_synchronize_block(current, b);
+            default: break;
         }
         LUISA_NOT_IMPLEMENTED();
     }
 
+    [[nodiscard]] llvm::Value *_translate_shared_alloca(CurrentFunction &current, IRBuilder &b,
+                                                        const xir::AllocaInst *inst) noexcept {
+        LUISA_ASSERT(current.shared_memory != nullptr, "Shared variables are only allowed in kernels.");
+        auto alignment = _get_type_alignment(inst->type());
+        LUISA_ASSERT(alignment <= shared_memory_alignment, "Invalid shared variable alignment.");
+        auto offset = luisa::align(current.shared_memory_size, alignment);
+        current.shared_memory_size = offset + _get_type_size(inst->type());
+        return b.CreateConstInBoundsGEP1_64(b.getInt8Ty(), current.shared_memory, offset);
+    }
+
     [[nodiscard]] llvm::Value *_translate_instruction(CurrentFunction &current, IRBuilder &b,
                                                       const xir::Instruction *inst) noexcept {
         switch (inst->derived_instruction_tag()) {
@@ -2659,17 +3031,33 @@ private:
             }
             case xir::DerivedInstructionTag::RETURN: {
                 auto return_inst = static_cast<const xir::ReturnInst *>(inst);
+                LUISA_ASSERT(current.ray_query_depth == 0u,
+                             "Returning from ray query candidates is not supported on the fallback backend.");
                 if (auto ret_val = return_inst->return_value()) {
                     auto llvm_ret_val = _lookup_value(current, b, ret_val);
                     return b.CreateRet(llvm_ret_val);
                 }
+                // coroutine kernels return their handle after the final suspension
+                if (current.coro_handle != nullptr) {
+                    return b.CreateBr(current.coro_final_block);
+                }
                 return b.CreateRetVoid();
             }
             case xir::DerivedInstructionTag::RASTER_DISCARD: LUISA_NOT_IMPLEMENTED();
             case xir::DerivedInstructionTag::PHI: {
-                LUISA_ERROR_WITH_LOCATION("Unexpected phi instruction. Please run reg2mem pass first.");
+                auto phi_inst = static_cast<const xir::PhiInst *>(inst);
+                LUISA_ASSERT(b.GetInsertBlock()->empty() || llvm::isa<llvm::PHINode>(b.GetInsertBlock()->back()),
+                             "Phi instructions must be at the beginning of the basic block.");
+                auto llvm_type = _translate_type(phi_inst->type(), true);
+                auto llvm_phi = b.CreatePHI(llvm_type, phi_inst->incoming_count());
+                current.phi_nodes.emplace_back(phi_inst, llvm_phi);
+                return llvm_phi;
             }
             case xir::DerivedInstructionTag::ALLOCA: {
+                auto alloca_inst = static_cast<const xir::AllocaInst *>(inst);
+                if (alloca_inst->space() == xir::AllocSpace::SHARED) {
+                    return _translate_shared_alloca(current, b, alloca_inst);
+                }
                 auto llvm_type = _translate_type(inst->type(), false);
                 auto llvm_inst = b.CreateAlloca(llvm_type);
                 auto alignment = _get_type_alignment(inst->type());
@@ -2796,10 +3184,27 @@ private:
                 }
                 LUISA_ERROR_WITH_LOCATION("Invalid atomic operation.");
             }
-            case xir::DerivedInstructionTag::RAY_QUERY_LOOP: LUISA_NOT_IMPLEMENTED();
-            case xir::DerivedInstructionTag::RAY_QUERY_DISPATCH: LUISA_NOT_IMPLEMENTED();
-            case xir::DerivedInstructionTag::RAY_QUERY_OBJECT_READ: LUISA_NOT_IMPLEMENTED();
-            case xir::DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: LUISA_NOT_IMPLEMENTED();
+            case xir::DerivedInstructionTag::RAY_QUERY_LOOP: {
+                auto loop_inst = static_cast<const xir::RayQueryLoopInst *>(inst);
+                auto llvm_dispatch_block = _find_or_create_basic_block(current, loop_inst->dispatch_block());
+                auto llvm_merge_block = _find_or_create_basic_block(current, loop_inst->merge_block());
+                auto llvm_inst = b.CreateBr(llvm_dispatch_block);
+                _translate_instructions_in_basic_block(current, llvm_dispatch_block, loop_inst->dispatch_block());
+                _translate_instructions_in_basic_block(current, llvm_merge_block, loop_inst->merge_block());
+                return llvm_inst;
+            }
+            case xir::DerivedInstructionTag::RAY_QUERY_DISPATCH: {
+                auto dispatch_inst = static_cast<const xir::RayQueryDispatchInst *>(inst);
+                return _translate_ray_query_dispatch(current, b, dispatch_inst);
+            }
+            case xir::DerivedInstructionTag::RAY_QUERY_OBJECT_READ: {
+                auto read_inst = static_cast<const xir::RayQueryObjectReadInst *>(inst);
+                return _translate_ray_query_object_read(current, b, read_inst);
+            }
+            case xir::DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: {
+                auto write_inst = static_cast<const xir::RayQueryObjectWriteInst *>(inst);
+                return _translate_ray_query_object_write(current, b, write_inst);
+            }
         }
         LUISA_ERROR_WITH_LOCATION("Invalid instruction.");
     }
@@ -2816,8 +3221,10 @@ private:
     void _translate_instructions_in_basic_block(CurrentFunction &current, llvm::BasicBlock *llvm_bb, const xir::BasicBlock *bb) noexcept {
         if (bb == nullptr) { return; }
         if (current.translated_basic_blocks.emplace(llvm_bb).second) {
+            // note: instructions may move the insertion point, e.g.,
+            // block barriers split the basic block at the suspension
+            IRBuilder b{llvm_bb};
             for (auto &inst : bb->instructions()) {
-                IRBuilder b{llvm_bb};
                 auto llvm_value = _translate_instruction(current, b, &inst);
                 auto [_, success] = current.value_map.emplace(&inst, llvm_value);
                 LUISA_ASSERT(success, "Instruction already translated.");
@@ -2825,12 +3232,241 @@ private:
         }
     }
 
+    void _resolve_phi_nodes(CurrentFunction &current) noexcept {
+        llvm::SmallDenseMap<llvm::BasicBlock *, llvm::Value *, 8u> llvm_incomings;
+        for (auto [phi_inst, llvm_phi] : current.phi_nodes) {
+            llvm_incomings.clear();
+            for (auto i = 0u; i < phi_inst->incoming_count(); i++) {
+                auto incoming = phi_inst->incoming(i);
+                // the incoming block may have been split during translation, so we
+                // take the LLVM block that finally holds the translated terminator
+                auto iter = current.value_map.find(incoming.block->terminator());
+                LUISA_ASSERT(iter != current.value_map.end(), "Incoming block not translated.");
+                auto llvm_terminator = llvm::cast<llvm::Instruction>(iter->second);
+                IRBuilder b{llvm_terminator};
+                auto llvm_value = _lookup_value(current, b, incoming.value);
+                llvm_incomings.try_emplace(llvm_terminator->getParent(), llvm_value);
+            }
+            // blocks unreachable in XIR are still translated and may branch here
+            auto llvm_undef = llvm::UndefValue::get(llvm_phi->getType());
+            for (auto llvm_pred : llvm::predecessors(llvm_phi->getParent())) {
+                auto iter = llvm_incomings.find(llvm_pred);
+                llvm_phi->addIncoming(iter != llvm_incomings.end() ? iter->second : llvm_undef, llvm_pred);
+            }
+        }
+        current.phi_nodes.clear();
+    }
+
     [[nodiscard]] llvm::BasicBlock *_translate_basic_block(CurrentFunction &current, const xir::BasicBlock *bb) noexcept {
         auto llvm_bb = _find_or_create_basic_block(current, bb);
         _translate_instructions_in_basic_block(current, llvm_bb, bb);
         return llvm_bb;
     }
 
+    [[nodiscard]] static bool _uses_block_synchronization(const xir::FunctionDefinition *f) noexcept {
+        auto uses = false;
+        f->traverse_instructions([&uses](const xir::Instruction *inst) noexcept {
+            if (inst->derived_instruction_tag() == xir::DerivedInstructionTag::THREAD_GROUP) {
+                auto cta_inst = static_cast<const xir::ThreadGroupInst *>(inst);
+                uses |= cta_inst->op() == xir::ThreadGroupOp::SYNCHRONIZE_BLOCK;
+            }
+        });
+        return uses;
+    }
+
+    [[nodiscard]] static bool _uses_ray_tracing(const xir::FunctionDefinition *f) noexcept {
+        auto uses = false;
+        f->traverse_instructions([&uses](const xir::Instruction *inst) noexcept {
+            if (inst->derived_instruction_tag() == xir::DerivedInstructionTag::RESOURCE_QUERY) {
+                auto op = static_cast<const xir::ResourceQueryInst *>(inst)->op();
+                uses |= op == xir::ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST ||
+                        op == xir::ResourceQueryOp::RAY_TRACING_TRACE_ANY ||
+                        op == xir::ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST_MOTION_BLUR ||
+                        op == xir::ResourceQueryOp::RAY_TRACING_TRACE_ANY_MOTION_BLUR;
+            }
+        });
+        return uses;
+    }
+
+    void _begin_coroutine(CurrentFunction &current) noexcept {
+        // coroutine prologue (switched-resume lowering):
+        // coro.entry:
+        //   id = coro.id(align, null, null, null);
+        //   br coro.alloc(id), coro.alloc, coro.begin;
+        // coro.alloc:
+        //   mem = luisa.coro.alloc(coro.size());
+        //   br coro.begin;
+        // coro.begin:
+        //   handle = coro.begin(id, phi(null, mem));
+        //   br body; /* emitted by _end_coroutine */
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_null = llvm::ConstantPointerNull::get(llvm_ptr_type);
+        auto llvm_entry_block = llvm::BasicBlock::Create(_llvm_context, "coro.entry", current.func);
+        auto llvm_alloc_block = llvm::BasicBlock::Create(_llvm_context, "coro.alloc", current.func);
+        auto llvm_begin_block = llvm::BasicBlock::Create(_llvm_context, "coro.begin", current.func);
+        IRBuilder b{llvm_entry_block};
+        auto llvm_coro_id = b.CreateIntrinsic(llvm::Intrinsic::coro_id, {},
+                                              {b.getInt32(shared_memory_alignment), llvm_null, llvm_null, llvm_null});
+        auto llvm_need_alloc = b.CreateIntrinsic(llvm::Intrinsic::coro_alloc, {}, {llvm_coro_id});
+        b.CreateCondBr(llvm_need_alloc, llvm_alloc_block, llvm_begin_block);
+        b.SetInsertPoint(llvm_alloc_block);
+        auto llvm_frame_size = b.CreateIntrinsic(llvm::Intrinsic::coro_size, {b.getInt64Ty()}, {});
+        auto llvm_alloc_type = llvm::FunctionType::get(llvm_ptr_type, {b.getInt64Ty()}, false);
+        auto llvm_alloc_func = _llvm_module->getOrInsertFunction("luisa.coro.alloc", llvm_alloc_type);
+        auto llvm_frame_alloc = b.CreateCall(llvm_alloc_func, {llvm_frame_size});
+        b.CreateBr(llvm_begin_block);
+        b.SetInsertPoint(llvm_begin_block);
+        auto llvm_frame = b.CreatePHI(llvm_ptr_type, 2u, "coro.frame");
+        llvm_frame->addIncoming(llvm_null, llvm_entry_block);
+        llvm_frame->addIncoming(llvm_frame_alloc, llvm_alloc_block);
+        current.coro_id = llvm_coro_id;
+        current.coro_handle = b.CreateIntrinsic(llvm::Intrinsic::coro_begin, {}, {llvm_coro_id, llvm_frame});
+        current.coro_handle->setName("coro.handle");
+        current.coro_begin_block = llvm_begin_block;
+        // the exit blocks are referenced by barriers and returns in the body,
+        // and are inserted into the function after the body is translated
+        current.coro_final_block = llvm::BasicBlock::Create(_llvm_context, "coro.final");
+        current.coro_cleanup_block = llvm::BasicBlock::Create(_llvm_context, "coro.cleanup");
+        current.coro_suspend_block = llvm::BasicBlock::Create(_llvm_context, "coro.suspend");
+    }
+
+    void _end_coroutine(CurrentFunction &current, llvm::BasicBlock *llvm_body_block) noexcept {
+        // coroutine epilogue:
+        // coro.final:
+        //   switch coro.suspend(none, final=true), coro.suspend [0: unreachable, 1: coro.cleanup];
+        // coro.cleanup:
+        //   mem = coro.free(id, handle);
+        //   if (mem != null) { luisa.coro.free(mem); }
+        //   br coro.suspend;
+        // coro.suspend:
+        //   coro.end(handle);
+        //   ret handle;
+        IRBuilder b{current.coro_begin_block};
+        b.CreateBr(llvm_body_block);
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto llvm_token_none = llvm::ConstantTokenNone::get(_llvm_context);
+        // final suspension
+        current.coro_final_block->insertInto(current.func);
+        b.SetInsertPoint(current.coro_final_block);
+        auto llvm_final_state = b.CreateIntrinsic(llvm::Intrinsic::coro_suspend, {}, {llvm_token_none, b.getTrue()});
+        auto llvm_final_resume_block = llvm::BasicBlock::Create(_llvm_context, "coro.final.resume", current.func);
+        auto llvm_final_switch = b.CreateSwitch(llvm_final_state, current.coro_suspend_block, 2u);
+        llvm_final_switch->addCase(b.getInt8(0), llvm_final_resume_block);
+        llvm_final_switch->addCase(b.getInt8(1), current.coro_cleanup_block);
+        // resuming a coroutine suspended at the final point is undefined
+        b.SetInsertPoint(llvm_final_resume_block);
+        b.CreateUnreachable();
+        // cleanup
+        current.coro_cleanup_block->insertInto(current.func);
+        b.SetInsertPoint(current.coro_cleanup_block);
+        auto llvm_frame = b.CreateIntrinsic(llvm::Intrinsic::coro_free, {}, {current.coro_id, current.coro_handle});
+        auto llvm_free_block = llvm::BasicBlock::Create(_llvm_context, "coro.free", current.func);
+        b.CreateCondBr(b.CreateIsNotNull(llvm_frame), llvm_free_block, current.coro_suspend_block);
+        b.SetInsertPoint(llvm_free_block);
+        auto llvm_free_type = llvm::FunctionType::get(b.getVoidTy(), {llvm_ptr_type}, false);
+        auto llvm_free_func = _llvm_module->getOrInsertFunction("luisa.coro.free", llvm_free_type);
+        b.CreateCall(llvm_free_func, {llvm_frame});
+        b.CreateBr(current.coro_suspend_block);
+        // suspend or return to the caller
+        current.coro_suspend_block->insertInto(current.func);
+        b.SetInsertPoint(current.coro_suspend_block);
+#if LLVM_VERSION_MAJOR >= 18
+        b.CreateIntrinsic(llvm::Intrinsic::coro_end, {}, {current.coro_handle, b.getFalse(), llvm_token_none});
+#else
+        b.CreateIntrinsic(llvm::Intrinsic::coro_end, {}, {current.coro_handle, b.getFalse()});
+#endif
+        b.CreateRet(current.coro_handle);
+    }
+
+    void _schedule_coroutines(IRBuilder &b, llvm::Value *llvm_thread_count,
+                              llvm::Value *llvm_handles, llvm::Value *llvm_resumed_ptr,
+                              llvm::Value *llvm_ray_query_slots) noexcept {
+        // round:
+        //   /* only if the kernel batches ray queries */
+        //   if (luisa.accel.trace.batch(slots, threads) != 0) {
+        //     for (i in threads) { if (slots[i].kind != 0) { slots[i].kind = 0; coro.resume(h[i]); } }
+        //     br round;
+        //   }
+        //   resumed = false;
+        //   for (i in threads) { if (h[i] && !coro.done(h[i])) { coro.resume(h[i]); resumed = true; } }
+        //   if (resumed) { br round; }
+        //   for (i in threads) { if (h[i]) { coro.destroy(h[i]); } }
+        auto llvm_func = b.GetInsertBlock()->getParent();
+        auto llvm_ptr_type = llvm::PointerType::get(_llvm_context, 0);
+        auto for_each_thread = [&](const char *name, auto &&body) noexcept {
+            auto llvm_pre_block = b.GetInsertBlock();
+            auto llvm_head_block = llvm::BasicBlock::Create(_llvm_context, llvm::Twine{name}.concat(".head"), llvm_func);
+            b.CreateBr(llvm_head_block);
+            b.SetInsertPoint(llvm_head_block);
+            auto llvm_i = b.CreatePHI(b.getInt32Ty(), 2u, llvm::Twine{name}.concat(".i"));
+            llvm_i->addIncoming(b.getInt32(0), llvm_pre_block);
+            auto llvm_handle_ptr = b.CreateInBoundsGEP(llvm_ptr_type, llvm_handles, llvm_i);
+            auto llvm_handle = b.CreateLoad(llvm_ptr_type, llvm_handle_ptr);
+            auto llvm_next_block = llvm::BasicBlock::Create(_llvm_context, llvm::Twine{name}.concat(".next"), llvm_func);
+            body(llvm_i, llvm_handle, llvm_next_block);
+            b.SetInsertPoint(llvm_next_block);
+            auto llvm_next_i = b.CreateNUWAdd(llvm_i, b.getInt32(1));
+            llvm_i->addIncoming(llvm_next_i, llvm_next_block);
+            auto llvm_exit_block = llvm::BasicBlock::Create(_llvm_context, llvm::Twine{name}.concat(".exit"), llvm_func);
+            b.CreateCondBr(b.CreateICmpULT(llvm_next_i, llvm_thread_count), llvm_head_block, llvm_exit_block);
+            b.SetInsertPoint(llvm_exit_block);
+        };
+        // resume the threads round by round until all of them are done
+        auto llvm_round_block = llvm::BasicBlock::Create(_llvm_context, "coro.round", llvm_func);
+        b.CreateBr(llvm_round_block);
+        b.SetInsertPoint(llvm_round_block);
+        // pending ray queries are served first, so barriers are only
+        // released once every thread is waiting at one
+        if (llvm_ray_query_slots != nullptr) {
+            auto llvm_slot_type = _ray_query_slot_type();
+            auto llvm_batch_type = llvm::FunctionType::get(b.getInt32Ty(), {llvm_ptr_type, b.getInt32Ty()}, false);
+            auto llvm_batch_func = _llvm_module->getOrInsertFunction("luisa.accel.trace.batch", llvm_batch_type);
+            auto llvm_served = b.CreateCall(llvm_batch_func, {llvm_ray_query_slots, llvm_thread_count}, "trace.served");
+            auto llvm_trace_block = llvm::BasicBlock::Create(_llvm_context, "coro.trace", llvm_func);
+            auto llvm_sync_block = llvm::BasicBlock::Create(_llvm_context, "coro.sync", llvm_func);
+            b.CreateCondBr(b.CreateICmpNE(llvm_served, b.getInt32(0)), llvm_trace_block, llvm_sync_block);
+            b.SetInsertPoint(llvm_trace_block);
+            for_each_thread("coro.trace", [&](llvm::Value *llvm_i, llvm::Value *llvm_handle, llvm::BasicBlock *llvm_next_block) noexcept {
+                auto llvm_slot = b.CreateInBoundsGEP(llvm_slot_type, llvm_ray_query_slots, llvm_i);
+                auto llvm_kind_ptr = b.CreateStructGEP(llvm_slot_type, llvm_slot, 0u);
+                auto llvm_kind = b.CreateLoad(b.getInt32Ty(), llvm_kind_ptr);
+                auto llvm_resume_block = llvm::BasicBlock::Create(_llvm_context, "coro.trace.thread", llvm_func);
+                b.CreateCondBr(b.CreateICmpNE(llvm_kind, b.getInt32(api::RAY_QUERY_SLOT_NONE)), llvm_resume_block, llvm_next_block);
+                b.SetInsertPoint(llvm_resume_block);
+                b.CreateStore(b.getInt32(api::RAY_QUERY_SLOT_NONE), llvm_kind_ptr);
+                b.CreateIntrinsic(llvm::Intrinsic::coro_resume, {}, {llvm_handle});
+                b.CreateBr(llvm_next_block);
+            });
+            b.CreateBr(llvm_round_block);
+            b.SetInsertPoint(llvm_sync_block);
+        }
+        b.CreateStore(b.getFalse(), llvm_resumed_ptr);
+        for_each_thread("coro.resume", [&](llvm::Value *, llvm::Value *llvm_handle, llvm::BasicBlock *llvm_next_block) noexcept {
+            auto llvm_check_block = llvm::BasicBlock::Create(_llvm_context, "coro.resume.check", llvm_func);
+            auto llvm_resume_block = llvm::BasicBlock::Create(_llvm_context, "coro.resume.thread", llvm_func);
+            b.CreateCondBr(b.CreateIsNotNull(llvm_handle), llvm_check_block, llvm_next_block);
+            b.SetInsertPoint(llvm_check_block);
+            auto llvm_done = b.CreateIntrinsic(llvm::Intrinsic::coro_done, {}, {llvm_handle});
+            b.CreateCondBr(llvm_done, llvm_next_block, llvm_resume_block);
+            b.SetInsertPoint(llvm_resume_block);
+            b.CreateIntrinsic(llvm::Intrinsic::coro_resume, {}, {llvm_handle});
+            b.CreateStore(b.getTrue(), llvm_resumed_ptr);
+            b.CreateBr(llvm_next_block);
+        });
+        auto llvm_resumed = b.CreateLoad(b.getInt1Ty(), llvm_resumed_ptr, "coro.resumed");
+        auto llvm_destroy_block = llvm::BasicBlock::Create(_llvm_context, "coro.destroy", llvm_func);
+        b.CreateCondBr(llvm_resumed, llvm_round_block, llvm_destroy_block);
+        // release the coroutine frames
+        b.SetInsertPoint(llvm_destroy_block);
+        for_each_thread("coro.destroy", [&](llvm::Value *, llvm::Value *llvm_handle, llvm::BasicBlock *llvm_next_block) noexcept {
+            auto llvm_destroy_thread_block = llvm::BasicBlock::Create(_llvm_context, "coro.destroy.thread", llvm_func);
+            b.CreateCondBr(b.CreateIsNotNull(llvm_handle), llvm_destroy_thread_block, llvm_next_block);
+            b.SetInsertPoint(llvm_destroy_thread_block);
+            b.CreateIntrinsic(llvm::Intrinsic::coro_destroy, {}, {llvm_handle});
+            b.CreateBr(llvm_next_block);
+        });
+    }
+
     [[nodiscard]] llvm::Function *_translate_kernel_function(const xir::KernelFunction *f) noexcept {
         // create a wrapper function for the kernel with the following template:
         // struct Params { params... };
@@ -2867,9 +3503,21 @@ private:
         //   br next_i < thread_count, loop, merge;
         // merge:
         //   ret;
+        //
+        // The block-shared storage is allocated in the entry block and passed to
+        // every thread. If the kernel synchronizes the block, it is a coroutine:
+        // the loop body only starts the thread and records its handle, and the
+        // merge block keeps resuming all threads in rounds, one barrier at a time,
+        // until every thread has finished, and finally destroys the coroutines.
 
         // create the kernel function
         auto llvm_kernel = _translate_function_definition(f, llvm::Function::PrivateLinkage, "kernel");
+        auto is_coroutine = llvm_kernel->isPresplitCoroutine();
+        // the vectorization hints only help if the kernel body is inlined into the thread loop;
+        // coroutine kernels are resumed one thread at a time and cannot be vectorized anyway
+        if (_config.simd_lane_count > 1u && !is_coroutine) {
+            llvm_kernel->addFnAttr(llvm::Attribute::AlwaysInline);
+        }
 
         // create the wrapper function
         auto llvm_void_type = llvm::Type::getVoidTy(_llvm_context);
@@ -2971,6 +3619,26 @@ private:
         }
         auto llvm_thread_count = b.CreateNUWMul(llvm_block_size_x, llvm_block_size_y, "thread_count");
         llvm_thread_count = b.CreateNUWMul(llvm_thread_count, llvm_block_size_z);
+        // block-shared storage
+        auto llvm_shared_memory = llvm::cast<llvm::Value>(llvm::ConstantPointerNull::get(llvm_ptr_type));
+        if (_kernel_shared_memory_size != 0u) {
+            auto llvm_shared_memory_type = llvm::ArrayType::get(llvm_i8_type, _kernel_shared_memory_size);
+            auto llvm_shared_memory_alloca = b.CreateAlloca(llvm_shared_memory_type, nullptr, "shared_memory");
+            llvm_shared_memory_alloca->setAlignment(llvm::Align{shared_memory_alignment});
+            llvm_shared_memory = llvm_shared_memory_alloca;
+        }
+        // coroutine handles of the threads in the block
+        llvm::Value *llvm_coro_handles = nullptr;
+        llvm::Value *llvm_coro_resumed_ptr = nullptr;
+        if (is_coroutine) {
+            llvm_coro_handles = b.CreateAlloca(llvm_ptr_type, llvm_thread_count, "coro.handles");
+            llvm_coro_resumed_ptr = b.CreateAlloca(b.getInt1Ty(), nullptr, "coro.resumed.ptr");
+        }
+        // ray query slots of the threads in the block
+        llvm::Value *llvm_ray_query_slots = nullptr;
+        if (_kernel_batches_ray_queries) {
+            llvm_ray_query_slots = b.CreateAlloca(_ray_query_slot_type(), llvm_thread_count, "ray_query.slots");
+        }
         // thread-in-block loop
         auto llvm_ptr_i = b.CreateAlloca(llvm_i32_type, nullptr, "loop.i.ptr");
         b.CreateStore(b.getInt32(0), llvm_ptr_i);
@@ -2989,6 +3657,18 @@ private:
         llvm_thread_id = b.CreateInsertElement(llvm_thread_id, llvm_thread_id_y, static_cast<uint64_t>(1));
         llvm_thread_id = b.CreateInsertElement(llvm_thread_id, llvm_thread_id_z, static_cast<uint64_t>(2));
         llvm_thread_id->setName("thread_id");
+        // out-of-range threads are never started
+        llvm::Value *llvm_coro_handle_ptr = nullptr;
+        if (is_coroutine) {
+            llvm_coro_handle_ptr = b.CreateInBoundsGEP(llvm_ptr_type, llvm_coro_handles, llvm_i, "coro.handle.ptr");
+            b.CreateStore(llvm::ConstantPointerNull::get(llvm_ptr_type), llvm_coro_handle_ptr);
+        }
+        llvm::Value *llvm_ray_query_slot = llvm::ConstantPointerNull::get(llvm_ptr_type);
+        if (_kernel_batches_ray_queries) {
+            auto llvm_slot_type = _ray_query_slot_type();
+            llvm_ray_query_slot = b.CreateInBoundsGEP(llvm_slot_type, llvm_ray_query_slots, llvm_i, "ray_query.slot");
+            b.CreateStore(b.getInt32(api::RAY_QUERY_SLOT_NONE), b.CreateStructGEP(llvm_slot_type, llvm_ray_query_slot, 0u));
+        }
         // compute dispatch id
         auto llvm_dispatch_id = b.CreateNUWMul(llvm_block_id, llvm_block_size);
         llvm_dispatch_id = b.CreateNUWAdd(llvm_dispatch_id, llvm_thread_id, "dispatch_id");
@@ -3014,8 +3694,12 @@ private:
                 default: LUISA_ERROR_WITH_LOCATION("Invalid builtin variable index.");
             }
         }
+        call_args.emplace_back(llvm_shared_memory);
+        if (is_coroutine) { call_args.emplace_back(llvm_ray_query_slot); }
         auto llvm_call = b.CreateCall(llvm_kernel, call_args);
         llvm_call->setCallingConv(llvm::CallingConv::Fast);
+        // the call runs the thread until its first barrier or ray query
+        if (is_coroutine) { b.CreateStore(llvm_call, llvm_coro_handle_ptr); }
         b.CreateBr(llvm_loop_update_block);
         // loop update
         b.SetInsertPoint(llvm_loop_update_block);
@@ -3023,9 +3707,32 @@ private:
         b.CreateStore(llvm_next_i, llvm_ptr_i);
         auto llvm_loop_cond = b.CreateICmpULT(llvm_next_i, llvm_thread_count, "loop.cond");
         auto llvm_loop_merge_block = llvm::BasicBlock::Create(_llvm_context, "loop.merge", llvm_wrapper_function);
-        b.CreateCondBr(llvm_loop_cond, llvm_loop_block, llvm_loop_merge_block);
+        auto llvm_loop_back_edge = b.CreateCondBr(llvm_loop_cond, llvm_loop_block, llvm_loop_merge_block);
+        // vectorization hints: ask the loop vectorizer to execute simd_lane_count threads
+        // together, with out-of-range threads masked off by predication. These are hints
+        // only: LLVM still checks legality and cost, so kernels with opaque calls or
+        // cross-thread dependencies keep the scalar loop. Warp intrinsics still see one
+        // lane per warp either way.
+        if (_config.simd_lane_count > 1u && !is_coroutine) {
+            auto make_hint = [&](const char *name, llvm::Constant *value) noexcept {
+                return llvm::MDNode::get(_llvm_context, {llvm::MDString::get(_llvm_context, name),
+                                                         llvm::ConstantAsMetadata::get(value)});
+            };
+            llvm::SmallVector<llvm::Metadata *, 4u> llvm_loop_md_ops;
+            llvm_loop_md_ops.emplace_back(nullptr);// self-reference
+            llvm_loop_md_ops.emplace_back(make_hint("llvm.loop.vectorize.enable", b.getTrue()));
+            llvm_loop_md_ops.emplace_back(make_hint("llvm.loop.vectorize.width", b.getInt32(_config.simd_lane_count)));
+            llvm_loop_md_ops.emplace_back(make_hint("llvm.loop.vectorize.predicate.enable", b.getTrue()));
+            auto llvm_loop_md = llvm::MDNode::getDistinct(_llvm_context, llvm_loop_md_ops);
+            llvm_loop_md->replaceOperandWith(0, llvm_loop_md);
+            llvm_loop_back_edge->setMetadata(llvm::LLVMContext::MD_loop, llvm_loop_md);
+        }
         // loop merge
         b.SetInsertPoint(llvm_loop_merge_block);
+        if (is_coroutine) {
+            _schedule_coroutines(b, llvm_thread_count, llvm_coro_handles,
+                                 llvm_coro_resumed_ptr, llvm_ray_query_slots);
+        }
         b.CreateRetVoid();
         // hoist the loop variable to the top
         {
@@ -3056,6 +3763,19 @@ private:
         for (auto builtin = 0u; builtin < CurrentFunction::builtin_variable_count; builtin++) {
             llvm_arg_types.emplace_back(llvm_i32x3_type);
         }
+        // kernels additionally take the block-shared storage
+        auto is_kernel = f->derived_function_tag() == xir::DerivedFunctionTag::KERNEL;
+        if (is_kernel) { llvm_arg_types.emplace_back(llvm::PointerType::get(_llvm_context, 0)); }
+        // kernels with block barriers are lowered to coroutines that suspend at
+        // each barrier and return their handles to the kernel wrapper; with ray
+        // packets enabled, kernels that trace rays also suspend at each trace so
+        // that the wrapper can serve the queries of the whole block in packets
+        auto batches_ray_queries = is_kernel && _config.batch_ray_queries && _uses_ray_tracing(f);
+        auto is_coroutine = is_kernel && (batches_ray_queries || _uses_block_synchronization(f));
+        if (is_coroutine) {
+            llvm_ret_type = llvm::PointerType::get(_llvm_context, 0);
+            llvm_arg_types.emplace_back(llvm::PointerType::get(_llvm_context, 0));
+        }
 
         // create function
         auto llvm_func_type = llvm::FunctionType::get(llvm_ret_type, llvm_arg_types, false);
@@ -3065,6 +3785,8 @@ private:
 
         // use fastcc
         llvm_func->setCallingConv(llvm::CallingConv::Fast);
+        if (is_coroutine) { llvm_func->setPresplitCoroutine(); }
+        if (_config.noinline_functions.contains(f)) { llvm_func->addFnAttr(llvm::Attribute::NoInline); }
 
         // inline functions that have too many arguments
         // static constexpr auto max_argument_count = 16u;
@@ -3081,8 +3803,8 @@ private:
             if (auto arg_i = arg_index++; arg_i < non_builtin_count) {
                 auto arg = f->arguments()[arg_i];
                 current.value_map.emplace(arg, &llvm_arg);
-            } else {// built-in variable
-                auto builtin = arg_i - non_builtin_count;
+            } else if (auto builtin = arg_i - non_builtin_count;
+                       builtin < CurrentFunction::builtin_variable_count) {// built-in variable
                 switch (builtin) {
                     case CurrentFunction::builtin_variable_index_thread_id: llvm_arg.setName("thread_id"); break;
                     case CurrentFunction::builtin_variable_index_block_id: llvm_arg.setName("block_id"); break;
@@ -3092,10 +3814,23 @@ private:
                     default: LUISA_ERROR_WITH_LOCATION("Invalid builtin variable index.");
                 }
                 current.builtin_variables[builtin] = &llvm_arg;
+            } else if (current.shared_memory == nullptr) {// block-shared storage
+                llvm_arg.setName("shared_memory");
+                current.shared_memory = &llvm_arg;
+            } else {// ray query slot of coroutine kernels
+                llvm_arg.setName("ray_query_slot");
+                if (batches_ray_queries) { current.ray_query_slot = &llvm_arg; }
             }
         }
         // translate body
-        static_cast<void>(_translate_basic_block(current, f->body_block()));
+        if (is_coroutine) { _begin_coroutine(current); }
+        auto llvm_body_block = _translate_basic_block(current, f->body_block());
+        _resolve_phi_nodes(current);
+        if (is_coroutine) { _end_coroutine(current, llvm_body_block); }
+        if (is_kernel) {
+            _kernel_shared_memory_size = current.shared_memory_size;
+            _kernel_batches_ray_queries = batches_ray_queries;
+        }
         // we should hoist all alloca instructions to the beginning of the function
         {
             luisa::vector<llvm::AllocaInst *> alloca_insts;
@@ -3114,11 +3849,19 @@ private:
                 inst->moveBefore(&llvm_entry.front());
             }
         }
+        // candidate blocks only use hoisted allocas, so they can be outlined as is
+        _outline_ray_query_dispatches(current);
         // return
         return llvm_func;
     }
 
     [[nodiscard]] llvm::Function *_translate_callable_function(const xir::CallableFunction *f) noexcept {
+        // barriers suspend the kernel coroutine, so the inline pass moves them into the kernel body
+        if (_uses_block_synchronization(f)) {
+            LUISA_ERROR_WITH_LOCATION("Callable '{}' synchronizes the block but was not inlined into the kernel, "
+                                      "which is required for block synchronization on the fallback backend.",
+                                      _get_name_from_metadata(f, "callable").str());
+        }
         return _translate_function_definition(f, llvm::Function::PrivateLinkage, "callable");
     }
 
@@ -3141,8 +3884,8 @@ private:
     }
 
 public:
-    explicit FallbackCodegen(llvm::LLVMContext &ctx) noexcept
-        : _llvm_context{ctx} {}
+    FallbackCodegen(llvm::LLVMContext &ctx, const FallbackCodeGenConfig &config) noexcept
+        : _llvm_context{ctx}, _config{config} {}
 
     FallbackCodeGenFeedback emit(llvm::Module *llvm_module, const xir::Module *module) noexcept {
         auto location_md = module->find_metadata<xir::LocationMD>();
@@ -3159,8 +3902,9 @@ public:
 };
 
 FallbackCodeGenFeedback
-luisa_fallback_backend_codegen(llvm::LLVMContext &llvm_ctx, llvm::Module *llvm_module, const xir::Module *module) noexcept {
-    FallbackCodegen codegen{llvm_ctx};
+luisa_fallback_backend_codegen(llvm::LLVMContext &llvm_ctx, llvm::Module *llvm_module,
+                               const xir::Module *module, const FallbackCodeGenConfig &config) noexcept {
+    FallbackCodegen codegen{llvm_ctx, config};
     return codegen.emit(llvm_module, module);
 }
 
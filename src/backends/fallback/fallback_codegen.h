@@ -1,5 +1,6 @@
 #pragma once
 
+#include <luisa/core/basic_types.h>
 #include <luisa/core/stl/unordered_map.h>
 
 namespace llvm {
@@ -9,11 +10,27 @@ class LLVMContext;
 
 namespace luisa::compute::xir {
 class PrintInst;
+class Function;
 class Module;
 }// namespace luisa::compute::xir
 
 namespace luisa::compute::fallback {
 
+struct FallbackCodeGenConfig {
+    // vectorization hint: the width requested from LLVM's loop vectorizer for the
+    // per-block thread loop; 1 emits no hints. This is not a SIMT lowering: WARP_SIZE
+    // stays 1, warp intrinsics are not mapped to lanes, divergent control flow gets no
+    // masked SIMD codegen of our own (LLVM may still decline to vectorize), and
+    // coroutine kernels (block barriers, batched ray queries) get no hints at all
+    uint simd_lane_count{1u};
+    // suspend kernel threads at ray traces so that the rays
+    // of a block are traced together in Embree packets
+    bool batch_ray_queries{false};
+    // functions that LLVM must not inline back into their callers,
+    // e.g., regions outlined to keep the kernel small
+    luisa::unordered_set<const xir::Function *> noinline_functions;
+};
+
 struct FallbackCodeGenFeedback {
     using PrintInstMap = luisa::vector<std::pair<
         const xir::PrintInst *,
@@ -24,6 +41,7 @@ struct FallbackCodeGenFeedback {
 [[nodiscard]] FallbackCodeGenFeedback
 luisa_fallback_backend_codegen(llvm::LLVMContext &llvm_ctx,
                                llvm::Module *llvm_module,
-                               const xir::Module *module) noexcept;
+                               const xir::Module *module,
+                               const FallbackCodeGenConfig &config = {}) noexcept;
 
 }// namespace luisa::compute::fallback
@@ -1,68 +1,179 @@
+#include <algorithm>
+#include <luisa/core/logging.h>
+
 #include "fallback_command_queue.h"
 
-#ifdef LUISA_FALLBACK_USE_AKR_THREAD_POOL
+#ifdef LUISA_FALLBACK_USE_WORK_STEALING_POOL
 
-#include <barrier>
-#include <optional>
+#include <atomic>
+#include <algorithm>
+#include <luisa/core/intrin.h>
+#include <luisa/core/stl/memory.h>
 #include <luisa/core/stl/vector.h>
-#include <luisa/vstl/unique_ptr.h>
 
 namespace luisa::compute::fallback {
 
-struct AkrThreadPool {
-    luisa::vector<luisa::unique_ptr<std::thread>> _threads;
-    std::mutex _task_mutex, _submit_mutex;
-    std::condition_variable _has_work, _work_done;
-    std::barrier<> _barrier;
-    std::atomic_uint32_t _item_count = 0u;
-    struct ParallelFor {
-        uint count;
-        uint block_size;
-        luisa::move_only_function<void(uint)> task{};
+// Work-stealing parallel-for pool. Each participant (the workers plus the
+// calling dispatcher thread) owns a contiguous range of indices packed into
+// a single atomic word. Owners pop chunks from the front of their ranges and,
+// once empty, steal the back half of a victim's range. Idle workers spin for
+// a while before parking on the dispatch state.
+class FallbackWorkStealingPool {
+
+private:
+    // dispatch state: [epoch (31 bits) | closed (1 bit) | active workers (32 bits)]
+    static constexpr auto active_mask = 0xffff'ffffull;
+    static constexpr auto closed_bit = 1ull << 32u;
+    static constexpr auto epoch_shift = 33u;
+    static constexpr auto spin_count = 1u << 12u;
+
+    struct alignas(64) Range {
+        std::atomic_uint64_t bounds{0u};// [end (32 bits) | begin (32 bits)]
     };
-    std::optional<ParallelFor> _parallel_for;
-    std::atomic_bool _stopped = false;
-    explicit AkrThreadPool(size_t n_threads) : _barrier(static_cast<std::ptrdiff_t>(n_threads)) {
-        for (size_t tid = 0; tid < n_threads; tid++) {
-            _threads.emplace_back(std::move(luisa::make_unique<std::thread>([this, tid] {
-                while (!_stopped.load(std::memory_order_relaxed)) {
-
-                    std::unique_lock lock{_task_mutex};
-                    _has_work.wait(lock, [this] { return _parallel_for.has_value() || _stopped.load(std::memory_order_relaxed); });
-                    if (_stopped.load(std::memory_order_relaxed)) { return; }
-                    auto &&[count, block_size, task] = *_parallel_for;
-                    lock.unlock();
-                    while (_item_count < count) {
-                        auto i = _item_count.fetch_add(block_size, std::memory_order_relaxed);
-                        for (uint j = i; j < std::min<uint>(i + block_size, count); j++) {
-                            task(j);
-                        }
-                    }
-                    _barrier.arrive_and_wait();
-                    if (tid == 0) {
-                        _work_done.notify_all();
-                    }
-                    _barrier.arrive_and_wait();
+
+    [[nodiscard]] static constexpr auto _pack(uint begin, uint end) noexcept {
+        return (static_cast<uint64_t>(end) << 32u) | begin;
+    }
+    [[nodiscard]] static constexpr auto _unpack(uint64_t bounds) noexcept {
+        return std::make_pair(static_cast<uint>(bounds), static_cast<uint>(bounds >> 32u));
+    }
+
+private:
+    luisa::vector<std::thread> _threads;
+    luisa::unique_ptr<Range[]> _ranges;
+    size_t _participant_count{};
+    std::mutex _submit_mutex;
+    std::atomic_uint64_t _state{0u};
+    std::atomic_uint32_t _parked{0u};
+    std::atomic_bool _stopped{false};
+    // only modified by the submitter while no worker has joined
+    const luisa::move_only_function<void(uint)> *_task{nullptr};
+    uint _chunk_size{1u};
+
+private:
+    [[nodiscard]] bool _pop(size_t self, uint &begin, uint &end) noexcept {
+        auto &range = _ranges[self].bounds;
+        auto bounds = range.load(std::memory_order_acquire);
+        for (;;) {
+            auto [b, e] = _unpack(bounds);
+            if (b >= e) { return false; }
+            auto next = std::min(b + _chunk_size, e);
+            if (range.compare_exchange_weak(bounds, _pack(next, e), std::memory_order_acq_rel)) {
+                begin = b, end = next;
+                return true;
+            }
+        }
+    }
+
+    [[nodiscard]] bool _steal(size_t victim, uint &begin, uint &end) noexcept {
+        auto &range = _ranges[victim].bounds;
+        auto bounds = range.load(std::memory_order_acquire);
+        for (;;) {
+            auto [b, e] = _unpack(bounds);
+            if (b >= e) { return false; }
+            auto mid = b + (e - b) / 2u;
+            if (range.compare_exchange_weak(bounds, _pack(b, mid), std::memory_order_acq_rel)) {
+                begin = mid, end = e;
+                return true;
+            }
+        }
+    }
+
+    void _work(size_t self) noexcept {
+        auto &task = *_task;
+        for (;;) {
+            for (uint begin, end; _pop(self, begin, end);) {
+                for (auto i = begin; i < end; i++) { task(i); }
+            }
+            // own range drained, try stealing from the others
+            auto stolen = false;
+            for (auto k = 1u; k < _participant_count && !stolen; k++) {
+                auto victim = (self + k) % _participant_count;
+                if (uint begin, end; _steal(victim, begin, end)) {
+                    // publish the stolen range so that it can be stolen again
+                    _ranges[self].bounds.store(_pack(begin, end), std::memory_order_release);
+                    stolen = true;
                 }
-            })));
+            }
+            if (!stolen) { return; }
         }
     }
-    void parallel_for(uint count, luisa::move_only_function<void(uint)> &&task) {
-        std::scoped_lock _lk{_submit_mutex};
-        std::unique_lock lock{_task_mutex};
-        _parallel_for = ParallelFor{count, 1u, std::move(task)};
-        _item_count.store(0, std::memory_order_seq_cst);
-        _has_work.notify_all();
-        _work_done.wait(lock, [this] { return _item_count.load(std::memory_order_relaxed) >= _parallel_for->count; });
-        _parallel_for.reset();
-    }
-    ~AkrThreadPool() {
-        _stopped.store(true, std::memory_order_relaxed);
-        _has_work.notify_all();
-        for (auto &&thread : _threads) {
-            thread->join();
+
+    [[nodiscard]] bool _try_join(uint64_t &epoch) noexcept {
+        auto state = _state.load(std::memory_order_acquire);
+        for (auto spin = 0u;; spin++) {
+            if (_stopped.load(std::memory_order_relaxed)) { return false; }
+            if ((state >> epoch_shift) != epoch && (state & closed_bit) == 0u) {
+                // join the dispatch; fails if it is closed or a new one started meanwhile
+                if (_state.compare_exchange_weak(state, state + 1u, std::memory_order_acq_rel)) {
+                    epoch = state >> epoch_shift;
+                    return true;
+                }
+                continue;
+            }
+            if (spin < spin_count) {
+                LUISA_INTRIN_PAUSE();
+            } else {
+                _parked.fetch_add(1u);
+                _state.wait(state);
+                _parked.fetch_sub(1u);
+            }
+            state = _state.load(std::memory_order_acquire);
         }
     }
+
+public:
+    explicit FallbackWorkStealingPool(size_t n_threads) noexcept
+        : _participant_count{std::max<size_t>(n_threads, 1u)} {
+        _ranges = luisa::make_unique<Range[]>(_participant_count);
+        // the submitting thread participates as the last one
+        for (auto tid = 0u; tid + 1u < _participant_count; tid++) {
+            _threads.emplace_back([this, tid] {
+                for (auto epoch = static_cast<uint64_t>(0u); _try_join(epoch);) {
+                    _work(tid);
+                    _state.fetch_sub(1u, std::memory_order_release);
+                }
+            });
+        }
+    }
+
+    ~FallbackWorkStealingPool() noexcept {
+        _stopped.store(true);
+        _state.fetch_add(1ull << epoch_shift);
+        _state.notify_all();
+        for (auto &&thread : _threads) { thread.join(); }
+    }
+
+    void parallel_for(uint count, luisa::move_only_function<void(uint)> &&task) noexcept {
+        if (count == 0u) { return; }
+        std::scoped_lock lock{_submit_mutex};
+        _task = &task;
+        // adaptive chunking: a few chunks per participant, but never less than a block
+        _chunk_size = std::max(count / static_cast<uint>(_participant_count * 8u), 1u);
+        // split the grid evenly among the participants
+        for (auto i = 0u; i < _participant_count; i++) {
+            auto begin = static_cast<uint>(static_cast<uint64_t>(count) * i / _participant_count);
+            auto end = static_cast<uint>(static_cast<uint64_t>(count) * (i + 1u) / _participant_count);
+            _ranges[i].bounds.store(_pack(begin, end), std::memory_order_relaxed);
+        }
+        // open a new dispatch and wake up the parked workers, if any
+        auto epoch = (_state.load(std::memory_order_relaxed) >> epoch_shift) + 1u;
+        _state.store(epoch << epoch_shift);
+        if (_parked.load() != 0u) { _state.notify_all(); }
+        _work(_participant_count - 1u);
+        // all ranges are drained; close the dispatch and wait for the
+        // workers that still execute their last chunks to leave
+        auto state = _state.fetch_or(closed_bit, std::memory_order_acq_rel);
+        for (auto spin = 0u; (state & active_mask) != 0u; spin++) {
+            if (spin < spin_count) {
+                LUISA_INTRIN_PAUSE();
+            } else {
+                std::this_thread::yield();
+            }
+            state = _state.load(std::memory_order_acquire);
+        }
+        _task = nullptr;
+    }
 };
 
 }// namespace luisa::compute::fallback
@@ -92,7 +203,7 @@ inline void FallbackCommandQueue::_run_dispatch_loop() noexcept {
     if (_dispatch_queue != nullptr) {
         dispatch_release(_dispatch_queue);
     }
-#elif defined(LUISA_FALLBACK_USE_AKR_THREAD_POOL)
+#elif defined(LUISA_FALLBACK_USE_WORK_STEALING_POOL)
     if (_worker_pool != nullptr) {
         luisa::delete_with_allocator(_worker_pool);
     }
@@ -144,11 +255,61 @@ void FallbackCommandQueue::synchronize() noexcept {
 }
 
 void FallbackCommandQueue::enqueue(luisa::move_only_function<void()> &&task) noexcept {
+    if (_recording_concurrent) {
+        _concurrent_tasks.emplace_back(ConcurrentTask{
+            .count = 1u,
+            .parallel = false,
+            .task = [task = std::move(task)](uint) mutable noexcept { task(); }});
+        return;
+    }
     _wait_for_task_queue_available();
     _enqueue_task_no_wait(std::move(task));
 }
 
+void FallbackCommandQueue::begin_concurrent() noexcept {
+    LUISA_ASSERT(!_recording_concurrent, "Concurrent recording already started.");
+    _recording_concurrent = true;
+}
+
+void FallbackCommandQueue::end_concurrent() noexcept {
+    LUISA_ASSERT(_recording_concurrent, "Concurrent recording not started.");
+    _recording_concurrent = false;
+    auto tasks = std::exchange(_concurrent_tasks, {});
+    if (tasks.empty()) { return; }
+    // nothing to overlap, take the usual path
+    if (tasks.size() == 1u) {
+        auto &&t = tasks.front();
+        if (t.parallel) {
+            enqueue_parallel(t.count, std::move(t.task));
+        } else {
+            enqueue([task = std::move(t.task)]() mutable noexcept { task(0u); });
+        }
+        return;
+    }
+    // fuse the index spaces of all tasks into one launch
+    luisa::vector<uint> offsets;
+    offsets.reserve(tasks.size());
+    auto total = 0u;
+    for (auto &&t : tasks) {
+        offsets.emplace_back(total);
+        total += t.count;
+    }
+    enqueue_parallel(total, [tasks = std::move(tasks), offsets = std::move(offsets)](uint i) mutable noexcept {
+        auto k = static_cast<size_t>(std::upper_bound(offsets.cbegin(), offsets.cend(), i) - offsets.cbegin()) - 1u;
+        tasks[k].task(i - offsets[k]);
+    });
+}
+
 void FallbackCommandQueue::enqueue_parallel(uint n, luisa::move_only_function<void(uint)> &&task) noexcept {
+    if (_recording_concurrent) {
+        if (n != 0u) {
+            _concurrent_tasks.emplace_back(ConcurrentTask{
+                .count = n,
+                .parallel = true,
+                .task = std::move(task)});
+        }
+        return;
+    }
     enqueue([this, n, task = std::move(task)]() mutable noexcept {
 #if defined(LUISA_FALLBACK_USE_DISPATCH_QUEUE)
         if (_dispatch_queue == nullptr) {
@@ -167,9 +328,9 @@ void FallbackCommandQueue::enqueue_parallel(uint n, luisa::move_only_function<vo
         concurrency::parallel_for(0u, n, task);
 #elif defined(LUISA_FALLBACK_USE_TBB)
         tbb::parallel_for(0u, n, task);
-#elif defined(LUISA_FALLBACK_USE_AKR_THREAD_POOL)
+#elif defined(LUISA_FALLBACK_USE_WORK_STEALING_POOL)
         if (_worker_pool == nullptr) {
-            _worker_pool = luisa::new_with_allocator<AkrThreadPool>(_worker_count);
+            _worker_pool = luisa::new_with_allocator<FallbackWorkStealingPool>(_worker_count);
         }
         _worker_pool->parallel_for(n, std::move(task));
 #endif
@@ -6,6 +6,7 @@
 
 #include <luisa/core/basic_types.h>
 #include <luisa/core/stl/queue.h>
+#include <luisa/core/stl/vector.h>
 #include <luisa/core/stl/functional.h>
 #include <luisa/runtime/rhi/device_interface.h>
 
@@ -22,12 +23,12 @@
 #define LUISA_FALLBACK_USE_TBB
 #include <tbb/parallel_for.h>
 #else
-#define LUISA_FALLBACK_USE_AKR_THREAD_POOL
+#define LUISA_FALLBACK_USE_WORK_STEALING_POOL
 #endif
 
 namespace luisa::compute::fallback {
 
-struct AkrThreadPool;
+class FallbackWorkStealingPool;
 
 class FallbackCommandQueue {
 
@@ -44,10 +45,19 @@ private:
     size_t _worker_count{0u};
     DeviceInterface::StreamLogCallback _log_callback;
 
+    // tasks recorded between begin_concurrent() and end_concurrent()
+    struct ConcurrentTask {
+        uint count;
+        bool parallel;
+        luisa::move_only_function<void(uint)> task;
+    };
+    luisa::vector<ConcurrentTask> _concurrent_tasks;
+    bool _recording_concurrent{false};
+
 #if defined(LUISA_FALLBACK_USE_DISPATCH_QUEUE)
     dispatch_queue_t _dispatch_queue{nullptr};
-#elif defined(LUISA_FALLBACK_USE_AKR_THREAD_POOL)
-    AkrThreadPool *_worker_pool{nullptr};
+#elif defined(LUISA_FALLBACK_USE_WORK_STEALING_POOL)
+    FallbackWorkStealingPool *_worker_pool{nullptr};
 #endif
 
 private:
@@ -60,6 +70,10 @@ public:
     ~FallbackCommandQueue() noexcept;
     void enqueue(luisa::move_only_function<void()> &&task) noexcept;
     void enqueue_parallel(uint n, luisa::move_only_function<void(uint)> &&task) noexcept;
+    // tasks enqueued between begin_concurrent() and end_concurrent() must be independent
+    // of each other; they are fused into a single parallel launch on the workers
+    void begin_concurrent() noexcept;
+    void end_concurrent() noexcept;
     void synchronize() noexcept;
 
     void set_log_callback(DeviceInterface::StreamLogCallback callback) noexcept { _log_callback = std::move(callback); }
@@ -0,0 +1,56 @@
+#include <algorithm>
+
+#include <luisa/core/logging.h>
+
+#include "fallback_compile_thread_pool.h"
+
+namespace luisa::compute::fallback {
+
+void FallbackCompileThreadPool::_run_worker_loop() noexcept {
+    for (;;) {
+        auto task = [this]() -> luisa::move_only_function<void()> {
+            std::unique_lock lock{_mutex};
+            _cv.wait(lock, [this] { return _stopped || !_tasks.empty(); });
+            // drain the remaining tasks before stopping so that no shader is left uncompiled
+            if (_tasks.empty()) { return {}; }
+            auto task = std::move(_tasks.front());
+            _tasks.pop();
+            return task;
+        }();
+        if (!task) { break; }
+        task();
+    }
+}
+
+FallbackCompileThreadPool::FallbackCompileThreadPool(size_t num_threads) noexcept {
+    if (num_threads == 0u) {
+        num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1u);
+    }
+    _threads.reserve(num_threads);
+    for (auto i = 0u; i < num_threads; i++) {
+        _threads.emplace_back([this] { _run_worker_loop(); });
+    }
+    LUISA_VERBOSE("Created fallback compile thread pool with {} thread(s).", num_threads);
+}
+
+FallbackCompileThreadPool::~FallbackCompileThreadPool() noexcept {
+    {
+        std::scoped_lock lock{_mutex};
+        _stopped = true;
+    }
+    _cv.notify_all();
+    for (auto &&t : _threads) { t.join(); }
+}
+
+std::shared_future<void> FallbackCompileThreadPool::async(luisa::move_only_function<void()> &&task) noexcept {
+    std::packaged_task<void()> packaged_task{std::move(task)};
+    auto future = packaged_task.get_future().share();
+    {
+        std::scoped_lock lock{_mutex};
+        _tasks.push([packaged_task = std::move(packaged_task)]() mutable noexcept { packaged_task(); });
+    }
+    _cv.notify_one();
+    return future;
+}
+
+}// namespace luisa::compute::fallback
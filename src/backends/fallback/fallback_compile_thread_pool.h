@@ -0,0 +1,39 @@
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <future>
+#include <condition_variable>
+
+#include <luisa/core/stl/queue.h>
+#include <luisa/core/stl/vector.h>
+#include <luisa/core/stl/functional.h>
+
+namespace luisa::compute::fallback {
+
+// A small pool of threads dedicated to shader compilation, so that
+// kernels created in a burst are JIT-compiled concurrently.
+class FallbackCompileThreadPool {
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    luisa::queue<luisa::move_only_function<void()>> _tasks;
+    luisa::vector<std::thread> _threads;
+    bool _stopped{false};
+
+private:
+    void _run_worker_loop() noexcept;
+
+public:
+    explicit FallbackCompileThreadPool(size_t num_threads) noexcept;
+    ~FallbackCompileThreadPool() noexcept;
+    FallbackCompileThreadPool(FallbackCompileThreadPool &&) noexcept = delete;
+    FallbackCompileThreadPool(const FallbackCompileThreadPool &) noexcept = delete;
+    FallbackCompileThreadPool &operator=(FallbackCompileThreadPool &&) noexcept = delete;
+    FallbackCompileThreadPool &operator=(const FallbackCompileThreadPool &) noexcept = delete;
+    [[nodiscard]] auto size() const noexcept { return _threads.size(); }
+    [[nodiscard]] std::shared_future<void> async(luisa::move_only_function<void()> &&task) noexcept;
+};
+
+}// namespace luisa::compute::fallback
@@ -0,0 +1,64 @@
+#include <luisa/core/logging.h>
+
+#include "fallback_buffer.h"
+#include "fallback_curve.h"
+
+namespace luisa::compute::fallback {
+
+[[nodiscard]] static RTCGeometryType fallback_curve_geometry_type(CurveBasis basis) noexcept {
+    switch (basis) {
+        case CurveBasis::PIECEWISE_LINEAR: return RTC_GEOMETRY_TYPE_ROUND_LINEAR_CURVE;
+        case CurveBasis::CUBIC_BSPLINE: return RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE;
+        case CurveBasis::CATMULL_ROM: return RTC_GEOMETRY_TYPE_ROUND_CATMULL_ROM_CURVE;
+        case CurveBasis::BEZIER: return RTC_GEOMETRY_TYPE_ROUND_BEZIER_CURVE;
+    }
+    LUISA_ERROR_WITH_LOCATION("Unsupported curve basis.");
+}
+
+FallbackCurve::FallbackCurve(RTCDevice device, const AccelOption &option) noexcept
+    : FallbackPrimitive{Tag::CURVE, device, option},
+      _build_quality{luisa_fallback_accel_build_quality(option)},
+      _allow_update{option.allow_update} {}
+
+void FallbackCurve::build(luisa::unique_ptr<CurveBuildCommand> cmd) noexcept {
+    auto cp_buffer = reinterpret_cast<FallbackBuffer *>(cmd->cp_buffer())->data();
+    auto seg_buffer = reinterpret_cast<FallbackBuffer *>(cmd->seg_buffer())->data();
+    auto type = fallback_curve_geometry_type(cmd->basis());
+    // the geometry type is fixed at creation, so a new basis needs a new geometry
+    if (_geometry == nullptr || _geometry_type != type) {
+        if (_geometry != nullptr) { rtcDetachGeometry(_handle, 0u); }
+        _geometry = rtcNewGeometry(rtcGetSceneDevice(_handle), type);
+        _geometry_type = type;
+        _segment_buffer = nullptr;
+        // kernels tell curve hits apart from triangle hits by the primitive tag in the user data
+        rtcSetGeometryUserData(_geometry, static_cast<FallbackPrimitive *>(this));
+        rtcAttachGeometryByID(_handle, _geometry, 0u);
+        rtcReleaseGeometry(_geometry);// already moved into the scene
+    }
+    // refit the existing BVH if only the control points moved
+    auto refit = _allow_update &&
+                 cmd->request() == AccelBuildRequest::PREFER_UPDATE &&
+                 _segment_buffer == seg_buffer &&
+                 _segment_buffer_offset == cmd->seg_buffer_offset() &&
+                 _segment_count == cmd->seg_count() &&
+                 _control_point_count == cmd->cp_count();
+    // control points are (x, y, z, radius), which matches RTC_FORMAT_FLOAT4
+    rtcSetSharedGeometryBuffer(_geometry, RTC_BUFFER_TYPE_VERTEX, 0u, RTC_FORMAT_FLOAT4,
+                               cp_buffer, cmd->cp_buffer_offset(), cmd->cp_stride(), cmd->cp_count());
+    if (refit) {
+        rtcUpdateGeometryBuffer(_geometry, RTC_BUFFER_TYPE_VERTEX, 0u);
+        rtcSetGeometryBuildQuality(_geometry, RTC_BUILD_QUALITY_REFIT);
+    } else {
+        rtcSetSharedGeometryBuffer(_geometry, RTC_BUFFER_TYPE_INDEX, 0u, RTC_FORMAT_UINT,
+                                   seg_buffer, cmd->seg_buffer_offset(), sizeof(uint), cmd->seg_count());
+        rtcSetGeometryBuildQuality(_geometry, _build_quality);
+        _segment_buffer = seg_buffer;
+        _segment_buffer_offset = cmd->seg_buffer_offset();
+        _segment_count = cmd->seg_count();
+        _control_point_count = cmd->cp_count();
+    }
+    rtcCommitGeometry(_geometry);
+    rtcCommitScene(_handle);
+}
+
+}// namespace luisa::compute::fallback
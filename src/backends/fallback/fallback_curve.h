@@ -0,0 +1,26 @@
+#pragma once
+
+#include <luisa/runtime/rtx/curve.h>
+#include "fallback_primitive.h"
+
+namespace luisa::compute::fallback {
+
+class FallbackCurve final : public FallbackPrimitive {
+
+private:
+    RTCGeometry _geometry{nullptr};
+    RTCGeometryType _geometry_type{};
+    RTCBuildQuality _build_quality;
+    bool _allow_update;
+    // topology of the last full build; the BVH can only be refit while it is unchanged
+    const std::byte *_segment_buffer{nullptr};
+    size_t _segment_buffer_offset{0u};
+    size_t _segment_count{0u};
+    size_t _control_point_count{0u};
+
+public:
+    FallbackCurve(RTCDevice device, const AccelOption &option) noexcept;
+    void build(luisa::unique_ptr<CurveBuildCommand> cmd) noexcept;
+};
+
+}// namespace luisa::compute::fallback
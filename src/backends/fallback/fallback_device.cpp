@@ -2,6 +2,9 @@
 // Created by Mike Smith on 2022/5/23.
 //
 
+#include <cstdlib>
+#include <thread>
+
 #include <luisa/core/intrin.h>
 
 #ifdef LUISA_ARCH_X86_64
@@ -23,6 +26,9 @@
 #include "fallback_device.h"
 #include "fallback_texture.h"
 #include "fallback_mesh.h"
+#include "fallback_curve.h"
+#include "fallback_procedural_primitive.h"
+#include "fallback_motion_instance.h"
 #include "fallback_accel.h"
 #include "fallback_bindless_array.h"
 #include "fallback_shader.h"
@@ -30,18 +36,73 @@
 #include "fallback_event.h"
 #include "fallback_swapchain.h"
 
+#include <luisa/backends/ext/fallback_config_ext.h>
+
+// LUISA_FALLBACK_ASYNC_COMPILE=1 enables asynchronous compilation on all cores,
+// while LUISA_FALLBACK_ASYNC_COMPILE=<n> with n > 1 limits it to n threads
+static const size_t LUISA_FALLBACK_ASYNC_COMPILE_THREADS = []() -> size_t {
+    if (auto env = getenv("LUISA_FALLBACK_ASYNC_COMPILE")) {
+        auto n = static_cast<size_t>(std::strtoull(env, nullptr, 10));
+        return n == 1u ? std::thread::hardware_concurrency() : n;
+    }
+    return 0u;
+}();
+
+// LUISA_FALLBACK_RAY_PACKETS=1 or 0 overrides whether rays are traced in packets
+static const char *LUISA_FALLBACK_RAY_PACKETS = getenv("LUISA_FALLBACK_RAY_PACKETS");
+
 namespace luisa::compute::fallback {
 
-FallbackDevice::FallbackDevice(Context &&ctx) noexcept
+FallbackDevice::FallbackDevice(Context &&ctx, const DeviceConfig *config) noexcept
     : DeviceInterface{std::move(ctx)} {
 
+    auto requested_isa = luisa::string_view{"auto"};
+    auto requested_simd_lane_count = 0u;
+    if (config != nullptr) {
+        _io = config->binary_io;
+        if (config->extension != nullptr) {
+            if (auto ext = dynamic_cast<const FallbackDeviceConfigExt *>(config->extension.get())) {
+                requested_isa = ext->isa();
+                requested_simd_lane_count = ext->simd_lane_count();
+                _ray_packets = ext->ray_packets();
+            } else {
+                LUISA_WARNING_WITH_LOCATION("Ignoring device config extension not meant for the fallback backend.");
+            }
+        }
+    }
+
+    if (_io == nullptr) {
+        _default_io = luisa::make_unique<DefaultBinaryIO>(context());
+        _io = _default_io.get();
+    }
+
+    if (LUISA_FALLBACK_RAY_PACKETS != nullptr) {
+        _ray_packets = luisa::string_view{LUISA_FALLBACK_RAY_PACKETS} != "0";
+    }
+
+    if (LUISA_FALLBACK_ASYNC_COMPILE_THREADS != 0u) {
+        _compile_thread_pool = luisa::make_unique<FallbackCompileThreadPool>(
+            LUISA_FALLBACK_ASYNC_COMPILE_THREADS);
+    }
+
 #ifdef LUISA_ARCH_X86_64
     _MM_SET_FLUSH_ZERO_MODE(_MM_FLUSH_ZERO_ON);
     _MM_SET_DENORMALS_ZERO_MODE(_MM_DENORMALS_ZERO_ON);
 #endif
 
+    // select the instruction set for both the JIT and Embree
+    _isa = fallback_select_isa(requested_isa);
+    _llvm_target_cpu = fallback_isa_llvm_cpu(_isa);
+    _llvm_target_features = fallback_isa_llvm_features(_isa);
+    _simd_lane_count = requested_simd_lane_count == 0u ?
+                           fallback_isa_simd_width(_isa) :
+                           requested_simd_lane_count;
+    LUISA_VERBOSE("Fallback backend using ISA '{}' with vectorization hint width {}.",
+                  to_string(_isa), _simd_lane_count);
+
     // embree
-    _rtc_device = rtcNewDevice("frequency_level=simd128,isa=avx2,verbose=1");
+    auto rtc_config = luisa::format("{},verbose=1", fallback_isa_embree_config(_isa));
+    _rtc_device = rtcNewDevice(rtc_config.c_str());
     rtcSetDeviceErrorFunction(
         _rtc_device,
         [](void *, RTCError code, const char *message) {
@@ -174,12 +235,13 @@ SwapchainCreationInfo FallbackDevice::create_swapchain(const SwapchainOption &op
 }
 
 ShaderCreationInfo FallbackDevice::create_shader(const ShaderOption &option, Function kernel) noexcept {
-    Clock clk;
     auto shader = luisa::new_with_allocator<FallbackShader>(this, option, kernel);
-    LUISA_VERBOSE("Shader compilation took {} ms.", clk.toc());
     ShaderCreationInfo info{};
     info.handle = reinterpret_cast<uint64_t>(shader);
-    info.native_handle = reinterpret_cast<void *>(shader->native_handle());
+    // do not block on asynchronous compilation just to report the entry
+    info.native_handle = shader->is_compiled() ?
+                             reinterpret_cast<void *>(shader->native_handle()) :
+                             nullptr;
     info.block_size = kernel.block_size();
     return info;
 }
@@ -233,26 +295,33 @@ ResourceCreationInfo FallbackDevice::create_mesh(const AccelOption &option) noex
 }
 
 ResourceCreationInfo FallbackDevice::create_procedural_primitive(const AccelOption &option) noexcept {
-    return ResourceCreationInfo();
+    auto primitive = luisa::new_with_allocator<FallbackProceduralPrimitive>(_rtc_device, option);
+    return {.handle = reinterpret_cast<uint64_t>(primitive),
+            .native_handle = primitive->handle()};
 }
 
 void FallbackDevice::destroy_procedural_primitive(uint64_t handle) noexcept {
+    luisa::delete_with_allocator(reinterpret_cast<FallbackProceduralPrimitive *>(handle));
 }
 
 ResourceCreationInfo FallbackDevice::create_curve(const AccelOption &option) noexcept {
-    return DeviceInterface::create_curve(option);
+    auto curve = luisa::new_with_allocator<FallbackCurve>(_rtc_device, option);
+    return {.handle = reinterpret_cast<uint64_t>(curve),
+            .native_handle = curve->handle()};
 }
 
 void FallbackDevice::destroy_curve(uint64_t handle) noexcept {
-    DeviceInterface::destroy_curve(handle);
+    luisa::delete_with_allocator(reinterpret_cast<FallbackCurve *>(handle));
 }
 
 ResourceCreationInfo FallbackDevice::create_motion_instance(const AccelMotionOption &option) noexcept {
-    return DeviceInterface::create_motion_instance(option);
+    auto instance = luisa::new_with_allocator<FallbackMotionInstance>(option);
+    return {.handle = reinterpret_cast<uint64_t>(instance),
+            .native_handle = instance};
 }
 
 void FallbackDevice::destroy_motion_instance(uint64_t handle) noexcept {
-    DeviceInterface::destroy_motion_instance(handle);
+    luisa::delete_with_allocator(reinterpret_cast<FallbackMotionInstance *>(handle));
 }
 
 ResourceCreationInfo FallbackDevice::create_accel(const AccelOption &option) noexcept {
@@ -262,6 +331,10 @@ ResourceCreationInfo FallbackDevice::create_accel(const AccelOption &option) noe
 }
 
 string FallbackDevice::query(luisa::string_view property) noexcept {
+    if (property == "isa") { return luisa::string{to_string(_isa)}; }
+    if (property == "host_isa") { return luisa::string{to_string(fallback_detect_host_isa())}; }
+    if (property == "simd_lane_count") { return luisa::format("{}", _simd_lane_count); }
+    if (property == "ray_packets") { return luisa::string{_ray_packets ? "1" : "0"}; }
     return DeviceInterface::query(property);
 }
 
@@ -326,8 +399,10 @@ ResourceCreationInfo FallbackDevice::create_event() noexcept {
 
 }// namespace luisa::compute::fallback
 
-LUISA_EXPORT_API luisa::compute::DeviceInterface *create(luisa::compute::Context &&ctx, std::string_view) noexcept {
-    return luisa::new_with_allocator<luisa::compute::fallback::FallbackDevice>(std::move(ctx));
+LUISA_EXPORT_API luisa::compute::DeviceInterface *create(luisa::compute::Context &&ctx,
+                                                         const luisa::compute::DeviceConfig *config) noexcept {
+    return luisa::new_with_allocator<luisa::compute::fallback::FallbackDevice>(
+        std::move(ctx), config);
 }
 
 LUISA_EXPORT_API void destroy(luisa::compute::DeviceInterface *device) noexcept {
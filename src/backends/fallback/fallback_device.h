@@ -5,7 +5,10 @@
 #pragma once
 
 #include <luisa/runtime/device.h>
+#include "../common/default_binary_io.h"
 #include "fallback_embree.h"
+#include "fallback_compile_thread_pool.h"
+#include "fallback_isa.h"
 
 namespace llvm {
 class TargetMachine;
@@ -21,9 +24,25 @@ class FallbackDevice : public DeviceInterface {
 
 private:
     RTCDevice _rtc_device{nullptr};
+    FallbackISA _isa{};
+    uint _simd_lane_count{1u};
+    bool _ray_packets{false};
+    luisa::string _llvm_target_cpu;
+    luisa::vector<luisa::string> _llvm_target_features;
+    luisa::unique_ptr<DefaultBinaryIO> _default_io;
+    const BinaryIO *_io{nullptr};
+    luisa::unique_ptr<FallbackCompileThreadPool> _compile_thread_pool;
 
 public:
-    explicit FallbackDevice(Context &&ctx) noexcept;
+    FallbackDevice(Context &&ctx, const DeviceConfig *config) noexcept;
+    [[nodiscard]] auto io() const noexcept { return _io; }
+    [[nodiscard]] auto isa() const noexcept { return _isa; }
+    [[nodiscard]] auto simd_lane_count() const noexcept { return _simd_lane_count; }
+    [[nodiscard]] auto ray_packets() const noexcept { return _ray_packets; }
+    [[nodiscard]] luisa::string_view llvm_target_cpu() const noexcept { return _llvm_target_cpu; }
+    [[nodiscard]] luisa::span<const luisa::string> llvm_target_features() const noexcept { return _llvm_target_features; }
+    // returns nullptr if shaders should be compiled synchronously
+    [[nodiscard]] auto compile_thread_pool() const noexcept { return _compile_thread_pool.get(); }
     ~FallbackDevice() noexcept override;
     void *native_handle() const noexcept override;
     void destroy_buffer(uint64_t handle) noexcept override;
@@ -1,7 +1,11 @@
+#include <limits>
+
 #include "fallback_texture.h"
 #include "fallback_texture_bc.h"
 #include "fallback_accel.h"
 #include "fallback_device_api.h"
+#include "fallback_procedural_primitive.h"
+#include "fallback_motion_instance.h"
 
 namespace luisa::compute::fallback::api {
 
@@ -144,12 +148,34 @@ template<typename T>
     return T{65536.f};
 }
 
+// Calls f with a texel fetcher specialized for the storage of the view, so that
+// the format is resolved once per sample rather than once per fetched texel.
+template<typename F>
+[[nodiscard]] inline luisa::float4 with_texel_fetch_2d(FallbackTextureView view, F &&f) noexcept {
+    if (is_block_compressed(view.storage())) [[unlikely]] {
+        auto handle = reinterpret_cast<const PackedTextureView *>(&view);
+        return f([handle](luisa::uint2 c) noexcept {
+            return bit_cast<luisa::float4>(luisa_fallback_texture2d_read_float(handle->data, handle->extra, c.x, c.y));
+        });
+    }
+    return detail::visit_pixel_storage(view.storage(), [&]<typename Src, uint dim>() noexcept {
+        return f([&view](luisa::uint2 c) noexcept { return view.read2d<float, Src, dim>(c); });
+    });
+}
+
+template<typename F>
+[[nodiscard]] inline luisa::float4 with_texel_fetch_3d(FallbackTextureView view, F &&f) noexcept {
+    LUISA_DEBUG_ASSERT(!is_block_compressed(view.storage()), "Block compression doesn't work for 3D texture");
+    return detail::visit_pixel_storage(view.storage(), [&]<typename Src, uint dim>() noexcept {
+        return f([&view](luisa::uint3 c) noexcept { return view.read3d<float, Src, dim>(c); });
+    });
+}
+
 [[nodiscard]] inline auto texture_sample_point(FallbackTextureView view, Sampler::Address address, luisa::float2 uv) noexcept {
     auto size = make_float2(view.size2d());
     auto p = texture_coord_point(address, uv, size);
     auto c = make_uint2(p);
-    auto handle = reinterpret_cast<const PackedTextureView *>(&view);
-    return bit_cast<luisa::float4>(luisa_fallback_texture2d_read_float(handle->data, handle->extra, c.x, c.y));
+    return with_texel_fetch_2d(view, [c](auto fetch) noexcept { return fetch(c); });
 }
 
 [[nodiscard]] inline auto texture_coord_linear(Sampler::Address address, luisa::float2 uv, luisa::float2 s) noexcept {
@@ -165,12 +191,13 @@ template<typename T>
     auto t = luisa::fract(st_max);
     auto c0 = make_uint2(st_min);
     auto c1 = make_uint2(st_max);
-    auto handle = reinterpret_cast<const PackedTextureView *>(&view);
-    auto v00 = bit_cast<luisa::float4>(luisa_fallback_texture2d_read_float(handle->data, handle->extra, c0.x, c0.y));
-    auto v01 = bit_cast<luisa::float4>(luisa_fallback_texture2d_read_float(handle->data, handle->extra, c1.x, c0.y));
-    auto v10 = bit_cast<luisa::float4>(luisa_fallback_texture2d_read_float(handle->data, handle->extra, c0.x, c1.y));
-    auto v11 = bit_cast<luisa::float4>(luisa_fallback_texture2d_read_float(handle->data, handle->extra, c1.x, c1.y));
-    return luisa::lerp(luisa::lerp(v00, v01, t.x), luisa::lerp(v10, v11, t.x), t.y);
+    return with_texel_fetch_2d(view, [c0, c1, t](auto fetch) noexcept {
+        auto v00 = fetch(make_uint2(c0.x, c0.y));
+        auto v01 = fetch(make_uint2(c1.x, c0.y));
+        auto v10 = fetch(make_uint2(c0.x, c1.y));
+        auto v11 = fetch(make_uint2(c1.x, c1.y));
+        return luisa::lerp(luisa::lerp(v00, v01, t.x), luisa::lerp(v10, v11, t.x), t.y);
+    });
 }
 
 [[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample(const Texture *handle, uint sampler, float u, float v) noexcept {
@@ -202,21 +229,10 @@ template<typename T>
     return {result.x, result.y, result.z, result.w};
 }
 
-// TODO: implement
-[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad(const Texture *handle, uint sampler, float u, float v, float dudx, float dudy, float dvdx, float dvdy) noexcept {
-    return luisa_fallback_bindless_texture2d_sample(handle, sampler, u, v);
-}
-
-// TODO: implement
-[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad_level(const Texture *handle, uint sampler, float u, float v, float dudx, float dudy, float dvdx, float dvdy, float level) noexcept {
-    return luisa_fallback_bindless_texture2d_sample_level(handle, sampler, u, v, level);
-}
-
 [[nodiscard]] inline auto texture_sample_point(FallbackTextureView view, Sampler::Address address, luisa::float3 uv) noexcept {
     auto size = make_float3(view.size3d());
     auto c = make_uint3(texture_coord_point(address, uv, size));
-    auto handle = reinterpret_cast<const PackedTextureView *>(&view);
-    return bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c.x, c.y, c.z));
+    return with_texel_fetch_3d(view, [c](auto fetch) noexcept { return fetch(c); });
 }
 
 [[nodiscard]] inline auto texture_coord_linear(Sampler::Address address, luisa::float3 uv, luisa::float3 size) noexcept {
@@ -233,20 +249,21 @@ template<typename T>
     auto t = luisa::fract(st_max);
     auto c0 = make_uint3(st_min);
     auto c1 = make_uint3(st_max);
-    auto handle = reinterpret_cast<const PackedTextureView *>(&view);
-    auto v000 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c0.x, c0.y, c0.z));
-    auto v001 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c1.x, c0.y, c0.z));
-    auto v010 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c0.x, c1.y, c0.z));
-    auto v011 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c1.x, c1.y, c0.z));
-    auto v100 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c0.x, c0.y, c1.z));
-    auto v101 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c1.x, c0.y, c1.z));
-    auto v110 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c0.x, c1.y, c1.z));
-    auto v111 = bit_cast<luisa::float4>(luisa_fallback_texture3d_read_float(handle->data, handle->extra, c1.x, c1.y, c1.z));
-    return luisa::lerp(luisa::lerp(luisa::lerp(v000, v001, t.x),
-                                   luisa::lerp(v010, v011, t.x), t.y),
-                       luisa::lerp(luisa::lerp(v100, v101, t.x),
-                                   luisa::lerp(v110, v111, t.x), t.y),
-                       t.z);
+    return with_texel_fetch_3d(view, [c0, c1, t](auto fetch) noexcept {
+        auto v000 = fetch(make_uint3(c0.x, c0.y, c0.z));
+        auto v001 = fetch(make_uint3(c1.x, c0.y, c0.z));
+        auto v010 = fetch(make_uint3(c0.x, c1.y, c0.z));
+        auto v011 = fetch(make_uint3(c1.x, c1.y, c0.z));
+        auto v100 = fetch(make_uint3(c0.x, c0.y, c1.z));
+        auto v101 = fetch(make_uint3(c1.x, c0.y, c1.z));
+        auto v110 = fetch(make_uint3(c0.x, c1.y, c1.z));
+        auto v111 = fetch(make_uint3(c1.x, c1.y, c1.z));
+        return luisa::lerp(luisa::lerp(luisa::lerp(v000, v001, t.x),
+                                       luisa::lerp(v010, v011, t.x), t.y),
+                           luisa::lerp(luisa::lerp(v100, v101, t.x),
+                                       luisa::lerp(v110, v111, t.x), t.y),
+                           t.z);
+    });
 }
 
 [[nodiscard]] float4 luisa_fallback_bindless_texture3d_sample(const Texture *handle, uint sampler, float u, float v, float w) noexcept {
@@ -278,14 +295,82 @@ template<typename T>
     return {result.x, result.y, result.z, result.w};
 }
 
-// TODO: implement
+// samples at a fractional mip level: trilinear for linear filters, nearest level and texel for point filters
+template<typename UV>
+[[nodiscard]] inline luisa::float4 texture_sample_lod(const FallbackTexture *tex, Sampler s, UV uv, float level) noexcept {
+    auto last_level = tex->mip_levels() - 1u;
+    level = std::clamp(level, 0.f, static_cast<float>(last_level));
+    if (s.filter() == Sampler::Filter::POINT) {
+        return texture_sample_point(tex->view(static_cast<uint>(level + .5f)), s.address(), uv);
+    }
+    if (s.filter() == Sampler::Filter::LINEAR_POINT) {
+        return texture_sample_linear(tex->view(static_cast<uint>(level + .5f)), s.address(), uv);
+    }
+    auto level0 = static_cast<uint>(level);
+    auto v0 = texture_sample_linear(tex->view(level0), s.address(), uv);
+    auto t = level - static_cast<float>(level0);
+    if (level0 == last_level || t == 0.f) { return v0; }
+    auto v1 = texture_sample_linear(tex->view(level0 + 1u), s.address(), uv);
+    return luisa::lerp(v0, v1, t);
+}
+
+// Selects the mip level from the screen-space derivatives of the texture coordinates. For
+// anisotropic filtering, the level is chosen from the minor axis of the footprint instead
+// and up to max_anisotropy taps are averaged along its major axis, like GPUs do.
+template<typename UV>
+[[nodiscard]] inline luisa::float4 texture_sample_grad(const FallbackTexture *tex, Sampler s,
+                                                       UV uv, UV dpdx, UV dpdy, float min_level) noexcept {
+    auto view = tex->view(0u);
+    auto size = [&view] {
+        if constexpr (std::is_same_v<UV, luisa::float2>) {
+            return make_float2(view.size2d());
+        } else {
+            return make_float3(view.size3d());
+        }
+    }();
+    // footprint extents in texels of the finest level
+    auto lx = luisa::length(dpdx * size);
+    auto ly = luisa::length(dpdy * size);
+    auto longer = std::max(lx, ly);
+    if (!(longer > 0.f)) { return texture_sample_lod(tex, s, uv, min_level); }
+    if (s.filter() != Sampler::Filter::ANISOTROPIC) {
+        return texture_sample_lod(tex, s, uv, std::max(std::log2(longer), min_level));
+    }
+    constexpr auto max_anisotropy = 16.f;
+    auto major_axis = lx < ly ? dpdy : dpdx;
+    auto shorter = std::max(std::min(lx, ly), longer / max_anisotropy);
+    auto level = std::max(std::log2(shorter), min_level);
+    auto n = static_cast<uint>(std::clamp(std::ceil(longer / shorter), 1.f, max_anisotropy));
+    if (n == 1u) { return texture_sample_lod(tex, s, uv, level); }
+    auto sum = luisa::make_float4(0.f);
+    auto inv_n = 1.f / static_cast<float>(n);
+    for (auto i = 0u; i < n; i++) {
+        auto offset = (static_cast<float>(i) + .5f) * inv_n - .5f;
+        sum += texture_sample_lod(tex, s, uv + offset * major_axis, level);
+    }
+    return sum * inv_n;
+}
+
+[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad(const Texture *handle, uint sampler, float u, float v, float dudx, float dvdx, float dudy, float dvdy) noexcept {
+    return luisa_fallback_bindless_texture2d_sample_grad_level(handle, sampler, u, v, dudx, dvdx, dudy, dvdy, 0.f);
+}
+
+[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad_level(const Texture *handle, uint sampler, float u, float v, float dudx, float dvdx, float dudy, float dvdy, float level) noexcept {
+    auto tex = reinterpret_cast<const FallbackTexture *>(handle);
+    auto result = texture_sample_grad(tex, Sampler::decode(sampler), make_float2(u, v),
+                                      make_float2(dudx, dvdx), make_float2(dudy, dvdy), level);
+    return {result.x, result.y, result.z, result.w};
+}
+
 [[nodiscard]] float4 luisa_fallback_bindless_texture3d_sample_grad(const Texture *handle, uint sampler, float u, float v, float w, float dudx, float dvdx, float dwdx, float dudy, float dvdy, float dwdy) noexcept {
-    return luisa_fallback_bindless_texture3d_sample(handle, sampler, u, v, w);
+    return luisa_fallback_bindless_texture3d_sample_grad_level(handle, sampler, u, v, w, dudx, dvdx, dwdx, dudy, dvdy, dwdy, 0.f);
 }
 
-// TODO: implement
 [[nodiscard]] float4 luisa_fallback_bindless_texture3d_sample_grad_level(const Texture *handle, uint sampler, float u, float v, float w, float dudx, float dvdx, float dwdx, float dudy, float dvdy, float dwdy, float level) noexcept {
-    return luisa_fallback_bindless_texture3d_sample_level(handle, sampler, u, v, w, level);
+    auto tex = reinterpret_cast<const FallbackTexture *>(handle);
+    auto result = texture_sample_grad(tex, Sampler::decode(sampler), make_float3(u, v, w),
+                                      make_float3(dudx, dvdx, dwdx), make_float3(dudy, dvdy, dwdy), level);
+    return {result.x, result.y, result.z, result.w};
 }
 
 [[nodiscard]] float4 luisa_fallback_bindless_texture2d_read_level(const Texture *handle, uint x, uint y, uint level) noexcept {
@@ -316,6 +401,16 @@ template<typename T>
     return luisa_fallback_bindless_texture3d_read_level(handle, x, y, z, 0u);
 }
 
+// curve hits have no v coordinate and are marked with a negative one, which Hit::is_curve() tests
+[[nodiscard]] static float fallback_closest_hit_bary_v(RTCScene scene, uint inst, float v) noexcept {
+    if (inst == RTC_INVALID_GEOMETRY_ID) { return v; }
+    auto primitive = static_cast<const FallbackPrimitive *>(rtcGetGeometryUserData(rtcGetGeometry(scene, inst)));
+    if (primitive != nullptr && primitive->tag() == FallbackPrimitive::Tag::MOTION_INSTANCE) {
+        primitive = static_cast<const FallbackMotionInstance *>(primitive)->child();
+    }
+    return primitive != nullptr && primitive->tag() == FallbackPrimitive::Tag::CURVE ? -1.f : v;
+}
+
 void luisa_fallback_accel_trace_closest(void *handle, EmbreeRayHit *ray_hit) noexcept {
     // prepare context
 #if LUISA_COMPUTE_EMBREE_VERSION == 3
@@ -334,6 +429,7 @@ void luisa_fallback_accel_trace_closest(void *handle, EmbreeRayHit *ray_hit) noe
 #else
     rtcIntersect1(scene, rh, &args);
 #endif
+    rh->hit.v = fallback_closest_hit_bary_v(scene, rh->hit.instID[0], rh->hit.v);
 }
 
 void luisa_fallback_accel_trace_any(void *handle, EmbreeRay *ray) noexcept {
@@ -356,4 +452,326 @@ void luisa_fallback_accel_trace_any(void *handle, EmbreeRay *ray) noexcept {
 #endif
 }
 
+namespace detail {
+
+static constexpr auto ray_packet_size = 8u;
+
+struct alignas(32) RayPacketValidMask {
+    int lanes[ray_packet_size];
+};
+
+[[nodiscard]] static RayPacketValidMask make_ray_packet_valid_mask(uint n) noexcept {
+    RayPacketValidMask valid{};
+    for (auto k = 0u; k < n; k++) { valid.lanes[k] = -1; }
+    return valid;
+}
+
+template<typename EmbreeRayPacket>
+static void fill_ray_packet(EmbreeRayPacket &r, const RayQuerySlot *slots, const uint *indices, uint n) noexcept {
+    for (auto k = 0u; k < n; k++) {
+        auto &&slot = slots[indices[k]];
+        auto ray = slot.ray;
+        r.org_x[k] = ray->origin[0];
+        r.org_y[k] = ray->origin[1];
+        r.org_z[k] = ray->origin[2];
+        r.tnear[k] = ray->t_min;
+        r.dir_x[k] = ray->direction[0];
+        r.dir_y[k] = ray->direction[1];
+        r.dir_z[k] = ray->direction[2];
+        r.time[k] = slot.time;
+        r.tfar[k] = ray->t_max;
+        r.mask[k] = slot.mask;
+        r.id[k] = 0u;
+        r.flags[k] = 0u;
+    }
+}
+
+static void trace_closest_packet(RTCScene scene, const RayQuerySlot *slots, const uint *indices, uint n) noexcept {
+    auto valid = make_ray_packet_valid_mask(n);
+    RTCRayHit8 rh;
+    fill_ray_packet(rh.ray, slots, indices, n);
+    for (auto k = 0u; k < n; k++) {
+        rh.hit.geomID[k] = RTC_INVALID_GEOMETRY_ID;
+        rh.hit.primID[k] = RTC_INVALID_GEOMETRY_ID;
+        rh.hit.instID[0][k] = RTC_INVALID_GEOMETRY_ID;
+    }
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+    RTCIntersectContext ctx{};
+    rtcInitIntersectContext(&ctx);
+    rtcIntersect8(valid.lanes, scene, &ctx, &rh);
+#else
+    RTCRayQueryContext ctx{};
+    rtcInitRayQueryContext(&ctx);
+    RTCIntersectArguments args{.context = &ctx};
+    rtcIntersect8(valid.lanes, scene, &rh, &args);
+#endif
+    for (auto k = 0u; k < n; k++) {
+        *static_cast<SurfaceHit *>(slots[indices[k]].result) = SurfaceHit{
+            .inst = rh.hit.instID[0][k],
+            .prim = rh.hit.primID[k],
+            .bary = {rh.hit.u[k], fallback_closest_hit_bary_v(scene, rh.hit.instID[0][k], rh.hit.v[k])},
+            .committed_ray_t = rh.ray.tfar[k]};
+    }
+}
+
+static void trace_any_packet(RTCScene scene, const RayQuerySlot *slots, const uint *indices, uint n) noexcept {
+    auto valid = make_ray_packet_valid_mask(n);
+    RTCRay8 r;
+    fill_ray_packet(r, slots, indices, n);
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+    RTCIntersectContext ctx{};
+    rtcInitIntersectContext(&ctx);
+    rtcOccluded8(valid.lanes, scene, &ctx, &r);
+#else
+    RTCRayQueryContext ctx{};
+    rtcInitRayQueryContext(&ctx);
+    RTCOccludedArguments args{.context = &ctx};
+    rtcOccluded8(valid.lanes, scene, &r, &args);
+#endif
+    // embree sets tfar to -inf for occluded rays
+    for (auto k = 0u; k < n; k++) {
+        *static_cast<bool *>(slots[indices[k]].result) = r.tfar[k] < 0.f;
+    }
+}
+
+}// namespace detail
+
+uint luisa_fallback_accel_trace_batch(RayQuerySlot *slots, uint count) noexcept {
+    auto served = 0u;
+    for (auto kind : {RAY_QUERY_SLOT_TRACE_CLOSEST, RAY_QUERY_SLOT_TRACE_ANY}) {
+        // gather queries of the same kind against the same scene into packets
+        uint indices[detail::ray_packet_size];
+        auto n = 0u;
+        RTCScene scene = nullptr;
+        auto flush = [&] {
+            if (n == 0u) { return; }
+            if (kind == RAY_QUERY_SLOT_TRACE_CLOSEST) {
+                detail::trace_closest_packet(scene, slots, indices, n);
+            } else {
+                detail::trace_any_packet(scene, slots, indices, n);
+            }
+            served += n;
+            n = 0u;
+        };
+        for (auto i = 0u; i < count; i++) {
+            if (slots[i].kind != kind) { continue; }
+            auto s = static_cast<RTCScene>(slots[i].accel->embree_scene);
+            if (n == detail::ray_packet_size || s != scene) {
+                flush();
+                scene = s;
+            }
+            indices[n++] = i;
+        }
+        flush();
+    }
+    return served;
+}
+
+namespace detail {
+
+// the embree context of a ray query traversal, which the
+// filter and the procedural callbacks cast back from
+struct RayQueryTraceContext {
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+    RTCIntersectContext base;
+#else
+    RTCRayQueryContext base;
+#endif
+    RayQueryObject *query;
+    RayQueryCandidateCallback on_surface_candidate;
+    void *surface_ctx;
+    RayQueryCandidateCallback on_procedural_candidate;
+    void *procedural_ctx;
+};
+
+// procedural primitives are shared by plain traces and ray queries, so their
+// callbacks only report candidates to the innermost ray query of the thread
+static thread_local const RayQueryTraceContext *active_ray_query = nullptr;
+
+[[nodiscard]] static bool ray_query_commit(RayQueryObject *query, const CommittedHit &hit) noexcept {
+    if (!(query->flags & RAY_QUERY_FLAG_COMMITTED)) { return false; }
+    query->committed = hit;
+    if (query->flags & RAY_QUERY_FLAG_TERMINATE_ON_FIRST_HIT) {
+        query->flags |= RAY_QUERY_FLAG_TERMINATED;
+    }
+    return true;
+}
+
+static void ray_query_filter(const RTCFilterFunctionNArguments *args) noexcept {
+    if (args->valid[0] == 0) { return; }
+    auto ctx = reinterpret_cast<const RayQueryTraceContext *>(args->context);
+    auto query = ctx->query;
+    auto ray = reinterpret_cast<RTCRay *>(args->ray);
+    auto hit = reinterpret_cast<const RTCHit *>(args->hit);
+    if (query->flags & RAY_QUERY_FLAG_TERMINATED) {
+        args->valid[0] = 0;
+        ray->tfar = -std::numeric_limits<float>::infinity();
+        return;
+    }
+    // curve hits have no v coordinate
+    auto primitive = static_cast<const FallbackPrimitive *>(args->geometryUserPtr);
+    auto is_curve = primitive != nullptr && primitive->tag() == FallbackPrimitive::Tag::CURVE;
+    auto v = is_curve ? -1.f : hit->v;
+    query->ray.t_max = ray->tfar;
+    query->candidate_type = RAY_QUERY_CANDIDATE_SURFACE;
+    query->candidate = SurfaceHit{.inst = hit->instID[0],
+                                  .prim = hit->primID,
+                                  .bary = {hit->u, v},
+                                  .committed_ray_t = ray->tfar};
+    if (query->instances[hit->instID[0]].opaque) {
+        query->flags |= RAY_QUERY_FLAG_COMMITTED;
+    } else {
+        query->flags &= ~RAY_QUERY_FLAG_COMMITTED;
+        if (ctx->on_surface_candidate != nullptr) { ctx->on_surface_candidate(ctx->surface_ctx); }
+    }
+    auto &&c = query->candidate;
+    auto committed = ray_query_commit(query, CommittedHit{.inst = c.inst,
+                                                          .prim = c.prim,
+                                                          .bary = c.bary,
+                                                          .hit_type = RAY_QUERY_CANDIDATE_SURFACE,
+                                                          .committed_ray_t = ray->tfar});
+    if (!committed) { args->valid[0] = 0; }
+    // a negative tfar stops the traversal
+    if (query->flags & RAY_QUERY_FLAG_TERMINATED) { ray->tfar = -std::numeric_limits<float>::infinity(); }
+}
+
+// reports a procedural candidate and returns whether it was committed within [t_min, tfar)
+[[nodiscard]] static bool ray_query_report_procedural(const RayQueryTraceContext *ctx, uint prim,
+                                                      float t_min, float &tfar) noexcept {
+    auto query = ctx->query;
+    if (query->flags & RAY_QUERY_FLAG_TERMINATED) {
+        tfar = -std::numeric_limits<float>::infinity();
+        return false;
+    }
+    query->ray.t_max = tfar;
+    query->candidate_type = RAY_QUERY_CANDIDATE_PROCEDURAL;
+    query->candidate = SurfaceHit{.inst = ctx->base.instID[0],
+                                  .prim = prim,
+                                  .bary = {0.f, 0.f},
+                                  .committed_ray_t = tfar};
+    query->flags &= ~RAY_QUERY_FLAG_COMMITTED;
+    if (ctx->on_procedural_candidate != nullptr) { ctx->on_procedural_candidate(ctx->procedural_ctx); }
+    auto t = query->candidate.committed_ray_t;
+    if (!(t >= t_min && t < tfar)) { query->flags &= ~RAY_QUERY_FLAG_COMMITTED; }
+    auto committed = ray_query_commit(query, CommittedHit{.inst = query->candidate.inst,
+                                                          .prim = prim,
+                                                          .bary = {0.f, 0.f},
+                                                          .hit_type = RAY_QUERY_CANDIDATE_PROCEDURAL,
+                                                          .committed_ray_t = t});
+    if (committed) { tfar = t; }
+    if (query->flags & RAY_QUERY_FLAG_TERMINATED) { tfar = -std::numeric_limits<float>::infinity(); }
+    return committed;
+}
+
+}// namespace detail
+
+void luisa_fallback_ray_query_init(RayQueryObject *query, const AccelView *accel, const Ray *ray,
+                                   uint mask, float time, uint flags) noexcept {
+    *query = RayQueryObject{.ray = *ray,
+                            .embree_scene = accel->embree_scene,
+                            .mask = mask,
+                            .time = time,
+                            .flags = flags,
+                            .candidate_type = RAY_QUERY_CANDIDATE_NONE,
+                            .candidate = {},
+                            .committed = CommittedHit{.inst = ~0u,
+                                                      .prim = ~0u,
+                                                      .bary = {0.f, 0.f},
+                                                      .hit_type = RAY_QUERY_CANDIDATE_NONE,
+                                                      .committed_ray_t = ray->t_max},
+                            .instances = accel->instances};
+}
+
+void luisa_fallback_ray_query_trace(RayQueryObject *query,
+                                    RayQueryCandidateCallback on_surface_candidate, void *surface_ctx,
+                                    RayQueryCandidateCallback on_procedural_candidate, void *procedural_ctx) noexcept {
+    if (query->flags & RAY_QUERY_FLAG_TERMINATED) { return; }
+    detail::RayQueryTraceContext ctx{.query = query,
+                                     .on_surface_candidate = on_surface_candidate,
+                                     .surface_ctx = surface_ctx,
+                                     .on_procedural_candidate = on_procedural_candidate,
+                                     .procedural_ctx = procedural_ctx};
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+    rtcInitIntersectContext(&ctx.base);
+    ctx.base.filter = detail::ray_query_filter;
+#else
+    rtcInitRayQueryContext(&ctx.base);
+#endif
+    auto &&r = query->ray;
+    RTCRay ray{.org_x = r.origin[0],
+               .org_y = r.origin[1],
+               .org_z = r.origin[2],
+               .tnear = r.t_min,
+               .dir_x = r.direction[0],
+               .dir_y = r.direction[1],
+               .dir_z = r.direction[2],
+               .time = query->time,
+               .tfar = r.t_max,
+               .mask = query->mask,
+               .id = 0u,
+               .flags = 0u};
+    // nested queries from the candidate callbacks restore the outer one on return
+    auto outer = detail::active_ray_query;
+    detail::active_ray_query = &ctx;
+    auto scene = static_cast<RTCScene>(query->embree_scene);
+    if (query->flags & RAY_QUERY_FLAG_TERMINATE_ON_FIRST_HIT) {
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+        rtcOccluded1(scene, &ctx.base, &ray);
+#else
+        RTCOccludedArguments args{};
+        rtcInitOccludedArguments(&args);
+        args.flags = static_cast<RTCRayQueryFlags>(RTC_RAY_QUERY_FLAG_INCOHERENT |
+                                                   RTC_RAY_QUERY_FLAG_INVOKE_ARGUMENT_FILTER);
+        args.filter = detail::ray_query_filter;
+        args.context = &ctx.base;
+        rtcOccluded1(scene, &ray, &args);
+#endif
+    } else {
+        RTCRayHit rh{.ray = ray};
+        rh.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+        rh.hit.primID = RTC_INVALID_GEOMETRY_ID;
+        rh.hit.instID[0] = RTC_INVALID_GEOMETRY_ID;
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+        rtcIntersect1(scene, &ctx.base, &rh);
+#else
+        RTCIntersectArguments args{};
+        rtcInitIntersectArguments(&args);
+        args.flags = static_cast<RTCRayQueryFlags>(RTC_RAY_QUERY_FLAG_INCOHERENT |
+                                                   RTC_RAY_QUERY_FLAG_INVOKE_ARGUMENT_FILTER);
+        args.filter = detail::ray_query_filter;
+        args.context = &ctx.base;
+        rtcIntersect1(scene, &rh, &args);
+#endif
+    }
+    detail::active_ray_query = outer;
+    query->candidate_type = RAY_QUERY_CANDIDATE_NONE;
+}
+
 }// namespace luisa::compute::fallback::api
+
+namespace luisa::compute::fallback {
+
+void luisa_fallback_procedural_intersect(const RTCIntersectFunctionNArguments *args) noexcept {
+    auto ctx = api::detail::active_ray_query;
+    if (args->valid[0] == 0 || ctx == nullptr ||
+        static_cast<const void *>(args->context) != &ctx->base) { return; }
+    auto rh = reinterpret_cast<RTCRayHit *>(args->rayhit);
+    if (api::detail::ray_query_report_procedural(ctx, args->primID, rh->ray.tnear, rh->ray.tfar)) {
+        rh->hit.u = 0.f;
+        rh->hit.v = 0.f;
+        rh->hit.primID = args->primID;
+        rh->hit.geomID = args->geomID;
+        rh->hit.instID[0] = args->context->instID[0];
+    }
+}
+
+void luisa_fallback_procedural_occluded(const RTCOccludedFunctionNArguments *args) noexcept {
+    auto ctx = api::detail::active_ray_query;
+    if (args->valid[0] == 0 || ctx == nullptr ||
+        static_cast<const void *>(args->context) != &ctx->base) { return; }
+    // occluded queries terminate on the first commit, which sets tfar to -inf
+    auto ray = reinterpret_cast<RTCRay *>(args->ray);
+    static_cast<void>(api::detail::ray_query_report_procedural(ctx, args->primID, ray->tnear, ray->tfar));
+}
+
+}// namespace luisa::compute::fallback
@@ -74,6 +74,14 @@ struct alignas(8) SurfaceHit {
     float committed_ray_t;
 };
 
+struct alignas(8) CommittedHit {
+    uint inst;
+    uint prim;
+    float2 bary;
+    uint hit_type;
+    float committed_ray_t;
+};
+
 struct alignas(16u) TextureView {
     void *_data;
     uint _width : 16u;
@@ -125,8 +133,8 @@ void luisa_fallback_texture3d_write_int(void *texture_data, uint64_t texture_dat
 
 [[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample(const Texture *handle, uint sampler, float u, float v) noexcept;
 [[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_level(const Texture *handle, uint sampler, float u, float v, float level) noexcept;
-[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad(const Texture *handle, uint sampler, float u, float v, float dudx, float dudy, float dvdx, float dvdy) noexcept;
-[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad_level(const Texture *handle, uint sampler, float u, float v, float dudx, float dudy, float dvdx, float dvdy, float level) noexcept;
+[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad(const Texture *handle, uint sampler, float u, float v, float dudx, float dvdx, float dudy, float dvdy) noexcept;
+[[nodiscard]] float4 luisa_fallback_bindless_texture2d_sample_grad_level(const Texture *handle, uint sampler, float u, float v, float dudx, float dvdx, float dudy, float dvdy, float level) noexcept;
 
 [[nodiscard]] float4 luisa_fallback_bindless_texture3d_sample(const Texture *handle, uint sampler, float u, float v, float w) noexcept;
 [[nodiscard]] float4 luisa_fallback_bindless_texture3d_sample_level(const Texture *handle, uint sampler, float u, float v, float w, float level) noexcept;
@@ -162,6 +170,65 @@ struct alignas(16) AccelView {
 void luisa_fallback_accel_trace_closest(void *handle, EmbreeRayHit *ray_hit) noexcept;
 void luisa_fallback_accel_trace_any(void *handle, EmbreeRay *ray) noexcept;
 
+// a ray query issued by a kernel thread that is suspended until the
+// whole block has reached a trace, so that rays can be traced in packets
+enum RayQuerySlotKind : uint {
+    RAY_QUERY_SLOT_NONE = 0u,
+    RAY_QUERY_SLOT_TRACE_CLOSEST = 1u,
+    RAY_QUERY_SLOT_TRACE_ANY = 2u,
+};
+
+struct alignas(8) RayQuerySlot {
+    uint kind;
+    uint mask;
+    const AccelView *accel;
+    const Ray *ray;
+    void *result;// SurfaceHit * for closest hits, bool * for any hits
+    float time;  // for motion blur; 0 for traces without a time
+};
+
+static_assert(sizeof(RayQuerySlot) == 40u);
+
+// traces all pending queries in the slots and returns the number of queries served
+[[nodiscard]] uint luisa_fallback_accel_trace_batch(RayQuerySlot *slots, uint count) noexcept;
+
+enum RayQueryFlag : uint {
+    RAY_QUERY_FLAG_TERMINATE_ON_FIRST_HIT = 1u << 0u,
+    RAY_QUERY_FLAG_COMMITTED = 1u << 1u,// the current candidate is committed
+    RAY_QUERY_FLAG_TERMINATED = 1u << 2u,
+};
+
+// also the hit types of committed hits
+enum RayQueryCandidateType : uint {
+    RAY_QUERY_CANDIDATE_NONE = 0u,
+    RAY_QUERY_CANDIDATE_SURFACE = 1u,
+    RAY_QUERY_CANDIDATE_PROCEDURAL = 2u,
+};
+
+// the state of a ray query object, read and written directly by kernels
+struct alignas(16) RayQueryObject {
+    Ray ray;
+    void *embree_scene;
+    uint mask;
+    float time;
+    uint flags;
+    uint candidate_type;
+    SurfaceHit candidate;// procedural commits store their distance in committed_ray_t
+    CommittedHit committed;
+    const AccelInstance *instances;// surface candidates of opaque instances are committed directly
+};
+
+static_assert(sizeof(RayQueryObject) == 112u);
+
+// invoked for each candidate with the context captured by the candidate block
+using RayQueryCandidateCallback = void (*)(void *ctx);
+
+void luisa_fallback_ray_query_init(RayQueryObject *query, const AccelView *accel, const Ray *ray,
+                                   uint mask, float time, uint flags) noexcept;
+void luisa_fallback_ray_query_trace(RayQueryObject *query,
+                                    RayQueryCandidateCallback on_surface_candidate, void *surface_ctx,
+                                    RayQueryCandidateCallback on_procedural_candidate, void *procedural_ctx) noexcept;
+
 }
 
 #ifndef LUISA_COMPUTE_FALLBACK_DEVICE_LIB
@@ -24,3 +24,6 @@ map_symbol("luisa.bindless.texture2d.read.level.impl", &api::luisa_fallback_bind
 map_symbol("luisa.bindless.texture3d.read.level.impl", &api::luisa_fallback_bindless_texture3d_read_level);
 map_symbol("luisa.accel.trace.closest.impl", &api::luisa_fallback_accel_trace_closest);
 map_symbol("luisa.accel.trace.any.impl", &api::luisa_fallback_accel_trace_any);
+map_symbol("luisa.accel.trace.batch", &api::luisa_fallback_accel_trace_batch);
+map_symbol("luisa.ray.query.init", &api::luisa_fallback_ray_query_init);
+map_symbol("luisa.ray.query.trace", &api::luisa_fallback_ray_query_trace);
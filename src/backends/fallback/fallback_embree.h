@@ -20,19 +20,26 @@
 
 namespace luisa::compute::fallback {
 
+[[nodiscard]] inline RTCBuildQuality luisa_fallback_accel_build_quality(const AccelOption &option) noexcept {
+    switch (option.hint) {
+        case AccelOption::UsageHint::FAST_TRACE: return RTC_BUILD_QUALITY_HIGH;
+        case AccelOption::UsageHint::FAST_BUILD: return RTC_BUILD_QUALITY_MEDIUM;
+    }
+    return RTC_BUILD_QUALITY_MEDIUM;
+}
+
 inline void luisa_fallback_accel_set_flags(RTCScene scene, const AccelOption &option) noexcept {
     auto scene_flags = 0u;
     if (option.allow_compaction) { scene_flags |= RTC_SCENE_FLAG_COMPACT; }
     if (option.allow_update) { scene_flags |= RTC_SCENE_FLAG_DYNAMIC; }
+    // ray queries install their candidate filter per traversal
+#if LUISA_COMPUTE_EMBREE_VERSION == 3
+    scene_flags |= RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION;
+#else
+    scene_flags |= RTC_SCENE_FLAG_FILTER_FUNCTION_IN_ARGUMENTS;
+#endif
     rtcSetSceneFlags(scene, static_cast<RTCSceneFlags>(scene_flags));
-    switch (option.hint) {
-        case AccelOption::UsageHint::FAST_TRACE:
-            rtcSetSceneBuildQuality(scene, RTC_BUILD_QUALITY_HIGH);
-            break;
-        case AccelOption::UsageHint::FAST_BUILD:
-            rtcSetSceneBuildQuality(scene, RTC_BUILD_QUALITY_MEDIUM);
-            break;
-    }
+    rtcSetSceneBuildQuality(scene, luisa_fallback_accel_build_quality(option));
 }
 
 }// namespace luisa::compute::fallback
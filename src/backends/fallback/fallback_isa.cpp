@@ -0,0 +1,114 @@
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/TargetParser/Host.h>
+
+#include <luisa/core/logging.h>
+
+#include "fallback_isa.h"
+
+namespace luisa::compute::fallback {
+
+luisa::string_view to_string(FallbackISA isa) noexcept {
+    switch (isa) {
+        case FallbackISA::GENERIC: return "generic";
+        case FallbackISA::SSE4: return "sse4";
+        case FallbackISA::AVX2: return "avx2";
+        case FallbackISA::AVX512: return "avx512";
+        case FallbackISA::NEON: return "neon";
+    }
+    LUISA_ERROR_WITH_LOCATION("Unknown fallback ISA.");
+}
+
+FallbackISA fallback_detect_host_isa() noexcept {
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return FallbackISA::NEON;
+#else
+#if LLVM_VERSION_MAJOR >= 20
+    auto features = ::llvm::sys::getHostCPUFeatures();
+#else
+    ::llvm::StringMap<bool> features;
+    if (!::llvm::sys::getHostCPUFeatures(features)) {
+        LUISA_WARNING_WITH_LOCATION("Failed to query host CPU features. Assuming a generic x86-64 CPU.");
+        return FallbackISA::GENERIC;
+    }
+#endif
+    auto has = [&features](const char *name) noexcept {
+        auto iter = features.find(name);
+        return iter != features.end() && iter->second;
+    };
+    if (has("avx512f") && has("avx512bw") && has("avx512dq") && has("avx512vl")) {
+        return FallbackISA::AVX512;
+    }
+    if (has("avx2") && has("fma")) { return FallbackISA::AVX2; }
+    if (has("sse4.1") && has("sse4.2")) { return FallbackISA::SSE4; }
+    return FallbackISA::GENERIC;
+#endif
+}
+
+FallbackISA fallback_select_isa(luisa::string_view requested) noexcept {
+    auto host_isa = fallback_detect_host_isa();
+    if (requested.empty() || requested == "auto" || requested == "native") { return host_isa; }
+    auto isa = [&] {
+        if (requested == "generic" || requested == "sse2") { return FallbackISA::GENERIC; }
+        if (requested == "sse4" || requested == "sse4.2") { return FallbackISA::SSE4; }
+        if (requested == "avx2") { return FallbackISA::AVX2; }
+        if (requested == "avx512") { return FallbackISA::AVX512; }
+        if (requested == "neon") { return FallbackISA::NEON; }
+        LUISA_WARNING_WITH_LOCATION("Unknown ISA '{}'. Using host ISA '{}'.",
+                                    requested, to_string(host_isa));
+        return host_isa;
+    }();
+    if ((isa == FallbackISA::NEON) != (host_isa == FallbackISA::NEON) ||
+        luisa::to_underlying(isa) > luisa::to_underlying(host_isa)) {
+        LUISA_WARNING_WITH_LOCATION("Requested ISA '{}' is not supported by the host. Using '{}' instead.",
+                                    requested, to_string(host_isa));
+        return host_isa;
+    }
+    return isa;
+}
+
+luisa::string fallback_isa_llvm_cpu(FallbackISA isa) noexcept {
+    // the host CPU model would imply SSE4 even with the features switched off
+    return isa == FallbackISA::GENERIC ? "x86-64" : "";
+}
+
+luisa::vector<luisa::string> fallback_isa_llvm_features(FallbackISA isa) noexcept {
+    // the JIT target machine starts from the full host feature set,
+    // so we only have to switch off what lies beyond the selected ISA
+    switch (isa) {
+        case FallbackISA::GENERIC: return {"-sse4.1", "-sse4.2", "-avx"};
+        case FallbackISA::SSE4: return {"-avx"};
+        case FallbackISA::AVX2: return {"-avx512f"};
+        case FallbackISA::AVX512: return {"-prefer-256-bit"};
+        case FallbackISA::NEON: return {"+neon"};
+    }
+    return {};
+}
+
+uint fallback_isa_simd_width(FallbackISA isa) noexcept {
+    switch (isa) {
+        case FallbackISA::GENERIC: return 4u;
+        case FallbackISA::SSE4: return 4u;
+        case FallbackISA::AVX2: return 8u;
+        case FallbackISA::AVX512: return 16u;
+        case FallbackISA::NEON: return 4u;
+    }
+    return 1u;
+}
+
+luisa::string fallback_isa_embree_config(FallbackISA isa) noexcept {
+    switch (isa) {
+        case FallbackISA::GENERIC: return "isa=sse2,frequency_level=simd128";
+        case FallbackISA::SSE4: return "isa=sse4.2,frequency_level=simd128";
+        case FallbackISA::AVX2: return "isa=avx2,frequency_level=simd256";
+#if LUISA_COMPUTE_EMBREE_VERSION >= 4
+        case FallbackISA::AVX512: return "isa=avx512,frequency_level=simd512";
+#else
+        case FallbackISA::AVX512: return "isa=avx512skx,frequency_level=simd512";
+#endif
+        case FallbackISA::NEON: return "isa=neon";
+    }
+    return {};
+}
+
+}// namespace luisa::compute::fallback
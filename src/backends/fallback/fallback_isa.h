@@ -0,0 +1,38 @@
+#pragma once
+
+#include <luisa/core/basic_types.h>
+#include <luisa/core/stl/string.h>
+#include <luisa/core/stl/vector.h>
+
+namespace luisa::compute::fallback {
+
+enum struct FallbackISA : uint8_t {
+    GENERIC,// baseline x86-64 without SSE4.1/4.2
+    SSE4,
+    AVX2,
+    AVX512,
+    NEON,
+};
+
+[[nodiscard]] luisa::string_view to_string(FallbackISA isa) noexcept;
+
+// the widest ISA supported by the host CPU
+[[nodiscard]] FallbackISA fallback_detect_host_isa() noexcept;
+
+// parses the user-requested ISA ("auto", "generic", "sse4", "avx2", "avx512" or "neon")
+// and clamps it to what the host CPU actually supports
+[[nodiscard]] FallbackISA fallback_select_isa(luisa::string_view requested) noexcept;
+
+// the LLVM target CPU to use instead of the host CPU, or empty to keep the host CPU
+[[nodiscard]] luisa::string fallback_isa_llvm_cpu(FallbackISA isa) noexcept;
+
+// extra LLVM target features (on top of the detected host features) to restrict codegen to the ISA
+[[nodiscard]] luisa::vector<luisa::string> fallback_isa_llvm_features(FallbackISA isa) noexcept;
+
+// number of 32-bit lanes in the ISA's widest vector register
+[[nodiscard]] uint fallback_isa_simd_width(FallbackISA isa) noexcept;
+
+// configuration string passed to rtcNewDevice
+[[nodiscard]] luisa::string fallback_isa_embree_config(FallbackISA isa) noexcept;
+
+}// namespace luisa::compute::fallback
@@ -10,17 +10,15 @@
 namespace luisa::compute::fallback {
 
 FallbackMesh::FallbackMesh(RTCDevice device, const AccelOption &option) noexcept
-    : _handle{rtcNewScene(device)},
-      _geometry{rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE)} {
-    luisa_fallback_accel_set_flags(_handle, option);
+    : FallbackPrimitive{Tag::MESH, device, option},
+      _geometry{rtcNewGeometry(device, RTC_GEOMETRY_TYPE_TRIANGLE)},
+      _build_quality{luisa_fallback_accel_build_quality(option)},
+      _allow_update{option.allow_update} {
+    rtcSetGeometryBuildQuality(_geometry, _build_quality);
     rtcAttachGeometry(_handle, _geometry);
     rtcReleaseGeometry(_geometry);// already moved into the scene
 }
 
-FallbackMesh::~FallbackMesh() noexcept {
-    rtcReleaseScene(_handle);
-}
-
 void FallbackMesh::build(luisa::unique_ptr<MeshBuildCommand> cmd) noexcept {
     auto v_buffer = reinterpret_cast<FallbackBuffer *>(cmd->vertex_buffer())->data();
     auto t_buffer = reinterpret_cast<FallbackBuffer *>(cmd->triangle_buffer())->data();
@@ -28,10 +26,27 @@ void FallbackMesh::build(luisa::unique_ptr<MeshBuildCommand> cmd) noexcept {
     LUISA_DEBUG_ASSERT(cmd->triangle_buffer_size() % sizeof(Triangle) == 0u, "Invalid triangle buffer size.");
     auto v_count = cmd->vertex_buffer_size() / cmd->vertex_stride();
     auto t_count = cmd->triangle_buffer_size() / sizeof(Triangle);
+    // refit the existing BVH if only the vertices moved
+    auto refit = _allow_update &&
+                 cmd->request() == AccelBuildRequest::PREFER_UPDATE &&
+                 _triangle_buffer == t_buffer &&
+                 _triangle_buffer_offset == cmd->triangle_buffer_offset() &&
+                 _triangle_count == t_count &&
+                 _vertex_count == v_count;
     rtcSetSharedGeometryBuffer(_geometry, RTC_BUFFER_TYPE_VERTEX, 0u, RTC_FORMAT_FLOAT3,
                                v_buffer, cmd->vertex_buffer_offset(), cmd->vertex_stride(), v_count);
-    rtcSetSharedGeometryBuffer(_geometry, RTC_BUFFER_TYPE_INDEX, 0u, RTC_FORMAT_UINT3,
-                               t_buffer, cmd->triangle_buffer_offset(), sizeof(Triangle), t_count);
+    if (refit) {
+        rtcUpdateGeometryBuffer(_geometry, RTC_BUFFER_TYPE_VERTEX, 0u);
+        rtcSetGeometryBuildQuality(_geometry, RTC_BUILD_QUALITY_REFIT);
+    } else {
+        rtcSetSharedGeometryBuffer(_geometry, RTC_BUFFER_TYPE_INDEX, 0u, RTC_FORMAT_UINT3,
+                                   t_buffer, cmd->triangle_buffer_offset(), sizeof(Triangle), t_count);
+        rtcSetGeometryBuildQuality(_geometry, _build_quality);
+        _triangle_buffer = t_buffer;
+        _triangle_buffer_offset = cmd->triangle_buffer_offset();
+        _triangle_count = t_count;
+        _vertex_count = v_count;
+    }
     rtcCommitGeometry(_geometry);
     rtcCommitScene(_handle);
 }
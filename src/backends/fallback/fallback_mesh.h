@@ -5,20 +5,24 @@
 #pragma once
 
 #include <luisa/runtime/rtx/mesh.h>
-#include "fallback_embree.h"
+#include "fallback_primitive.h"
 
 namespace luisa::compute::fallback {
 
-class FallbackMesh {
+class FallbackMesh final : public FallbackPrimitive {
 
 private:
-    RTCScene _handle;
     RTCGeometry _geometry;
+    RTCBuildQuality _build_quality;
+    bool _allow_update;
+    // topology of the last full build; the BVH can only be refit while it is unchanged
+    const std::byte *_triangle_buffer{nullptr};
+    size_t _triangle_buffer_offset{0u};
+    size_t _triangle_count{0u};
+    size_t _vertex_count{0u};
 
 public:
     FallbackMesh(RTCDevice device, const AccelOption &option) noexcept;
-    ~FallbackMesh() noexcept;
-    [[nodiscard]] auto handle() const noexcept { return _handle; }
     void build(luisa::unique_ptr<MeshBuildCommand> cmd) noexcept;
 };
 
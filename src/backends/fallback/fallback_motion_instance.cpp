@@ -0,0 +1,112 @@
+#include <algorithm>
+
+#include <luisa/core/logging.h>
+
+#include "fallback_motion_instance.h"
+
+namespace luisa::compute::fallback {
+
+FallbackMotionInstance::FallbackMotionInstance(const AccelMotionOption &option) noexcept
+    : FallbackPrimitive{Tag::MOTION_INSTANCE}, _option{option} {
+    LUISA_ASSERT(option.keyframe_count >= 2u,
+                 "Motion instance should have at least two keyframes.");
+    LUISA_ASSERT(option.mode == AccelMotionMode::MATRIX || option.mode == AccelMotionMode::SRT,
+                 "Unsupported motion mode.");
+}
+
+void FallbackMotionInstance::build(luisa::unique_ptr<MotionInstanceBuildCommand> cmd) noexcept {
+    LUISA_ASSERT(cmd->keyframes().size() == _option.keyframe_count,
+                 "Keyframe count mismatch.");
+    _child = reinterpret_cast<const FallbackPrimitive *>(cmd->child());
+    LUISA_ASSERT(_child->tag() != Tag::MOTION_INSTANCE,
+                 "Motion instances cannot be nested.");
+    _keyframes = cmd->steal_keyframes();
+}
+
+namespace detail {
+
+// m is a 3x4 row-major matrix, while the input is 4x4 column-major
+static void motion_keyframe_to_affine(const MotionInstanceTransformMatrix &t, float m[12]) noexcept {
+    for (auto r = 0u; r < 3u; r++) {
+        for (auto c = 0u; c < 4u; c++) {
+            m[r * 4u + c] = t[c][r];
+        }
+    }
+}
+
+// T * R * S, where S also carries the shear and the pivot
+static void motion_keyframe_to_affine(const MotionInstanceTransformSRT &t, float m[12]) noexcept {
+    float s[12] = {t.scale[0], t.shear[0], t.shear[1], t.pivot[0],
+                   0.f, t.scale[1], t.shear[2], t.pivot[1],
+                   0.f, 0.f, t.scale[2], t.pivot[2]};
+    auto [x, y, z, w] = t.quaternion;
+    float r[9] = {1.f - 2.f * (y * y + z * z), 2.f * (x * y - w * z), 2.f * (x * z + w * y),
+                  2.f * (x * y + w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z - w * x),
+                  2.f * (x * z - w * y), 2.f * (y * z + w * x), 1.f - 2.f * (x * x + y * y)};
+    for (auto i = 0u; i < 3u; i++) {
+        for (auto j = 0u; j < 4u; j++) {
+            m[i * 4u + j] = r[i * 3u + 0u] * s[0u * 4u + j] +
+                            r[i * 3u + 1u] * s[1u * 4u + j] +
+                            r[i * 3u + 2u] * s[2u * 4u + j];
+        }
+        m[i * 4u + 3u] += t.translation[i];
+    }
+}
+
+// out = a * b, treating both as affine 4x4 matrices
+static void multiply_affine(const float a[12], const float b[12], float out[12]) noexcept {
+    for (auto i = 0u; i < 3u; i++) {
+        for (auto j = 0u; j < 4u; j++) {
+            out[i * 4u + j] = a[i * 4u + 0u] * b[0u * 4u + j] +
+                              a[i * 4u + 1u] * b[1u * 4u + j] +
+                              a[i * 4u + 2u] * b[2u * 4u + j];
+        }
+        out[i * 4u + 3u] += a[i * 4u + 3u];
+    }
+}
+
+[[nodiscard]] static bool is_identity_affine(const float m[12]) noexcept {
+    constexpr float identity[12] = {1.f, 0.f, 0.f, 0.f,
+                                    0.f, 1.f, 0.f, 0.f,
+                                    0.f, 0.f, 1.f, 0.f};
+    return std::equal(m, m + 12, identity);
+}
+
+}// namespace detail
+
+void FallbackMotionInstance::apply(RTCGeometry geometry, const float affine[12]) const noexcept {
+    LUISA_ASSERT(_child != nullptr, "Motion instance is not built.");
+    rtcSetGeometryInstancedScene(geometry, _child->handle());
+    rtcSetGeometryTimeStepCount(geometry, _option.keyframe_count);
+    rtcSetGeometryTimeRange(geometry, _option.time_start, _option.time_end);
+    // embree interpolates SRT keyframes natively, but an extra instance
+    // transform can only be folded into matrix keyframes
+    if (_option.mode == AccelMotionMode::SRT && detail::is_identity_affine(affine)) {
+        for (auto i = 0u; i < _option.keyframe_count; i++) {
+            auto &&srt = _keyframes[i].as_srt();
+            RTCQuaternionDecomposition d{};
+            rtcInitQuaternionDecomposition(&d);
+            rtcQuaternionDecompositionSetScale(&d, srt.scale[0], srt.scale[1], srt.scale[2]);
+            rtcQuaternionDecompositionSetSkew(&d, srt.shear[0], srt.shear[1], srt.shear[2]);
+            rtcQuaternionDecompositionSetShift(&d, srt.pivot[0], srt.pivot[1], srt.pivot[2]);
+            rtcQuaternionDecompositionSetQuaternion(&d, srt.quaternion[3], srt.quaternion[0],
+                                                    srt.quaternion[1], srt.quaternion[2]);
+            rtcQuaternionDecompositionSetTranslation(&d, srt.translation[0], srt.translation[1], srt.translation[2]);
+            rtcSetGeometryTransformQuaternion(geometry, i, &d);
+        }
+    } else {
+        for (auto i = 0u; i < _option.keyframe_count; i++) {
+            float key[12];
+            if (_option.mode == AccelMotionMode::SRT) {
+                detail::motion_keyframe_to_affine(_keyframes[i].as_srt(), key);
+            } else {
+                detail::motion_keyframe_to_affine(_keyframes[i].as_matrix(), key);
+            }
+            float m[12];
+            detail::multiply_affine(affine, key, m);
+            rtcSetGeometryTransform(geometry, i, RTC_FORMAT_FLOAT3X4_ROW_MAJOR, m);
+        }
+    }
+}
+
+}// namespace luisa::compute::fallback
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <luisa/runtime/rtx/motion_instance.h>
+#include "fallback_primitive.h"
+
+namespace luisa::compute::fallback {
+
+// motion instances have no BVH of their own: they are expanded into
+// the time steps of the accel instance geometries that refer to them
+class FallbackMotionInstance final : public FallbackPrimitive {
+
+private:
+    AccelMotionOption _option;
+    const FallbackPrimitive *_child{nullptr};
+    luisa::vector<MotionInstanceTransform> _keyframes;
+
+public:
+    explicit FallbackMotionInstance(const AccelMotionOption &option) noexcept;
+    void build(luisa::unique_ptr<MotionInstanceBuildCommand> cmd) noexcept;
+    // sets up the instance geometry with the keyframes premultiplied by the instance transform
+    void apply(RTCGeometry geometry, const float affine[12]) const noexcept;
+    [[nodiscard]] auto child() const noexcept { return _child; }
+};
+
+}// namespace luisa::compute::fallback
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <luisa/runtime/rhi/resource.h>
+#include "fallback_embree.h"
+
+namespace luisa::compute::fallback {
+
+// common base of the bottom-level structures that accel instances refer to
+class FallbackPrimitive {
+
+public:
+    enum struct Tag : uint8_t {
+        MESH,
+        CURVE,
+        PROCEDURAL,
+        MOTION_INSTANCE,
+    };
+
+private:
+    Tag _tag;
+
+protected:
+    RTCScene _handle{nullptr};
+
+protected:
+    explicit FallbackPrimitive(Tag tag) noexcept : _tag{tag} {}
+    FallbackPrimitive(Tag tag, RTCDevice device, const AccelOption &option) noexcept
+        : _tag{tag}, _handle{rtcNewScene(device)} { luisa_fallback_accel_set_flags(_handle, option); }
+
+public:
+    virtual ~FallbackPrimitive() noexcept {
+        if (_handle != nullptr) { rtcReleaseScene(_handle); }
+    }
+    FallbackPrimitive(const FallbackPrimitive &) noexcept = delete;
+    FallbackPrimitive &operator=(const FallbackPrimitive &) noexcept = delete;
+    [[nodiscard]] auto tag() const noexcept { return _tag; }
+    [[nodiscard]] auto handle() const noexcept { return _handle; }
+};
+
+}// namespace luisa::compute::fallback
@@ -0,0 +1,51 @@
+#include <luisa/core/logging.h>
+
+#include "fallback_buffer.h"
+#include "fallback_procedural_primitive.h"
+
+namespace luisa::compute::fallback {
+
+FallbackProceduralPrimitive::FallbackProceduralPrimitive(RTCDevice device, const AccelOption &option) noexcept
+    : FallbackPrimitive{Tag::PROCEDURAL, device, option},
+      _geometry{rtcNewGeometry(device, RTC_GEOMETRY_TYPE_USER)},
+      _build_quality{luisa_fallback_accel_build_quality(option)},
+      _allow_update{option.allow_update} {
+    rtcSetGeometryUserData(_geometry, this);
+    rtcSetGeometryBoundsFunction(_geometry, &FallbackProceduralPrimitive::_bounds, this);
+    rtcSetGeometryIntersectFunction(_geometry, &luisa_fallback_procedural_intersect);
+    rtcSetGeometryOccludedFunction(_geometry, &luisa_fallback_procedural_occluded);
+    rtcSetGeometryBuildQuality(_geometry, _build_quality);
+    rtcAttachGeometry(_handle, _geometry);
+    rtcReleaseGeometry(_geometry);// already moved into the scene
+}
+
+void FallbackProceduralPrimitive::_bounds(const RTCBoundsFunctionArguments *args) noexcept {
+    auto self = static_cast<const FallbackProceduralPrimitive *>(args->geometryUserPtr);
+    AABB aabb{};
+    std::memcpy(&aabb, self->_aabb_buffer + args->primID * sizeof(AABB), sizeof(AABB));
+    *args->bounds_o = RTCBounds{.lower_x = aabb.packed_min[0],
+                                .lower_y = aabb.packed_min[1],
+                                .lower_z = aabb.packed_min[2],
+                                .upper_x = aabb.packed_max[0],
+                                .upper_y = aabb.packed_max[1],
+                                .upper_z = aabb.packed_max[2]};
+}
+
+void FallbackProceduralPrimitive::build(luisa::unique_ptr<ProceduralPrimitiveBuildCommand> cmd) noexcept {
+    auto buffer = reinterpret_cast<FallbackBuffer *>(cmd->aabb_buffer())->data();
+    LUISA_DEBUG_ASSERT(cmd->aabb_buffer_size() % sizeof(AABB) == 0u, "Invalid AABB buffer size.");
+    auto aabb = buffer + cmd->aabb_buffer_offset();
+    auto n = cmd->aabb_buffer_size() / sizeof(AABB);
+    // embree queries the bounds during the build, so only the primitive count is topology
+    auto refit = _allow_update &&
+                 cmd->request() == AccelBuildRequest::PREFER_UPDATE &&
+                 _aabb_count == n;
+    _aabb_buffer = aabb;
+    _aabb_count = n;
+    rtcSetGeometryUserPrimitiveCount(_geometry, n);
+    rtcSetGeometryBuildQuality(_geometry, refit ? RTC_BUILD_QUALITY_REFIT : _build_quality);
+    rtcCommitGeometry(_geometry);
+    rtcCommitScene(_handle);
+}
+
+}// namespace luisa::compute::fallback
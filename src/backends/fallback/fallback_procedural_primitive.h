@@ -0,0 +1,30 @@
+#pragma once
+
+#include <luisa/runtime/rtx/procedural_primitive.h>
+#include "fallback_primitive.h"
+
+namespace luisa::compute::fallback {
+
+// procedural candidates are reported to ray queries from these callbacks,
+// which are implemented along with the ray query runtime in the device api
+void luisa_fallback_procedural_intersect(const RTCIntersectFunctionNArguments *args) noexcept;
+void luisa_fallback_procedural_occluded(const RTCOccludedFunctionNArguments *args) noexcept;
+
+class FallbackProceduralPrimitive final : public FallbackPrimitive {
+
+private:
+    RTCGeometry _geometry;
+    RTCBuildQuality _build_quality;
+    bool _allow_update;
+    const std::byte *_aabb_buffer{nullptr};
+    size_t _aabb_count{0u};
+
+private:
+    static void _bounds(const RTCBoundsFunctionArguments *args) noexcept;
+
+public:
+    FallbackProceduralPrimitive(RTCDevice device, const AccelOption &option) noexcept;
+    void build(luisa::unique_ptr<ProceduralPrimitiveBuildCommand> cmd) noexcept;
+};
+
+}// namespace luisa::compute::fallback
@@ -15,19 +15,30 @@
 #include <llvm/Analysis/LoopAnalysisManager.h>
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Config/llvm-config.h>
 
 #include <luisa/core/stl.h>
 #include <luisa/core/logging.h>
 #include <luisa/core/clock.h>
+#include <luisa/core/binary_io.h>
 
 #include <luisa/xir/translators/ast2xir.h>
 #include <luisa/xir/translators/xir2text.h>
 #include <luisa/xir/instructions/print.h>
 
+#include <luisa/xir/passes/outline.h>
+#include <luisa/xir/passes/inline.h>
 #include <luisa/xir/passes/dce.h>
 #include <luisa/xir/passes/local_store_forward.h>
 #include <luisa/xir/passes/local_load_elimination.h>
 #include <luisa/xir/passes/trace_gep.h>
+#include <luisa/xir/passes/sroa.h>
+#include <luisa/xir/passes/mem2reg.h>
+#include <luisa/xir/passes/const_fold.h>
+#include <luisa/xir/passes/gvn.h>
+#include <luisa/xir/passes/licm.h>
 
 #include "../common/shader_print_formatter.h"
 
@@ -85,6 +96,17 @@ static void luisa_fallback_assert(bool condition, const char *message) noexcept
     if (!condition) { LUISA_ERROR_WITH_LOCATION("Assertion failed: {}.", message); }
 }
 
+// frames of kernel threads suspended at block barriers
+static constexpr auto coroutine_frame_alignment = 16u;
+
+[[nodiscard]] static void *luisa_fallback_coro_alloc(size_t size) noexcept {
+    return luisa::detail::allocator_allocate(size, coroutine_frame_alignment);
+}
+
+static void luisa_fallback_coro_free(void *frame) noexcept {
+    luisa::detail::allocator_deallocate(frame, coroutine_frame_alignment);
+}
+
 static thread_local const DeviceInterface::StreamLogCallback *current_device_log_callback{nullptr};
 
 static void luisa_fallback_print(const FallbackShader *shader, size_t fmt_id, const std::byte *args) noexcept {
@@ -105,8 +127,76 @@ struct FallbackShaderLaunchConfig {
     uint3 block_size;
 };
 
+// header prepended to cached kernel objects to detect stale or mismatched entries
+struct FallbackShaderObjectHeader {
+    static constexpr auto magic_value = 0x6a626f2e6b6c6366ull;// "fclk.obj"
+    uint64_t magic;
+    uint64_t key;
+    uint64_t object_size;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(FallbackShaderObjectHeader) == 32u);
+
 FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &option, Function kernel) noexcept {
 
+    _block_size = kernel.block_size();
+    _build_bound_arguments(kernel.bound_arguments());
+    _argument_usages.reserve(kernel.arguments().size());
+    for (auto arg : kernel.arguments()) {
+        _argument_usages.emplace_back(kernel.variable_usage(arg.uid()));
+    }
+
+    // compute argument buffer size
+    _argument_buffer_size = 0u;
+    static constexpr auto argument_alignment = 16u;
+    for (auto arg : kernel.arguments()) {
+        switch (arg.tag()) {
+            case Variable::Tag::LOCAL: {
+                _argument_buffer_size += arg.type()->size();
+                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
+                break;
+            }
+            case Variable::Tag::BUFFER: {
+                _argument_buffer_size += sizeof(FallbackBufferView);
+                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
+                break;
+            }
+            case Variable::Tag::TEXTURE: {
+                _argument_buffer_size += sizeof(FallbackTextureView);
+                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
+                break;
+            }
+            case Variable::Tag::BINDLESS_ARRAY: {
+                _argument_buffer_size += sizeof(FallbackBindlessArray *);
+                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
+                break;
+            }
+            case Variable::Tag::ACCEL: {
+                _argument_buffer_size += sizeof(FallbackAccel *);
+                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
+                break;
+            }
+            default: LUISA_ERROR_WITH_LOCATION("Unsupported argument type.");
+        }
+    }
+
+    // compile the kernel, either in place or on the device's compile thread pool
+    if (auto compile_pool = device->compile_thread_pool()) {
+        // make sure the kernel hash is computed on the calling thread
+        static_cast<void>(kernel.hash());
+        _compilation = compile_pool->async([this, device, option, builder = kernel.shared_builder()] {
+            _compile(device, option, Function{builder.get()});
+        });
+    } else {
+        _compile(device, option, kernel);
+    }
+}
+
+void FallbackShader::_compile(const FallbackDevice *device, const ShaderOption &option, Function kernel) noexcept {
+
+    Clock clk;
+
     // build JIT engine
     ::llvm::orc::LLJITBuilder jit_builder;
     if (auto host = ::llvm::orc::JITTargetMachineBuilder::detectHost()) {
@@ -132,11 +222,12 @@ FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &optio
         options.NoTrapAfterNoreturn = true;
         host->setOptions(options);
         host->setCodeGenOptLevel(::llvm::CodeGenOptLevel::Aggressive);
-#ifdef __aarch64__
-        host->addFeatures({"+neon"});
-#else
-        host->addFeatures({"+avx2"});
-#endif
+        if (auto cpu = device->llvm_target_cpu(); !cpu.empty()) {
+            host->setCPU(std::string{cpu});
+        }
+        for (auto &&feature : device->llvm_target_features()) {
+            host->getFeatures().AddFeature(::llvm::StringRef{feature.data(), feature.size()});
+        }
         // LUISA_INFO("LLVM JIT target: triplet = {}, features = {}.",
         //            host->getTargetTriple().str(),
         //            host->getFeatures().getString());
@@ -175,8 +266,151 @@ FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &optio
     //     LUISA_ERROR_WITH_LOCATION("Failed to add generator.");
     // }
 
-    _block_size = kernel.block_size();
-    _build_bound_arguments(kernel.bound_arguments());
+    // map symbols
+    llvm::orc::SymbolMap symbol_map{};
+    auto map_symbol = [jit = _jit.get(), &symbol_map]<typename T>(const char *name, T *f) noexcept {
+        auto addr = llvm::orc::ExecutorAddr::fromPtr(f);
+        auto symbol = llvm::orc::ExecutorSymbolDef{addr, llvm::JITSymbolFlags::Callable};
+        symbol_map.try_emplace(jit->mangleAndIntern(name), symbol);
+    };
+
+#include "fallback_device_api_map_symbols.inl.h"
+
+    // asin, acos, atan, atan2
+    map_symbol("luisa.asin.f16", &luisa_fallback_asin_f16);
+    map_symbol("luisa.asin.f32", &luisa_fallback_asin_f32);
+    map_symbol("luisa.asin.f64", &luisa_fallback_asin_f64);
+    map_symbol("luisa.acos.f16", &luisa_fallback_acos_f16);
+    map_symbol("luisa.acos.f32", &luisa_fallback_acos_f32);
+    map_symbol("luisa.acos.f64", &luisa_fallback_acos_f64);
+    map_symbol("luisa.atan.f16", &luisa_fallback_atan_f16);
+    map_symbol("luisa.atan.f32", &luisa_fallback_atan_f32);
+    map_symbol("luisa.atan.f64", &luisa_fallback_atan_f64);
+    map_symbol("luisa.atan2.f16", &luisa_fallback_atan2_f16);
+    map_symbol("luisa.atan2.f32", &luisa_fallback_atan2_f32);
+    map_symbol("luisa.atan2.f64", &luisa_fallback_atan2_f64);
+
+    // assert
+    map_symbol("luisa.assert", &luisa_fallback_assert);
+
+    // coroutine frames
+    map_symbol("luisa.coro.alloc", &luisa_fallback_coro_alloc);
+    map_symbol("luisa.coro.free", &luisa_fallback_coro_free);
+
+    // define symbols
+    if (auto error = _jit->getMainJITDylib().define(
+            ::llvm::orc::absoluteSymbols(std::move(symbol_map)))) {
+        ::llvm::handleAllErrors(std::move(error), [](const ::llvm::ErrorInfoBase &err) {
+            LUISA_WARNING_WITH_LOCATION("LLJIT::define(): {}", err.message());
+        });
+        LUISA_ERROR_WITH_LOCATION("Failed to define symbols.");
+    }
+
+    // try loading the compiled object from cache, otherwise compile the kernel
+    auto object_key = _object_cache_key(device, option, kernel);
+    auto object = _load_object(device->io(), option, kernel, object_key);
+    if (object.empty()) {
+        auto cacheable = true;
+        object = _compile_object(device, option, kernel, cacheable);
+        if (cacheable) { _store_object(device->io(), option, object_key, object); }
+    }
+
+    // load the object into the JIT
+    auto object_buffer = ::llvm::MemoryBuffer::getMemBufferCopy(
+        ::llvm::StringRef{reinterpret_cast<const char *>(object.data()), object.size()},
+        luisa::format("kernel_{:016x}.o", kernel.hash()));
+    if (auto error = _jit->addObjectFile(std::move(object_buffer))) {
+        ::llvm::handleAllErrors(std::move(error), [](const ::llvm::ErrorInfoBase &err) {
+            LUISA_WARNING_WITH_LOCATION("LLJIT::addObjectFile(): {}", err.message());
+        });
+    }
+    auto addr = _jit->lookup("kernel.main");
+    if (!addr) {
+        ::llvm::handleAllErrors(addr.takeError(), [](const ::llvm::ErrorInfoBase &err) {
+            LUISA_WARNING_WITH_LOCATION("LLJIT::lookup(): {}", err.message());
+        });
+    }
+    LUISA_ASSERT(addr, "JIT compilation failed with error [{}]");
+    _kernel_entry = addr->toPtr<kernel_entry_t>();
+    LUISA_VERBOSE("Shader compilation took {} ms.", clk.toc());
+}
+
+uint64_t FallbackShader::_object_cache_key(const FallbackDevice *device, const ShaderOption &option, Function kernel) const noexcept {
+    // everything that affects the generated machine code goes into the key
+    auto triple = _target_machine->getTargetTriple().str();
+    auto cpu = _target_machine->getTargetCPU();
+    auto features = _target_machine->getTargetFeatureString();
+    return luisa::hash_combine({kernel.hash(),
+                                luisa::hash_value(luisa::string_view{triple}),
+                                luisa::hash_value(luisa::string_view{cpu.data(), cpu.size()}),
+                                luisa::hash_value(luisa::string_view{features.data(), features.size()}),
+                                luisa::hash_value(option.enable_fast_math),
+                                luisa::hash_value(device->simd_lane_count()),
+                                luisa::hash_value(device->ray_packets()),
+                                luisa::hash_value(luisa::string_view{LLVM_VERSION_STRING}),
+                                luisa::hash_value(fallback_backend_device_builtin_module())});
+}
+
+[[nodiscard]] static auto fallback_shader_object_name(const ShaderOption &option, uint64_t key) noexcept {
+    if (option.name.empty()) { return luisa::format("fallback_kernel_{:016x}.o", key); }
+    auto name = option.name;
+    if (!name.ends_with(".o")) { name.append(".o"); }
+    return name;
+}
+
+luisa::vector<std::byte> FallbackShader::_load_object(const BinaryIO *io, const ShaderOption &option,
+                                                      Function kernel, uint64_t key) const noexcept {
+    // dumping requires going through the full pipeline
+    if (LUISA_SHOULD_DUMP_XIR || LUISA_SHOULD_DUMP_LLVM_IR || LUISA_SHOULD_DUMP_ASM) { return {}; }
+    auto name = fallback_shader_object_name(option, key);
+    luisa::unique_ptr<BinaryStream> stream;
+    if (!option.name.empty()) {
+        stream = io->read_shader_bytecode(name);
+    } else if (option.enable_cache) {
+        stream = io->read_shader_cache(name);
+    }
+    if (stream == nullptr || stream->length() < sizeof(FallbackShaderObjectHeader)) { return {}; }
+    FallbackShaderObjectHeader header{};
+    stream->read({reinterpret_cast<std::byte *>(&header), sizeof(header)});
+    if (header.magic != FallbackShaderObjectHeader::magic_value ||
+        header.key != key ||
+        header.object_size != stream->length() - sizeof(header)) {
+        LUISA_WARNING_WITH_LOCATION(
+            "Kernel object '{}' is found in cache, but it does not match "
+            "the current kernel or host (expected key {:016x}, found {:016x}). "
+            "The kernel will be recompiled.",
+            name, key, header.key);
+        return {};
+    }
+    luisa::vector<std::byte> object;
+    object.resize(header.object_size);
+    stream->read(luisa::span{object});
+    LUISA_VERBOSE("Loaded kernel_{:016x} from cached object '{}'.", kernel.hash(), name);
+    return object;
+}
+
+void FallbackShader::_store_object(const BinaryIO *io, const ShaderOption &option, uint64_t key,
+                                   luisa::span<const std::byte> object) const noexcept {
+    if (option.name.empty() && !option.enable_cache) { return; }
+    FallbackShaderObjectHeader header{
+        .magic = FallbackShaderObjectHeader::magic_value,
+        .key = key,
+        .object_size = object.size(),
+        .reserved = 0u};
+    luisa::vector<std::byte> data;
+    data.resize(sizeof(header) + object.size());
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), object.data(), object.size());
+    auto name = fallback_shader_object_name(option, key);
+    if (!option.name.empty()) {
+        static_cast<void>(io->write_shader_bytecode(name, luisa::span{data}));
+    } else {
+        static_cast<void>(io->write_shader_cache(name, luisa::span{data}));
+    }
+}
+
+luisa::vector<std::byte> FallbackShader::_compile_object(const FallbackDevice *device, const ShaderOption &option,
+                                                         Function kernel, bool &cacheable) noexcept {
 
     xir::Pool pool;
     xir::PoolGuard guard{&pool};
@@ -193,18 +427,48 @@ FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &optio
 
     // run some simple optimization passes on XIR to reduce the size of LLVM IR
     Clock opt_clk;
+    auto outline_info = xir::outline_pass_run_on_module(xir_module);
+    auto inline_info = xir::inline_pass_run_on_module(xir_module);
+    // keep the outlined regions and the `$outline` callables (both marked noinline) out of their callers in LLVM
+    luisa::unordered_set<const xir::Function *> outlined_functions;
+    for (auto &&f : xir_module->functions()) {
+        if (f.derived_function_tag() == xir::DerivedFunctionTag::CALLABLE &&
+            static_cast<const xir::CallableFunction &>(f).is_noinline()) {
+            outlined_functions.emplace(&f);
+        }
+    }
     auto dce1_info = xir::dce_pass_run_on_module(xir_module);
     auto gep_trace_info = xir::trace_gep_pass_run_on_module(xir_module);
+    auto sroa_info = xir::sroa_pass_run_on_module(xir_module);
+    auto mem2reg_info = xir::mem2reg_pass_run_on_module(xir_module);
+    auto const_fold_info = xir::const_fold_pass_run_on_module(xir_module);
+    auto gvn_info = xir::gvn_pass_run_on_module(xir_module);
+    auto licm_info = xir::licm_pass_run_on_module(xir_module);
     auto store_forward_info = xir::local_store_forward_pass_run_on_module(xir_module);
     auto load_elim_info = xir::local_load_elimination_pass_run_on_module(xir_module);
     auto dce2_info = xir::dce_pass_run_on_module(xir_module);
     LUISA_INFO("XIR optimization done in {} ms: "
+               "outlined {} region(s), "
+               "inlined {} call(s), "
                "traced {} GEP instruction(s), "
+               "split {} aggregate variable(s), "
+               "promoted {} variable(s) with {} phi(s), "
+               "folded {} instruction(s), "
+               "eliminated {} redundant instruction(s), "
+               "hoisted {} loop-invariant instruction(s), "
                "forwarded {} store instruction(s), "
                "eliminated {} load instruction(s), "
                "removed {} + {} = {} dead instruction(s).",
                opt_clk.toc(),
+               outline_info.outlines.size(),
+               inline_info.inlined_calls.size(),
                gep_trace_info.traced_geps.size(),
+               sroa_info.split_allocas.size(),
+               mem2reg_info.promoted_allocas.size(),
+               mem2reg_info.inserted_phis.size(),
+               const_fold_info.folded_instructions.size(),
+               gvn_info.eliminated_instructions.size(),
+               licm_info.hoisted_instructions.size(),
                store_forward_info.forwarded_instructions.size(),
                load_elim_info.eliminated_instructions.size(),
                dce1_info.removed_instructions.size(),
@@ -226,40 +490,24 @@ FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &optio
         LUISA_ERROR_WITH_LOCATION("Failed to generate LLVM IR: {}.",
                                   luisa::string_view{parse_error.getMessage()});
     }
-    auto codegen_feedback = luisa_fallback_backend_codegen(*llvm_ctx, llvm_module.get(), xir_module);
+    FallbackCodeGenConfig codegen_config{.simd_lane_count = device->simd_lane_count(),
+                                         .batch_ray_queries = device->ray_packets(),
+                                         .noinline_functions = std::move(outlined_functions)};
+    auto codegen_feedback = luisa_fallback_backend_codegen(*llvm_ctx, llvm_module.get(), xir_module, codegen_config);
     if (llvm::verifyModule(*llvm_module, &llvm::errs())) {
         LUISA_ERROR_WITH_LOCATION("LLVM module verification failed.");
     }
 
-    // map symbols
-    llvm::orc::SymbolMap symbol_map{};
-    auto map_symbol = [jit = _jit.get(), &symbol_map]<typename T>(const char *name, T *f) noexcept {
-        auto addr = llvm::orc::ExecutorAddr::fromPtr(f);
-        auto symbol = llvm::orc::ExecutorSymbolDef{addr, llvm::JITSymbolFlags::Callable};
-        symbol_map.try_emplace(jit->mangleAndIntern(name), symbol);
-    };
-
-#include "fallback_device_api_map_symbols.inl.h"
-
-    // asin, acos, atan, atan2
-    map_symbol("luisa.asin.f16", &luisa_fallback_asin_f16);
-    map_symbol("luisa.asin.f32", &luisa_fallback_asin_f32);
-    map_symbol("luisa.asin.f64", &luisa_fallback_asin_f64);
-    map_symbol("luisa.acos.f16", &luisa_fallback_acos_f16);
-    map_symbol("luisa.acos.f32", &luisa_fallback_acos_f32);
-    map_symbol("luisa.acos.f64", &luisa_fallback_acos_f64);
-    map_symbol("luisa.atan.f16", &luisa_fallback_atan_f16);
-    map_symbol("luisa.atan.f32", &luisa_fallback_atan_f32);
-    map_symbol("luisa.atan.f64", &luisa_fallback_atan_f64);
-    map_symbol("luisa.atan2.f16", &luisa_fallback_atan2_f16);
-    map_symbol("luisa.atan2.f32", &luisa_fallback_atan2_f32);
-    map_symbol("luisa.atan2.f64", &luisa_fallback_atan2_f64);
-
-    // assert
-    map_symbol("luisa.assert", &luisa_fallback_assert);
-
     // bind print instructions
     if (!codegen_feedback.print_inst_map.empty()) {
+        // the print context and formatters live in this shader object, so do not cache the kernel
+        cacheable = false;
+        llvm::orc::SymbolMap symbol_map{};
+        auto map_symbol = [jit = _jit.get(), &symbol_map]<typename T>(const char *name, T *f) noexcept {
+            auto addr = llvm::orc::ExecutorAddr::fromPtr(f);
+            auto symbol = llvm::orc::ExecutorSymbolDef{addr, llvm::JITSymbolFlags::Callable};
+            symbol_map.try_emplace(jit->mangleAndIntern(name), symbol);
+        };
         map_symbol("luisa.print.context", this);
         _print_formatters.reserve(codegen_feedback.print_inst_map.size());
         for (auto fmt_id = 0u; fmt_id < codegen_feedback.print_inst_map.size(); fmt_id++) {
@@ -274,15 +522,13 @@ FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &optio
             _print_formatters.emplace_back(luisa::make_unique<ShaderPrintFormatter>(
                 print_inst->format(), arg_pack_type, false));
         }
-    }
-
-    // define symbols
-    if (auto error = _jit->getMainJITDylib().define(
-            ::llvm::orc::absoluteSymbols(std::move(symbol_map)))) {
-        ::llvm::handleAllErrors(std::move(error), [](const ::llvm::ErrorInfoBase &err) {
-            LUISA_WARNING_WITH_LOCATION("LLJIT::define(): {}", err.message());
-        });
-        LUISA_ERROR_WITH_LOCATION("Failed to define symbols.");
+        if (auto error = _jit->getMainJITDylib().define(
+                ::llvm::orc::absoluteSymbols(std::move(symbol_map)))) {
+            ::llvm::handleAllErrors(std::move(error), [](const ::llvm::ErrorInfoBase &err) {
+                LUISA_WARNING_WITH_LOCATION("LLJIT::define(): {}", err.message());
+            });
+            LUISA_ERROR_WITH_LOCATION("Failed to define print symbols.");
+        }
     }
 
     llvm_module->setDataLayout(_target_machine->createDataLayout());
@@ -370,54 +616,19 @@ FallbackShader::FallbackShader(FallbackDevice *device, const ShaderOption &optio
     }
 
     // compile to machine code
-    auto m = llvm::orc::ThreadSafeModule(std::move(llvm_module), std::move(llvm_ctx));
-    if (auto error = _jit->addIRModule(std::move(m))) {
-        ::llvm::handleAllErrors(std::move(error), [](const ::llvm::ErrorInfoBase &err) {
-            LUISA_WARNING_WITH_LOCATION("LLJIT::addIRModule(): {}", err.message());
-        });
-    }
-    auto addr = _jit->lookup("kernel.main");
-    if (!addr) {
-        ::llvm::handleAllErrors(addr.takeError(), [](const ::llvm::ErrorInfoBase &err) {
-            LUISA_WARNING_WITH_LOCATION("LLJIT::lookup(): {}", err.message());
-        });
-    }
-    LUISA_ASSERT(addr, "JIT compilation failed with error [{}]");
-    _kernel_entry = addr->toPtr<kernel_entry_t>();
-
-    // compute argument buffer size
-    _argument_buffer_size = 0u;
-    static constexpr auto argument_alignment = 16u;
-    for (auto arg : kernel.arguments()) {
-        switch (arg.tag()) {
-            case Variable::Tag::LOCAL: {
-                _argument_buffer_size += arg.type()->size();
-                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
-                break;
-            }
-            case Variable::Tag::BUFFER: {
-                _argument_buffer_size += sizeof(FallbackBufferView);
-                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
-                break;
-            }
-            case Variable::Tag::TEXTURE: {
-                _argument_buffer_size += sizeof(FallbackTextureView);
-                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
-                break;
-            }
-            case Variable::Tag::BINDLESS_ARRAY: {
-                _argument_buffer_size += sizeof(FallbackBindlessArray *);
-                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
-                break;
-            }
-            case Variable::Tag::ACCEL: {
-                _argument_buffer_size += sizeof(FallbackAccel *);
-                _argument_buffer_size = luisa::align(_argument_buffer_size, argument_alignment);
-                break;
-            }
-            default: LUISA_ERROR_WITH_LOCATION("Unsupported argument type.");
-        }
+    Clock codegen_clk;
+    llvm::SmallVector<char, 0u> object_buffer;
+    llvm::raw_svector_ostream object_stream{object_buffer};
+    llvm::legacy::PassManager pass;
+    if (_target_machine->addPassesToEmitFile(pass, object_stream, nullptr, llvm::CodeGenFileType::ObjectFile)) {
+        LUISA_ERROR_WITH_LOCATION("TheTargetMachine can't emit a file of this type");
     }
+    pass.run(*llvm_module);
+    LUISA_INFO("Generated machine code in {} ms.", codegen_clk.toc());
+    luisa::vector<std::byte> object;
+    object.resize(object_buffer.size());
+    std::memcpy(object.data(), object_buffer.data(), object_buffer.size());
+    return object;
 }
 
 class FallbackShaderDispatchBuffer {
@@ -459,7 +670,9 @@ void FallbackShader::dispatch(FallbackCommandQueue *queue, luisa::unique_ptr<Sha
 
     FallbackShaderDispatchBuffer dispatch_buffer{_argument_buffer_size};
     auto dispatch_config = dispatch_buffer.config();
-    dispatch_config->kernel = _kernel_entry;
+    // if the shader is still being compiled asynchronously, the
+    // entry is resolved by the workers right before the launch
+    dispatch_config->kernel = is_compiled() ? _kernel_entry : nullptr;
     dispatch_config->dispatch_size = {dispatch_size.x, dispatch_size.y, dispatch_size.z};
     dispatch_config->block_size = {block_size.x, block_size.y, block_size.z};
 
@@ -524,8 +737,13 @@ void FallbackShader::dispatch(FallbackCommandQueue *queue, luisa::unique_ptr<Sha
     auto grid_size = roundup_div(dispatch_size, block_size);
     auto grid_count = grid_size.x * grid_size.y * grid_size.z;
 
-    queue->enqueue_parallel(grid_count, [queue, dispatch_buffer = std::move(dispatch_buffer)](auto block) noexcept {
+    queue->enqueue_parallel(grid_count, [this, queue, dispatch_buffer = std::move(dispatch_buffer)](auto block) noexcept {
         auto config = dispatch_buffer.config();
+        auto kernel = config->kernel;
+        if (kernel == nullptr) [[unlikely]] {
+            wait_for_compilation();
+            kernel = _kernel_entry;
+        }
         auto dispatch_size = config->dispatch_size;
         auto block_size = config->block_size;
         auto grid_size_x = roundup_div(dispatch_size[0], block_size[0]);
@@ -540,12 +758,22 @@ void FallbackShader::dispatch(FallbackCommandQueue *queue, luisa::unique_ptr<Sha
         };
         auto launch_params = dispatch_buffer.argument_buffer();
         current_device_log_callback = queue->log_callback() ? &queue->log_callback() : nullptr;
-        config->kernel(launch_params, &launch_config);
+        kernel(launch_params, &launch_config);
         current_device_log_callback = nullptr;
     });
 }
 
-FallbackShader::~FallbackShader() noexcept = default;
+FallbackShader::~FallbackShader() noexcept { wait_for_compilation(); }
+
+bool FallbackShader::is_compiled() const noexcept {
+    using namespace std::chrono_literals;
+    return !_compilation.valid() ||
+           _compilation.wait_for(0s) == std::future_status::ready;
+}
+
+void FallbackShader::wait_for_compilation() const noexcept {
+    if (_compilation.valid()) { _compilation.wait(); }
+}
 
 void FallbackShader::_build_bound_arguments(luisa::span<const Function::Binding> bindings) noexcept {
     _bound_arguments.reserve(bindings.size());
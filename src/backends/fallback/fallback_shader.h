@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <future>
+
 #include <luisa/core/stl/unordered_map.h>
 #include <luisa/ast/function.h>
 #include <luisa/runtime/rhi/resource.h>
@@ -20,6 +22,10 @@ namespace llvm::orc {
 class LLJIT;
 }// namespace llvm::orc
 
+namespace luisa {
+class BinaryIO;
+}// namespace luisa
+
 namespace luisa::compute {
 class ShaderPrintFormatter;
 }// namespace luisa::compute
@@ -39,17 +45,26 @@ private:
     luisa::unordered_map<uint, size_t> _argument_offsets;
     kernel_entry_t *_kernel_entry{nullptr};
     size_t _argument_buffer_size{};
-    size_t _shared_memory_size{};
     luisa::unique_ptr<llvm::Module> _module{};
     luisa::vector<ShaderDispatchCommand::Argument> _bound_arguments;
+    luisa::vector<Usage> _argument_usages;// bound arguments first
     luisa::vector<luisa::unique_ptr<ShaderPrintFormatter>> _print_formatters;
 
     uint3 _block_size;
     std::unique_ptr<::llvm::orc::LLJIT> _jit;
     std::unique_ptr<::llvm::TargetMachine> _target_machine;
+    std::shared_future<void> _compilation;// only valid for asynchronously compiled shaders
 
 private:
     void _build_bound_arguments(luisa::span<const Function::Binding> bindings) noexcept;
+    void _compile(const FallbackDevice *device, const ShaderOption &option, Function kernel) noexcept;
+    [[nodiscard]] uint64_t _object_cache_key(const FallbackDevice *device, const ShaderOption &option, Function kernel) const noexcept;
+    [[nodiscard]] luisa::vector<std::byte> _load_object(const BinaryIO *io, const ShaderOption &option,
+                                                        Function kernel, uint64_t key) const noexcept;
+    void _store_object(const BinaryIO *io, const ShaderOption &option,
+                       uint64_t key, luisa::span<const std::byte> object) const noexcept;
+    [[nodiscard]] luisa::vector<std::byte> _compile_object(const FallbackDevice *device, const ShaderOption &option,
+                                                           Function kernel, bool &cacheable) noexcept;
 
 public:
     void dispatch(ThreadPool &pool, const ShaderDispatchCommand *command) const noexcept;
@@ -58,8 +73,14 @@ public:
     ~FallbackShader() noexcept;
 
     [[nodiscard]] auto argument_buffer_size() const noexcept { return _argument_buffer_size; }
-    [[nodiscard]] auto shared_memory_size() const noexcept { return _shared_memory_size; }
-    [[nodiscard]] auto native_handle() const noexcept { return _kernel_entry; }
+    [[nodiscard]] auto bound_arguments() const noexcept { return luisa::span{_bound_arguments}; }
+    [[nodiscard]] auto argument_usage(size_t i) const noexcept { return _argument_usages[i]; }
+    [[nodiscard]] bool is_compiled() const noexcept;
+    void wait_for_compilation() const noexcept;
+    [[nodiscard]] auto native_handle() const noexcept {
+        wait_for_compilation();
+        return _kernel_entry;
+    }
     [[nodiscard]] auto print_formatter(size_t i) const noexcept -> const ShaderPrintFormatter * { return _print_formatters[i].get(); }
 };
 
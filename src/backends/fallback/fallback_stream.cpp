@@ -4,17 +4,29 @@
 
 #include <algorithm>
 #include <luisa/core/logging.h>
+#include <luisa/core/stl/unordered_map.h>
 
 #include "fallback_stream.h"
 #include "fallback_accel.h"
 #include "fallback_bindless_array.h"
 #include "fallback_mesh.h"
+#include "fallback_curve.h"
+#include "fallback_procedural_primitive.h"
+#include "fallback_motion_instance.h"
 #include "fallback_texture.h"
 #include "fallback_shader.h"
 #include "fallback_buffer.h"
 
 namespace luisa::compute::fallback {
 
+Usage FallbackReorderFuncTable::get_usage(uint64_t shader_handle, size_t argument_index) const noexcept {
+    return reinterpret_cast<const FallbackShader *>(shader_handle)->argument_usage(argument_index);
+}
+
+luisa::span<const Argument> FallbackReorderFuncTable::shader_bindings(uint64_t handle) const noexcept {
+    return reinterpret_cast<const FallbackShader *>(handle)->bound_arguments();
+}
+
 void FallbackStream::_enqueue(luisa::unique_ptr<BufferUploadCommand> cmd) noexcept {
     auto temp_buffer = luisa::allocate_with_allocator<std::byte>(cmd->size());
     std::memcpy(temp_buffer, cmd->data(), cmd->size());
@@ -55,8 +67,7 @@ void FallbackStream::_enqueue(luisa::unique_ptr<TextureUploadCommand> cmd) noexc
     auto temp_buffer = luisa::allocate_with_allocator<std::byte>(byte_size);
     std::memcpy(temp_buffer, cmd->data(), byte_size);
     queue()->enqueue([tex, temp_buffer] {
-        auto byte_size = pixel_storage_size(tex.storage(), tex.size3d());
-        std::memcpy(const_cast<std::byte *>(tex.data()), temp_buffer, byte_size);
+        tex.copy_from(temp_buffer);
         luisa::deallocate_with_allocator(temp_buffer);
     });
 }
@@ -93,15 +104,24 @@ void FallbackStream::_enqueue(luisa::unique_ptr<MeshBuildCommand> cmd) noexcept
 }
 
 void FallbackStream::_enqueue(luisa::unique_ptr<CurveBuildCommand> cmd) noexcept {
-    LUISA_NOT_IMPLEMENTED();
+    queue()->enqueue([cmd = std::move(cmd)]() mutable noexcept {
+        auto curve = reinterpret_cast<FallbackCurve *>(cmd->handle());
+        curve->build(std::move(cmd));
+    });
 }
 
 void FallbackStream::_enqueue(luisa::unique_ptr<ProceduralPrimitiveBuildCommand> cmd) noexcept {
-    LUISA_NOT_IMPLEMENTED();
+    queue()->enqueue([cmd = std::move(cmd)]() mutable noexcept {
+        auto primitive = reinterpret_cast<FallbackProceduralPrimitive *>(cmd->handle());
+        primitive->build(std::move(cmd));
+    });
 }
 
 void FallbackStream::_enqueue(luisa::unique_ptr<MotionInstanceBuildCommand> cmd) noexcept {
-    LUISA_NOT_IMPLEMENTED();
+    queue()->enqueue([cmd = std::move(cmd)]() mutable noexcept {
+        auto instance = reinterpret_cast<FallbackMotionInstance *>(cmd->handle());
+        instance->build(std::move(cmd));
+    });
 }
 
 void FallbackStream::_enqueue(luisa::unique_ptr<BindlessArrayUpdateCommand> cmd) noexcept {
@@ -115,20 +135,51 @@ void FallbackStream::_enqueue(luisa::unique_ptr<CustomCommand> cmd) noexcept {
     LUISA_NOT_IMPLEMENTED();
 }
 
-void FallbackStream::dispatch(CommandList &&cmd_list) noexcept {
-    auto cmds = cmd_list.steal_commands();
-    for (auto &&cmd : cmds) {
+void FallbackStream::_enqueue_command(luisa::unique_ptr<Command> cmd) noexcept {
 #define LUISA_FALLBACK_STREAM_CAST_AND_ENQUEUE_COMMAND_CASE(COMMAND_TYPE) \
     case Command::Tag::E##COMMAND_TYPE: {                                 \
         auto derived_cmd = static_cast<COMMAND_TYPE *>(cmd.release());    \
         _enqueue(luisa::unique_ptr<COMMAND_TYPE>{derived_cmd});           \
         break;                                                            \
     }
-        switch (cmd->tag()) {
-            LUISA_MAP(LUISA_FALLBACK_STREAM_CAST_AND_ENQUEUE_COMMAND_CASE,
-                      LUISA_COMPUTE_RUNTIME_COMMANDS)
-        }
+    switch (cmd->tag()) {
+        LUISA_MAP(LUISA_FALLBACK_STREAM_CAST_AND_ENQUEUE_COMMAND_CASE,
+                  LUISA_COMPUTE_RUNTIME_COMMANDS)
+    }
 #undef LUISA_FALLBACK_STREAM_CAST_AND_ENQUEUE_COMMAND_CASE
+}
+
+void FallbackStream::dispatch(CommandList &&cmd_list) noexcept {
+    auto cmds = cmd_list.steal_commands();
+    // the reorder visitor does not track these commands
+    auto reorderable = cmds.size() > 1u && std::none_of(cmds.cbegin(), cmds.cend(), [](auto &&cmd) noexcept {
+        auto tag = cmd->tag();
+        return tag == Command::Tag::ECurveBuildCommand ||
+               tag == Command::Tag::EMotionInstanceBuildCommand ||
+               tag == Command::Tag::ECustomCommand;
+    });
+    if (!reorderable) {
+        for (auto &&cmd : cmds) { _enqueue_command(std::move(cmd)); }
+    } else {
+        // group the commands into layers of mutually independent ones,
+        // and run the commands in each layer concurrently on the workers
+        for (auto &&cmd : cmds) { cmd->accept(_reorder); }
+        luisa::unordered_map<const Command *, luisa::unique_ptr<Command>> owned_cmds;
+        owned_cmds.reserve(cmds.size());
+        for (auto &&cmd : cmds) {
+            auto key = cmd.get();
+            owned_cmds.emplace(key, std::move(cmd));
+        }
+        for (auto layer : _reorder.command_lists()) {
+            queue()->begin_concurrent();
+            for (auto node = layer; node != nullptr; node = node->p_next) {
+                auto iter = owned_cmds.find(node->cmd);
+                LUISA_ASSERT(iter != owned_cmds.end(), "Invalid reordered command.");
+                _enqueue_command(std::move(iter->second));
+            }
+            queue()->end_concurrent();
+        }
+        _reorder.clear();
     }
     dispatch([callbacks = cmd_list.steal_callbacks()] {
         for (auto &&cb : callbacks) { cb(); }
@@ -140,6 +191,6 @@ void FallbackStream::dispatch(luisa::move_only_function<void()> &&f) noexcept {
 }
 
 FallbackStream::FallbackStream(size_t in_flight_limit) noexcept
-    : _queue{in_flight_limit, 0u} {}
+    : _queue{in_flight_limit, 0u}, _reorder{FallbackReorderFuncTable{}} {}
 
 }// namespace luisa::compute::fallback
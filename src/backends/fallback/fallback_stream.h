@@ -5,19 +5,33 @@
 #pragma once
 
 #include <luisa/runtime/command_list.h>
+#include "../common/command_reorder_visitor.h"
 #include "fallback_command_queue.h"
 
 namespace luisa::compute::fallback {
 
+struct FallbackReorderFuncTable {
+    // bindless arrays are updated on the dispatcher thread, so conservatively
+    // assume that any resource may be referenced by a bindless array
+    [[nodiscard]] bool is_res_in_bindless(uint64_t bindless_handle, uint64_t resource_handle) const noexcept { return true; }
+    [[nodiscard]] Usage get_usage(uint64_t shader_handle, size_t argument_index) const noexcept;
+    void update_bindless(uint64_t handle, luisa::span<const BindlessArrayUpdateCommand::Modification> modifications) const noexcept {}
+    [[nodiscard]] luisa::span<const Argument> shader_bindings(uint64_t handle) const noexcept;
+    void lock_bindless(uint64_t bindless_handle) const noexcept {}
+    void unlock_bindless(uint64_t bindless_handle) const noexcept {}
+};
+
 class FallbackStream final {
 
 private:
     FallbackCommandQueue _queue;
+    CommandReorderVisitor<FallbackReorderFuncTable, true> _reorder;
 
 #define LUISA_FALLBACK_STREAM_ENQUEUE_COMMAND_DECL(COMMAND_TYPE) \
     void _enqueue(luisa::unique_ptr<COMMAND_TYPE> cmd) noexcept;
     LUISA_MAP(LUISA_FALLBACK_STREAM_ENQUEUE_COMMAND_DECL, LUISA_COMPUTE_RUNTIME_COMMANDS)
 #undef LUISA_FALLBACK_STREAM_ENQUEUE_COMMAND_DECL
+    void _enqueue_command(luisa::unique_ptr<Command> cmd) noexcept;
 
 public:
     explicit FallbackStream(size_t queue_size = 8u) noexcept;
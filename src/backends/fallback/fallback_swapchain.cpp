@@ -39,7 +39,10 @@ void FallbackSwapchain::present(FallbackStream *stream, FallbackTexture *frame)
     LUISA_ASSERT(stream == _bound_stream, "Stream mismatch.");
     stream->queue()->enqueue([handle = this->_handle, frame] {
         auto view = frame->view(0);
-        luisa_compute_cpu_swapchain_present(handle, view.data(), view.size_bytes());
+        // the swapchain expects row-major pixels rather than the tiled layout
+        luisa::vector<std::byte> pixels(view.size_bytes());
+        view.copy_to(pixels.data());
+        luisa_compute_cpu_swapchain_present(handle, pixels.data(), pixels.size());
     });
     stream->synchronize();
 }
@@ -15,21 +15,30 @@ template<size_t stride>
 struct alignas(stride) Pixel : std::array<std::byte, stride> {};
 }// namespace detail
 
-void FallbackTextureView::copy_from(const void *data) const noexcept {
-    auto LC_TEXTURE_COPY = [data, this]<uint dim, uint stride>() mutable noexcept {
-        auto p = static_cast<const detail::Pixel<stride> *>(data);
+size_t FallbackTextureView::_tiled_size_bytes() const noexcept {
+    auto blocks = static_cast<size_t>(_blocks_x()) * _blocks_y();
+    auto block_pixels = block_size * block_size;
+    if (_dimension == 3u) {
+        blocks *= _blocks_z();
+        block_pixels *= block_size;
+    }
+    return (blocks * block_pixels) << _pixel_stride_shift;
+}
+
+template<bool to_tiled>
+void FallbackTextureView::_convert_layout(std::byte *linear) const noexcept {
+    auto LC_TEXTURE_COPY = [linear, this]<uint dim, uint stride>() mutable noexcept {
+        auto p = reinterpret_cast<detail::Pixel<stride> *>(linear);
         for (auto z = 0u; z < (dim == 2u ? 1u : _depth); z++) {
             for (auto y = 0u; y < _height; y++) {
+                auto row = p + (z * _height + y) * _width;
                 for (auto x = 0u; x < _width; x++) {
-                    auto pp = p + ((z * _height + y) * _width + x);
-                    if constexpr (dim == 2) {
-                        auto pixel = reinterpret_cast<detail::Pixel<stride> *>(
-                            _pixel2d(make_uint2(x, y)));
-                        *pixel = *pp;
+                    auto pixel = reinterpret_cast<detail::Pixel<stride> *>(
+                        dim == 2u ? _pixel2d(make_uint2(x, y)) : _pixel3d(make_uint3(x, y, z)));
+                    if constexpr (to_tiled) {
+                        *pixel = row[x];
                     } else {
-                        auto pixel = reinterpret_cast<detail::Pixel<stride> *>(
-                            _pixel3d(make_uint3(x, y, z)));
-                        *pixel = *pp;
+                        row[x] = *pixel;
                     }
                 }
             }
@@ -56,13 +65,37 @@ void FallbackTextureView::copy_from(const void *data) const noexcept {
     }
 }
 
+void FallbackTextureView::copy_from(const void *data) const noexcept {
+    // block-compressed textures are already stored in 4x4 blocks, so keep them as is
+    if (is_block_compressed(_storage)) {
+        std::memcpy(_data, data, size_bytes());
+    } else {
+        _convert_layout<true>(static_cast<std::byte *>(const_cast<void *>(data)));
+    }
+}
+
 void FallbackTextureView::copy_to(void *data) const noexcept {
-    memcpy(data, this->_data, this->size_bytes());
+    if (is_block_compressed(_storage)) {
+        std::memcpy(data, _data, size_bytes());
+    } else {
+        _convert_layout<false>(static_cast<std::byte *>(data));
+    }
 }
 
 void FallbackTextureView::copy_from(FallbackTextureView dst) const noexcept {
     LUISA_ASSERT(size_bytes() == dst.size_bytes(), "Texture sizes must match.");
-    std::memcpy(dst._data, _data, size_bytes());
+    if (is_block_compressed(_storage) || is_block_compressed(dst._storage)) {
+        std::memcpy(dst._data, _data, size_bytes());
+    } else if (all(size3d() == dst.size3d()) && _dimension == dst._dimension &&
+               _pixel_stride_shift == dst._pixel_stride_shift) {
+        // identical tilings, so the padded storage can be copied verbatim
+        std::memcpy(dst._data, _data, _tiled_size_bytes());
+    } else {
+        // differently shaped textures of the same byte size: go through the linear layout
+        luisa::vector<std::byte> temp(size_bytes());
+        copy_to(temp.data());
+        dst.copy_from(temp.data());
+    }
 }
 
 namespace detail {
@@ -230,6 +230,33 @@ inline void write_pixel(PixelStorage storage, std::byte *p, Vector<T, 4u> v) noe
     }
 }
 
+// Invokes f.template operator()<Src, dim>() with the scalar type and channel count
+// of the storage, so that callers fetching several texels can resolve the format
+// once and run the per-texel code fully specialized. Block-compressed storages
+// are not handled here and yield zero-channel (all-zero) pixels.
+template<typename F>
+[[nodiscard]] inline decltype(auto) visit_pixel_storage(PixelStorage storage, F &&f) noexcept {
+    switch (storage) {
+        case PixelStorage::BYTE1: return f.template operator()<uint8_t, 1u>();
+        case PixelStorage::BYTE2: return f.template operator()<uint8_t, 2u>();
+        case PixelStorage::BYTE4: return f.template operator()<uint8_t, 4u>();
+        case PixelStorage::SHORT1: return f.template operator()<uint16_t, 1u>();
+        case PixelStorage::SHORT2: return f.template operator()<uint16_t, 2u>();
+        case PixelStorage::SHORT4: return f.template operator()<uint16_t, 4u>();
+        case PixelStorage::INT1: return f.template operator()<uint32_t, 1u>();
+        case PixelStorage::INT2: return f.template operator()<uint32_t, 2u>();
+        case PixelStorage::INT4: return f.template operator()<uint32_t, 4u>();
+        case PixelStorage::HALF1: return f.template operator()<luisa::half, 1u>();
+        case PixelStorage::HALF2: return f.template operator()<luisa::half, 2u>();
+        case PixelStorage::HALF4: return f.template operator()<luisa::half, 4u>();
+        case PixelStorage::FLOAT1: return f.template operator()<float, 1u>();
+        case PixelStorage::FLOAT2: return f.template operator()<float, 2u>();
+        case PixelStorage::FLOAT4: return f.template operator()<float, 4u>();
+        default: break;
+    }
+    return f.template operator()<uint8_t, 0u>();
+}
+
 }// namespace detail
 
 class FallbackTexture;
@@ -278,16 +305,51 @@ public:
     [[nodiscard]] size_t size_bytes() const noexcept { return pixel_storage_size(storage(), size3d()); }
 
 private:
+    // Pixels are stored in block_size^2 (2D) or block_size^3 (3D) tiles laid out
+    // row-major over the (padded) mip level; pixels inside a tile are Z-ordered,
+    // so that the neighbors touched by filtering share cache lines.
+    static_assert(block_size == 4u, "Tile swizzling assumes 4x4(x4) tiles.");
+    static constexpr auto block_shift = 2u;
+    static constexpr auto block_mask = block_size - 1u;
+
+    [[nodiscard]] inline auto _blocks_x() const noexcept { return (_width + block_mask) >> block_shift; }
+    [[nodiscard]] inline auto _blocks_y() const noexcept { return (_height + block_mask) >> block_shift; }
+    [[nodiscard]] inline auto _blocks_z() const noexcept { return (_depth + block_mask) >> block_shift; }
+
+    [[nodiscard]] static inline uint _morton2d(uint2 xy) noexcept {
+        return (xy.x & 1u) | ((xy.y & 1u) << 1u) | ((xy.x & 2u) << 1u) | ((xy.y & 2u) << 2u);
+    }
+
+    [[nodiscard]] static inline uint _morton3d(uint3 xyz) noexcept {
+        return (xyz.x & 1u) | ((xyz.y & 1u) << 1u) | ((xyz.z & 1u) << 2u) |
+               ((xyz.x & 2u) << 2u) | ((xyz.y & 2u) << 3u) | ((xyz.z & 2u) << 4u);
+    }
+
+    [[nodiscard]] inline size_t _pixel_index2d(uint2 xy) const noexcept {
+        auto block = (xy.x >> block_shift) + (xy.y >> block_shift) * _blocks_x();
+        return (static_cast<size_t>(block) << (2u * block_shift)) | _morton2d(xy);
+    }
+
+    [[nodiscard]] inline size_t _pixel_index3d(uint3 xyz) const noexcept {
+        auto block = (xyz.x >> block_shift) +
+                     ((xyz.y >> block_shift) + (xyz.z >> block_shift) * _blocks_y()) * _blocks_x();
+        return (static_cast<size_t>(block) << (3u * block_shift)) | _morton3d(xyz);
+    }
+
     [[nodiscard]] inline std::byte *_pixel2d(uint2 xy) const noexcept {
-        auto idx = xy.x + xy.y * _width;
-        return _data + (static_cast<size_t>(idx) << _pixel_stride_shift);
+        return _data + (_pixel_index2d(xy) << _pixel_stride_shift);
     }
 
     [[nodiscard]] inline std::byte *_pixel3d(uint3 xyz) const noexcept {
-        auto idx = xyz.x + xyz.y * _width + xyz.z * _width * _height;
-        return _data + (static_cast<size_t>(idx) << _pixel_stride_shift);
+        return _data + (_pixel_index3d(xyz) << _pixel_stride_shift);
     }
 
+    // size of the tiled storage of this level, including the padding of partial tiles
+    [[nodiscard]] size_t _tiled_size_bytes() const noexcept;
+
+    template<bool to_tiled>
+    void _convert_layout(std::byte *linear) const noexcept;
+
     [[nodiscard]] inline auto _out_of_bounds(uint2 xy) const noexcept {
         return !(xy[0] < _width & xy[1] < _height);
     }
@@ -318,6 +380,19 @@ public:
         return detail::read_pixel<T>(_storage, _pixel3d(xyz));
     }
 
+    // format-specialized reads, see detail::visit_pixel_storage
+    template<typename T, typename Src, uint dim>
+    [[nodiscard]] inline Vector<T, 4u> read2d(uint2 xy) const noexcept {
+        if (_out_of_bounds(xy)) [[unlikely]] { return {}; }
+        return detail::read_pixel<T, Src, dim>(_pixel2d(xy));
+    }
+
+    template<typename T, typename Src, uint dim>
+    [[nodiscard]] inline Vector<T, 4u> read3d(uint3 xyz) const noexcept {
+        if (_out_of_bounds(xyz)) [[unlikely]] { return {}; }
+        return detail::read_pixel<T, Src, dim>(_pixel3d(xyz));
+    }
+
     template<typename T>
     inline void write2d(uint2 xy, Vector<T, 4u> value) const noexcept {
         if (_out_of_bounds(xy)) [[unlikely]] { return; }
@@ -333,6 +408,7 @@ public:
     [[nodiscard]] uint2 size2d() const noexcept { return make_uint2(_width, _height); }
     [[nodiscard]] uint3 size3d() const noexcept { return make_uint3(_width, _height, _depth); }
 
+    // copies from/to tightly packed row-major pixels, converting from/to the tiled layout
     void copy_from(const void *data) const noexcept;
 
     void copy_to(void *data) const noexcept;
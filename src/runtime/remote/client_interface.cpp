@@ -1,7 +1,10 @@
 #include <luisa/runtime/remote/client_interface.h>
 #include <luisa/runtime/context.h>
 #include <luisa/core/logging.h>
+#include <luisa/core/stl/hash.h>
 #include "serde.hpp"
+#include "delta_codec.hpp"
+#include "compression.h"
 #include "device_func.h"
 #include <luisa/ast/callable_library.h>
 namespace luisa::compute {
@@ -12,6 +15,77 @@ ClientInterface::ClientInterface(
       _callback(callback) {
     _receive_bytes.reserve(32);
     _send_bytes.reserve(65536);
+    _bindless_codec = luisa::make_unique<DeltaCodec<BindlessArrayUpdateCommand::Modification>>();
+    _accel_codec = luisa::make_unique<DeltaCodec<AccelBuildCommand::Modification>>();
+}
+ClientInterface::~ClientInterface() noexcept = default;
+bool ClientInterface::set_compression(RemoteCompression mode, size_t threshold) noexcept {
+    _compression = RemoteCompression::NONE;
+    _compression_threshold = threshold;
+    if (mode == RemoteCompression::NONE) { return true; }
+    if (!detail::remote_compression_supported(mode)) { return false; }
+    SerDe::ser_value(DeviceFunc::QueryCompression, _send_bytes);
+    SerDe::ser_value(mode, _send_bytes);
+    _receive_bytes.clear();
+    _callback->sync_send(_send_bytes, _receive_bytes);
+    _send_bytes.clear();
+    auto const *ptr = _receive_bytes.data();
+    if (!SerDe::deser_value<bool>(ptr)) { return false; }
+    _compression = mode;
+    return true;
+}
+uint32_t ClientInterface::_query_server_capabilities() noexcept {
+    if (!_server_capabilities) {
+        SerDe::ser_value(DeviceFunc::QueryCapabilities, _send_bytes);
+        _receive_bytes.clear();
+        _callback->sync_send(_send_bytes, _receive_bytes);
+        _send_bytes.clear();
+        auto const *ptr = _receive_bytes.data();
+        _server_capabilities = SerDe::deser_value<uint32_t>(ptr);
+    }
+    return *_server_capabilities;
+}
+void ClientInterface::_async_send() noexcept {
+    auto size = _send_bytes.size();
+    for (auto &&p : _send_payloads) { size += p.data.size(); }
+    if (_compression != RemoteCompression::NONE && size >= _compression_threshold) {
+        // compress the message with the payloads spliced in, in the same order as ClientCallback::async_send_gather
+        luisa::vector<luisa::span<const std::byte>> segments;
+        segments.reserve(_send_payloads.size() * 2u + 1u);
+        auto last_offset = static_cast<size_t>(0u);
+        for (auto &&p : _send_payloads) {
+            segments.emplace_back(luisa::span<const std::byte>{_send_bytes}.subspan(last_offset, p.offset - last_offset));
+            segments.emplace_back(p.data);
+            last_offset = p.offset;
+        }
+        segments.emplace_back(luisa::span<const std::byte>{_send_bytes}.subspan(last_offset));
+        luisa::vector<std::byte> compressed;
+        SerDe::ser_value(DeviceFunc::Compressed, compressed);
+        SerDe::ser_value(_compression, compressed);
+        SerDe::ser_value(size, compressed);
+        if (detail::remote_compress(_compression, segments, compressed)) {
+            _send_bytes.clear();
+            _send_payloads.clear();
+            _callback->async_send(std::move(compressed));
+            return;
+        }
+    }
+    if (_send_payloads.empty()) {
+        _callback->async_send(std::move(_send_bytes));
+    } else {
+        _callback->async_send_gather(std::move(_send_bytes), std::move(_send_payloads));
+    }
+}
+void ClientInterface::_ser_payload(luisa::span<const std::byte> data) noexcept {
+    // small payloads are cheaper to copy than to send as separate segments
+    static constexpr auto min_referenced_payload_size = static_cast<size_t>(64u * 1024u);
+    if (data.size() < min_referenced_payload_size) {
+        SerDe::ser_array(data, _send_bytes);
+    } else {
+        // same layout as ser_array, with the elements spliced in by the callback
+        SerDe::ser_value(data.size(), _send_bytes);
+        _send_payloads.emplace_back(ClientCallback::Payload{_send_bytes.size(), data});
+    }
 }
 BufferCreationInfo ClientInterface::create_buffer(
     const Type *element,
@@ -94,6 +168,7 @@ void ClientInterface::destroy_bindless_array(uint64_t handle) noexcept {
     SerDe::ser_value(DeviceFunc::DestroyBindlessArray, _send_bytes);
     SerDe::ser_value(handle, _send_bytes);
     _callback->async_send(std::move(_send_bytes));
+    _bindless_codec->erase(handle);
 }
 
 // stream
@@ -144,11 +219,9 @@ void ClientInterface::dispatch(uint64_t stream_handle, CommandList &&list) noexc
                 SerDe::ser_value(cmd->handle(), _send_bytes);
                 SerDe::ser_value(cmd->offset(), _send_bytes);
                 SerDe::ser_value(cmd->size(), _send_bytes);
-                SerDe::ser_array(
-                    luisa::span<std::byte const>{
-                        reinterpret_cast<std::byte const *>(cmd->data()),
-                        cmd->size()},
-                    _send_bytes);
+                _ser_payload(luisa::span<std::byte const>{
+                    reinterpret_cast<std::byte const *>(cmd->data()),
+                    cmd->size()});
             } break;
             case Command::Tag::EBufferDownloadCommand: {
                 auto cmd = static_cast<BufferDownloadCommand const *>(cmd_base.get());
@@ -203,11 +276,9 @@ void ClientInterface::dispatch(uint64_t stream_handle, CommandList &&list) noexc
                 SerDe::ser_value(cmd->level(), _send_bytes);
                 SerDe::ser_value(cmd->size(), _send_bytes);
                 SerDe::ser_value(cmd->offset(), _send_bytes);
-                SerDe::ser_array(
-                    luisa::span<std::byte const>{
-                        reinterpret_cast<std::byte const *>(cmd->data()),
-                        pixel_storage_size(cmd->storage(), cmd->size())},
-                    _send_bytes);
+                _ser_payload(luisa::span<std::byte const>{
+                    reinterpret_cast<std::byte const *>(cmd->data()),
+                    pixel_storage_size(cmd->storage(), cmd->size())});
             } break;
             case Command::Tag::ETextureDownloadCommand: {
                 auto cmd = static_cast<TextureDownloadCommand const *>(cmd_base.get());
@@ -256,13 +327,17 @@ void ClientInterface::dispatch(uint64_t stream_handle, CommandList &&list) noexc
                 SerDe::ser_value(cmd->handle(), _send_bytes);
                 SerDe::ser_value(cmd->request(), _send_bytes);
                 SerDe::ser_value(cmd->instance_count(), _send_bytes);
-                SerDe::ser_array(cmd->modifications(), _send_bytes);
+                _accel_codec->encode(
+                    cmd->handle(), cmd->modifications(),
+                    [](auto &&m) noexcept { return m.index; }, _send_bytes);
                 SerDe::ser_value(cmd->update_instance_buffer_only(), _send_bytes);
             } break;
             case Command::Tag::EBindlessArrayUpdateCommand: {
                 auto cmd = static_cast<BindlessArrayUpdateCommand const *>(cmd_base.get());
                 SerDe::ser_value(cmd->handle(), _send_bytes);
-                SerDe::ser_value(cmd->modifications(), _send_bytes);
+                _bindless_codec->encode(
+                    cmd->handle(), cmd->modifications(),
+                    [](auto &&m) noexcept { return m.slot; }, _send_bytes);
             } break;
             default:
                 LUISA_ERROR("Unsupported command.");
@@ -270,7 +345,7 @@ void ClientInterface::dispatch(uint64_t stream_handle, CommandList &&list) noexc
         }
     }
     _unfinished_stream.try_emplace(stream_handle).first->second.push(std::move(feedback));
-    _callback->async_send(std::move(_send_bytes));
+    _async_send();
 }
 
 void ClientInterface::set_stream_log_callback(
@@ -295,6 +370,33 @@ ShaderCreationInfo ClientInterface::create_shader(const ShaderOption &option, Fu
     ShaderCreationInfo r;
     r.handle = _flag++;
     r.block_size = kernel.block_size();
+    LUISA_ASSERT(option.native_include.empty(), "Native include not allowed in remote device.");
+    // the kernel and the options that affect the generated code address the shader in the server's cache,
+    // so only kernels the server has not compiled yet are transferred
+    // kernels capturing resources have the frontend handles baked into the compiled shader, so
+    // they can neither be told apart by the kernel hash nor be shared with other sessions
+    auto has_bindings = false;
+    for (auto &&b : kernel.bound_arguments()) {
+        if (!luisa::holds_alternative<luisa::monostate>(b)) { has_bindings = true; }
+    }
+    auto cache_key = static_cast<uint64_t>(0u);
+    if (!option.compile_only && !has_bindings &&
+        (_query_server_capabilities() & luisa::to_underlying(ServerCapability::ShaderCache))) {
+        cache_key = luisa::hash_combine({kernel.hash(),
+                                         static_cast<uint64_t>(option.enable_fast_math),
+                                         static_cast<uint64_t>(option.enable_debug_info),
+                                         static_cast<uint64_t>(option.max_registers)});
+        // 0 is reserved for "do not cache"
+        if (cache_key == 0u) [[unlikely]] { cache_key = 1u; }
+        SerDe::ser_value(DeviceFunc::LookupShaderCache, _send_bytes);
+        SerDe::ser_value(r.handle, _send_bytes);
+        SerDe::ser_value(cache_key, _send_bytes);
+        _receive_bytes.clear();
+        _callback->sync_send(_send_bytes, _receive_bytes);
+        _send_bytes.clear();
+        auto const *ptr = _receive_bytes.data();
+        if (SerDe::deser_value<bool>(ptr)) { return r; }
+    }
     CallableLibrary lib{};
     lib.add_callable("##", kernel.shared_builder());
     SerDe::ser_value(DeviceFunc::CreateShaderAst, _send_bytes);
@@ -306,10 +408,10 @@ ShaderCreationInfo ClientInterface::create_shader(const ShaderOption &option, Fu
     SerDe::ser_value(option.max_registers, _send_bytes);
     SerDe::ser_value(option.time_trace, _send_bytes);
     SerDe::ser_value(option.name, _send_bytes);
-    LUISA_ASSERT(option.native_include.empty(), "Native include not allowed in remote device.");
+    SerDe::ser_value(cache_key, _send_bytes);
     auto ser_data = lib.serialize();
     SerDe::ser_array(span<std::byte const>(ser_data), _send_bytes);
-    _callback->async_send(std::move(_send_bytes));
+    _async_send();
     return r;
 }
 ShaderCreationInfo ClientInterface::create_shader(const ShaderOption &option, const ir::KernelModule *kernel) noexcept {
@@ -480,6 +582,7 @@ void ClientInterface::destroy_accel(uint64_t handle) noexcept {
     SerDe::ser_value(DeviceFunc::DestroyAccel, _send_bytes);
     SerDe::ser_value(handle, _send_bytes);
     _callback->async_send(std::move(_send_bytes));
+    _accel_codec->erase(handle);
 }
 
 // query
@@ -0,0 +1,143 @@
+#include <luisa/core/logging.h>
+#include "compression.h"
+#ifdef LUISA_COMPUTE_REMOTE_ENABLE_ZLIB
+#include <zlib.h>
+#endif
+namespace luisa::compute::detail {
+
+#ifdef LUISA_COMPUTE_REMOTE_ENABLE_ZLIB
+// zlib counts bytes in uInt, so large inputs and outputs are fed in chunks
+static constexpr auto zlib_max_chunk_size = static_cast<size_t>(1u << 30u);
+
+[[nodiscard]] static bool remote_zlib_compress(luisa::span<const luisa::span<const std::byte>> input,
+                                               luisa::vector<std::byte> &output) noexcept {
+    auto raw_size = static_cast<size_t>(0u);
+    for (auto &&i : input) { raw_size += i.size(); }
+    z_stream stream{};
+    // favor speed: the messages are compressed on the critical path of dispatches
+    if (deflateInit(&stream, Z_BEST_SPEED) != Z_OK) { return false; }
+    auto header_size = output.size();
+    // stop as soon as the compressed data would not be smaller than the raw data
+    auto max_size = header_size + raw_size;
+    output.resize(max_size);
+    auto produced = header_size;
+    auto ok = true;
+    auto ended = false;
+    auto segment = static_cast<size_t>(0u);
+    auto segment_offset = static_cast<size_t>(0u);
+    while (ok) {
+        // skip the consumed segments
+        while (segment < input.size() && segment_offset == input[segment].size()) {
+            segment++;
+            segment_offset = 0u;
+        }
+        auto finish = segment == input.size();
+        if (!finish) {
+            auto chunk = std::min(input[segment].size() - segment_offset, zlib_max_chunk_size);
+            stream.next_in = reinterpret_cast<Bytef *>(const_cast<std::byte *>(input[segment].data() + segment_offset));
+            stream.avail_in = static_cast<uInt>(chunk);
+        }
+        do {
+            if (produced == max_size) {
+                ok = false;
+                break;
+            }
+            auto out_chunk = std::min(max_size - produced, zlib_max_chunk_size);
+            stream.next_out = reinterpret_cast<Bytef *>(output.data() + produced);
+            stream.avail_out = static_cast<uInt>(out_chunk);
+            auto ret = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            produced += out_chunk - stream.avail_out;
+            if (ret == Z_STREAM_END) {
+                ended = true;
+                break;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                ok = false;
+                break;
+            }
+        } while (stream.avail_in != 0u || (finish && stream.avail_out == 0u));
+        if (!ok || finish) { break; }
+        segment_offset = static_cast<size_t>(reinterpret_cast<std::byte const *>(stream.next_in) - input[segment].data());
+    }
+    deflateEnd(&stream);
+    ok = ok && ended;
+    output.resize(ok ? produced : header_size);
+    return ok;
+}
+
+[[nodiscard]] static bool remote_zlib_decompress(luisa::span<const std::byte> input,
+                                                 size_t raw_size,
+                                                 luisa::vector<std::byte> &output) noexcept {
+    // deflate never expands data by more than about 1032:1, so larger sizes can only come from
+    // corrupted or malicious messages and are rejected before allocating the output
+    static constexpr auto zlib_max_ratio = static_cast<size_t>(1032u);
+    if (raw_size / zlib_max_ratio > input.size()) { return false; }
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK) { return false; }
+    auto offset = output.size();
+    output.resize(offset + raw_size);
+    auto consumed = static_cast<size_t>(0u);
+    auto produced = static_cast<size_t>(0u);
+    auto ok = true;
+    while (true) {
+        auto in_chunk = std::min(input.size() - consumed, zlib_max_chunk_size);
+        auto out_chunk = std::min(raw_size - produced, zlib_max_chunk_size);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<std::byte *>(input.data() + consumed));
+        stream.avail_in = static_cast<uInt>(in_chunk);
+        stream.next_out = reinterpret_cast<Bytef *>(output.data() + offset + produced);
+        stream.avail_out = static_cast<uInt>(out_chunk);
+        auto ret = inflate(&stream, Z_NO_FLUSH);
+        auto progress = (in_chunk - stream.avail_in) + (out_chunk - stream.avail_out);
+        consumed += in_chunk - stream.avail_in;
+        produced += out_chunk - stream.avail_out;
+        if (ret == Z_STREAM_END) { break; }
+        // corrupted data, or truncated data or data longer than announced that stall the stream
+        if ((ret != Z_OK && ret != Z_BUF_ERROR) || progress == 0u) {
+            ok = false;
+            break;
+        }
+    }
+    inflateEnd(&stream);
+    ok = ok && produced == raw_size;
+    if (!ok) { output.resize(offset); }
+    return ok;
+}
+#endif
+
+bool remote_compression_supported(RemoteCompression mode) noexcept {
+    switch (mode) {
+        case RemoteCompression::NONE: return true;
+#ifdef LUISA_COMPUTE_REMOTE_ENABLE_ZLIB
+        case RemoteCompression::ZLIB: return true;
+#endif
+        default: break;
+    }
+    return false;
+}
+
+bool remote_compress(RemoteCompression mode,
+                     luisa::span<const luisa::span<const std::byte>> input,
+                     luisa::vector<std::byte> &output) noexcept {
+    switch (mode) {
+#ifdef LUISA_COMPUTE_REMOTE_ENABLE_ZLIB
+        case RemoteCompression::ZLIB: return remote_zlib_compress(input, output);
+#endif
+        default: break;
+    }
+    return false;
+}
+
+bool remote_decompress(RemoteCompression mode,
+                       luisa::span<const std::byte> input,
+                       size_t raw_size,
+                       luisa::vector<std::byte> &output) noexcept {
+    switch (mode) {
+#ifdef LUISA_COMPUTE_REMOTE_ENABLE_ZLIB
+        case RemoteCompression::ZLIB: return remote_zlib_decompress(input, raw_size, output);
+#endif
+        default: break;
+    }
+    return false;
+}
+
+}// namespace luisa::compute::detail
@@ -0,0 +1,18 @@
+#pragma once
+#include <luisa/runtime/remote/client_interface.h>
+namespace luisa::compute::detail {
+// internal to the runtime, shared by ClientInterface and ServerInterface
+[[nodiscard]] bool remote_compression_supported(RemoteCompression mode) noexcept;
+// Appends the compressed concatenation of `input` to `output`. Returns false, leaving `output`
+// unchanged, if the mode is not supported or compression does not reduce the size.
+[[nodiscard]] bool remote_compress(RemoteCompression mode,
+                                   luisa::span<const luisa::span<const std::byte>> input,
+                                   luisa::vector<std::byte> &output) noexcept;
+// Appends the `raw_size` bytes decompressed from `input` to `output`. Returns false, leaving `output`
+// unchanged, if the mode is not supported, or the input is malformed or does not decompress to
+// exactly `raw_size` bytes, which is bounded by the maximum compression ratio of the mode.
+[[nodiscard]] bool remote_decompress(RemoteCompression mode,
+                                     luisa::span<const std::byte> input,
+                                     size_t raw_size,
+                                     luisa::vector<std::byte> &output) noexcept;
+}// namespace luisa::compute::detail
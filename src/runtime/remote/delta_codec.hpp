@@ -0,0 +1,59 @@
+#pragma once
+#include <array>
+#include <luisa/core/stl/unordered_map.h>
+#include "serde.hpp"
+namespace luisa::compute {
+// Delta encoding of the per-slot modifications of a resource (bindless array slots, accel instances),
+// which mostly repeat the previously sent values between frames. Each element is sent as its slot,
+// a bit mask of the bytes that differ from the last element sent for the same slot of the same
+// resource, and these bytes only. The encoder (client) and the decoder (server) keep identical
+// mirrors of the last elements sent, which must be erased when the resource is destroyed.
+template<typename T>
+class DeltaCodec {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static constexpr auto mask_size = (sizeof(T) + 7u) / 8u;
+    using Element = std::array<std::byte, sizeof(T)>;
+    luisa::unordered_map<uint64_t, luisa::unordered_map<uint64_t, Element>> _mirrors;
+
+public:
+    template<typename SlotOf>
+    void encode(uint64_t resource, luisa::span<const T> elements, SlotOf &&slot_of, luisa::vector<std::byte> &vec) noexcept {
+        auto &mirror = _mirrors[resource];
+        SerDe::ser_value(elements.size(), vec);
+        for (auto &&e : elements) {
+            auto slot = static_cast<uint64_t>(slot_of(e));
+            // unseen slots are encoded against zeros
+            auto &last = mirror.try_emplace(slot, Element{}).first->second;
+            auto bytes = reinterpret_cast<std::byte const *>(&e);
+            std::array<uint8_t, mask_size> mask{};
+            for (auto i = 0u; i < sizeof(T); i++) {
+                if (bytes[i] != last[i]) { mask[i / 8u] |= static_cast<uint8_t>(1u << (i % 8u)); }
+            }
+            SerDe::ser_value(slot, vec);
+            SerDe::ser_value(mask, vec);
+            for (auto i = 0u; i < sizeof(T); i++) {
+                if (mask[i / 8u] & (1u << (i % 8u))) { vec.emplace_back(bytes[i]); }
+            }
+            std::memcpy(last.data(), bytes, sizeof(T));
+        }
+    }
+    [[nodiscard]] luisa::vector<T> decode(uint64_t resource, std::byte const *&ptr) noexcept {
+        auto &mirror = _mirrors[resource];
+        auto size = SerDe::deser_value<size_t>(ptr);
+        luisa::vector<T> r;
+        if (size == 0) { return r; }
+        r.push_back_uninitialized(size);
+        for (size_t i = 0; i < size; ++i) {
+            auto slot = SerDe::deser_value<uint64_t>(ptr);
+            auto mask = SerDe::deser_value<std::array<uint8_t, mask_size>>(ptr);
+            auto &last = mirror.try_emplace(slot, Element{}).first->second;
+            for (auto j = 0u; j < sizeof(T); j++) {
+                if (mask[j / 8u] & (1u << (j % 8u))) { last[j] = *(ptr++); }
+            }
+            std::memcpy(r.data() + i, last.data(), sizeof(T));
+        }
+        return r;
+    }
+    void erase(uint64_t resource) noexcept { _mirrors.erase(resource); }
+};
+}// namespace luisa::compute
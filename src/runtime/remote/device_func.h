@@ -46,5 +46,13 @@ enum class DeviceFunc : uint32_t {
     AllocSparseTextureHeap,
     DeAllocSparseTextureHeap,
     UpdateSparseResource,
+    LookupShaderCache,
+    QueryCompression,
+    Compressed,
+    QueryCapabilities,
+};
+// optional features advertised by the server in response to DeviceFunc::QueryCapabilities
+enum class ServerCapability : uint32_t {
+    ShaderCache = 1u << 0u,
 };
 }// namespace luisa::compute
\ No newline at end of file
@@ -3,6 +3,11 @@
 #include <luisa/core/stl/string.h>
 namespace luisa::compute {
 class SerDe {
+    // types with ser_value specializations (e.g., string_view) must go through them
+    template<typename T>
+    static constexpr bool is_bitwise_serializable = std::is_trivially_copyable_v<T> &&
+                                                    !std::is_same_v<T, luisa::string_view>;
+
 public:
     template<typename T>
     static void ser_value(T const &t, luisa::vector<std::byte> &vec) noexcept;
@@ -54,17 +59,31 @@ inline luisa::string SerDe::deser_value(std::byte const *&ptr) noexcept {
 template<typename T>
 inline void SerDe::ser_array(span<const T> t, luisa::vector<std::byte> &vec) noexcept {
     ser_value<size_t>(t.size(), vec);
-    for (auto &i : t) {
-        ser_value<T>(i, vec);
+    if constexpr (is_bitwise_serializable<T>) {
+        // copy the whole span at once instead of element by element
+        if (t.empty()) { return; }
+        auto last_len = vec.size();
+        vec.push_back_uninitialized(t.size_bytes());
+        memcpy(vec.data() + last_len, t.data(), t.size_bytes());
+    } else {
+        for (auto &i : t) {
+            ser_value<T>(i, vec);
+        }
     }
 }
 template<typename T>
 inline vector<T> SerDe::deser_array(std::byte const *&ptr) noexcept {
     vector<T> r;
     auto size = deser_value<size_t>(ptr);
+    if (size == 0) { return r; }
     r.push_back_uninitialized(size);
-    for (size_t i = 0; i < size; ++i) {
-        new (std::launder(r.data() + i)) T{deser_value<T>(ptr)};
+    if constexpr (is_bitwise_serializable<T>) {
+        memcpy(r.data(), ptr, size * sizeof(T));
+        ptr += size * sizeof(T);
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            new (std::launder(r.data() + i)) T{deser_value<T>(ptr)};
+        }
     }
     return r;
 }
@@ -1,13 +1,55 @@
 #include <luisa/runtime/remote/server_interface.h>
 #include <luisa/core/logging.h>
+#include <luisa/ast/callable_library.h>
 #include "device_func.h"
 #include "serde.hpp"
+#include "delta_codec.hpp"
+#include "compression.h"
 namespace luisa::compute {
+ServerShaderCache::ServerShaderCache(Handle device, size_t capacity) noexcept
+    : _device{std::move(device)}, _capacity{capacity} {}
+ServerShaderCache::~ServerShaderCache() noexcept {
+    for (auto handle : _handles) {
+        _device->destroy_shader(handle);
+    }
+}
+size_t ServerShaderCache::size() const noexcept {
+    std::lock_guard lck{_mtx};
+    return _shaders.size();
+}
+uint64_t ServerShaderCache::find(uint64_t key) const noexcept {
+    std::lock_guard lck{_mtx};
+    auto iter = _shaders.find(key);
+    return iter == _shaders.end() ? invalid_resource_handle : iter->second;
+}
+uint64_t ServerShaderCache::insert(uint64_t key, uint64_t handle) noexcept {
+    std::lock_guard lck{_mtx};
+    if (auto iter = _shaders.find(key); iter != _shaders.end()) {
+        return iter->second;
+    }
+    if (_shaders.size() < _capacity) {
+        _shaders.emplace(key, handle);
+        _handles.emplace(handle);
+    }
+    return handle;
+}
+bool ServerShaderCache::contains_handle(uint64_t handle) const noexcept {
+    std::lock_guard lck{_mtx};
+    return _handles.contains(handle);
+}
 ServerInterface::ServerInterface(
     Handle device_impl,
-    SendMsgFunc &&send_msg) noexcept
+    SendMsgFunc &&send_msg,
+    luisa::shared_ptr<ServerShaderCache> shader_cache) noexcept
     : _impl{std::move(device_impl)},
-      _send_msg{std::move(send_msg)} {}
+      _send_msg{std::move(send_msg)},
+      _shader_cache{std::move(shader_cache)} {
+    LUISA_ASSERT(_shader_cache == nullptr || _shader_cache->device() == _impl,
+                 "Shader cache must be created on the same device as the server.");
+    _bindless_codec = luisa::make_unique<DeltaCodec<BindlessArrayUpdateCommand::Modification>>();
+    _accel_codec = luisa::make_unique<DeltaCodec<AccelBuildCommand::Modification>>();
+}
+ServerInterface::~ServerInterface() noexcept = default;
 uint64_t ServerInterface::native_handle(uint64_t handle) const {
     std::lock_guard lck{_handle_mtx};
     auto iter = _handle_map.find(handle);
@@ -72,6 +114,28 @@ void ServerInterface::execute(luisa::span<const std::byte> data, luisa::vector<s
         case DeviceFunc::AllocSparseTextureHeap: alloc_sparse_texture_heap(ptr, result); break;
         case DeviceFunc::DeAllocSparseTextureHeap: dealloc_sparse_texture_heap(ptr, result); break;
         case DeviceFunc::UpdateSparseResource: update_sparse_resource(ptr, result); break;
+        case DeviceFunc::LookupShaderCache: lookup_shader_cache(ptr, result); break;
+        case DeviceFunc::QueryCapabilities: query_capabilities(ptr, result); break;
+        case DeviceFunc::QueryCompression: {
+            auto mode = SerDe::deser_value<RemoteCompression>(ptr);
+            SerDe::ser_value(detail::remote_compression_supported(mode), result);
+        } break;
+        case DeviceFunc::Compressed: {
+            auto mode = SerDe::deser_value<RemoteCompression>(ptr);
+            auto raw_size = SerDe::deser_value<size_t>(ptr);
+            luisa::vector<std::byte> raw;
+            if (!detail::remote_decompress(
+                    mode, luisa::span<const std::byte>{ptr, static_cast<size_t>(data.data() + data.size() - ptr)},
+                    raw_size, raw)) {
+                // a broken message only affects its client, so drop it without aborting the server
+                LUISA_WARNING_WITH_LOCATION(
+                    "Dropping remote message that failed to decompress "
+                    "(mode = {}, announced size = {}).",
+                    luisa::to_underlying(mode), raw_size);
+                break;
+            }
+            execute(raw, result);
+        } break;
         default: break;
     }
 }
@@ -124,6 +188,7 @@ void ServerInterface::create_bindless_array(std::byte const *&ptr, luisa::vector
 void ServerInterface::destroy_bindless_array(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
     auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
     auto handle = remove_handle(frontend_handle);
+    _bindless_codec->erase(frontend_handle);
     _impl->destroy_bindless_array(handle);
 }
 void ServerInterface::create_stream(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
@@ -138,10 +203,230 @@ void ServerInterface::destroy_stream(std::byte const *&ptr, luisa::vector<std::b
     _impl->destroy_stream(handle);
 }
 void ServerInterface::dispatch(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
-    // TODO
+    // mirrors ClientInterface::dispatch, with the frontend handles replaced by the backend ones
+    auto stream_handle = SerDe::deser_value<uint64_t>(ptr);
+    auto cmd_count = SerDe::deser_value<size_t>(ptr);
+    auto list = CommandList::create(cmd_count, 1u);
+    // the message is only alive during the call, so the uploaded data is kept until the commands complete
+    luisa::vector<luisa::vector<std::byte>> uploads;
+    luisa::vector<luisa::vector<std::byte>> readbacks;
+    auto upload = [&]() noexcept {
+        return uploads.emplace_back(SerDe::deser_array<std::byte>(ptr)).data();
+    };
+    auto readback = [&](size_t size) noexcept {
+        auto &&r = readbacks.emplace_back();
+        r.push_back_uninitialized(size);
+        return r.data();
+    };
+    for (auto i = 0u; i < cmd_count; i++) {
+        switch (SerDe::deser_value<Command::Tag>(ptr)) {
+            case Command::Tag::EBufferUploadCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto offset = SerDe::deser_value<size_t>(ptr);
+                auto size = SerDe::deser_value<size_t>(ptr);
+                list << luisa::make_unique<BufferUploadCommand>(handle, offset, size, upload());
+            } break;
+            case Command::Tag::EBufferDownloadCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto offset = SerDe::deser_value<size_t>(ptr);
+                auto size = SerDe::deser_value<size_t>(ptr);
+                list << luisa::make_unique<BufferDownloadCommand>(handle, offset, size, readback(size));
+            } break;
+            case Command::Tag::EBufferCopyCommand: {
+                auto src = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto src_offset = SerDe::deser_value<size_t>(ptr);
+                auto dst = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto dst_offset = SerDe::deser_value<size_t>(ptr);
+                auto size = SerDe::deser_value<size_t>(ptr);
+                list << luisa::make_unique<BufferCopyCommand>(src, dst, src_offset, dst_offset, size);
+            } break;
+            case Command::Tag::EBufferToTextureCopyCommand: {
+                auto buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto buffer_offset = SerDe::deser_value<size_t>(ptr);
+                auto texture = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto storage = SerDe::deser_value<PixelStorage>(ptr);
+                auto level = SerDe::deser_value<uint>(ptr);
+                auto texture_offset = SerDe::deser_value<uint3>(ptr);
+                auto size = SerDe::deser_value<uint3>(ptr);
+                list << luisa::make_unique<BufferToTextureCopyCommand>(
+                    buffer, buffer_offset, texture, storage, level, size, texture_offset);
+            } break;
+            case Command::Tag::ETextureToBufferCopyCommand: {
+                auto buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto buffer_offset = SerDe::deser_value<size_t>(ptr);
+                auto texture = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto storage = SerDe::deser_value<PixelStorage>(ptr);
+                auto level = SerDe::deser_value<uint>(ptr);
+                auto texture_offset = SerDe::deser_value<uint3>(ptr);
+                auto size = SerDe::deser_value<uint3>(ptr);
+                list << luisa::make_unique<TextureToBufferCopyCommand>(
+                    buffer, buffer_offset, texture, storage, level, size, texture_offset);
+            } break;
+            case Command::Tag::ETextureCopyCommand: {
+                auto storage = SerDe::deser_value<PixelStorage>(ptr);
+                auto src = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto dst = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto size = SerDe::deser_value<uint3>(ptr);
+                auto src_level = SerDe::deser_value<uint>(ptr);
+                auto src_offset = SerDe::deser_value<uint3>(ptr);
+                auto dst_offset = SerDe::deser_value<uint3>(ptr);
+                auto dst_level = SerDe::deser_value<uint>(ptr);
+                list << luisa::make_unique<TextureCopyCommand>(
+                    storage, src, dst, src_level, dst_level, size, src_offset, dst_offset);
+            } break;
+            case Command::Tag::ETextureUploadCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto storage = SerDe::deser_value<PixelStorage>(ptr);
+                auto level = SerDe::deser_value<uint>(ptr);
+                auto size = SerDe::deser_value<uint3>(ptr);
+                auto offset = SerDe::deser_value<uint3>(ptr);
+                list << luisa::make_unique<TextureUploadCommand>(
+                    handle, storage, level, size, upload(), offset);
+            } break;
+            case Command::Tag::ETextureDownloadCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto storage = SerDe::deser_value<PixelStorage>(ptr);
+                auto level = SerDe::deser_value<uint>(ptr);
+                auto size = SerDe::deser_value<uint3>(ptr);
+                auto offset = SerDe::deser_value<uint3>(ptr);
+                list << luisa::make_unique<TextureDownloadCommand>(
+                    handle, storage, level, size, readback(pixel_storage_size(storage, size)), offset);
+            } break;
+            case Command::Tag::EMeshBuildCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto request = SerDe::deser_value<AccelBuildRequest>(ptr);
+                auto vertex_buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto vertex_stride = SerDe::deser_value<size_t>(ptr);
+                auto vertex_buffer_offset = SerDe::deser_value<size_t>(ptr);
+                auto vertex_buffer_size = SerDe::deser_value<size_t>(ptr);
+                auto triangle_buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto triangle_buffer_offset = SerDe::deser_value<size_t>(ptr);
+                auto triangle_buffer_size = SerDe::deser_value<size_t>(ptr);
+                list << luisa::make_unique<MeshBuildCommand>(
+                    handle, request,
+                    vertex_buffer, vertex_buffer_offset, vertex_buffer_size, vertex_stride,
+                    triangle_buffer, triangle_buffer_offset, triangle_buffer_size);
+            } break;
+            case Command::Tag::ECurveBuildCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto request = SerDe::deser_value<AccelBuildRequest>(ptr);
+                auto basis = SerDe::deser_value<CurveBasis>(ptr);
+                auto cp_count = SerDe::deser_value<size_t>(ptr);
+                auto seg_count = SerDe::deser_value<size_t>(ptr);
+                auto cp_buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto cp_buffer_offset = SerDe::deser_value<size_t>(ptr);
+                auto cp_stride = SerDe::deser_value<size_t>(ptr);
+                auto seg_buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto seg_buffer_offset = SerDe::deser_value<size_t>(ptr);
+                list << luisa::make_unique<CurveBuildCommand>(
+                    handle, request, basis, cp_count, seg_count,
+                    cp_buffer, cp_buffer_offset, cp_stride,
+                    seg_buffer, seg_buffer_offset);
+            } break;
+            case Command::Tag::EProceduralPrimitiveBuildCommand: {
+                auto handle = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto request = SerDe::deser_value<AccelBuildRequest>(ptr);
+                auto aabb_buffer = native_handle(SerDe::deser_value<uint64_t>(ptr));
+                auto aabb_buffer_offset = SerDe::deser_value<size_t>(ptr);
+                auto aabb_buffer_size = SerDe::deser_value<size_t>(ptr);
+                list << luisa::make_unique<ProceduralPrimitiveBuildCommand>(
+                    handle, request, aabb_buffer, aabb_buffer_offset, aabb_buffer_size);
+            } break;
+            case Command::Tag::EAccelBuildCommand: {
+                auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
+                auto request = SerDe::deser_value<AccelBuildRequest>(ptr);
+                auto instance_count = SerDe::deser_value<uint32_t>(ptr);
+                // the codec mirrors the client's elements, so the handles are translated in the decoded copies only
+                auto modifications = _accel_codec->decode(frontend_handle, ptr);
+                for (auto &&m : modifications) {
+                    if (m.flags & AccelBuildCommand::Modification::flag_primitive) {
+                        m.primitive = native_handle(m.primitive);
+                    }
+                }
+                auto update_instance_buffer_only = SerDe::deser_value<bool>(ptr);
+                list << luisa::make_unique<AccelBuildCommand>(
+                    native_handle(frontend_handle), instance_count, request,
+                    std::move(modifications), update_instance_buffer_only);
+            } break;
+            case Command::Tag::EBindlessArrayUpdateCommand: {
+                using Operation = BindlessArrayUpdateCommand::Modification::Operation;
+                auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
+                auto modifications = _bindless_codec->decode(frontend_handle, ptr);
+                for (auto &&m : modifications) {
+                    if (m.buffer.op == Operation::EMPLACE) { m.buffer.handle = native_handle(m.buffer.handle); }
+                    if (m.tex2d.op == Operation::EMPLACE) { m.tex2d.handle = native_handle(m.tex2d.handle); }
+                    if (m.tex3d.op == Operation::EMPLACE) { m.tex3d.handle = native_handle(m.tex3d.handle); }
+                }
+                list << luisa::make_unique<BindlessArrayUpdateCommand>(
+                    native_handle(frontend_handle), std::move(modifications));
+            } break;
+            default:
+                LUISA_WARNING_WITH_LOCATION("Unsupported command in remote dispatch.");
+                return;
+        }
+    }
+    // the downloaded data is sent back in the order of the download commands once the commands complete
+    list.add_callback([this, stream_handle, uploads = std::move(uploads), readbacks = std::move(readbacks)] {
+        if (readbacks.empty()) { return; }
+        luisa::vector<std::byte> msg;
+        SerDe::ser_value(stream_handle, msg);
+        SerDe::ser_value(readbacks.size(), msg);
+        for (auto &&r : readbacks) { SerDe::ser_array(luisa::span<const std::byte>{r}, msg); }
+        _send_msg(std::move(msg));
+    });
+    _impl->dispatch(native_handle(stream_handle), std::move(list));
 }
 void ServerInterface::create_swap_chain(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
-void ServerInterface::create_shader_ast(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
+void ServerInterface::create_shader_ast(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
+    auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
+    ShaderOption option;
+    option.enable_cache = SerDe::deser_value<bool>(ptr);
+    option.enable_fast_math = SerDe::deser_value<bool>(ptr);
+    option.enable_debug_info = SerDe::deser_value<bool>(ptr);
+    option.compile_only = SerDe::deser_value<bool>(ptr);
+    option.max_registers = SerDe::deser_value<uint32_t>(ptr);
+    option.time_trace = SerDe::deser_value<bool>(ptr);
+    option.name = SerDe::deser_value<luisa::string>(ptr);
+    auto cache_key = SerDe::deser_value<uint64_t>(ptr);
+    auto lib_data = SerDe::deser_array<std::byte>(ptr);
+    CallableLibrary lib;
+    lib.load(lib_data);
+    auto res = _impl->create_shader(option, lib.get_function("##"));
+    if (!res.valid()) {
+        // compile-only shaders are not expected to create shader objects
+        if (!option.compile_only) {
+            // do not abort the server, as a failed shader only affects its client
+            LUISA_WARNING_WITH_LOCATION(
+                "Failed to create shader '{}' for frontend handle {}; "
+                "the handle is left unmapped.",
+                option.name, frontend_handle);
+        }
+        return;
+    }
+    // keys are only sent for shaders that may be shared, i.e., not compile-only ones
+    if (_shader_cache != nullptr && cache_key != 0u) {
+        if (auto cached = _shader_cache->insert(cache_key, res.handle); cached != res.handle) {
+            // another session inserted the same shader while this one was being compiled,
+            // so switch to the cached one to keep a single copy alive
+            _impl->destroy_shader(res.handle);
+            res.handle = cached;
+        }
+    }
+    insert_handle(frontend_handle, res.handle);
+}
+void ServerInterface::query_capabilities(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
+    auto capabilities = static_cast<uint32_t>(0u);
+    if (_shader_cache != nullptr) { capabilities |= luisa::to_underlying(ServerCapability::ShaderCache); }
+    SerDe::ser_value(capabilities, result);
+}
+void ServerInterface::lookup_shader_cache(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
+    auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
+    auto cache_key = SerDe::deser_value<uint64_t>(ptr);
+    auto handle = _shader_cache == nullptr ? invalid_resource_handle : _shader_cache->find(cache_key);
+    auto hit = handle != invalid_resource_handle;
+    if (hit) { insert_handle(frontend_handle, handle); }
+    SerDe::ser_value(hit, result);
+}
 // void ServerInterface::create_shader_ir(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
 // void ServerInterface::create_shader_ir_v2(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
 void ServerInterface::load_shader(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
@@ -149,7 +434,10 @@ void ServerInterface::shader_arg_usage(std::byte const *&ptr, luisa::vector<std:
 void ServerInterface::destroy_shader(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
     auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
     auto handle = remove_handle(frontend_handle);
-    _impl->destroy_shader(handle);
+    // cached shaders may be shared with other sessions and are destroyed with the cache
+    if (_shader_cache == nullptr || !_shader_cache->contains_handle(handle)) {
+        _impl->destroy_shader(handle);
+    }
 }
 void ServerInterface::create_event(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
 void ServerInterface::destroy_event(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
@@ -188,6 +476,7 @@ void ServerInterface::create_accel(std::byte const *&ptr, luisa::vector<std::byt
 void ServerInterface::destroy_accel(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {
     auto frontend_handle = SerDe::deser_value<uint64_t>(ptr);
     auto handle = remove_handle(frontend_handle);
+    _accel_codec->erase(frontend_handle);
     _impl->destroy_accel(handle);
 }
 void ServerInterface::create_sparse_buffer(std::byte const *&ptr, luisa::vector<std::byte> &result) noexcept {}
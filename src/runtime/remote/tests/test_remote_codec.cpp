@@ -0,0 +1,148 @@
+#include <luisa/core/logging.h>
+#include <luisa/runtime/remote/client_interface.h>
+
+#include "../delta_codec.hpp"
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// no padding, so that the bytes compared by the codec are all well-defined
+struct Element {
+    uint slot;
+    uint flags;
+    std::array<float, 4u> value;
+};
+
+[[nodiscard]] bool same(luisa::span<const Element> a, luisa::span<const Element> b) noexcept {
+    return a.size() == b.size() &&
+           std::memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+}
+
+// round trips the elements through the codec pair, returning the size of the encoded data
+size_t round_trip(DeltaCodec<Element> &encoder, DeltaCodec<Element> &decoder,
+                  uint64_t resource, luisa::span<const Element> elements) noexcept {
+    luisa::vector<std::byte> bytes;
+    encoder.encode(resource, elements, [](auto &&e) noexcept { return e.slot; }, bytes);
+    auto ptr = static_cast<std::byte const *>(bytes.data());
+    auto decoded = decoder.decode(resource, ptr);
+    LUISA_ASSERT(ptr == bytes.data() + bytes.size(), "Decoder did not consume the whole message.");
+    LUISA_ASSERT(same(decoded, elements), "Delta codec round trip mismatch.");
+    return bytes.size();
+}
+
+void test_delta_codec() noexcept {
+    static constexpr auto mask_size = (sizeof(Element) + 7u) / 8u;
+    static constexpr auto header_size = sizeof(size_t);
+    static constexpr auto element_header_size = sizeof(uint64_t) + mask_size;
+    DeltaCodec<Element> encoder;
+    DeltaCodec<Element> decoder;
+
+    // unseen slots are encoded against zeros, so only the non-zero bytes are sent
+    std::array first{Element{0u, 0u, {1.f, 1.f, 1.f, 1.f}},
+                     Element{5u, 1u, {2.f, 2.f, 2.f, 2.f}},
+                     Element{3u, 0u, {0.f, 0.f, 0.f, 0.f}}};
+    round_trip(encoder, decoder, 1u, first);
+    std::array almost_zero{Element{7u, 0u, {0.f, 0.f, 0.f, 0.f}}};
+    LUISA_ASSERT(round_trip(encoder, decoder, 1u, almost_zero) == header_size + element_header_size + 1u,
+                 "Only the non-zero bytes of an unseen slot should be sent.");
+
+    // unchanged elements only send their headers, and changed ones only the bytes that differ
+    auto second = first;
+    second[1].flags = 2u;
+    LUISA_ASSERT(round_trip(encoder, decoder, 1u, second) == header_size + 3u * element_header_size + 1u,
+                 "Unexpected size of the delta-encoded elements.");
+
+    // the same slot of another resource has its own mirror
+    std::array other{Element{5u, 2u, {2.f, 2.f, 2.f, 2.f}}};
+    auto unseen_size = round_trip(encoder, decoder, 2u, other);
+    LUISA_ASSERT(unseen_size > header_size + element_header_size, "Slots of different resources should not share mirrors.");
+
+    // empty updates
+    LUISA_ASSERT(round_trip(encoder, decoder, 1u, {}) == header_size, "Unexpected size of an empty update.");
+
+    // erased resources start over from zeros on both sides
+    encoder.erase(2u);
+    decoder.erase(2u);
+    LUISA_ASSERT(round_trip(encoder, decoder, 2u, other) == unseen_size, "Erased mirrors should be reset.");
+}
+
+void test_serde() noexcept {
+    // string views are serialized through their ser_value specialization, not bitwise
+    std::array<luisa::string_view, 2u> names{"ab", "cde"};
+    luisa::vector<std::byte> bytes;
+    SerDe::ser_array(luisa::span<const luisa::string_view>{names}, bytes);
+    LUISA_ASSERT(bytes.size() == 3u * sizeof(size_t) + 5u, "Unexpected size of serialized string views.");
+    auto ptr = static_cast<std::byte const *>(bytes.data());
+    auto strings = SerDe::deser_array<luisa::string>(ptr);
+    LUISA_ASSERT(ptr == bytes.data() + bytes.size() &&
+                     strings.size() == 2u && strings[0] == "ab" && strings[1] == "cde",
+                 "String view serialization round trip mismatch.");
+
+    // trivially copyable elements are copied as a whole
+    std::array elements{Element{1u, 2u, {3.f, 4.f, 5.f, 6.f}}, Element{7u, 8u, {9.f, 10.f, 11.f, 12.f}}};
+    bytes.clear();
+    SerDe::ser_array(luisa::span<const Element>{elements}, bytes);
+    LUISA_ASSERT(bytes.size() == sizeof(size_t) + sizeof(elements), "Unexpected size of serialized elements.");
+    ptr = bytes.data();
+    auto decoded = SerDe::deser_array<Element>(ptr);
+    LUISA_ASSERT(ptr == bytes.data() + bytes.size() && same(decoded, elements),
+                 "Element serialization round trip mismatch.");
+}
+
+// records the messages sent through the default gathering implementation
+class RecordingCallback final : public ClientCallback {
+public:
+    luisa::vector<luisa::vector<std::byte>> sent;
+    void async_send(luisa::vector<std::byte> data) noexcept override { sent.emplace_back(std::move(data)); }
+    void sync_send(luisa::span<const std::byte>, luisa::vector<std::byte> &) noexcept override {
+        LUISA_ERROR_WITH_LOCATION("Unexpected synchronous send.");
+    }
+};
+
+[[nodiscard]] luisa::vector<std::byte> to_bytes(luisa::string_view s) noexcept {
+    luisa::vector<std::byte> bytes(s.size());
+    std::memcpy(bytes.data(), s.data(), s.size());
+    return bytes;
+}
+
+[[nodiscard]] luisa::span<const std::byte> as_bytes(luisa::string_view s) noexcept {
+    return {reinterpret_cast<const std::byte *>(s.data()), s.size()};
+}
+
+void test_send_gather() noexcept {
+    RecordingCallback callback;
+    auto gather = [&](luisa::vector<ClientCallback::Payload> payloads) noexcept {
+        callback.async_send_gather(to_bytes("0123456789"), std::move(payloads));
+        LUISA_ASSERT(!callback.sent.empty(), "Nothing was sent.");
+        auto &&last = callback.sent.back();
+        return luisa::string{reinterpret_cast<const char *>(last.data()), last.size()};
+    };
+
+    // no payloads: the data is sent as is
+    LUISA_ASSERT(gather({}) == "0123456789", "Data without payloads should be sent unchanged.");
+
+    // a single payload in the middle
+    LUISA_ASSERT(gather({{4u, as_bytes("abc")}}) == "0123abc456789",
+                 "A single payload should be spliced at its offset.");
+
+    // several payloads at the front, at a shared offset, and at the end, including an empty one
+    LUISA_ASSERT(gather({{0u, as_bytes("x")},
+                         {3u, as_bytes("yy")},
+                         {3u, as_bytes("z")},
+                         {6u, as_bytes("")},
+                         {10u, as_bytes("w")}}) == "x012yyz3456789w",
+                 "Several payloads should be spliced at their offsets in order.");
+
+    LUISA_ASSERT(callback.sent.size() == 3u, "Each gather should send exactly one message.");
+}
+
+}// namespace
+
+int main() {
+    test_delta_codec();
+    test_serde();
+    test_send_gather();
+    LUISA_INFO("Remote codec tests passed.");
+}
@@ -14,4 +14,12 @@ if get_config("enable_ir") then
 end
 add_headerfiles("../../include/luisa/runtime/**.h")
 add_files("**.cpp")
+-- the in-tree zlib package only ships prebuilt libraries for windows and macosx
+if is_plat("windows", "macosx") then
+	add_packages("zlib", {
+		public = false,
+		inherit = false
+	})
+	add_defines("LUISA_COMPUTE_REMOTE_ENABLE_ZLIB")
+end
 target_end()
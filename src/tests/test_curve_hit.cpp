@@ -0,0 +1,70 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    if (argc <= 1) {
+        LUISA_INFO("Usage: {} <backend>. <backend>: cuda, dx, cpu, metal", argv[0]);
+        exit(1);
+    }
+    Device device = context.create_device(argv[1]);
+    auto stream = device.create_stream();
+
+    // a straight curve along the x-axis around the origin and a triangle around (5, 0, 0)
+    static constexpr auto curve_basis = CurveBasis::PIECEWISE_LINEAR;
+    std::array control_points{make_float4(-1.f, 0.f, 0.f, .1f),
+                              make_float4(1.f, 0.f, 0.f, .1f)};
+    std::array segments{0u};
+    std::array vertices{make_float3(4.f, -1.f, 0.f),
+                        make_float3(6.f, -1.f, 0.f),
+                        make_float3(5.f, 1.f, 0.f)};
+    std::array indices{0u, 1u, 2u};
+
+    auto control_point_buffer = device.create_buffer<float4>(control_points.size());
+    auto segment_buffer = device.create_buffer<uint>(segments.size());
+    auto vertex_buffer = device.create_buffer<float3>(vertices.size());
+    auto triangle_buffer = device.create_buffer<Triangle>(1u);
+    stream << control_point_buffer.copy_from(control_points.data())
+           << segment_buffer.copy_from(segments.data())
+           << vertex_buffer.copy_from(vertices.data())
+           << triangle_buffer.copy_from(indices.data());
+
+    auto curve = device.create_curve(curve_basis, control_point_buffer, segment_buffer);
+    auto mesh = device.create_mesh(vertex_buffer, triangle_buffer);
+    auto accel = device.create_accel();
+    accel.emplace_back(curve);
+    accel.emplace_back(mesh);
+    stream << curve.build()
+           << mesh.build()
+           << accel.build();
+
+    // 0: miss, 1: triangle, 2: curve
+    auto classify = device.compile<1>([&](AccelVar accel, BufferUInt result) noexcept {
+        auto i = dispatch_id().x;
+        auto x = cast<float>(i) * 5.f;// 0, 5, 10
+        auto ray = make_ray(make_float3(x, 0.f, 5.f), make_float3(0.f, 0.f, -1.f));
+        auto hit = accel.intersect(ray, {.curve_bases = {curve_basis}});
+        auto kind = def(0u);
+        $if (hit->is_curve()) {
+            kind = 2u;
+        }
+        $elif (hit->is_triangle()) {
+            kind = 1u;
+        };
+        result.write(i, kind);
+    });
+
+    auto result_buffer = device.create_buffer<uint>(3u);
+    std::array<uint, 3u> result{};
+    stream << classify(accel, result_buffer).dispatch(3u)
+           << result_buffer.copy_to(result.data())
+           << synchronize();
+
+    LUISA_INFO("Closest hits: [{}, {}, {}].", result[0], result[1], result[2]);
+    LUISA_ASSERT(result[0] == 2u, "Expected a curve hit, got {}.", result[0]);
+    LUISA_ASSERT(result[1] == 1u, "Expected a triangle hit, got {}.", result[1]);
+    LUISA_ASSERT(result[2] == 0u, "Expected a miss, got {}.", result[2]);
+}
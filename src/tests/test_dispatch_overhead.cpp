@@ -0,0 +1,48 @@
+#include <luisa/core/clock.h>
+#include <luisa/core/logging.h>
+#include <luisa/runtime/context.h>
+#include <luisa/runtime/device.h>
+#include <luisa/runtime/stream.h>
+#include <luisa/dsl/syntax.h>
+#include <luisa/dsl/sugar.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    log_level_info();
+
+    Context context{argv[0]};
+    if (argc <= 1) {
+        LUISA_INFO("Usage: {} <backend>. <backend>: cuda, dx, cpu, metal, fallback", argv[0]);
+        exit(1);
+    }
+    Device device = context.create_device(argv[1]);
+    Stream stream = device.create_stream();
+
+    // tiny per-thread work so that the measured time is dominated by the dispatch overhead
+    static constexpr auto block_size = 64u;
+    static constexpr auto max_block_count = 4096u;
+    Buffer<uint> buffer = device.create_buffer<uint>(block_size * max_block_count);
+    Kernel1D tiny_kernel = [&]() noexcept {
+        set_block_size(block_size);
+        auto i = dispatch_x();
+        buffer->write(i, i);
+    };
+    auto shader = device.compile(tiny_kernel);
+
+    static constexpr auto warmup_count = 16u;
+    static constexpr auto dispatch_count = 1024u;
+    for (auto block_count : {1u, 16u, 256u, max_block_count}) {
+        auto thread_count = block_count * block_size;
+        for (auto i = 0u; i < warmup_count; i++) { stream << shader().dispatch(thread_count); }
+        stream << synchronize();
+        Clock clock;
+        for (auto i = 0u; i < dispatch_count; i++) { stream << shader().dispatch(thread_count); }
+        stream << synchronize();
+        auto time = clock.toc();
+        LUISA_INFO("Blocks: {:>5}, Threads: {:>7}, Overhead: {:.2f} us/dispatch",
+                   block_count, thread_count, time * 1e3 / dispatch_count);
+    }
+}
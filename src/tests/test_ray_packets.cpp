@@ -0,0 +1,176 @@
+#include <bit>
+
+#include <luisa/core/clock.h>
+#include <luisa/luisa-compute.h>
+#include <luisa/backends/ext/fallback_config_ext.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+class RayPacketConfig final : public FallbackDeviceConfigExt {
+
+private:
+    bool _ray_packets;
+
+public:
+    explicit RayPacketConfig(bool ray_packets) noexcept : _ray_packets{ray_packets} {}
+    [[nodiscard]] bool ray_packets() const noexcept override { return _ray_packets; }
+};
+
+// per ray: closest hit (inst, prim, t, any hit) and motion blurred closest hit (inst, prim, t, bary.x)
+struct TraceResults {
+    luisa::vector<uint4> closest;
+    luisa::vector<uint4> motion;
+    double milliseconds{0.};
+};
+
+}// namespace
+
+// Compares the fallback backend tracing rays one at a time with tracing them in
+// Embree packets, and measures the throughput of both on coherent primary rays.
+int main(int argc, char *argv[]) {
+
+    log_level_info();
+
+    Context context{argv[0]};
+
+    static constexpr auto width = 256u;
+    static constexpr auto height = 256u;
+    static constexpr auto benchmark_size = 1024u;
+    static constexpr auto benchmark_rounds = 16u;
+
+    // orthographic rays along -z over [-4, 4]^2, with times spread over [0, 1)
+    Callable primary_ray = [](UInt2 p, UInt2 size) noexcept {
+        auto uv = (make_float2(p) + .5f) / make_float2(size) * 2.f - 1.f;
+        return make_ray(make_float3(uv * 4.f, 10.f), make_float3(0.f, 0.f, -1.f));
+    };
+    Callable ray_time = [](UInt2 p) noexcept {
+        return fract(cast<float>(p.y * 7919u + p.x) * 0.6180339887f);
+    };
+    Kernel2D trace_kernel = [&](AccelVar accel, BufferUInt4 closest, BufferUInt4 motion) noexcept {
+        auto p = dispatch_id().xy();
+        auto i = p.y * dispatch_size_x() + p.x;
+        auto ray = primary_ray(p, dispatch_size().xy());
+        auto hit = accel.intersect(ray, {});
+        auto any = accel.intersect_any(ray, {});
+        closest.write(i, make_uint4(hit.inst, hit.prim, as<uint>(hit.committed_ray_t), cast<uint>(any)));
+        auto motion_hit = accel.intersect_motion(ray, ray_time(p), {});
+        motion.write(i, make_uint4(motion_hit.inst, motion_hit.prim,
+                                   as<uint>(motion_hit.committed_ray_t), as<uint>(motion_hit.bary.x)));
+    };
+    Kernel2D benchmark_kernel = [&](AccelVar accel, BufferUInt result) noexcept {
+        auto p = dispatch_id().xy();
+        auto hit = accel.intersect(primary_ray(p, dispatch_size().xy()), {});
+        result.write(p.y * dispatch_size_x() + p.x, hit.inst);
+    };
+
+    auto run = [&](bool ray_packets) noexcept {
+        DeviceConfig config{.extension = luisa::make_unique<RayPacketConfig>(ray_packets)};
+        auto device = context.create_device("fallback", &config);
+        if (device.query("ray_packets") != (ray_packets ? "1" : "0")) {
+            LUISA_WARNING("LUISA_FALLBACK_RAY_PACKETS overrides the device config, "
+                          "so both runs take the same path.");
+        }
+        auto stream = device.create_stream();
+
+        // a 4x4 grid of separate triangles at different depths, and a
+        // triangle in front of them that moves along the x-axis over time
+        std::array vertices{make_float3(-.9f, -.9f, 0.f),
+                            make_float3(.9f, -.9f, 0.f),
+                            make_float3(0.f, .9f, 0.f)};
+        std::array indices{0u, 1u, 2u};
+        auto vertex_buffer = device.create_buffer<float3>(vertices.size());
+        auto triangle_buffer = device.create_buffer<Triangle>(1u);
+        stream << vertex_buffer.copy_from(vertices.data())
+               << triangle_buffer.copy_from(indices.data());
+        auto mesh = device.create_mesh(vertex_buffer, triangle_buffer);
+        AccelMotionOption motion_option;
+        motion_option.mode = AccelMotionMode::MATRIX;
+        motion_option.keyframe_count = 2u;
+        auto motion_instance = device.create_motion_instance(mesh, motion_option);
+        std::array keyframes{translation(-4.f, 0.f, 1.f), translation(4.f, 0.f, 1.f)};
+        motion_instance.set_keyframes(luisa::span<const MotionInstanceTransformMatrix>{keyframes});
+        auto accel = device.create_accel();
+        for (auto y = 0u; y < 4u; y++) {
+            for (auto x = 0u; x < 4u; x++) {
+                accel.emplace_back(mesh, translation(2.f * static_cast<float>(x) - 3.f,
+                                                     2.f * static_cast<float>(y) - 3.f,
+                                                     -.1f * static_cast<float>(x + y)));
+            }
+        }
+        accel.emplace_back(motion_instance);
+        stream << mesh.build()
+               << motion_instance.build()
+               << accel.build();
+
+        TraceResults results;
+        results.closest.resize(width * height);
+        results.motion.resize(width * height);
+        auto closest_buffer = device.create_buffer<uint4>(width * height);
+        auto motion_buffer = device.create_buffer<uint4>(width * height);
+        auto trace = device.compile(trace_kernel);
+        stream << trace(accel, closest_buffer, motion_buffer).dispatch(width, height)
+               << closest_buffer.copy_to(results.closest.data())
+               << motion_buffer.copy_to(results.motion.data())
+               << synchronize();
+
+        auto benchmark_buffer = device.create_buffer<uint>(benchmark_size * benchmark_size);
+        auto benchmark = device.compile(benchmark_kernel);
+        stream << benchmark(accel, benchmark_buffer).dispatch(benchmark_size, benchmark_size)
+               << synchronize();
+        Clock clock;
+        for (auto i = 0u; i < benchmark_rounds; i++) {
+            stream << benchmark(accel, benchmark_buffer).dispatch(benchmark_size, benchmark_size);
+        }
+        stream << synchronize();
+        results.milliseconds = clock.toc();
+        return results;
+    };
+
+    auto scalar = run(false);
+    auto packets = run(true);
+
+    // rays that graze the triangle edges may end up on either side with different
+    // arithmetic, so a few mismatches are tolerated, but no systematic ones
+    auto mismatch_count = [](luisa::span<const uint4> a, luisa::span<const uint4> b, bool compare_w) noexcept {
+        auto close = [](uint x, uint y) noexcept {
+            auto fx = std::bit_cast<float>(x);
+            auto fy = std::bit_cast<float>(y);
+            return std::abs(fx - fy) <= 1e-4f * std::max(1.f, std::abs(fx));
+        };
+        auto count = 0u;
+        for (auto i = 0u; i < a.size(); i++) {
+            auto same = a[i].x == b[i].x && a[i].y == b[i].y &&
+                        (a[i].x == ~0u || close(a[i].z, b[i].z)) &&
+                        (compare_w ? a[i].w == b[i].w : (a[i].x == ~0u || close(a[i].w, b[i].w)));
+            if (!same) { count++; }
+        }
+        return count;
+    };
+    auto max_mismatch_count = width * height / 1000u;
+    auto closest_mismatches = mismatch_count(scalar.closest, packets.closest, true);
+    auto motion_mismatches = mismatch_count(scalar.motion, packets.motion, false);
+    LUISA_INFO("Mismatches between scalar and packet traces: {} closest/any, {} motion blur (of {} rays).",
+               closest_mismatches, motion_mismatches, width * height);
+    LUISA_ASSERT(closest_mismatches <= max_mismatch_count, "Packet traces should match the scalar ones.");
+    LUISA_ASSERT(motion_mismatches <= max_mismatch_count, "Packet motion blur traces should match the scalar ones.");
+
+    // the moving triangle is hit by some rays at some times only, so the results depend on the ray time
+    static constexpr auto motion_inst = 16u;
+    auto static_hits = 0u;
+    auto motion_hits = 0u;
+    for (auto i = 0u; i < width * height; i++) {
+        if (packets.closest[i].x == motion_inst) { static_hits++; }
+        if (packets.motion[i].x == motion_inst) { motion_hits++; }
+    }
+    LUISA_ASSERT(motion_hits > 0u && motion_hits < width * height / 2u,
+                 "The moving triangle should be hit at some times only.");
+    LUISA_ASSERT(motion_hits != static_hits, "Motion blur traces should use the ray time.");
+
+    auto ray_count = static_cast<double>(benchmark_size) * benchmark_size * benchmark_rounds;
+    LUISA_INFO("Scalar traces: {:.2f} ms ({:.2f} Mrays/s).", scalar.milliseconds, ray_count / scalar.milliseconds * 1e-3);
+    LUISA_INFO("Packet traces: {:.2f} ms ({:.2f} Mrays/s).", packets.milliseconds, ray_count / packets.milliseconds * 1e-3);
+    LUISA_INFO("Packet speedup: {:.2f}x.", scalar.milliseconds / packets.milliseconds);
+}
@@ -0,0 +1,127 @@
+#include <bit>
+
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    if (argc <= 1) {
+        LUISA_INFO("Usage: {} <backend>. <backend>: cuda, dx, cpu, metal", argv[0]);
+        exit(1);
+    }
+    Device device = context.create_device(argv[1]);
+    auto stream = device.create_stream();
+
+    // one triangle around the origin in the xy-plane, instanced along the x-axis
+    std::array vertices{make_float3(-1.f, -1.f, 0.f),
+                        make_float3(1.f, -1.f, 0.f),
+                        make_float3(0.f, 1.f, 0.f)};
+    std::array indices{0u, 1u, 2u};
+    std::array aabbs{AABB{.packed_min = {9.f, -1.f, -1.f}, .packed_max = {11.f, 1.f, 1.f}}};
+    auto vertex_buffer = device.create_buffer<float3>(vertices.size());
+    auto triangle_buffer = device.create_buffer<Triangle>(1u);
+    auto aabb_buffer = device.create_buffer<AABB>(aabbs.size());
+    stream << vertex_buffer.copy_from(vertices.data())
+           << triangle_buffer.copy_from(indices.data())
+           << aabb_buffer.copy_from(aabbs.data());
+    auto mesh = device.create_mesh(vertex_buffer, triangle_buffer);
+    auto procedural = device.create_procedural_primitive(aabb_buffer.view());
+
+    // rays go along -z from (5 * i, 0, 10):
+    //   i = 0: an opaque triangle at z = 0, committed without a candidate callback
+    //   i = 1: non-opaque triangles at z = 2 (instance 1) and z = -2 (instance 3)
+    //   i = 2: a procedural box whose top face is at z = 1
+    //   i = 3: nothing
+    //   i = 4: a non-opaque triangle at z = 0 that the callback rejects
+    auto accel = device.create_accel();
+    accel.emplace_back(mesh, translation(0.f, 0.f, 0.f), 0xffu, true);
+    accel.emplace_back(mesh, translation(5.f, 0.f, 2.f), 0xffu, false);
+    accel.emplace_back(procedural);
+    accel.emplace_back(mesh, translation(5.f, 0.f, -2.f), 0xffu, false);
+    accel.emplace_back(mesh, translation(20.f, 0.f, 0.f), 0xffu, false);
+    stream << mesh.build()
+           << procedural.build()
+           << accel.build();
+
+    static constexpr auto ray_count = 5u;
+    static constexpr auto rejected_inst = 4u;
+    static constexpr auto kind_miss = 0u;
+    static constexpr auto kind_triangle = 1u;
+    static constexpr auto kind_procedural = 2u;
+
+    // writes (kind, inst, number of candidates, distance bits) for each ray
+    auto trace = device.compile<1>([&](AccelVar accel, BufferUInt4 result, Bool terminate) noexcept {
+        auto i = dispatch_id().x;
+        auto ray = make_ray(make_float3(cast<float>(i) * 5.f, 0.f, 10.f), make_float3(0.f, 0.f, -1.f));
+        auto candidates = def(0u);
+        auto hit = accel.traverse(ray, {})
+                       .on_surface_candidate([&](SurfaceCandidate &candidate) noexcept {
+                           candidates += 1u;
+                           $if (candidate.hit().inst != rejected_inst) {
+                               candidate.commit();
+                               $if (terminate) { candidate.terminate(); };
+                           };
+                       })
+                       .on_procedural_candidate([&](ProceduralCandidate &candidate) noexcept {
+                           candidates += 1u;
+                           // the ray starts at z = 10 and enters the box at z = 1
+                           candidate.commit(9.f);
+                           $if (terminate) { candidate.terminate(); };
+                       })
+                       .trace();
+        auto kind = def(kind_miss);
+        $if (hit->is_triangle()) {
+            kind = kind_triangle;
+        }
+        $elif (hit->is_procedural()) {
+            kind = kind_procedural;
+        };
+        result.write(i, make_uint4(kind, hit.inst, candidates, as<uint>(hit.committed_ray_t)));
+    });
+
+    auto result_buffer = device.create_buffer<uint4>(ray_count);
+    std::array<uint4, ray_count> closest{};
+    std::array<uint4, ray_count> terminated{};
+    stream << trace(accel, result_buffer, false).dispatch(ray_count)
+           << result_buffer.copy_to(closest.data())
+           << trace(accel, result_buffer, true).dispatch(ray_count)
+           << result_buffer.copy_to(terminated.data())
+           << synchronize();
+
+    auto distance = [](uint4 r) noexcept { return std::bit_cast<float>(r.w); };
+    for (auto &&[name, results] : {std::pair{"closest", &closest}, std::pair{"terminated", &terminated}}) {
+        for (auto i = 0u; i < ray_count; i++) {
+            auto r = (*results)[i];
+            LUISA_INFO("[{}] ray {}: kind = {}, inst = {}, candidates = {}, t = {}.",
+                       name, i, r.x, r.y, r.z, distance(r));
+        }
+    }
+
+    for (auto &&results : {closest, terminated}) {
+        // opaque triangles are committed directly
+        LUISA_ASSERT(results[0].x == kind_triangle && results[0].y == 0u && results[0].z == 0u &&
+                         distance(results[0]) == 10.f,
+                     "Ray 0 should commit the opaque triangle without candidates.");
+        // procedural candidates are committed at the reported distance
+        LUISA_ASSERT(results[2].x == kind_procedural && results[2].y == 2u && results[2].z == 1u &&
+                         distance(results[2]) == 9.f,
+                     "Ray 2 should commit the procedural candidate at t = 9.");
+        LUISA_ASSERT(results[3].x == kind_miss && results[3].z == 0u, "Ray 3 should miss.");
+        // rejected candidates do not become hits
+        LUISA_ASSERT(results[4].x == kind_miss && results[4].z == 1u,
+                     "Ray 4 should report the candidate and miss after rejecting it.");
+    }
+    // without termination the closest of the two committed candidates wins
+    LUISA_ASSERT(closest[1].x == kind_triangle && closest[1].y == 1u && distance(closest[1]) == 8.f &&
+                     closest[1].z >= 1u && closest[1].z <= 2u,
+                 "Ray 1 should commit the closer non-opaque triangle.");
+    // terminate() stops the traversal right after the first committed candidate
+    LUISA_ASSERT(terminated[1].x == kind_triangle && terminated[1].z == 1u &&
+                     ((terminated[1].y == 1u && distance(terminated[1]) == 8.f) ||
+                      (terminated[1].y == 3u && distance(terminated[1]) == 12.f)),
+                 "Ray 1 should stop at the first committed candidate.");
+    LUISA_INFO("Ray query tests passed.");
+}
@@ -0,0 +1,160 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// delivers the messages of a client to its server in-process, recording their sizes
+// and optionally corrupting the tail of the next message on the way
+class LoopbackCallback final : public ClientCallback {
+
+private:
+    ServerInterface *_server;
+
+public:
+    luisa::vector<size_t> sent_sizes;
+    bool corrupt_next{false};
+
+public:
+    explicit LoopbackCallback(ServerInterface *server) noexcept : _server{server} {}
+    void async_send(luisa::vector<std::byte> data) noexcept override {
+        sent_sizes.emplace_back(data.size());
+        if (corrupt_next) {
+            for (auto i = data.size() / 2u; i < data.size(); i++) { data[i] ^= std::byte{0x5au}; }
+            corrupt_next = false;
+        }
+        luisa::vector<std::byte> result;
+        _server->execute(data, result);
+    }
+    void sync_send(luisa::span<const std::byte> send, luisa::vector<std::byte> &received) noexcept override {
+        _server->execute(send, received);
+    }
+};
+
+// collects the downloaded data the server sends back once the commands complete
+class Readbacks {
+
+private:
+    std::mutex _mutex;
+    luisa::vector<luisa::vector<std::byte>> _data;
+    std::atomic<size_t> _count{0u};
+
+public:
+    void receive(luisa::vector<std::byte> msg) noexcept {
+        // stream handle, number of downloads, and the downloaded bytes of each
+        auto ptr = msg.data() + sizeof(uint64_t);
+        size_t count;
+        std::memcpy(&count, ptr, sizeof(size_t));
+        ptr += sizeof(size_t);
+        std::lock_guard lock{_mutex};
+        for (auto i = 0u; i < count; i++) {
+            size_t size;
+            std::memcpy(&size, ptr, sizeof(size_t));
+            ptr += sizeof(size_t);
+            _data.emplace_back(ptr, ptr + size);
+            ptr += size;
+        }
+        _count = _data.size();
+    }
+    [[nodiscard]] luisa::vector<std::byte> wait(size_t index) noexcept {
+        while (_count <= index) { std::this_thread::yield(); }
+        std::lock_guard lock{_mutex};
+        return _data[index];
+    }
+};
+
+}// namespace
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    if (argc <= 1) {
+        LUISA_INFO("Usage: {} <backend>. <backend>: cuda, dx, cpu, metal", argv[0]);
+        exit(1);
+    }
+    Device device = context.create_device(argv[1]);
+
+    Readbacks readbacks;
+    ServerInterface server{device.impl_shared(), [&readbacks](luisa::vector<std::byte> msg) noexcept {
+                               readbacks.receive(std::move(msg));
+                           }};
+    LoopbackCallback callback{&server};
+    ClientInterface client{context, &callback};
+    auto compressed = client.set_compression(RemoteCompression::ZLIB, 16u * 1024u);
+    if (!compressed) { LUISA_WARNING("zlib is not available, messages are sent uncompressed."); }
+
+    static constexpr auto element_count = 256u * 1024u;
+    static constexpr auto size_bytes = element_count * sizeof(uint);
+    auto buffer = client.create_buffer(Type::of<uint>(), element_count, nullptr);
+    auto stream = client.create_stream(StreamTag::COMPUTE);
+    auto upload = [&](luisa::span<const uint> data) noexcept {
+        CommandList list;
+        list << luisa::make_unique<BufferUploadCommand>(buffer.handle, 0u, size_bytes, data.data());
+        client.dispatch(stream.handle, std::move(list));
+    };
+    auto download_index = static_cast<size_t>(0u);
+    luisa::vector<uint> host_readback(element_count);
+    auto download = [&]() noexcept {
+        CommandList list;
+        list << luisa::make_unique<BufferDownloadCommand>(buffer.handle, 0u, size_bytes, host_readback.data());
+        client.dispatch(stream.handle, std::move(list));
+        auto bytes = readbacks.wait(download_index++);
+        LUISA_ASSERT(bytes.size() == size_bytes, "Unexpected size of the downloaded data.");
+        luisa::vector<uint> data(element_count);
+        std::memcpy(data.data(), bytes.data(), size_bytes);
+        return data;
+    };
+
+    // repetitive data are compressed on the client and restored on the server
+    luisa::vector<uint> pattern(element_count);
+    for (auto i = 0u; i < element_count; i++) { pattern[i] = (i / 7u) % 13u; }
+    upload(pattern);
+    if (compressed) {
+        LUISA_ASSERT(callback.sent_sizes.back() < size_bytes / 4u, "The upload should be compressed.");
+    }
+    LUISA_ASSERT(download() == pattern, "Compressed upload round trip mismatch.");
+
+    // a corrupted message is dropped by the server instead of aborting it
+    if (compressed) {
+        luisa::vector<uint> other(element_count, 42u);
+        callback.corrupt_next = true;
+        upload(other);
+        LUISA_ASSERT(download() == pattern, "A corrupted upload should not modify the buffer.");
+    }
+
+    // repeated bindless updates only send the bytes that changed since the last update
+    auto bindless = client.create_bindless_array(16u);
+    auto update_bindless = [&](size_t offset) noexcept {
+        using Modification = BindlessArrayUpdateCommand::Modification;
+        luisa::vector<Modification> mods;
+        for (auto slot = 0u; slot < 8u; slot++) {
+            mods.emplace_back(slot, Modification::Buffer::emplace(buffer.handle, offset + slot * sizeof(uint)),
+                              Modification::Texture{}, Modification::Texture{});
+        }
+        CommandList list;
+        list << luisa::make_unique<BindlessArrayUpdateCommand>(bindless.handle, std::move(mods));
+        client.dispatch(stream.handle, std::move(list));
+        return callback.sent_sizes.back();
+    };
+    auto first_update_size = update_bindless(0u);
+    auto repeated_update_size = update_bindless(0u);
+    auto changed_update_size = update_bindless(sizeof(uint));
+    LUISA_INFO("Bindless update sizes: first = {}, repeated = {}, changed = {}.",
+               first_update_size, repeated_update_size, changed_update_size);
+    LUISA_ASSERT(repeated_update_size < first_update_size, "Repeated updates should be delta-encoded.");
+    LUISA_ASSERT(repeated_update_size < changed_update_size && changed_update_size < first_update_size,
+                 "Changed updates should only send the changed bytes.");
+
+    // the server keeps decoding the commands after the delta-encoded ones
+    LUISA_ASSERT(download() == pattern, "Commands after the bindless updates should still be decoded.");
+
+    client.destroy_bindless_array(bindless.handle);
+    client.destroy_buffer(buffer.handle);
+    client.destroy_stream(stream.handle);
+    LUISA_INFO("Remote compression tests passed.");
+}
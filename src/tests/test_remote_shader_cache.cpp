@@ -0,0 +1,127 @@
+#include <thread>
+
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+namespace {
+
+// delivers the messages of a client to its server in-process; asynchronous messages are
+// held back until flushed, so that the test controls when the server sees them
+class LoopbackCallback final : public ClientCallback {
+
+private:
+    ServerInterface *_server;
+    luisa::vector<luisa::vector<std::byte>> _pending;
+
+public:
+    explicit LoopbackCallback(ServerInterface *server) noexcept : _server{server} {}
+    void async_send(luisa::vector<std::byte> data) noexcept override {
+        _pending.emplace_back(std::move(data));
+    }
+    void sync_send(luisa::span<const std::byte> send, luisa::vector<std::byte> &received) noexcept override {
+        _server->execute(send, received);
+    }
+    [[nodiscard]] auto pending_count() const noexcept { return _pending.size(); }
+    void flush() noexcept {
+        luisa::vector<std::byte> result;
+        for (auto &&message : _pending) {
+            result.clear();
+            _server->execute(message, result);
+        }
+        _pending.clear();
+    }
+};
+
+// a client session connected to its own server interface, with all sessions sharing one shader cache
+struct Session {
+    ServerInterface server;
+    LoopbackCallback callback;
+    ClientInterface client;
+    Session(const Context &context, luisa::shared_ptr<ServerShaderCache> cache) noexcept
+        : server{cache->device(), [](luisa::vector<std::byte>) noexcept {}, cache},
+          callback{&server},
+          client{context, &callback} {}
+    template<typename K>
+    [[nodiscard]] uint64_t create(const K &kernel) noexcept {
+        return client.create_shader(ShaderOption{}, kernel.function()->function()).handle;
+    }
+};
+
+}// namespace
+
+int main(int argc, char *argv[]) {
+
+    Context context{argv[0]};
+    if (argc <= 1) {
+        LUISA_INFO("Usage: {} <backend>. <backend>: cuda, dx, cpu, metal", argv[0]);
+        exit(1);
+    }
+    Device device = context.create_device(argv[1]);
+
+    Kernel1D fill = [](BufferFloat buffer, Float value) noexcept {
+        buffer.write(dispatch_id().x, value);
+    };
+    Kernel1D scale = [](BufferFloat buffer, Float value) noexcept {
+        auto i = dispatch_id().x;
+        buffer.write(i, buffer.read(i) * value);
+    };
+    Kernel1D offset = [](BufferFloat buffer, Float value) noexcept {
+        auto i = dispatch_id().x;
+        buffer.write(i, buffer.read(i) + value);
+    };
+
+    // room for two shaders only, so that the third one exercises the bound
+    auto cache = luisa::make_shared<ServerShaderCache>(device.impl_shared(), 2u);
+    {
+        Session a{context, cache};
+        Session b{context, cache};
+        luisa::vector<std::pair<Session *, uint64_t>> shaders;
+
+        // miss: the first session sends the kernel, which is compiled and cached
+        shaders.emplace_back(&a, a.create(fill));
+        LUISA_ASSERT(a.callback.pending_count() == 1u, "A cache miss should send the kernel.");
+        a.callback.flush();
+        LUISA_ASSERT(cache->size() == 1u, "The compiled shader should be cached.");
+
+        // hit: the second session reuses the shader without sending the kernel
+        shaders.emplace_back(&b, b.create(fill));
+        LUISA_ASSERT(b.callback.pending_count() == 0u, "A cache hit should not send the kernel.");
+        LUISA_ASSERT(cache->size() == 1u, "A cache hit should not add shaders.");
+
+        // race: both sessions miss before either shader is compiled, and the
+        // compiled shaders are inserted concurrently; only one of them is kept
+        shaders.emplace_back(&a, a.create(scale));
+        shaders.emplace_back(&b, b.create(scale));
+        LUISA_ASSERT(a.callback.pending_count() == 1u && b.callback.pending_count() == 1u,
+                     "Both sessions should miss before the shader is compiled.");
+        std::thread flush_a{[&a] { a.callback.flush(); }};
+        std::thread flush_b{[&b] { b.callback.flush(); }};
+        flush_a.join();
+        flush_b.join();
+        LUISA_ASSERT(cache->size() == 2u, "Concurrently compiled copies should be cached once.");
+        {
+            Session c{context, cache};
+            auto handle = c.create(scale);
+            LUISA_ASSERT(c.callback.pending_count() == 0u, "The shader cached by the race should be found.");
+            c.client.destroy_shader(handle);
+            c.callback.flush();
+        }
+
+        // full: shaders beyond the capacity stay private to their sessions
+        shaders.emplace_back(&a, a.create(offset));
+        a.callback.flush();
+        LUISA_ASSERT(cache->size() == 2u, "The cache should not grow beyond its capacity.");
+        shaders.emplace_back(&b, b.create(offset));
+        LUISA_ASSERT(b.callback.pending_count() == 1u, "Uncached shaders should miss in other sessions.");
+        b.callback.flush();
+
+        // destroying the shaders in the sessions only destroys the uncached ones
+        for (auto [session, handle] : shaders) { session->client.destroy_shader(handle); }
+        a.callback.flush();
+        b.callback.flush();
+        LUISA_ASSERT(cache->size() == 2u, "Cached shaders should outlive the sessions using them.");
+    }
+    LUISA_INFO("Remote shader cache tests passed.");
+}
@@ -93,4 +93,47 @@ int main(int argc, char *argv[]) {
     auto mean = std::reduce(values.cbegin(), values.cend(), 0.0) / queue_size;
     LUISA_INFO("count = {} (expected {}), mean = {} (expected ~0.5)",
                n, queue_size, mean);
+    LUISA_ASSERT(n == queue_size, "Every thread should push exactly one value.");
+
+    // each thread reads the values its neighbors wrote to shared memory before the barrier,
+    // with the barrier directly in the kernel, in a callable, and in a callable's callee
+    static constexpr auto block_size = 64u;
+    static constexpr auto block_count = 16u;
+    Callable barrier = [](UInt x) noexcept {
+        sync_block();
+        return x;
+    };
+    Callable nested_barrier = [&](UInt x) noexcept { return barrier(x) + 1u; };
+    auto exchange = device.compile<1>([&](BufferUInt result, Int mode) noexcept {
+        set_block_size(block_size);
+        Shared<uint> values{block_size};
+        auto tid = thread_x();
+        values.write(tid, dispatch_x() * 3u + 1u);
+        auto next = def((tid + 1u) % block_size);
+        $switch (mode) {
+            $case (0) { sync_block(); };
+            $case (1) { next = barrier(next); };
+            $default { next = nested_barrier(next) - 1u; };
+        };
+        auto neighbor = values.read(next);
+        // overwrite the values after a second barrier, so that no thread reads the new ones above
+        sync_block();
+        values.write(tid, 0u);
+        result.write(dispatch_x(), neighbor);
+    });
+    auto exchange_buffer = device.create_buffer<uint>(block_size * block_count);
+    luisa::vector<uint> exchanged(block_size * block_count);
+    for (auto mode = 0; mode < 3; mode++) {
+        stream << exchange(exchange_buffer, mode).dispatch(block_size * block_count)
+               << exchange_buffer.copy_to(exchanged.data())
+               << synchronize();
+        for (auto i = 0u; i < exchanged.size(); i++) {
+            auto block_begin = i / block_size * block_size;
+            auto neighbor = block_begin + (i - block_begin + 1u) % block_size;
+            LUISA_ASSERT(exchanged[i] == neighbor * 3u + 1u,
+                         "Thread {} read {} from shared memory (expected {}) with barrier mode {}.",
+                         i, exchanged[i], neighbor * 3u + 1u, mode);
+        }
+    }
+    LUISA_INFO("Shared memory exchange tests passed.");
 }
@@ -0,0 +1,77 @@
+#include <luisa/core/clock.h>
+#include <luisa/core/logging.h>
+#include <luisa/dsl/syntax.h>
+#include <luisa/dsl/sugar.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// counts the statements and expressions reachable from the function body
+[[nodiscard]] static size_t count_ast_nodes(Function f) noexcept {
+    auto count = static_cast<size_t>(0u);
+    traverse_expressions<true>(
+        f.body(),
+        [&count](auto) noexcept { count++; },
+        [&count](auto) noexcept { count++; },
+        [](auto) noexcept {});
+    return count;
+}
+
+// Measures the throughput of AST construction when tracing a megakernel that dispatches
+// over many material-like callables, similar to polymorphic material evaluation.
+// Run it on builds with different FunctionBuilder allocation strategies to compare.
+int main() {
+
+    log_level_info();
+
+    static constexpr auto material_count = 64u;
+    static constexpr auto warmup_count = 2u;
+    static constexpr auto trace_count = 16u;
+
+    // returns the number of AST nodes traced
+    auto trace = [](bool count_nodes) noexcept {
+        luisa::vector<Callable<float3(float3, float3)>> materials;
+        materials.reserve(material_count);
+        for (auto m = 0u; m < material_count; m++) {
+            materials.emplace_back([m](Float3 wo, Float3 wi) noexcept {
+                auto n = make_float3(0.f, 0.f, 1.f);
+                auto cos_o = max(dot(wo, n), 0.f);
+                auto cos_i = max(dot(wi, n), 0.f);
+                auto h = normalize(wo + wi);
+                auto d = pow(max(dot(h, n), 0.f), static_cast<float>(m + 1u));
+                auto albedo = make_float3(static_cast<float>(m) / static_cast<float>(material_count));
+                return albedo * (cos_o * cos_i + d);
+            });
+        }
+        Kernel1D megakernel = [&](BufferFloat3 out, BufferUInt material_ids) noexcept {
+            auto i = dispatch_id().x;
+            auto wo = normalize(make_float3(cast<float>(i), 1.f, 1.f));
+            auto wi = normalize(make_float3(1.f, cast<float>(i), 1.f));
+            auto result = def(make_float3());
+            $for (bounce, 8u) {
+                auto id = cast<int>(material_ids.read(i * 8u + bounce));
+                $switch (id) {
+                    for (auto m = 0u; m < material_count; m++) {
+                        $case (static_cast<int>(m)) { result += materials[m](wo, wi); };
+                    }
+                    $default { unreachable(); };
+                };
+            };
+            out.write(i, result);
+        };
+        if (!count_nodes) { return static_cast<size_t>(0u); }
+        auto node_count = count_ast_nodes(megakernel.function()->function());
+        for (auto &&m : materials) { node_count += count_ast_nodes(m.function()); }
+        return node_count;
+    };
+
+    // every trace builds the same ASTs, so the nodes are only counted during warmup
+    auto nodes_per_trace = static_cast<size_t>(0u);
+    for (auto i = 0u; i < warmup_count; i++) { nodes_per_trace = trace(true); }
+    Clock clock;
+    for (auto i = 0u; i < trace_count; i++) { static_cast<void>(trace(false)); }
+    auto time = clock.toc();
+    auto node_count = nodes_per_trace * trace_count;
+    LUISA_INFO("Traced {} AST node(s) in {:.2f} ms ({:.2f} ms/trace, {:.2f} M nodes/s).",
+               node_count, time, time / trace_count, node_count / time * 1e-3);
+}
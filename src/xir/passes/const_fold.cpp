@@ -0,0 +1,569 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/optional.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/passes/const_fold.h>
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+// invokes f.template operator()<T>() with the C++ type of the scalar type, or returns false if unsupported
+template<typename F>
+[[nodiscard]] static bool const_fold_visit_scalar_type(const Type *type, F &&f) noexcept {
+    switch (type->tag()) {
+        case Type::Tag::BOOL: return f.template operator()<bool>();
+        case Type::Tag::INT8: return f.template operator()<int8_t>();
+        case Type::Tag::UINT8: return f.template operator()<uint8_t>();
+        case Type::Tag::INT16: return f.template operator()<int16_t>();
+        case Type::Tag::UINT16: return f.template operator()<uint16_t>();
+        case Type::Tag::INT32: return f.template operator()<int32_t>();
+        case Type::Tag::UINT32: return f.template operator()<uint32_t>();
+        case Type::Tag::INT64: return f.template operator()<int64_t>();
+        case Type::Tag::UINT64: return f.template operator()<uint64_t>();
+        case Type::Tag::FLOAT32: return f.template operator()<float>();
+        case Type::Tag::FLOAT64: return f.template operator()<double>();
+        default: break;
+    }
+    return false;
+}
+
+[[nodiscard]] static const Type *const_fold_element_type(const Type *type) noexcept {
+    return type->is_vector() ? type->element() : type;
+}
+
+[[nodiscard]] static size_t const_fold_element_count(const Type *type) noexcept {
+    return type->is_vector() ? type->dimension() : 1u;
+}
+
+[[nodiscard]] static bool const_fold_is_scalar_or_vector(const Value *value) noexcept {
+    auto type = value->type();
+    return type != nullptr && (type->is_scalar() || type->is_vector());
+}
+
+[[nodiscard]] static Constant *const_fold_as_constant(Value *value) noexcept {
+    return value->derived_value_tag() == DerivedValueTag::CONSTANT ? static_cast<Constant *>(value) : nullptr;
+}
+
+[[nodiscard]] static ArithmeticInst *const_fold_as_arithmetic(Value *value, ArithmeticOp op) noexcept {
+    if (value->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+        static_cast<Instruction *>(value)->derived_instruction_tag() == DerivedInstructionTag::ARITHMETIC) {
+        if (auto inst = static_cast<ArithmeticInst *>(value); inst->op() == op) { return inst; }
+    }
+    return nullptr;
+}
+
+template<typename T>
+[[nodiscard]] static T const_fold_read_element(const Constant *c, size_t index) noexcept {
+    T x{};
+    std::memcpy(&x, static_cast<const std::byte *>(c->data()) + index * sizeof(T), sizeof(T));
+    return x;
+}
+
+template<typename T>
+static void const_fold_write_element(luisa::vector<std::byte> &buffer, size_t index, T x) noexcept {
+    std::memcpy(buffer.data() + index * sizeof(T), &x, sizeof(T));
+}
+
+[[nodiscard]] static luisa::optional<size_t> const_fold_index(Value *value) noexcept {
+    auto c = const_fold_as_constant(value);
+    if (c == nullptr) { return luisa::nullopt; }
+    switch (c->type()->tag()) {
+        case Type::Tag::INT8: return static_cast<size_t>(static_cast<int64_t>(c->as<int8_t>()));
+        case Type::Tag::UINT8: return static_cast<size_t>(c->as<uint8_t>());
+        case Type::Tag::INT16: return static_cast<size_t>(static_cast<int64_t>(c->as<int16_t>()));
+        case Type::Tag::UINT16: return static_cast<size_t>(c->as<uint16_t>());
+        case Type::Tag::INT32: return static_cast<size_t>(static_cast<int64_t>(c->as<int32_t>()));
+        case Type::Tag::UINT32: return static_cast<size_t>(c->as<uint32_t>());
+        case Type::Tag::INT64: return static_cast<size_t>(c->as<int64_t>());
+        case Type::Tag::UINT64: return static_cast<size_t>(c->as<uint64_t>());
+        default: break;
+    }
+    return luisa::nullopt;
+}
+
+// checks if the value is a scalar or vector constant with all elements bitwise equal to k
+[[nodiscard]] static bool const_fold_is_splat(Value *value, int k) noexcept {
+    auto c = const_fold_as_constant(value);
+    if (c == nullptr || !const_fold_is_scalar_or_vector(c)) { return false; }
+    auto type = c->type();
+    return const_fold_visit_scalar_type(const_fold_element_type(type), [&]<typename T>() noexcept {
+        auto expected = static_cast<T>(k);
+        for (auto i = 0u; i < const_fold_element_count(type); i++) {
+            auto x = const_fold_read_element<T>(c, i);
+            if (std::memcmp(&x, &expected, sizeof(T)) != 0) { return false; }
+        }
+        return true;
+    });
+}
+
+template<typename T>
+[[nodiscard]] static luisa::optional<T> const_fold_unary(ArithmeticOp op, T x) noexcept {
+    switch (op) {
+        case ArithmeticOp::UNARY_PLUS: return x;
+        case ArithmeticOp::UNARY_MINUS: {
+            if constexpr (std::is_same_v<T, bool>) {
+                return luisa::nullopt;
+            } else if constexpr (std::is_integral_v<T>) {
+                return static_cast<T>(0ull - static_cast<uint64_t>(x));
+            } else {
+                return -x;
+            }
+        }
+        case ArithmeticOp::UNARY_BIT_NOT: {
+            if constexpr (std::is_same_v<T, bool>) {
+                return !x;
+            } else if constexpr (std::is_integral_v<T>) {
+                return static_cast<T>(~x);
+            } else {
+                return luisa::nullopt;
+            }
+        }
+        case ArithmeticOp::ABS: {
+            if constexpr (std::is_same_v<T, bool> || std::is_unsigned_v<T>) {
+                return x;
+            } else if constexpr (std::is_integral_v<T>) {
+                return x < 0 ? static_cast<T>(0ull - static_cast<uint64_t>(x)) : x;
+            } else {
+                return std::abs(x);
+            }
+        }
+        default: break;
+    }
+    return luisa::nullopt;
+}
+
+template<typename T>
+[[nodiscard]] static luisa::optional<T> const_fold_binary(ArithmeticOp op, T a, T b) noexcept {
+    if constexpr (std::is_same_v<T, bool>) {
+        switch (op) {
+            case ArithmeticOp::BINARY_BIT_AND: return a && b;
+            case ArithmeticOp::BINARY_BIT_OR: return a || b;
+            case ArithmeticOp::BINARY_BIT_XOR: return a != b;
+            default: break;
+        }
+    } else if constexpr (std::is_integral_v<T>) {
+        // wrap around on overflow as the backends do
+        auto wrap = [](uint64_t x) noexcept { return static_cast<T>(x); };
+        auto ua = static_cast<uint64_t>(a);
+        auto ub = static_cast<uint64_t>(b);
+        auto division_is_defined = b != 0 && !(std::is_signed_v<T> && a == std::numeric_limits<T>::min() && b == static_cast<T>(-1));
+        auto shift_is_defined = static_cast<uint64_t>(b) < sizeof(T) * 8u;
+        if constexpr (std::is_signed_v<T>) { shift_is_defined = shift_is_defined && b >= 0; }
+        switch (op) {
+            case ArithmeticOp::BINARY_ADD: return wrap(ua + ub);
+            case ArithmeticOp::BINARY_SUB: return wrap(ua - ub);
+            case ArithmeticOp::BINARY_MUL: return wrap(ua * ub);
+            case ArithmeticOp::BINARY_DIV: return division_is_defined ? luisa::make_optional(static_cast<T>(a / b)) : luisa::nullopt;
+            case ArithmeticOp::BINARY_MOD: return division_is_defined ? luisa::make_optional(static_cast<T>(a % b)) : luisa::nullopt;
+            case ArithmeticOp::BINARY_BIT_AND: return static_cast<T>(a & b);
+            case ArithmeticOp::BINARY_BIT_OR: return static_cast<T>(a | b);
+            case ArithmeticOp::BINARY_BIT_XOR: return static_cast<T>(a ^ b);
+            case ArithmeticOp::BINARY_SHIFT_LEFT: return shift_is_defined ? luisa::make_optional(wrap(ua << ub)) : luisa::nullopt;
+            case ArithmeticOp::BINARY_SHIFT_RIGHT: return shift_is_defined ? luisa::make_optional(static_cast<T>(a >> b)) : luisa::nullopt;
+            case ArithmeticOp::MIN: return std::min(a, b);
+            case ArithmeticOp::MAX: return std::max(a, b);
+            default: break;
+        }
+    } else {
+        switch (op) {
+            case ArithmeticOp::BINARY_ADD: return a + b;
+            case ArithmeticOp::BINARY_SUB: return a - b;
+            case ArithmeticOp::BINARY_MUL: return a * b;
+            case ArithmeticOp::BINARY_DIV: return a / b;
+            case ArithmeticOp::MIN: return std::fmin(a, b);
+            case ArithmeticOp::MAX: return std::fmax(a, b);
+            default: break;
+        }
+    }
+    return luisa::nullopt;
+}
+
+template<typename T>
+[[nodiscard]] static luisa::optional<bool> const_fold_compare(ArithmeticOp op, T a, T b) noexcept {
+    switch (op) {
+        case ArithmeticOp::BINARY_LESS: return a < b;
+        case ArithmeticOp::BINARY_GREATER: return a > b;
+        case ArithmeticOp::BINARY_LESS_EQUAL: return a <= b;
+        case ArithmeticOp::BINARY_GREATER_EQUAL: return a >= b;
+        case ArithmeticOp::BINARY_EQUAL: return a == b;
+        case ArithmeticOp::BINARY_NOT_EQUAL: return a != b;
+        default: break;
+    }
+    return luisa::nullopt;
+}
+
+[[nodiscard]] static bool const_fold_is_comparison(ArithmeticOp op) noexcept {
+    switch (op) {
+        case ArithmeticOp::BINARY_LESS: [[fallthrough]];
+        case ArithmeticOp::BINARY_GREATER: [[fallthrough]];
+        case ArithmeticOp::BINARY_LESS_EQUAL: [[fallthrough]];
+        case ArithmeticOp::BINARY_GREATER_EQUAL: [[fallthrough]];
+        case ArithmeticOp::BINARY_EQUAL: [[fallthrough]];
+        case ArithmeticOp::BINARY_NOT_EQUAL: return true;
+        default: break;
+    }
+    return false;
+}
+
+// converts x to To, or returns nullopt if the conversion is undefined
+template<typename To, typename From>
+[[nodiscard]] static luisa::optional<To> const_fold_static_cast(From x) noexcept {
+    if constexpr (std::is_same_v<To, bool>) {
+        return x != From{0};
+    } else if constexpr (std::is_floating_point_v<From> && std::is_integral_v<To>) {
+        // float-to-integer conversions of out-of-range values are poison
+        auto v = static_cast<double>(x);
+        if (!std::isfinite(v) ||
+            std::trunc(v) < static_cast<double>(std::numeric_limits<To>::min()) ||
+            std::trunc(v) >= static_cast<double>(std::numeric_limits<To>::max())) {
+            return luisa::nullopt;
+        }
+        return static_cast<To>(x);
+    } else {
+        return static_cast<To>(x);
+    }
+}
+
+class ConstFoldContext {
+
+private:
+    Module *_module;
+    luisa::vector<std::byte> _buffer;
+
+public:
+    explicit ConstFoldContext(Module *module) noexcept : _module{module} {}
+
+    [[nodiscard]] Constant *zero(const Type *type) noexcept {
+        return _module->create_constant_zero(type);
+    }
+
+private:
+    // evaluates f(i) -> optional<R> for each element and creates a constant of the result type
+    template<typename R, typename F>
+    [[nodiscard]] Constant *_fold_elements(const Type *type, F &&f) noexcept {
+        _buffer.clear();
+        _buffer.resize(type->size());
+        for (auto i = 0u; i < const_fold_element_count(type); i++) {
+            auto r = f(i);
+            if (!r) { return nullptr; }
+            const_fold_write_element<R>(_buffer, i, *r);
+        }
+        return _module->create_constant(type, _buffer.data());
+    }
+
+    [[nodiscard]] Value *_fold_constant_arithmetic(ArithmeticInst *inst) noexcept {
+        auto type = inst->type();
+        auto op = inst->op();
+        if (!const_fold_is_scalar_or_vector(inst)) { return nullptr; }
+        for (auto op_use : inst->operand_uses()) {
+            if (const_fold_as_constant(op_use->value()) == nullptr) { return nullptr; }
+        }
+        Value *result = nullptr;
+        auto elem_type = const_fold_element_type(type);
+        auto elem_count = const_fold_element_count(type);
+        auto operand_matches = [&](size_t i) noexcept {
+            auto t = inst->operand(i)->type();
+            return t->is_scalar() || t->is_vector() ? const_fold_element_count(t) == elem_count : false;
+        };
+        switch (inst->operand_count()) {
+            case 1u: {
+                auto x = static_cast<Constant *>(inst->operand(0u));
+                if (x->type() != type) { return nullptr; }
+                static_cast<void>(const_fold_visit_scalar_type(elem_type, [&]<typename T>() noexcept {
+                    result = _fold_elements<T>(type, [&](size_t i) noexcept {
+                        return const_fold_unary<T>(op, const_fold_read_element<T>(x, i));
+                    });
+                    return true;
+                }));
+                break;
+            }
+            case 2u: {
+                auto a = static_cast<Constant *>(inst->operand(0u));
+                auto b = static_cast<Constant *>(inst->operand(1u));
+                if (a->type() != b->type() || !operand_matches(0u)) { return nullptr; }
+                auto is_comparison = const_fold_is_comparison(op);
+                static_cast<void>(const_fold_visit_scalar_type(const_fold_element_type(a->type()), [&]<typename T>() noexcept {
+                    if (is_comparison) {
+                        if (!elem_type->is_bool()) { return false; }
+                        result = _fold_elements<bool>(type, [&](size_t i) noexcept {
+                            return const_fold_compare<T>(op, const_fold_read_element<T>(a, i), const_fold_read_element<T>(b, i));
+                        });
+                    } else if (a->type() == type) {
+                        result = _fold_elements<T>(type, [&](size_t i) noexcept {
+                            return const_fold_binary<T>(op, const_fold_read_element<T>(a, i), const_fold_read_element<T>(b, i));
+                        });
+                    }
+                    return true;
+                }));
+                break;
+            }
+            case 3u: {
+                if (op != ArithmeticOp::SELECT) { return nullptr; }
+                // note that the order of operands is (false_value, true_value, condition)
+                auto f = static_cast<Constant *>(inst->operand(0u));
+                auto t = static_cast<Constant *>(inst->operand(1u));
+                auto c = static_cast<Constant *>(inst->operand(2u));
+                if (f->type() != type || t->type() != type || !operand_matches(2u) ||
+                    !const_fold_element_type(c->type())->is_bool()) { return nullptr; }
+                static_cast<void>(const_fold_visit_scalar_type(elem_type, [&]<typename T>() noexcept {
+                    result = _fold_elements<T>(type, [&](size_t i) noexcept {
+                        return luisa::make_optional(const_fold_read_element<bool>(c, i) ?
+                                                        const_fold_read_element<T>(t, i) :
+                                                        const_fold_read_element<T>(f, i));
+                    });
+                    return true;
+                }));
+                break;
+            }
+            default: break;
+        }
+        return result;
+    }
+
+    [[nodiscard]] Value *_fold_aggregate(ArithmeticInst *inst) noexcept {
+        auto type = inst->type();
+        if (!type->is_vector() || inst->operand_count() != type->dimension()) { return nullptr; }
+        for (auto op_use : inst->operand_uses()) {
+            if (auto c = const_fold_as_constant(op_use->value()); c == nullptr || c->type() != type->element()) {
+                return nullptr;
+            }
+        }
+        Value *result = nullptr;
+        static_cast<void>(const_fold_visit_scalar_type(type->element(), [&]<typename T>() noexcept {
+            result = _fold_elements<T>(type, [&](size_t i) noexcept {
+                return luisa::make_optional(const_fold_read_element<T>(static_cast<Constant *>(inst->operand(i)), 0u));
+            });
+            return true;
+        }));
+        return result;
+    }
+
+    [[nodiscard]] Value *_fold_extract(ArithmeticInst *inst) noexcept {
+        if (inst->operand_count() != 2u) { return nullptr; }
+        auto base = inst->operand(0u);
+        auto index = const_fold_index(inst->operand(1u));
+        if (!index) { return nullptr; }
+        // extract(aggregate(..., e, ...), i) => e
+        if (auto aggregate = const_fold_as_arithmetic(base, ArithmeticOp::AGGREGATE);
+            aggregate != nullptr && (aggregate->type()->is_vector() || aggregate->type()->is_array()) &&
+            aggregate->operand_count() == aggregate->type()->dimension() && *index < aggregate->operand_count()) {
+            return aggregate->operand(*index);
+        }
+        // extract(insert(v, e, i), i) => e
+        if (auto insert = const_fold_as_arithmetic(base, ArithmeticOp::INSERT);
+            insert != nullptr && insert->operand_count() == 3u) {
+            if (auto insert_index = const_fold_index(insert->operand(2u)); insert_index && *insert_index == *index) {
+                return insert->operand(1u);
+            }
+        }
+        // extract from constant vectors and arrays
+        if (auto c = const_fold_as_constant(base);
+            c != nullptr && (c->type()->is_vector() || c->type()->is_array()) && *index < c->type()->dimension()) {
+            auto elem_type = c->type()->element();
+            auto stride = c->type()->is_vector() ? elem_type->size() : c->type()->size() / c->type()->dimension();
+            return _module->create_constant(elem_type, static_cast<const std::byte *>(c->data()) + *index * stride);
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] Value *_simplify_arithmetic(ArithmeticInst *inst) noexcept {
+        auto type = inst->type();
+        if (!const_fold_is_scalar_or_vector(inst)) { return nullptr; }
+        auto elem_type = const_fold_element_type(type);
+        auto is_integral = elem_type->is_scalar() && !elem_type->is_float16() &&
+                           !elem_type->is_float32() && !elem_type->is_float64();
+        auto same_typed = [&](Value *v) noexcept { return v->type() == type ? v : nullptr; };
+        switch (inst->op()) {
+            case ArithmeticOp::UNARY_PLUS: return same_typed(inst->operand(0u));
+            case ArithmeticOp::UNARY_MINUS: [[fallthrough]];
+            case ArithmeticOp::UNARY_BIT_NOT: {
+                // -(-x) => x, ~(~x) => x
+                if (auto inner = const_fold_as_arithmetic(inst->operand(0u), inst->op())) {
+                    return same_typed(inner->operand(0u));
+                }
+                return nullptr;
+            }
+            default: break;
+        }
+        if (inst->operand_count() != 2u && inst->op() != ArithmeticOp::SELECT) { return nullptr; }
+        auto a = inst->operand(0u);
+        auto b = inst->operand(1u);
+        switch (inst->op()) {
+            case ArithmeticOp::BINARY_ADD: {
+                if (!is_integral) { return nullptr; }
+                if (const_fold_is_splat(b, 0)) { return same_typed(a); }
+                if (const_fold_is_splat(a, 0)) { return same_typed(b); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_SUB: {
+                if (const_fold_is_splat(b, 0)) { return same_typed(a); }
+                if (is_integral && a == b) { return zero(type); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_MUL: {
+                if (const_fold_is_splat(b, 1)) { return same_typed(a); }
+                if (const_fold_is_splat(a, 1)) { return same_typed(b); }
+                if (is_integral && (const_fold_is_splat(a, 0) || const_fold_is_splat(b, 0))) { return zero(type); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_DIV: {
+                if (const_fold_is_splat(b, 1)) { return same_typed(a); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_BIT_AND: {
+                if (!is_integral) { return nullptr; }
+                if (a == b) { return same_typed(a); }
+                if (const_fold_is_splat(a, 0) || const_fold_is_splat(b, 0)) { return zero(type); }
+                if (const_fold_is_splat(b, -1)) { return same_typed(a); }
+                if (const_fold_is_splat(a, -1)) { return same_typed(b); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_BIT_OR: {
+                if (!is_integral) { return nullptr; }
+                if (a == b) { return same_typed(a); }
+                if (const_fold_is_splat(b, 0)) { return same_typed(a); }
+                if (const_fold_is_splat(a, 0)) { return same_typed(b); }
+                if (const_fold_is_splat(b, -1)) { return same_typed(b); }
+                if (const_fold_is_splat(a, -1)) { return same_typed(a); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_BIT_XOR: {
+                if (!is_integral) { return nullptr; }
+                if (a == b) { return zero(type); }
+                if (const_fold_is_splat(b, 0)) { return same_typed(a); }
+                if (const_fold_is_splat(a, 0)) { return same_typed(b); }
+                return nullptr;
+            }
+            case ArithmeticOp::BINARY_SHIFT_LEFT: [[fallthrough]];
+            case ArithmeticOp::BINARY_SHIFT_RIGHT: [[fallthrough]];
+            case ArithmeticOp::BINARY_ROTATE_LEFT: [[fallthrough]];
+            case ArithmeticOp::BINARY_ROTATE_RIGHT: {
+                if (const_fold_is_splat(b, 0)) { return same_typed(a); }
+                return nullptr;
+            }
+            case ArithmeticOp::MIN: [[fallthrough]];
+            case ArithmeticOp::MAX: {
+                if (a == b) { return same_typed(a); }
+                return nullptr;
+            }
+            case ArithmeticOp::SELECT: {
+                // note that the order of operands is (false_value, true_value, condition)
+                if (a == b) { return same_typed(a); }
+                if (auto c = inst->operand(2u); const_fold_is_splat(c, 1)) { return same_typed(b); }
+                if (auto c = inst->operand(2u); const_fold_is_splat(c, 0)) { return same_typed(a); }
+                return nullptr;
+            }
+            default: break;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] Value *_fold_cast(CastInst *inst) noexcept {
+        auto type = inst->type();
+        auto value = inst->value();
+        // casting to the same type is a no-op
+        if (value->type() == type) { return value; }
+        if (inst->op() == CastOp::BITWISE_CAST) {
+            // bitcast(bitcast(x)) => x
+            if (value->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+                static_cast<Instruction *>(value)->derived_instruction_tag() == DerivedInstructionTag::CAST) {
+                if (auto inner = static_cast<CastInst *>(value);
+                    inner->op() == CastOp::BITWISE_CAST && inner->value()->type() == type) {
+                    return inner->value();
+                }
+            }
+            if (auto c = const_fold_as_constant(value);
+                c != nullptr && const_fold_is_scalar_or_vector(c) && const_fold_is_scalar_or_vector(inst) &&
+                c->type()->size() == type->size()) {
+                return _module->create_constant(type, c->data());
+            }
+            return nullptr;
+        }
+        auto c = const_fold_as_constant(value);
+        if (c == nullptr || !const_fold_is_scalar_or_vector(c) || !const_fold_is_scalar_or_vector(inst) ||
+            const_fold_element_count(c->type()) != const_fold_element_count(type)) {
+            return nullptr;
+        }
+        Value *result = nullptr;
+        static_cast<void>(const_fold_visit_scalar_type(const_fold_element_type(c->type()), [&]<typename From>() noexcept {
+            return const_fold_visit_scalar_type(const_fold_element_type(type), [&]<typename To>() noexcept {
+                result = _fold_elements<To>(type, [&](size_t i) noexcept {
+                    return const_fold_static_cast<To, From>(const_fold_read_element<From>(c, i));
+                });
+                return true;
+            });
+        }));
+        return result;
+    }
+
+public:
+    [[nodiscard]] Value *fold(Instruction *inst) noexcept {
+        switch (inst->derived_instruction_tag()) {
+            case DerivedInstructionTag::ARITHMETIC: {
+                auto arith = static_cast<ArithmeticInst *>(inst);
+                switch (arith->op()) {
+                    case ArithmeticOp::AGGREGATE: return _fold_aggregate(arith);
+                    case ArithmeticOp::EXTRACT: return _fold_extract(arith);
+                    default: break;
+                }
+                if (auto folded = _fold_constant_arithmetic(arith)) { return folded; }
+                return _simplify_arithmetic(arith);
+            }
+            case DerivedInstructionTag::CAST: {
+                return _fold_cast(static_cast<CastInst *>(inst));
+            }
+            default: break;
+        }
+        return nullptr;
+    }
+};
+
+static void run_const_fold_on_function(ConstFoldContext &ctx, Function *function, ConstFoldInfo &info) noexcept {
+    auto definition = function->definition();
+    if (definition == nullptr) { return; }
+    luisa::vector<BasicBlock *> blocks;
+    definition->traverse_basic_blocks(BasicBlockTraversalOrder::REVERSE_POST_ORDER, [&](BasicBlock *block) noexcept {
+        blocks.emplace_back(block);
+    });
+    // operands are visited before their users except for loop-carried phis,
+    // so we iterate until no more instructions can be folded
+    for (auto changed = true; changed;) {
+        changed = false;
+        for (auto block : blocks) {
+            for (auto iter = block->instructions().begin(); iter != block->instructions().end();) {
+                auto inst = &*(iter++);
+                if (auto folded = ctx.fold(inst)) {
+                    LUISA_DEBUG_ASSERT(folded != inst && folded->type() == inst->type(), "Invalid folded value.");
+                    inst->replace_all_uses_with(folded);
+                    inst->remove_self();
+                    info.folded_instructions.emplace(inst, folded);
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+}// namespace detail
+
+ConstFoldInfo const_fold_pass_run_on_function(Module *module, Function *function) noexcept {
+    ConstFoldInfo info;
+    detail::ConstFoldContext ctx{module};
+    detail::run_const_fold_on_function(ctx, function, info);
+    return info;
+}
+
+ConstFoldInfo const_fold_pass_run_on_module(Module *module) noexcept {
+    ConstFoldInfo info;
+    detail::ConstFoldContext ctx{module};
+    for (auto &&f : module->functions()) {
+        detail::run_const_fold_on_function(ctx, &f, info);
+    }
+    return info;
+}
+
+}// namespace luisa::compute::xir
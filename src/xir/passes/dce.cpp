@@ -301,7 +301,7 @@ void fix_phi_nodes_in_function(Function *function) noexcept {
                         if (auto incoming_terminator = incoming.block->terminator()) {
                             auto unreachable_from_incoming = true;
                             for (auto op_use : incoming_terminator->operand_uses()) {
-                                if (op_use->value() == incoming.block) {
+                                if (op_use->value() == block) {
                                     unreachable_from_incoming = false;
                                     break;
                                 }
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstring>
+
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/optional.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/special_register.h>
+#include <luisa/xir/passes/dom_tree.h>
+#include <luisa/xir/passes/gvn.h>
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+struct GVNKey {
+    DerivedInstructionTag tag;
+    uint32_t op;
+    const Type *type;
+    luisa::fixed_vector<const Value *, 4u> operands;
+    uint64_t digest;
+
+    [[nodiscard]] auto hash() const noexcept { return digest; }
+    [[nodiscard]] bool operator==(const GVNKey &rhs) const noexcept {
+        return digest == rhs.digest && tag == rhs.tag && op == rhs.op && type == rhs.type &&
+               std::equal(operands.begin(), operands.end(), rhs.operands.begin(), rhs.operands.end());
+    }
+};
+
+[[nodiscard]] static bool gvn_is_commutative(ArithmeticOp op) noexcept {
+    switch (op) {
+        case ArithmeticOp::BINARY_ADD: [[fallthrough]];
+        case ArithmeticOp::BINARY_MUL: [[fallthrough]];
+        case ArithmeticOp::BINARY_BIT_AND: [[fallthrough]];
+        case ArithmeticOp::BINARY_BIT_OR: [[fallthrough]];
+        case ArithmeticOp::BINARY_BIT_XOR: [[fallthrough]];
+        case ArithmeticOp::BINARY_EQUAL: [[fallthrough]];
+        case ArithmeticOp::BINARY_NOT_EQUAL: [[fallthrough]];
+        case ArithmeticOp::MIN: [[fallthrough]];
+        case ArithmeticOp::MAX: [[fallthrough]];
+        case ArithmeticOp::DOT: return true;
+        default: break;
+    }
+    return false;
+}
+
+class GVNContext {
+
+private:
+    luisa::unordered_map<uint64_t, luisa::vector<const Constant *>> _constants;
+    luisa::unordered_map<DerivedSpecialRegisterTag, const SpecialRegister *> _special_registers;
+
+public:
+    // maps equivalent constants and special registers to a single representative
+    [[nodiscard]] const Value *canonicalize(const Value *value) noexcept {
+        switch (value->derived_value_tag()) {
+            case DerivedValueTag::CONSTANT: {
+                auto c = static_cast<const Constant *>(value);
+                auto &&candidates = _constants[c->hash()];
+                for (auto candidate : candidates) {
+                    if (candidate->type() == c->type() &&
+                        std::memcmp(candidate->data(), c->data(), c->type()->size()) == 0) {
+                        return candidate;
+                    }
+                }
+                candidates.emplace_back(c);
+                return c;
+            }
+            case DerivedValueTag::SPECIAL_REGISTER: {
+                auto sreg = static_cast<const SpecialRegister *>(value);
+                return _special_registers.try_emplace(sreg->derived_special_register_tag(), sreg).first->second;
+            }
+            default: break;
+        }
+        return value;
+    }
+
+    [[nodiscard]] luisa::optional<GVNKey> key(Instruction *inst) noexcept {
+        GVNKey key{.tag = inst->derived_instruction_tag(), .op = 0u, .type = inst->type(), .operands = {}, .digest = 0u};
+        auto commutative = false;
+        switch (key.tag) {
+            case DerivedInstructionTag::ARITHMETIC: {
+                auto op = static_cast<ArithmeticInst *>(inst)->op();
+                key.op = static_cast<uint32_t>(op);
+                commutative = gvn_is_commutative(op);
+                break;
+            }
+            case DerivedInstructionTag::CAST: {
+                key.op = static_cast<uint32_t>(static_cast<CastInst *>(inst)->op());
+                break;
+            }
+            case DerivedInstructionTag::GEP: break;
+            default: return luisa::nullopt;// not a pure instruction
+        }
+        for (auto op_use : inst->operand_uses()) {
+            auto op = op_use->value();
+            if (op == nullptr) { return luisa::nullopt; }
+            key.operands.emplace_back(canonicalize(op));
+        }
+        if (commutative && key.operands.size() == 2u && key.operands[1] < key.operands[0]) {
+            std::swap(key.operands[0], key.operands[1]);
+        }
+        key.digest = luisa::hash64(key.operands.data(), key.operands.size() * sizeof(const Value *),
+                                   luisa::hash_combine({static_cast<uint64_t>(key.tag),
+                                                        static_cast<uint64_t>(key.op),
+                                                        reinterpret_cast<uint64_t>(key.type)}));
+        return key;
+    }
+};
+
+static void run_gvn_on_function(GVNContext &ctx, Function *function, GVNInfo &info) noexcept {
+    auto definition = function->definition();
+    if (definition == nullptr) { return; }
+    auto dom_tree = compute_dom_tree(function);
+    // available expressions in the current dominator tree scope
+    luisa::unordered_map<GVNKey, Instruction *> available;
+    struct Frame {
+        const DomTreeNode *node;
+        size_t log_size;
+        bool visited;
+    };
+    luisa::vector<GVNKey> inserted_keys;
+    luisa::vector<Frame> stack;
+    stack.emplace_back(Frame{dom_tree.root(), 0u, false});
+    while (!stack.empty()) {
+        if (auto &frame = stack.back(); frame.visited) {
+            // expressions defined in the subtree are no longer available
+            while (inserted_keys.size() > frame.log_size) {
+                available.erase(inserted_keys.back());
+                inserted_keys.pop_back();
+            }
+            stack.pop_back();
+            continue;
+        }
+        auto node = stack.back().node;
+        stack.back().log_size = inserted_keys.size();
+        stack.back().visited = true;
+        auto block = node->block();
+        for (auto iter = block->instructions().begin(); iter != block->instructions().end();) {
+            auto inst = &*(iter++);
+            if (auto key = ctx.key(inst)) {
+                if (auto existing = available.find(*key); existing != available.end()) {
+                    inst->replace_all_uses_with(existing->second);
+                    inst->remove_self();
+                    info.eliminated_instructions.emplace(inst, existing->second);
+                } else {
+                    available.emplace(*key, inst);
+                    inserted_keys.emplace_back(std::move(*key));
+                }
+            }
+        }
+        for (auto child : node->children()) {
+            stack.emplace_back(Frame{child, 0u, false});
+        }
+    }
+}
+
+}// namespace detail
+
+GVNInfo gvn_pass_run_on_function(Function *function) noexcept {
+    GVNInfo info;
+    detail::GVNContext ctx;
+    detail::run_gvn_on_function(ctx, function, info);
+    return info;
+}
+
+GVNInfo gvn_pass_run_on_module(Module *module) noexcept {
+    GVNInfo info;
+    detail::GVNContext ctx;
+    for (auto &&f : module->functions()) {
+        detail::run_gvn_on_function(ctx, &f, info);
+    }
+    return info;
+}
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,404 @@
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/optional.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/passes/inline.h>
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+// instructions that are (almost) free after lowering do not count towards the cost
+[[nodiscard]] static luisa::optional<size_t> inline_callee_cost(FunctionDefinition *callee) noexcept {
+    auto cost = static_cast<size_t>(0u);
+    auto inlinable = true;
+    callee->traverse_instructions([&](Instruction *inst) noexcept {
+        switch (inst->derived_instruction_tag()) {
+            case DerivedInstructionTag::PHI: [[fallthrough]];
+            case DerivedInstructionTag::BRANCH: [[fallthrough]];
+            case DerivedInstructionTag::ALLOCA: [[fallthrough]];
+            case DerivedInstructionTag::OUTLINE: break;
+            case DerivedInstructionTag::AUTO_DIFF: inlinable = false; break;
+            default: cost++; break;
+        }
+    });
+    if (!inlinable) { return luisa::nullopt; }
+    return cost;
+}
+
+[[nodiscard]] static bool inline_synchronizes_block(FunctionDefinition *callee) noexcept {
+    auto synchronizes = false;
+    callee->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::THREAD_GROUP) {
+            synchronizes |= static_cast<ThreadGroupInst *>(inst)->op() == ThreadGroupOp::SYNCHRONIZE_BLOCK;
+        }
+    });
+    return synchronizes;
+}
+
+// collects all blocks of the function, including the merge blocks that are not reachable
+static void inline_collect_blocks(FunctionDefinition *f, luisa::vector<BasicBlock *> &blocks) noexcept {
+    luisa::unordered_set<BasicBlock *> visited;
+    luisa::vector<BasicBlock *> stack{f->body_block()};
+    visited.emplace(f->body_block());
+    auto visit = [&](BasicBlock *block) noexcept {
+        if (block != nullptr && visited.emplace(block).second) { stack.emplace_back(block); }
+    };
+    while (!stack.empty()) {
+        auto block = stack.back();
+        stack.pop_back();
+        blocks.emplace_back(block);
+        auto terminator = block->terminator();
+        block->traverse_successors(false, visit);
+        if (auto merge = terminator->control_flow_merge()) { visit(merge->merge_block()); }
+        if (terminator->derived_instruction_tag() == DerivedInstructionTag::LOOP) {
+            auto loop = static_cast<LoopInst *>(terminator);
+            visit(loop->body_block());
+            visit(loop->update_block());
+        }
+    }
+}
+
+// creates an unlinked copy of the instruction that still refers to the original operands
+[[nodiscard]] static Instruction *inline_clone_instruction(Instruction *inst) noexcept {
+    auto pool = Pool::current();
+    auto type = inst->type();
+    auto cloned = [&]() noexcept -> Instruction * {
+        switch (inst->derived_instruction_tag()) {
+            case DerivedInstructionTag::IF: return pool->create<IfInst>();
+            case DerivedInstructionTag::SWITCH: {
+                auto switch_inst = static_cast<SwitchInst *>(inst);
+                auto clone = pool->create<SwitchInst>();
+                clone->set_case_count(switch_inst->case_count());
+                for (auto i = 0u; i < switch_inst->case_count(); i++) {
+                    clone->set_case_value(i, switch_inst->case_value(i));
+                }
+                return clone;
+            }
+            case DerivedInstructionTag::LOOP: {
+                auto loop_inst = static_cast<LoopInst *>(inst);
+                auto clone = pool->create<LoopInst>();
+                clone->set_body_block(loop_inst->body_block());
+                clone->set_update_block(loop_inst->update_block());
+                return clone;
+            }
+            case DerivedInstructionTag::SIMPLE_LOOP: return pool->create<SimpleLoopInst>();
+            case DerivedInstructionTag::BRANCH: return pool->create<BranchInst>();
+            case DerivedInstructionTag::CONDITIONAL_BRANCH: return pool->create<ConditionalBranchInst>();
+            case DerivedInstructionTag::UNREACHABLE: {
+                auto message = static_cast<UnreachableInst *>(inst)->message();
+                return pool->create<UnreachableInst>(luisa::string{message});
+            }
+            case DerivedInstructionTag::BREAK: return pool->create<BreakInst>();
+            case DerivedInstructionTag::CONTINUE: return pool->create<ContinueInst>();
+            case DerivedInstructionTag::RETURN: return pool->create<ReturnInst>();
+            case DerivedInstructionTag::RASTER_DISCARD: return pool->create<RasterDiscardInst>();
+            case DerivedInstructionTag::PHI: {
+                auto phi_inst = static_cast<PhiInst *>(inst);
+                auto clone = pool->create<PhiInst>(type);
+                clone->set_incoming_count(phi_inst->incoming_count());
+                for (auto i = 0u; i < phi_inst->incoming_count(); i++) {
+                    auto incoming = phi_inst->incoming(i);
+                    clone->set_incoming(i, incoming.value, incoming.block);
+                }
+                return clone;
+            }
+            case DerivedInstructionTag::ALLOCA: {
+                auto space = static_cast<AllocaInst *>(inst)->space();
+                return pool->create<AllocaInst>(type, space);
+            }
+            case DerivedInstructionTag::LOAD: return pool->create<LoadInst>(type);
+            case DerivedInstructionTag::STORE: return pool->create<StoreInst>();
+            case DerivedInstructionTag::GEP: return pool->create<GEPInst>(type);
+            case DerivedInstructionTag::ATOMIC: {
+                auto atomic_inst = static_cast<AtomicInst *>(inst);
+                luisa::fixed_vector<Value *, 8u> indices;
+                luisa::fixed_vector<Value *, 2u> values;
+                for (auto use : atomic_inst->index_uses()) { indices.emplace_back(use->value()); }
+                for (auto use : atomic_inst->value_uses()) { values.emplace_back(use->value()); }
+                return pool->create<AtomicInst>(type, atomic_inst->op(), atomic_inst->base(), indices, values);
+            }
+            case DerivedInstructionTag::ARITHMETIC: return pool->create<ArithmeticInst>(type, static_cast<ArithmeticInst *>(inst)->op());
+            case DerivedInstructionTag::THREAD_GROUP: return pool->create<ThreadGroupInst>(type, static_cast<ThreadGroupInst *>(inst)->op());
+            case DerivedInstructionTag::RESOURCE_QUERY: return pool->create<ResourceQueryInst>(type, static_cast<ResourceQueryInst *>(inst)->op());
+            case DerivedInstructionTag::RESOURCE_READ: return pool->create<ResourceReadInst>(type, static_cast<ResourceReadInst *>(inst)->op());
+            case DerivedInstructionTag::RESOURCE_WRITE: return pool->create<ResourceWriteInst>(static_cast<ResourceWriteInst *>(inst)->op());
+            case DerivedInstructionTag::RAY_QUERY_LOOP: return pool->create<RayQueryLoopInst>();
+            case DerivedInstructionTag::RAY_QUERY_DISPATCH: return pool->create<RayQueryDispatchInst>();
+            case DerivedInstructionTag::RAY_QUERY_OBJECT_READ: return pool->create<RayQueryObjectReadInst>(type, static_cast<RayQueryObjectReadInst *>(inst)->op());
+            case DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: return pool->create<RayQueryObjectWriteInst>(static_cast<RayQueryObjectWriteInst *>(inst)->op());
+            case DerivedInstructionTag::CALL: return pool->create<CallInst>(type);
+            case DerivedInstructionTag::CAST: return pool->create<CastInst>(type, static_cast<CastInst *>(inst)->op());
+            case DerivedInstructionTag::PRINT: return pool->create<PrintInst>(luisa::string{static_cast<PrintInst *>(inst)->format()});
+            case DerivedInstructionTag::CLOCK: return pool->create<ClockInst>();
+            case DerivedInstructionTag::ASSERT: return pool->create<AssertInst>(nullptr, luisa::string{static_cast<AssertInst *>(inst)->message()});
+            case DerivedInstructionTag::ASSUME: return pool->create<AssumeInst>(nullptr, luisa::string{static_cast<AssumeInst *>(inst)->message()});
+            case DerivedInstructionTag::OUTLINE: return pool->create<OutlineInst>();
+            case DerivedInstructionTag::INTRINSIC: return pool->create<IntrinsicInst>(type, static_cast<IntrinsicInst *>(inst)->op());
+            default: break;
+        }
+        LUISA_ERROR_WITH_LOCATION("Cannot inline instruction '{}'.", to_string(inst->derived_instruction_tag()));
+    }();
+    // phi and atomic instructions carry extra state along with their operands
+    if (auto tag = inst->derived_instruction_tag();
+        tag != DerivedInstructionTag::PHI && tag != DerivedInstructionTag::ATOMIC) {
+        luisa::fixed_vector<Value *, 16u> operands;
+        for (auto use : inst->operand_uses()) { operands.emplace_back(use->value()); }
+        cloned->set_operands(operands);
+    }
+    if (auto merge = inst->control_flow_merge()) {
+        cloned->control_flow_merge()->set_merge_block(merge->merge_block());
+    }
+    return cloned;
+}
+
+struct InlinedBody {
+    BasicBlock *entry;
+    luisa::vector<ReturnInst *> returns;
+    luisa::vector<AllocaInst *> allocas;
+};
+
+// clones the callee body with the arguments replaced by the given values
+[[nodiscard]] static InlinedBody inline_clone_body(FunctionDefinition *callee, luisa::span<Value *const> args) noexcept {
+    luisa::unordered_map<Value *, Value *> value_map;
+    for (auto i = 0u; i < args.size(); i++) {
+        value_map.emplace(callee->arguments()[i], args[i]);
+    }
+    auto remap = [&value_map]<typename T>(T *value) noexcept -> T * {
+        if (value == nullptr) { return nullptr; }
+        auto iter = value_map.find(value);
+        return iter == value_map.end() ? value : static_cast<T *>(iter->second);
+    };
+    luisa::vector<BasicBlock *> blocks;
+    inline_collect_blocks(callee, blocks);
+    for (auto block : blocks) {
+        value_map.emplace(block, Pool::current()->create<BasicBlock>());
+    }
+    luisa::vector<std::pair<BasicBlock *, Instruction *>> clones;
+    for (auto block : blocks) {
+        for (auto &&inst : block->instructions()) {
+            auto clone = inline_clone_instruction(&inst);
+            value_map.emplace(&inst, clone);
+            clones.emplace_back(remap(block), clone);
+        }
+    }
+    // now that all values are cloned, redirect the operands to the copies
+    InlinedBody body{.entry = remap(callee->body_block()), .returns = {}, .allocas = {}};
+    for (auto [block, clone] : clones) {
+        for (auto i = 0u; i < clone->operand_count(); i++) {
+            clone->set_operand(i, remap(clone->operand(i)));
+        }
+        switch (clone->derived_instruction_tag()) {
+            case DerivedInstructionTag::PHI: {
+                auto phi = static_cast<PhiInst *>(clone);
+                for (auto i = 0u; i < phi->incoming_count(); i++) {
+                    auto incoming = phi->incoming(i);
+                    phi->set_incoming(i, incoming.value, remap(incoming.block));
+                }
+                break;
+            }
+            case DerivedInstructionTag::LOOP: {
+                auto loop = static_cast<LoopInst *>(clone);
+                loop->set_body_block(remap(loop->body_block()));
+                loop->set_update_block(remap(loop->update_block()));
+                break;
+            }
+            case DerivedInstructionTag::RETURN: body.returns.emplace_back(static_cast<ReturnInst *>(clone)); break;
+            case DerivedInstructionTag::ALLOCA: body.allocas.emplace_back(static_cast<AllocaInst *>(clone)); break;
+            default: break;
+        }
+        if (auto merge = clone->control_flow_merge()) {
+            merge->set_merge_block(remap(merge->merge_block()));
+        }
+        block->instructions().tail_sentinel()->insert_before_self(clone);
+    }
+    return body;
+}
+
+static void inline_call(FunctionDefinition *caller, CallInst *call, FunctionDefinition *callee) noexcept {
+    luisa::fixed_vector<Value *, 16u> args;
+    for (auto use : call->argument_uses()) { args.emplace_back(use->value()); }
+    auto body = inline_clone_body(callee, args);
+    // split the block after the call, and fix the phi nodes in the successors
+    auto block = call->parent_block();
+    auto merge = Pool::current()->create<BasicBlock>();
+    while (call->next() != block->instructions().tail_sentinel()) {
+        auto inst = call->next();
+        inst->remove_self();
+        merge->instructions().tail_sentinel()->insert_before_self(inst);
+    }
+    merge->traverse_successors(false, [&](BasicBlock *succ) noexcept {
+        for (auto &&inst : succ->instructions()) {
+            if (inst.derived_instruction_tag() != DerivedInstructionTag::PHI) { break; }
+            auto phi = static_cast<PhiInst *>(&inst);
+            for (auto i = 0u; i < phi->incoming_count(); i++) {
+                if (auto incoming = phi->incoming(i); incoming.block == block) {
+                    phi->set_incoming(i, incoming.value, merge);
+                }
+            }
+        }
+    });
+    // local variables of the callee are declared at the beginning of the caller
+    Builder b;
+    auto caller_entry = caller->body_block()->instructions().head_sentinel();
+    for (auto alloca : body.allocas) {
+        alloca->remove_self();
+        caller_entry->insert_after_self(alloca);
+    }
+    AllocaInst *return_variable = nullptr;
+    if (call->type() != nullptr) {
+        b.set_insertion_point(caller_entry);
+        return_variable = b.alloca_local(call->type());
+        return_variable->add_comment("Inlined return value");
+    }
+    for (auto ret : body.returns) {
+        b.set_insertion_point(ret->prev());
+        if (auto value = ret->return_value()) {
+            LUISA_DEBUG_ASSERT(return_variable != nullptr, "Unexpected return value.");
+            b.store(return_variable, value);
+        }
+        b.br(merge);
+        ret->remove_self();
+    }
+    // replace the call with the inlined body
+    b.set_insertion_point(call);
+    auto outline = b.outline();
+    outline->set_target_block(body.entry);
+    outline->set_merge_block(merge);
+    if (return_variable != nullptr) {
+        b.set_insertion_point(merge->instructions().head_sentinel());
+        call->replace_all_uses_with(b.load(call->type(), return_variable));
+    }
+    call->remove_self();
+}
+
+[[nodiscard]] static FunctionDefinition *inline_callee_definition(CallInst *call) noexcept {
+    if (auto callee = call->callee();
+        callee != nullptr && callee->derived_value_tag() == DerivedValueTag::FUNCTION) {
+        if (auto f = static_cast<Function *>(callee);
+            f->derived_function_tag() == DerivedFunctionTag::CALLABLE) {
+            return f->definition();
+        }
+    }
+    return nullptr;
+}
+
+class InlineContext {
+
+private:
+    size_t _max_callee_cost;
+    luisa::unordered_map<FunctionDefinition *, bool> _should_inline;
+
+public:
+    explicit InlineContext(size_t max_callee_cost) noexcept : _max_callee_cost{max_callee_cost} {}
+
+    // note: the decision is cached, so callees must not change after they are first queried
+    [[nodiscard]] bool should_inline(FunctionDefinition *callee) noexcept {
+        auto [iter, first] = _should_inline.try_emplace(callee, false);
+        if (first) {
+            if (auto cost = inline_callee_cost(callee); !cost.has_value()) {
+                iter->second = false;
+            } else if (inline_synchronizes_block(callee)) {
+                // barriers must end up in the kernel body on backends that implement them
+                // by suspending the kernel, so such callables are inlined regardless of cost
+                iter->second = true;
+            } else {
+                iter->second = !static_cast<CallableFunction *>(callee)->is_noinline() &&
+                               *cost <= _max_callee_cost;
+            }
+        }
+        return iter->second;
+    }
+};
+
+static void run_inline_on_function(InlineContext &ctx, Function *function, InlineInfo &info) noexcept {
+    auto definition = function->definition();
+    if (definition == nullptr) { return; }
+    luisa::vector<CallInst *> calls;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::CALL) {
+            calls.emplace_back(static_cast<CallInst *>(inst));
+        }
+    });
+    for (auto call : calls) {
+        if (auto callee = inline_callee_definition(call);
+            callee != nullptr && callee != definition && ctx.should_inline(callee)) {
+            inline_call(definition, call, callee);
+            info.inlined_calls.emplace(call, callee);
+        }
+    }
+}
+
+// visits the callees before the callers
+static void inline_collect_functions_post_order(Function *function,
+                                                luisa::unordered_set<Function *> &visited,
+                                                luisa::vector<Function *> &order) noexcept {
+    if (!visited.emplace(function).second) { return; }
+    if (auto definition = function->definition()) {
+        definition->traverse_instructions([&](Instruction *inst) noexcept {
+            if (inst->derived_instruction_tag() == DerivedInstructionTag::CALL) {
+                if (auto callee = inline_callee_definition(static_cast<CallInst *>(inst))) {
+                    inline_collect_functions_post_order(callee, visited, order);
+                }
+            }
+        });
+    }
+    order.emplace_back(function);
+}
+
+static void inline_remove_function(Function *function) noexcept {
+    if (auto definition = function->definition()) {
+        // drop the uses of the instructions so that the callees become unreferenced as well
+        luisa::vector<BasicBlock *> blocks;
+        inline_collect_blocks(definition, blocks);
+        for (auto block : blocks) {
+            while (!block->instructions().empty()) {
+                block->instructions().front().remove_self();
+            }
+        }
+    }
+    function->remove_self();
+}
+
+}// namespace detail
+
+InlineInfo inline_pass_run_on_function(Function *function, size_t max_callee_cost) noexcept {
+    InlineInfo info;
+    detail::InlineContext ctx{max_callee_cost};
+    detail::run_inline_on_function(ctx, function, info);
+    return info;
+}
+
+InlineInfo inline_pass_run_on_module(Module *module, size_t max_callee_cost) noexcept {
+    InlineInfo info;
+    detail::InlineContext ctx{max_callee_cost};
+    luisa::unordered_set<Function *> visited;
+    luisa::vector<Function *> order;
+    luisa::unordered_set<Function *> called;
+    for (auto &&f : module->functions()) {
+        detail::inline_collect_functions_post_order(&f, visited, order);
+        if (!f.use_list().empty()) { called.emplace(&f); }
+    }
+    for (auto f : order) {
+        detail::run_inline_on_function(ctx, f, info);
+    }
+    // remove the callables that are no longer called
+    for (auto changed = true; changed;) {
+        changed = false;
+        luisa::vector<Function *> unused;
+        for (auto &&f : module->functions()) {
+            if (f.derived_function_tag() == DerivedFunctionTag::CALLABLE &&
+                called.contains(&f) && f.use_list().empty()) {
+                unused.emplace_back(&f);
+            }
+        }
+        for (auto f : unused) {
+            detail::inline_remove_function(f);
+            called.erase(f);
+            info.removed_functions.emplace(f);
+            changed = true;
+        }
+    }
+    return info;
+}
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,266 @@
+#include <algorithm>
+
+#include <luisa/core/logging.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/passes/dom_tree.h>
+#include <luisa/xir/passes/loop_info.h>
+#include <luisa/xir/passes/licm.h>
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+enum struct LICMHoistKind {
+    NONE,       // not hoistable
+    SPECULATIVE,// pure and safe to execute even if the loop would not have executed it
+    GUARANTEED, // pure, but only hoistable if executed whenever the loop is entered
+    RESOURCE,   // reads resources: GUARANTEED, and the loop must not write resources
+    LOCAL,      // reads a variable: GUARANTEED, and the loop must not write the variable
+};
+
+struct LICMLoopEffects {
+    bool writes_all{false};       // calls and instructions with unknown effects
+    bool writes_resources{false}; // resource writes and atomics on resources
+    bool writes_references{false};// stores and atomics through reference arguments
+    luisa::unordered_set<const Value *> written_variables;
+};
+
+// the variable that a pointer is derived from, i.e., an alloca or an argument
+[[nodiscard]] static Value *licm_trace_pointer_root(Value *pointer) noexcept {
+    while (pointer != nullptr &&
+           pointer->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+           static_cast<Instruction *>(pointer)->derived_instruction_tag() == DerivedInstructionTag::GEP) {
+        pointer = static_cast<GEPInst *>(pointer)->base();
+    }
+    return pointer;
+}
+
+static void licm_record_write(LICMLoopEffects &effects, Value *pointer) noexcept {
+    auto root = licm_trace_pointer_root(pointer);
+    if (root == nullptr) {
+        effects.writes_all = true;
+    } else if (root->type() != nullptr && root->type()->is_resource()) {
+        effects.writes_resources = true;
+    } else if (root->derived_value_tag() == DerivedValueTag::ARGUMENT) {
+        effects.writes_references = true;
+    } else if (root->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+               static_cast<Instruction *>(root)->derived_instruction_tag() == DerivedInstructionTag::ALLOCA) {
+        effects.written_variables.emplace(root);
+    } else {
+        effects.writes_all = true;
+    }
+}
+
+[[nodiscard]] static LICMLoopEffects licm_collect_loop_effects(const Loop *loop) noexcept {
+    LICMLoopEffects effects;
+    for (auto block : loop->blocks()) {
+        for (auto &&inst : block->instructions()) {
+            if (inst.is_terminator()) { continue; }
+            switch (inst.derived_instruction_tag()) {
+                case DerivedInstructionTag::STORE: licm_record_write(effects, static_cast<StoreInst *>(&inst)->variable()); break;
+                case DerivedInstructionTag::ATOMIC: licm_record_write(effects, static_cast<AtomicInst *>(&inst)->base()); break;
+                case DerivedInstructionTag::RESOURCE_WRITE: effects.writes_resources = true; break;
+                case DerivedInstructionTag::PHI: [[fallthrough]];
+                case DerivedInstructionTag::ALLOCA: [[fallthrough]];
+                case DerivedInstructionTag::LOAD: [[fallthrough]];
+                case DerivedInstructionTag::GEP: [[fallthrough]];
+                case DerivedInstructionTag::ARITHMETIC: [[fallthrough]];
+                case DerivedInstructionTag::CAST: [[fallthrough]];
+                case DerivedInstructionTag::THREAD_GROUP: [[fallthrough]];// barriers only order shared memory, which is never loaded from in hoisted code
+                case DerivedInstructionTag::RESOURCE_QUERY: [[fallthrough]];
+                case DerivedInstructionTag::RESOURCE_READ: [[fallthrough]];
+                case DerivedInstructionTag::RAY_QUERY_OBJECT_READ: [[fallthrough]];
+                case DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: [[fallthrough]];
+                case DerivedInstructionTag::PRINT: [[fallthrough]];
+                case DerivedInstructionTag::CLOCK: [[fallthrough]];
+                case DerivedInstructionTag::ASSERT: [[fallthrough]];
+                case DerivedInstructionTag::ASSUME: break;
+                default: effects.writes_all = true; break;
+            }
+        }
+    }
+    return effects;
+}
+
+[[nodiscard]] static bool licm_may_be_written(const LICMLoopEffects &effects, Value *pointer) noexcept {
+    if (effects.writes_all) { return true; }
+    auto root = licm_trace_pointer_root(pointer);
+    if (root == nullptr) { return true; }
+    if (root->derived_value_tag() == DerivedValueTag::ARGUMENT) { return effects.writes_references; }
+    if (root->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+        static_cast<Instruction *>(root)->derived_instruction_tag() == DerivedInstructionTag::ALLOCA) {
+        // shared memory may be written by other threads in the block
+        return static_cast<AllocaInst *>(root)->space() != AllocSpace::LOCAL ||
+               effects.written_variables.contains(root);
+    }
+    return true;
+}
+
+// integer division traps on zero divisors (and on -1 for signed types, due to overflow)
+[[nodiscard]] static bool licm_is_safe_integer_divisor(const Value *divisor) noexcept {
+    if (divisor == nullptr || divisor->derived_value_tag() != DerivedValueTag::CONSTANT) { return false; }
+    auto c = static_cast<const Constant *>(divisor);
+    auto type = c->type();
+    auto elem = type->is_vector() ? type->element() : type;
+    if (!elem->is_scalar()) { return false; }
+    auto is_signed = elem->is_int8() || elem->is_int16() || elem->is_int32() || elem->is_int64();
+    auto dim = type->is_vector() ? type->dimension() : 1u;
+    auto data = static_cast<const std::byte *>(c->data());
+    for (auto i = 0u; i < dim; i++) {
+        auto begin = data + i * elem->size();
+        auto end = begin + elem->size();
+        if (std::all_of(begin, end, [](std::byte b) noexcept { return b == std::byte{0x00u}; }) ||
+            (is_signed && std::all_of(begin, end, [](std::byte b) noexcept { return b == std::byte{0xffu}; }))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+[[nodiscard]] static LICMHoistKind licm_hoist_kind(Instruction *inst) noexcept {
+    switch (inst->derived_instruction_tag()) {
+        case DerivedInstructionTag::ARITHMETIC: {
+            auto arith = static_cast<ArithmeticInst *>(inst);
+            if (arith->op() == ArithmeticOp::BINARY_DIV || arith->op() == ArithmeticOp::BINARY_MOD) {
+                auto elem = arith->type()->is_vector() ? arith->type()->element() : arith->type();
+                auto is_float = elem->is_float16() || elem->is_float32() || elem->is_float64();
+                if (!is_float && !licm_is_safe_integer_divisor(arith->operand(1))) {
+                    return LICMHoistKind::GUARANTEED;
+                }
+            }
+            return LICMHoistKind::SPECULATIVE;
+        }
+        case DerivedInstructionTag::CAST: [[fallthrough]];
+        case DerivedInstructionTag::GEP: return LICMHoistKind::SPECULATIVE;
+        case DerivedInstructionTag::RESOURCE_QUERY: {
+            switch (static_cast<ResourceQueryInst *>(inst)->op()) {
+                // these only read the argument descriptors
+                case ResourceQueryOp::BUFFER_SIZE: [[fallthrough]];
+                case ResourceQueryOp::BYTE_BUFFER_SIZE: [[fallthrough]];
+                case ResourceQueryOp::TEXTURE2D_SIZE: [[fallthrough]];
+                case ResourceQueryOp::TEXTURE3D_SIZE: [[fallthrough]];
+                case ResourceQueryOp::BUFFER_DEVICE_ADDRESS: return LICMHoistKind::SPECULATIVE;
+                // ray tracing queries are expensive, may suspend the kernel, or depend on instance writes
+                case ResourceQueryOp::RAY_TRACING_INSTANCE_TRANSFORM: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_INSTANCE_USER_ID: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_INSTANCE_VISIBILITY_MASK: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_ANY: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_QUERY_ALL: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_QUERY_ANY: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_INSTANCE_MOTION_MATRIX: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_INSTANCE_MOTION_SRT: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST_MOTION_BLUR: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_ANY_MOTION_BLUR: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_QUERY_ALL_MOTION_BLUR: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_QUERY_ANY_MOTION_BLUR: return LICMHoistKind::NONE;
+                // bindless slot queries and texture sampling
+                default: break;
+            }
+            return LICMHoistKind::GUARANTEED;
+        }
+        case DerivedInstructionTag::RESOURCE_READ: return LICMHoistKind::RESOURCE;
+        case DerivedInstructionTag::LOAD: return LICMHoistKind::LOCAL;
+        default: break;
+    }
+    return LICMHoistKind::NONE;
+}
+
+static void run_licm_on_loop(const DomTree &dom_tree, const Loop *loop, LICMInfo &info) noexcept {
+    auto effects = licm_collect_loop_effects(loop);
+    // blocks that dominate all exits are executed whenever the loop is entered
+    luisa::unordered_map<BasicBlock *, bool> guaranteed_blocks;
+    auto is_guaranteed = [&](BasicBlock *block) noexcept {
+        auto [iter, first] = guaranteed_blocks.try_emplace(block, false);
+        if (first && dom_tree.contains(block)) {
+            auto exits = loop->exiting_blocks();
+            iter->second = std::all_of(exits.begin(), exits.end(), [&](BasicBlock *exit) noexcept {
+                return !dom_tree.contains(exit) || dom_tree.dominates(block, exit);
+            });
+        }
+        return iter->second;
+    };
+    luisa::unordered_set<const Instruction *> invariants;
+    auto is_invariant = [&](const Value *value) noexcept {
+        if (value == nullptr) { return false; }
+        if (value->derived_value_tag() != DerivedValueTag::INSTRUCTION) { return true; }
+        auto inst = static_cast<const Instruction *>(value);
+        return !loop->contains(inst) || invariants.contains(inst);
+    };
+    auto can_hoist = [&](Instruction *inst) noexcept {
+        switch (licm_hoist_kind(inst)) {
+            case LICMHoistKind::NONE: return false;
+            case LICMHoistKind::SPECULATIVE: break;
+            case LICMHoistKind::GUARANTEED: {
+                if (!is_guaranteed(inst->parent_block())) { return false; }
+                break;
+            }
+            case LICMHoistKind::RESOURCE: {
+                if (effects.writes_all || effects.writes_resources ||
+                    !is_guaranteed(inst->parent_block())) { return false; }
+                break;
+            }
+            case LICMHoistKind::LOCAL: {
+                if (licm_may_be_written(effects, static_cast<LoadInst *>(inst)->variable()) ||
+                    !is_guaranteed(inst->parent_block())) { return false; }
+                break;
+            }
+        }
+        for (auto op_use : inst->operand_uses()) {
+            if (!is_invariant(op_use->value())) { return false; }
+        }
+        return true;
+    };
+    // iterate to a fixed point; an instruction is only found invariant after its operands,
+    // so the discovery order is also a valid order to place the hoisted instructions
+    luisa::vector<Instruction *> hoisted;
+    for (auto changed = true; changed;) {
+        changed = false;
+        for (auto block : loop->blocks()) {
+            for (auto &&inst : block->instructions()) {
+                if (!invariants.contains(&inst) && can_hoist(&inst)) {
+                    invariants.emplace(&inst);
+                    hoisted.emplace_back(&inst);
+                    changed = true;
+                }
+            }
+        }
+    }
+    auto loop_inst = loop->instruction();
+    for (auto inst : hoisted) {
+        inst->remove_self();
+        loop_inst->insert_before_self(inst);
+        info.hoisted_instructions.insert_or_assign(inst, loop_inst);
+    }
+}
+
+static void run_licm_on_function(Function *function, LICMInfo &info) noexcept {
+    if (function->definition() == nullptr) { return; }
+    auto loop_info = compute_loop_info(function);
+    if (loop_info.loops().empty()) { return; }
+    // hoisting does not change the control flow, so the dominator tree stays valid
+    auto dom_tree = compute_dom_tree(function);
+    // inner loops first, so that hoisted instructions may be further hoisted out of the outer loops
+    auto loops = loop_info.loops();
+    for (auto iter = loops.rbegin(); iter != loops.rend(); ++iter) {
+        run_licm_on_loop(dom_tree, iter->get(), info);
+    }
+}
+
+}// namespace detail
+
+LICMInfo licm_pass_run_on_function(Function *function) noexcept {
+    LICMInfo info;
+    detail::run_licm_on_function(function, info);
+    return info;
+}
+
+LICMInfo licm_pass_run_on_module(Module *module) noexcept {
+    LICMInfo info;
+    for (auto &&f : module->functions()) {
+        detail::run_licm_on_function(&f, info);
+    }
+    return info;
+}
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,162 @@
+#include <algorithm>
+
+#include <luisa/core/logging.h>
+#include <luisa/xir/instructions/loop.h>
+#include <luisa/xir/passes/loop_info.h>
+
+namespace luisa::compute::xir {
+
+Loop::Loop(TerminatorInstruction *instruction) noexcept
+    : _instruction{instruction}, _header{nullptr}, _parent{nullptr} {
+    switch (instruction->derived_instruction_tag()) {
+        case DerivedInstructionTag::LOOP: _header = static_cast<LoopInst *>(instruction)->prepare_block(); break;
+        case DerivedInstructionTag::SIMPLE_LOOP: _header = static_cast<SimpleLoopInst *>(instruction)->body_block(); break;
+        default: LUISA_ERROR_WITH_LOCATION("Invalid loop instruction.");
+    }
+    LUISA_ASSERT(_header != nullptr, "Loop header block is not set.");
+}
+
+void Loop::add_block(BasicBlock *block) noexcept {
+    if (_block_set.emplace(block).second) {
+        _blocks.emplace_back(block);
+    }
+}
+
+void Loop::add_exiting_block(BasicBlock *block) noexcept {
+    LUISA_DEBUG_ASSERT(_block_set.contains(block), "Exiting block is not in the loop.");
+    _exiting_blocks.emplace_back(block);
+}
+
+void Loop::add_child(Loop *child) noexcept {
+    LUISA_DEBUG_ASSERT(child != nullptr && child->_parent == nullptr && child != this, "Invalid child.");
+    child->_parent = this;
+    _children.emplace_back(child);
+}
+
+BasicBlock *Loop::preheader() const noexcept {
+    return _instruction->parent_block();
+}
+
+BasicBlock *Loop::merge_block() const noexcept {
+    return _instruction->control_flow_merge()->merge_block();
+}
+
+size_t Loop::depth() const noexcept {
+    auto depth = static_cast<size_t>(1u);
+    for (auto p = _parent; p != nullptr; p = p->_parent) { depth++; }
+    return depth;
+}
+
+bool Loop::contains(const BasicBlock *block) const noexcept {
+    return _block_set.contains(const_cast<BasicBlock *>(block));
+}
+
+bool Loop::contains(const Instruction *inst) const noexcept {
+    return inst->parent_block() != nullptr && contains(inst->parent_block());
+}
+
+LoopInfo::LoopInfo() noexcept = default;
+
+Loop *LoopInfo::add_loop(TerminatorInstruction *instruction) noexcept {
+    return _loops.emplace_back(luisa::make_unique<Loop>(instruction)).get();
+}
+
+void LoopInfo::add_top_level_loop(Loop *loop) noexcept {
+    LUISA_DEBUG_ASSERT(loop->parent() == nullptr, "Top-level loop should not have a parent.");
+    _top_level_loops.emplace_back(loop);
+}
+
+void LoopInfo::set_innermost_loop(BasicBlock *block, Loop *loop) noexcept {
+    _innermost_loops[block] = loop;
+}
+
+void LoopInfo::sort_loops_by_depth() noexcept {
+    std::stable_sort(_loops.begin(), _loops.end(), [](auto &&lhs, auto &&rhs) noexcept {
+        return lhs->depth() < rhs->depth();
+    });
+}
+
+const Loop *LoopInfo::loop(const BasicBlock *block) const noexcept {
+    auto iter = _innermost_loops.find(block);
+    return iter == _innermost_loops.end() ? nullptr : iter->second;
+}
+
+size_t LoopInfo::loop_depth(const BasicBlock *block) const noexcept {
+    auto l = loop(block);
+    return l == nullptr ? 0u : l->depth();
+}
+
+namespace detail {
+
+static void loop_info_collect_blocks(Loop *loop) noexcept {
+    auto merge = loop->merge_block();
+    luisa::vector<BasicBlock *> stack{loop->header()};
+    luisa::unordered_set<BasicBlock *> visited{loop->header()};
+    auto visit = [&](BasicBlock *block) noexcept {
+        if (block != nullptr && block != merge && visited.emplace(block).second) {
+            stack.emplace_back(block);
+        }
+    };
+    while (!stack.empty()) {
+        auto block = stack.back();
+        stack.pop_back();
+        loop->add_block(block);
+        auto terminator = block->terminator();
+        auto has_successors = false;
+        auto exits_loop = false;
+        block->traverse_successors(false, [&](BasicBlock *succ) noexcept {
+            has_successors = true;
+            if (succ == merge) { exits_loop = true; }
+            visit(succ);
+        });
+        // nested merge blocks belong to the loop even if they are not reachable
+        if (auto nested = terminator->control_flow_merge()) { visit(nested->merge_block()); }
+        if (exits_loop || !has_successors) { loop->add_exiting_block(block); }
+    }
+}
+
+}// namespace detail
+
+LoopInfo compute_loop_info(Function *function) noexcept {
+    auto definition = function->definition();
+    LUISA_ASSERT(definition != nullptr, "Function has no definition.");
+    LoopInfo info;
+    luisa::vector<Loop *> loops;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::LOOP ||
+            inst->derived_instruction_tag() == DerivedInstructionTag::SIMPLE_LOOP) {
+            loops.emplace_back(info.add_loop(static_cast<TerminatorInstruction *>(inst)));
+        }
+    });
+    for (auto loop : loops) { detail::loop_info_collect_blocks(loop); }
+    // the parent of a loop is the smallest other loop that contains its preheader
+    for (auto loop : loops) {
+        Loop *parent = nullptr;
+        for (auto other : loops) {
+            if (other != loop && other->contains(loop->preheader()) &&
+                (parent == nullptr || other->blocks().size() < parent->blocks().size())) {
+                parent = other;
+            }
+        }
+        if (parent != nullptr) {
+            parent->add_child(loop);
+        } else {
+            info.add_top_level_loop(loop);
+        }
+    }
+    // likewise, the innermost loop of a block is the smallest loop that contains it
+    luisa::unordered_map<BasicBlock *, Loop *> innermost;
+    for (auto loop : loops) {
+        for (auto block : loop->blocks()) {
+            if (auto [iter, first] = innermost.try_emplace(block, loop);
+                !first && loop->blocks().size() < iter->second->blocks().size()) {
+                iter->second = loop;
+            }
+        }
+    }
+    for (auto [block, loop] : innermost) { info.set_innermost_loop(block, loop); }
+    info.sort_loops_by_depth();
+    return info;
+}
+
+}// namespace luisa::compute::xir
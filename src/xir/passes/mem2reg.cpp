@@ -0,0 +1,277 @@
+#include <luisa/core/logging.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/metadata/name.h>
+#include <luisa/xir/passes/dom_tree.h>
+#include <luisa/xir/passes/mem2reg.h>
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+[[nodiscard]] static bool mem2reg_is_promotable_alloca(AllocaInst *alloca,
+                                                       const luisa::unordered_set<BasicBlock *> &pinned_blocks) noexcept {
+    if (alloca->space() != AllocSpace::LOCAL || !alloca->type()->is_basic()) { return false; }
+    for (auto &&use : alloca->use_list()) {
+        auto user = use.user();
+        if (user == nullptr) { continue; }
+        if (user->derived_value_tag() != DerivedValueTag::INSTRUCTION) { return false; }
+        auto inst = static_cast<Instruction *>(user);
+        if (pinned_blocks.contains(inst->parent_block())) { return false; }
+        switch (inst->derived_instruction_tag()) {
+            case DerivedInstructionTag::LOAD: break;
+            case DerivedInstructionTag::STORE: {
+                if (static_cast<StoreInst *>(inst)->variable() != alloca) { return false; }
+                break;
+            }
+            default: return false;
+        }
+    }
+    return true;
+}
+
+// the candidate blocks of ray query dispatches (and the dispatch blocks themselves) may be
+// outlined into callbacks by the backends, so variables accessed there must stay in memory
+static void mem2reg_collect_pinned_blocks(FunctionDefinition *definition,
+                                          luisa::unordered_set<BasicBlock *> &pinned_blocks) noexcept {
+    luisa::vector<BasicBlock *> stack;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::RAY_QUERY_DISPATCH) {
+            auto dispatch = static_cast<RayQueryDispatchInst *>(inst);
+            auto dispatch_block = dispatch->parent_block();
+            pinned_blocks.emplace(dispatch_block);
+            for (auto candidate : {dispatch->on_surface_candidate_block(),
+                                   dispatch->on_procedural_candidate_block()}) {
+                if (candidate != nullptr) { stack.emplace_back(candidate); }
+            }
+            while (!stack.empty()) {
+                auto block = stack.back();
+                stack.pop_back();
+                if (block != dispatch_block && pinned_blocks.emplace(block).second) {
+                    block->traverse_successors(true, [&](BasicBlock *succ) noexcept {
+                        stack.emplace_back(succ);
+                    });
+                }
+            }
+        }
+    });
+}
+
+class Mem2RegContext {
+
+private:
+    Module *_module;
+    luisa::unordered_map<const Type *, Constant *> _zero_constants;
+
+public:
+    explicit Mem2RegContext(Module *module) noexcept : _module{module} {}
+
+    [[nodiscard]] Constant *zero(const Type *type) noexcept {
+        auto iter = _zero_constants.try_emplace(type, nullptr).first;
+        if (iter->second == nullptr) { iter->second = _module->create_constant_zero(type); }
+        return iter->second;
+    }
+};
+
+// replaces phis that merge a single value (apart from themselves) with that value
+static void mem2reg_remove_trivial_phis(luisa::unordered_set<PhiInst *> &phis) noexcept {
+    for (auto changed = true; changed;) {
+        changed = false;
+        for (auto iter = phis.begin(); iter != phis.end();) {
+            auto phi = *iter;
+            Value *unique = nullptr;
+            auto trivial = true;
+            for (auto i = 0u; i < phi->incoming_count(); i++) {
+                auto value = phi->incoming(i).value;
+                if (value == phi || value == unique) { continue; }
+                if (unique != nullptr) {
+                    trivial = false;
+                    break;
+                }
+                unique = value;
+            }
+            if (trivial && unique != nullptr) {
+                phi->replace_all_uses_with(unique);
+                phi->remove_self();
+                iter = phis.erase(iter);
+                changed = true;
+            } else {
+                ++iter;
+            }
+        }
+    }
+}
+
+static void run_mem2reg_on_function(Mem2RegContext &ctx, Function *function, Mem2RegInfo &info) noexcept {
+    auto definition = function->definition();
+    if (definition == nullptr) { return; }
+
+    // collect the promotable variables
+    luisa::unordered_set<BasicBlock *> pinned_blocks;
+    mem2reg_collect_pinned_blocks(definition, pinned_blocks);
+    luisa::vector<AllocaInst *> variables;
+    luisa::unordered_map<const Value *, size_t> variable_indices;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::ALLOCA) {
+            if (auto alloca = static_cast<AllocaInst *>(inst);
+                mem2reg_is_promotable_alloca(alloca, pinned_blocks)) {
+                variable_indices.emplace(alloca, variables.size());
+                variables.emplace_back(alloca);
+            }
+        }
+    });
+    if (variables.empty()) { return; }
+
+    // insert phis at the iterated dominance frontiers of the stores
+    auto dom_tree = compute_dom_tree(function);
+    luisa::unordered_map<BasicBlock *, luisa::vector<std::pair<PhiInst *, size_t>>> block_phis;
+    luisa::unordered_map<PhiInst *, size_t> phi_variables;
+    luisa::unordered_set<PhiInst *> inserted_phis;
+    luisa::vector<BasicBlock *> worklist;
+    luisa::unordered_set<BasicBlock *> blocks_with_phi;
+    Builder b;
+    for (auto i = 0u; i < variables.size(); i++) {
+        auto variable = variables[i];
+        worklist.clear();
+        blocks_with_phi.clear();
+        for (auto &&use : variable->use_list()) {
+            if (auto user = static_cast<Instruction *>(use.user());
+                user != nullptr && user->derived_instruction_tag() == DerivedInstructionTag::STORE &&
+                dom_tree.contains(user->parent_block())) {
+                worklist.emplace_back(user->parent_block());
+            }
+        }
+        auto name = variable->find_metadata<NameMD>();
+        while (!worklist.empty()) {
+            auto block = worklist.back();
+            worklist.pop_back();
+            for (auto frontier : dom_tree.node(block)->frontiers()) {
+                if (auto frontier_block = frontier->block(); blocks_with_phi.emplace(frontier_block).second) {
+                    b.set_insertion_point(frontier_block->instructions().head_sentinel());
+                    auto phi = b.phi(variable->type());
+                    if (name != nullptr) { phi->set_name(name->name()); }
+                    block_phis[frontier_block].emplace_back(phi, i);
+                    phi_variables.emplace(phi, i);
+                    inserted_phis.emplace(phi);
+                    // the phi is a new definition of the variable
+                    worklist.emplace_back(frontier_block);
+                }
+            }
+        }
+    }
+
+    // rename the loads and stores by walking the dominator tree
+    luisa::vector<Value *> current_values(variables.size(), nullptr);
+    luisa::vector<std::pair<size_t, Value *>> undo_log;
+    auto current_value = [&](size_t index) noexcept -> Value * {
+        if (auto value = current_values[index]) { return value; }
+        return ctx.zero(variables[index]->type());
+    };
+    auto define = [&](size_t index, Value *value) noexcept {
+        undo_log.emplace_back(index, current_values[index]);
+        current_values[index] = value;
+    };
+    struct Frame {
+        const DomTreeNode *node;
+        size_t undo_size;
+        bool visited;
+    };
+    luisa::vector<Frame> stack;
+    stack.emplace_back(Frame{dom_tree.root(), 0u, false});
+    while (!stack.empty()) {
+        if (auto &frame = stack.back(); frame.visited) {
+            // restore the definitions on leaving the subtree
+            while (undo_log.size() > frame.undo_size) {
+                auto [index, value] = undo_log.back();
+                current_values[index] = value;
+                undo_log.pop_back();
+            }
+            stack.pop_back();
+            continue;
+        }
+        auto node = stack.back().node;
+        stack.back().undo_size = undo_log.size();
+        stack.back().visited = true;
+        auto block = node->block();
+        for (auto iter = block->instructions().begin(); iter != block->instructions().end();) {
+            auto inst = &*(iter++);
+            switch (inst->derived_instruction_tag()) {
+                case DerivedInstructionTag::PHI: {
+                    if (auto p = phi_variables.find(static_cast<PhiInst *>(inst)); p != phi_variables.end()) {
+                        define(p->second, inst);
+                    }
+                    break;
+                }
+                case DerivedInstructionTag::LOAD: {
+                    auto load = static_cast<LoadInst *>(inst);
+                    if (auto v = variable_indices.find(load->variable());
+                        v != variable_indices.end()) {
+                        load->replace_all_uses_with(current_value(v->second));
+                        load->remove_self();
+                    }
+                    break;
+                }
+                case DerivedInstructionTag::STORE: {
+                    auto store = static_cast<StoreInst *>(inst);
+                    if (auto v = variable_indices.find(store->variable());
+                        v != variable_indices.end()) {
+                        define(v->second, store->value());
+                        store->remove_self();
+                    }
+                    break;
+                }
+                default: break;
+            }
+        }
+        // fill in the incoming values of the phis in the successors
+        block->traverse_successors(false, [&](BasicBlock *succ) noexcept {
+            if (auto iter = block_phis.find(succ); iter != block_phis.end()) {
+                for (auto [phi, index] : iter->second) {
+                    phi->add_incoming(current_value(index), block);
+                }
+            }
+        });
+        for (auto child : node->children()) {
+            stack.emplace_back(Frame{child, 0u, false});
+        }
+    }
+
+    // the remaining users are in unreachable blocks, where the values do not matter
+    luisa::vector<Instruction *> users;
+    for (auto variable : variables) {
+        users.clear();
+        for (auto &&use : variable->use_list()) {
+            if (auto user = use.user()) { users.emplace_back(static_cast<Instruction *>(user)); }
+        }
+        for (auto user : users) {
+            if (user->derived_instruction_tag() == DerivedInstructionTag::LOAD) {
+                user->replace_all_uses_with(ctx.zero(variable->type()));
+            }
+            user->remove_self();
+        }
+        LUISA_DEBUG_ASSERT(variable->use_list().empty(), "Promoted alloca should have no users.");
+        variable->remove_self();
+        info.promoted_allocas.emplace(variable);
+    }
+    mem2reg_remove_trivial_phis(inserted_phis);
+    for (auto phi : inserted_phis) { info.inserted_phis.emplace(phi); }
+}
+
+}// namespace detail
+
+Mem2RegInfo mem2reg_pass_run_on_function(Module *module, Function *function) noexcept {
+    Mem2RegInfo info;
+    detail::Mem2RegContext ctx{module};
+    detail::run_mem2reg_on_function(ctx, function, info);
+    return info;
+}
+
+Mem2RegInfo mem2reg_pass_run_on_module(Module *module) noexcept {
+    Mem2RegInfo info;
+    detail::Mem2RegContext ctx{module};
+    for (auto &&f : module->functions()) {
+        detail::run_mem2reg_on_function(ctx, &f, info);
+    }
+    return info;
+}
+
+}// namespace luisa::compute::xir
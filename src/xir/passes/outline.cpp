@@ -1,17 +1,298 @@
+#include <luisa/core/logging.h>
+#include <luisa/xir/builder.h>
 #include <luisa/xir/passes/outline.h>
 
 namespace luisa::compute::xir {
 
+namespace detail {
+
+struct OutlineRegion {
+    luisa::vector<BasicBlock *> blocks;
+    luisa::unordered_set<BasicBlock *> block_set;
+    luisa::vector<BasicBlock *> exits;// blocks that branch to the merge block
+    luisa::vector<Value *> inputs;
+    luisa::vector<Instruction *> outputs;
+
+    [[nodiscard]] bool contains(const Value *value) const noexcept {
+        return value->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+               block_set.contains(static_cast<const Instruction *>(value)->parent_block());
+    }
+};
+
+// whether the function synchronizes the block, either directly or through its callees
+[[nodiscard]] static bool outline_synchronizes_block(Function *f, luisa::unordered_set<Function *> &visited) noexcept {
+    auto definition = f->definition();
+    if (definition == nullptr || !visited.emplace(f).second) { return false; }
+    auto synchronizes = false;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (synchronizes) { return; }
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::THREAD_GROUP) {
+            synchronizes = static_cast<ThreadGroupInst *>(inst)->op() == ThreadGroupOp::SYNCHRONIZE_BLOCK;
+        } else if (inst->derived_instruction_tag() == DerivedInstructionTag::CALL) {
+            if (auto callee = static_cast<CallInst *>(inst)->callee();
+                callee != nullptr && callee->derived_value_tag() == DerivedValueTag::FUNCTION) {
+                synchronizes = outline_synchronizes_block(static_cast<Function *>(callee), visited);
+            }
+        }
+    });
+    return synchronizes;
+}
+
+[[nodiscard]] static bool outline_is_supported_instruction(Instruction *inst) noexcept {
+    switch (inst->derived_instruction_tag()) {
+        // early returns would have to be propagated to the caller
+        case DerivedInstructionTag::RETURN: [[fallthrough]];
+        case DerivedInstructionTag::RASTER_DISCARD: [[fallthrough]];
+        case DerivedInstructionTag::AUTO_DIFF: return false;
+        // block barriers and ray traces may suspend the kernel, which is not possible from callables
+        case DerivedInstructionTag::THREAD_GROUP: {
+            return static_cast<ThreadGroupInst *>(inst)->op() != ThreadGroupOp::SYNCHRONIZE_BLOCK;
+        }
+        case DerivedInstructionTag::CALL: {
+            if (auto callee = static_cast<CallInst *>(inst)->callee();
+                callee != nullptr && callee->derived_value_tag() == DerivedValueTag::FUNCTION) {
+                luisa::unordered_set<Function *> visited;
+                return !outline_synchronizes_block(static_cast<Function *>(callee), visited);
+            }
+            break;
+        }
+        case DerivedInstructionTag::RESOURCE_QUERY: {
+            switch (static_cast<ResourceQueryInst *>(inst)->op()) {
+                case ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_ANY: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_CLOSEST_MOTION_BLUR: [[fallthrough]];
+                case ResourceQueryOp::RAY_TRACING_TRACE_ANY_MOTION_BLUR: return false;
+                default: break;
+            }
+            break;
+        }
+        default: break;
+    }
+    return true;
+}
+
+[[nodiscard]] static bool outline_collect_region(OutlineInst *outline, OutlineRegion &region) noexcept {
+    auto entry = outline->target_block();
+    auto merge = outline->merge_block();
+    if (entry == nullptr || entry == merge) { return false; }
+    // collect the blocks reachable from the entry without passing through the merge block
+    luisa::vector<BasicBlock *> stack{entry};
+    region.block_set.emplace(entry);
+    while (!stack.empty()) {
+        auto block = stack.back();
+        stack.pop_back();
+        region.blocks.emplace_back(block);
+        auto terminator = block->terminator();
+        auto exits_region = false;
+        block->traverse_successors(false, [&](BasicBlock *succ) noexcept {
+            if (succ == merge) {
+                exits_region = true;
+            } else if (region.block_set.emplace(succ).second) {
+                stack.emplace_back(succ);
+            }
+        });
+        // nested merge blocks are moved along with their control flow
+        // instructions, even if they are not reachable
+        if (auto nested = terminator->control_flow_merge()) {
+            if (auto nested_merge = nested->merge_block();
+                nested_merge != nullptr && nested_merge != merge &&
+                region.block_set.emplace(nested_merge).second) {
+                stack.emplace_back(nested_merge);
+            }
+        }
+        if (exits_region) {
+            // only plain branches to the merge block can be turned into returns
+            if (terminator->derived_instruction_tag() != DerivedInstructionTag::BRANCH) { return false; }
+            region.exits.emplace_back(block);
+        }
+    }
+    // the region must be single-entry, and break/continue must not leave it
+    luisa::unordered_set<BasicBlock *> loop_blocks;
+    for (auto block : region.blocks) {
+        for (auto &&use : block->use_list()) {
+            auto user = static_cast<Instruction *>(use.user());
+            if (block == entry ? user != outline : !region.block_set.contains(user->parent_block())) {
+                return false;
+            }
+        }
+        switch (auto terminator = block->terminator(); terminator->derived_instruction_tag()) {
+            case DerivedInstructionTag::LOOP: {
+                auto loop = static_cast<LoopInst *>(terminator);
+                loop_blocks.insert({loop->prepare_block(), loop->body_block(), loop->update_block(), loop->merge_block()});
+                break;
+            }
+            case DerivedInstructionTag::SIMPLE_LOOP: {
+                auto loop = static_cast<SimpleLoopInst *>(terminator);
+                loop_blocks.insert({loop->body_block(), loop->merge_block()});
+                break;
+            }
+            default: break;
+        }
+        for (auto &&inst : block->instructions()) {
+            if (!outline_is_supported_instruction(&inst)) { return false; }
+        }
+    }
+    for (auto block : region.blocks) {
+        if (auto terminator = block->terminator();
+            terminator->derived_instruction_tag() == DerivedInstructionTag::BREAK ||
+            terminator->derived_instruction_tag() == DerivedInstructionTag::CONTINUE) {
+            if (!loop_blocks.contains(static_cast<BranchTerminatorInstruction *>(terminator)->target_block())) {
+                return false;
+            }
+        }
+    }
+    // phi nodes in the merge block would need a value per exit
+    if (merge != nullptr) {
+        for (auto &&inst : merge->instructions()) {
+            if (inst.derived_instruction_tag() == DerivedInstructionTag::PHI) {
+                auto phi = static_cast<PhiInst *>(&inst);
+                for (auto block : phi->incoming_blocks()) {
+                    if (region.block_set.contains(block)) { return false; }
+                }
+            }
+        }
+    }
+    // collect the values that flow into and out of the region
+    luisa::unordered_set<Value *> input_set;
+    for (auto block : region.blocks) {
+        for (auto &&inst : block->instructions()) {
+            for (auto op_use : inst.operand_uses()) {
+                auto op = op_use->value();
+                if (op == nullptr || region.contains(op)) { continue; }
+                if (op->derived_value_tag() == DerivedValueTag::INSTRUCTION ||
+                    op->derived_value_tag() == DerivedValueTag::ARGUMENT) {
+                    // opaque values can only be passed by reference
+                    if (!op->is_lvalue() && op->type() != nullptr && op->type()->is_custom()) { return false; }
+                    if (input_set.emplace(op).second) { region.inputs.emplace_back(op); }
+                }
+            }
+            for (auto &&use : inst.use_list()) {
+                if (auto user = use.user(); user != nullptr && !region.contains(user)) {
+                    // pointers into the region cannot be written back
+                    if (inst.is_lvalue()) { return false; }
+                    region.outputs.emplace_back(&inst);
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// replaces the uses of the value either inside or outside the region
+static void outline_replace_uses(const OutlineRegion &region, Value *value, Value *replacement, bool inside) noexcept {
+    luisa::fixed_vector<Use *, 16u> uses;
+    for (auto &&use : value->use_list()) {
+        if (auto user = use.user(); user != nullptr && region.contains(user) == inside) {
+            uses.emplace_back(&use);
+        }
+    }
+    for (auto use : uses) {
+        use->remove_self();
+        use->set_value(replacement);
+        use->add_to_list(replacement->use_list());
+    }
+}
+
+[[nodiscard]] static Function *outline_region(Module *module, FunctionDefinition *caller,
+                                              OutlineInst *outline, const OutlineRegion &region) noexcept {
+    auto callee = module->create_callable(nullptr);
+    callee->add_comment("Outlined region");
+    // the region was outlined on purpose, so the inliner must not copy it back
+    callee->set_noinline(true);
+    luisa::vector<Value *> call_args;
+    call_args.reserve(region.inputs.size() + region.outputs.size());
+    // inputs are passed as arguments
+    for (auto input : region.inputs) {
+        auto arg = callee->create_argument(input->type(), input->is_lvalue());
+        outline_replace_uses(region, input, arg, true);
+        call_args.emplace_back(input);
+    }
+    // outputs are written back to local variables of the caller at each exit
+    Builder b;
+    luisa::vector<std::pair<Instruction *, AllocaInst *>> output_variables;
+    output_variables.reserve(region.outputs.size());
+    for (auto output : region.outputs) {
+        auto arg = callee->create_reference_argument(output->type());
+        b.set_insertion_point(caller->body_block()->instructions().head_sentinel());
+        auto variable = b.alloca_local(output->type());
+        variable->add_comment("Outlined region output");
+        output_variables.emplace_back(output, variable);
+        call_args.emplace_back(variable);
+        for (auto exit : region.exits) {
+            b.set_insertion_point(exit->terminator()->prev());
+            b.store(arg, output);
+        }
+    }
+    for (auto exit : region.exits) {
+        auto terminator = exit->terminator();
+        b.set_insertion_point(terminator);
+        b.return_void();
+        terminator->remove_self();
+    }
+    // the entry block has no other predecessors, so it can be used as the function body
+    callee->set_body_block(outline->target_block());
+    // call the outlined function in a new body of the outline instruction
+    auto body = outline->create_target_block(true);
+    b.set_insertion_point(body);
+    b.call(nullptr, callee, call_args);
+    for (auto [output, variable] : output_variables) {
+        auto value = b.load(output->type(), variable);
+        outline_replace_uses(region, output, value, false);
+    }
+    if (auto merge = outline->merge_block()) {
+        b.br(merge);
+    } else {
+        b.unreachable_("Outlined region does not return.");
+    }
+    return callee;
+}
+
+static void run_outline_on_function(Module *module, Function *function, OutlineInfo &info) noexcept {
+    auto definition = function->definition();
+    if (definition == nullptr) { return; }
+    luisa::vector<OutlineInst *> outlines;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::OUTLINE) {
+            outlines.emplace_back(static_cast<OutlineInst *>(inst));
+        }
+    });
+    // outer regions are visited first; nested outline instructions are moved
+    // into the outlined functions and skipped here (as they are no longer in
+    // this function), and will be processed when the new functions are visited
+    luisa::unordered_set<BasicBlock *> moved_blocks;
+    for (auto outline : outlines) {
+        if (moved_blocks.contains(outline->parent_block())) { continue; }
+        OutlineRegion region;
+        if (!outline_collect_region(outline, region)) {
+            LUISA_VERBOSE("Skipping outline instruction that cannot be outlined.");
+            continue;
+        }
+        auto callee = outline_region(module, definition, outline, region);
+        moved_blocks.insert(region.blocks.begin(), region.blocks.end());
+        info.outlines.emplace(outline, callee);
+    }
+}
+
+}// namespace detail
+
 OutlineInfo outline_pass_run_on_function(Module *module, Function *function) noexcept {
-    return {};
+    OutlineInfo info;
+    detail::run_outline_on_function(module, function, info);
+    return info;
 }
 
 OutlineInfo outline_pass_run_on_module(Module *module) noexcept {
     OutlineInfo info;
     luisa::vector<Function *> functions;
     for (auto &f : module->functions()) { functions.emplace_back(&f); }
-    for (auto &f : module->functions()) {
-        auto func_info = outline_pass_run_on_function(module, &f);
+    // outlined functions may contain nested outline instructions, so we process them as well
+    for (auto i = 0u; i < functions.size(); i++) {
+        auto func_info = outline_pass_run_on_function(module, functions[i]);
+        for (auto [inst, f] : func_info.outlines) {
+            functions.emplace_back(f);
+            info.outlines.emplace(inst, f);
+        }
     }
     return info;
 }
@@ -1,7 +1,264 @@
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/queue.h>
+#include <luisa/ast/type.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/metadata/name.h>
+#include <luisa/xir/passes/aggregate_field_bitmask.h>
 #include <luisa/xir/passes/sroa.h>
 
 namespace luisa::compute::xir {
 
+namespace detail {
 
+// arrays with more elements are kept in memory, as splitting them would only bloat the IR
+static constexpr auto sroa_max_array_elements = 16u;
+static constexpr auto sroa_invalid_index = ~static_cast<size_t>(0u);
 
+[[nodiscard]] static bool sroa_is_splittable_type(const Type *type) noexcept {
+    return (type->is_structure() && !type->members().empty()) ||
+           (type->is_array() && type->dimension() <= sroa_max_array_elements);
 }
+
+[[nodiscard]] static size_t sroa_field_count(const Type *type) noexcept {
+    return type->is_structure() ? type->members().size() : type->dimension();
+}
+
+[[nodiscard]] static const Type *sroa_field_type(const Type *type, size_t index) noexcept {
+    return type->is_structure() ? type->members()[index] : type->element();
+}
+
+[[nodiscard]] static size_t sroa_field_offset(const Type *type, size_t index) noexcept {
+    if (type->is_array()) { return index * type->element()->size(); }
+    auto offset = static_cast<size_t>(0u);
+    auto members = type->members();
+    for (auto i = 0u; i < index; i++) {
+        offset = luisa::align(offset, members[i]->alignment()) + members[i]->size();
+    }
+    return luisa::align(offset, members[index]->alignment());
+}
+
+[[nodiscard]] static size_t sroa_constant_index(Value *value) noexcept {
+    if (value->derived_value_tag() != DerivedValueTag::CONSTANT) { return sroa_invalid_index; }
+    auto c = static_cast<Constant *>(value);
+    switch (c->type()->tag()) {
+        case Type::Tag::INT8: return static_cast<size_t>(static_cast<int64_t>(c->as<int8_t>()));
+        case Type::Tag::UINT8: return static_cast<size_t>(c->as<uint8_t>());
+        case Type::Tag::INT16: return static_cast<size_t>(static_cast<int64_t>(c->as<int16_t>()));
+        case Type::Tag::UINT16: return static_cast<size_t>(c->as<uint16_t>());
+        case Type::Tag::INT32: return static_cast<size_t>(static_cast<int64_t>(c->as<int32_t>()));
+        case Type::Tag::UINT32: return static_cast<size_t>(c->as<uint32_t>());
+        case Type::Tag::INT64: return static_cast<size_t>(c->as<int64_t>());
+        case Type::Tag::UINT64: return static_cast<size_t>(c->as<uint64_t>());
+        default: break;
+    }
+    return sroa_invalid_index;
+}
+
+// checks that the alloca is only accessed through GEPs with constant leading
+// indices or loaded/stored as a whole, and records the accessed fields
+[[nodiscard]] static bool sroa_collect_accessed_fields(AllocaInst *alloca, AggregateFieldBitmask &accessed) noexcept {
+    auto field_count = sroa_field_count(alloca->type());
+    for (auto &&use : alloca->use_list()) {
+        auto user = use.user();
+        if (user == nullptr) { continue; }
+        if (user->derived_value_tag() != DerivedValueTag::INSTRUCTION) { return false; }
+        switch (auto inst = static_cast<Instruction *>(user); inst->derived_instruction_tag()) {
+            case DerivedInstructionTag::GEP: {
+                auto gep = static_cast<GEPInst *>(inst);
+                if (gep->base() != alloca || gep->index_count() == 0u) { return false; }
+                auto index = sroa_constant_index(gep->index(0u));
+                if (index >= field_count) { return false; }
+                accessed.access(index).set();
+                break;
+            }
+            case DerivedInstructionTag::LOAD: {
+                accessed.set();
+                break;
+            }
+            case DerivedInstructionTag::STORE: {
+                if (static_cast<StoreInst *>(inst)->variable() != alloca) { return false; }
+                accessed.set();
+                break;
+            }
+            default: return false;
+        }
+    }
+    return true;
+}
+
+class SROAContext {
+
+private:
+    Module *_module;
+    luisa::unordered_map<size_t, Constant *> _index_constants;
+    luisa::unordered_map<Constant *, luisa::vector<Constant *>> _split_constants;
+
+public:
+    explicit SROAContext(Module *module) noexcept : _module{module} {
+        // reuse the existing index constants
+        for (auto &&c : module->constants()) {
+            if (c.type() == Type::of<uint>()) {
+                _index_constants.try_emplace(c.as<uint>(), &c);
+            }
+        }
+    }
+
+    [[nodiscard]] Constant *index_constant(size_t index) noexcept {
+        auto iter = _index_constants.try_emplace(index, nullptr).first;
+        if (iter->second == nullptr) {
+            auto i = static_cast<uint>(index);
+            iter->second = _module->create_constant(Type::of<uint>(), &i);
+        }
+        return iter->second;
+    }
+
+    [[nodiscard]] Constant *split_constant(Constant *c, size_t index) noexcept {
+        auto type = c->type();
+        auto iter = _split_constants.try_emplace(c).first;
+        if (iter->second.empty()) {
+            auto field_count = sroa_field_count(type);
+            iter->second.reserve(field_count);
+            for (auto i = 0u; i < field_count; i++) {
+                auto data = static_cast<const std::byte *>(c->data()) + sroa_field_offset(type, i);
+                iter->second.emplace_back(_module->create_constant(sroa_field_type(type, i), data));
+            }
+        }
+        return iter->second[index];
+    }
+
+    [[nodiscard]] Value *extract_field(Builder &b, Value *value, size_t index) noexcept {
+        auto type = value->type();
+        auto field_type = sroa_field_type(type, index);
+        // constants are split at compile time
+        if (value->derived_value_tag() == DerivedValueTag::CONSTANT) {
+            return split_constant(static_cast<Constant *>(value), index);
+        }
+        // aggregates built in place can be forwarded directly
+        if (value->derived_value_tag() == DerivedValueTag::INSTRUCTION &&
+            static_cast<Instruction *>(value)->derived_instruction_tag() == DerivedInstructionTag::ARITHMETIC) {
+            if (auto inst = static_cast<ArithmeticInst *>(value);
+                inst->op() == ArithmeticOp::AGGREGATE && inst->operand_count() == sroa_field_count(type)) {
+                return inst->operand(index);
+            }
+        }
+        return b.call(field_type, ArithmeticOp::EXTRACT, {value, index_constant(index)});
+    }
+
+    void split(AllocaInst *alloca, const AggregateFieldBitmask &accessed,
+               luisa::vector<AllocaInst *> &fields) noexcept {
+        auto type = alloca->type();
+        auto field_count = sroa_field_count(type);
+        // create the field alloca's right after the aggregate alloca
+        Builder b;
+        b.set_insertion_point(alloca);
+        auto name = alloca->find_metadata<NameMD>();
+        fields.resize(field_count, nullptr);
+        for (auto i = 0u; i < field_count; i++) {
+            if (accessed.access(i).any()) {
+                auto field = b.alloca_local(sroa_field_type(type, i));
+                if (name != nullptr) { field->set_name(luisa::format("{}.{}", name->name(), i)); }
+                fields[i] = field;
+            }
+        }
+        // collect the users first as we are going to modify the use list
+        luisa::vector<Instruction *> users;
+        for (auto &&use : alloca->use_list()) {
+            if (auto user = use.user()) {
+                users.emplace_back(static_cast<Instruction *>(user));
+            }
+        }
+        for (auto user : users) {
+            switch (user->derived_instruction_tag()) {
+                case DerivedInstructionTag::GEP: {
+                    auto gep = static_cast<GEPInst *>(user);
+                    auto field = fields[sroa_constant_index(gep->index(0u))];
+                    LUISA_DEBUG_ASSERT(field != nullptr, "Accessed field must have been split.");
+                    if (gep->index_count() == 1u) {
+                        gep->replace_all_uses_with(field);
+                        gep->remove_self();
+                    } else {
+                        gep->set_base(field);
+                        gep->remove_index(0u);
+                    }
+                    break;
+                }
+                case DerivedInstructionTag::LOAD: {
+                    auto load = static_cast<LoadInst *>(user);
+                    b.set_insertion_point(load);
+                    luisa::fixed_vector<Value *, 16u> elements;
+                    for (auto field : fields) {
+                        elements.emplace_back(b.load(field->type(), field));
+                    }
+                    auto value = b.call(type, ArithmeticOp::AGGREGATE, elements);
+                    load->replace_all_uses_with(value);
+                    load->remove_self();
+                    break;
+                }
+                case DerivedInstructionTag::STORE: {
+                    auto store = static_cast<StoreInst *>(user);
+                    b.set_insertion_point(store);
+                    for (auto i = 0u; i < field_count; i++) {
+                        auto value = extract_field(b, store->value(), i);
+                        b.store(fields[i], value);
+                    }
+                    store->remove_self();
+                    break;
+                }
+                default: LUISA_ERROR_WITH_LOCATION("Unexpected alloca user.");
+            }
+        }
+        LUISA_DEBUG_ASSERT(alloca->use_list().empty(), "Split alloca should have no users.");
+        alloca->remove_self();
+        // drop the fields that are never accessed
+        fields.erase(std::remove(fields.begin(), fields.end(), nullptr), fields.end());
+    }
+};
+
+static void run_sroa_on_function(SROAContext &ctx, Function *function, SROAInfo &info) noexcept {
+    auto definition = function->definition();
+    if (definition == nullptr) { return; }
+    luisa::queue<AllocaInst *> candidates;
+    definition->traverse_instructions([&](Instruction *inst) noexcept {
+        if (inst->derived_instruction_tag() == DerivedInstructionTag::ALLOCA) {
+            if (auto alloca = static_cast<AllocaInst *>(inst);
+                alloca->space() == AllocSpace::LOCAL && sroa_is_splittable_type(alloca->type())) {
+                candidates.push(alloca);
+            }
+        }
+    });
+    while (!candidates.empty()) {
+        auto alloca = candidates.front();
+        candidates.pop();
+        AggregateFieldBitmask accessed{alloca->type()};
+        if (!sroa_collect_accessed_fields(alloca, accessed)) { continue; }
+        luisa::vector<AllocaInst *> fields;
+        ctx.split(alloca, accessed, fields);
+        // the fields might be further split
+        for (auto field : fields) {
+            if (sroa_is_splittable_type(field->type())) {
+                candidates.push(field);
+            }
+        }
+        info.split_allocas.emplace(alloca, std::move(fields));
+    }
+}
+
+}// namespace detail
+
+SROAInfo sroa_pass_run_on_function(Module *module, Function *function) noexcept {
+    SROAInfo info;
+    detail::SROAContext ctx{module};
+    detail::run_sroa_on_function(ctx, function, info);
+    return info;
+}
+
+SROAInfo sroa_pass_run_on_module(Module *module) noexcept {
+    SROAInfo info;
+    detail::SROAContext ctx{module};
+    for (auto &&f : module->functions()) {
+        detail::run_sroa_on_function(ctx, &f, info);
+    }
+    return info;
+}
+
+}// namespace luisa::compute::xir
@@ -11,8 +11,36 @@ Pool::Pool(size_t init_cap) noexcept {
 
 Pool::~Pool() noexcept {
     for (auto object : _objects) {
-        luisa::delete_with_allocator(object);
+        object->~PooledObject();
     }
+    for (auto page : _pages) {
+        luisa::detail::allocator_deallocate(page, page_alignment);
+    }
+}
+
+void *Pool::_allocate(size_t size, size_t alignment) noexcept {
+    LUISA_DEBUG_ASSERT(alignment != 0u && (alignment & (alignment - 1u)) == 0u &&
+                           alignment <= page_alignment,
+                       "Invalid alignment {}.", alignment);
+    if (size > page_size / 4u) {
+        auto memory = static_cast<std::byte *>(luisa::detail::allocator_allocate(size, page_alignment));
+        _pages.emplace_back(memory);
+        return memory;
+    }
+    if (_page_cursor != nullptr) {
+        auto padding = (alignment - reinterpret_cast<uintptr_t>(_page_cursor) % alignment) % alignment;
+        if (padding + size <= static_cast<size_t>(_page_end - _page_cursor)) {
+            auto memory = _page_cursor + padding;
+            _page_cursor = memory + size;
+            return memory;
+        }
+    }
+    // the remaining space of the current page (if any) is abandoned
+    auto page = static_cast<std::byte *>(luisa::detail::allocator_allocate(page_size, page_alignment));
+    _pages.emplace_back(page);
+    _page_cursor = page + size;
+    _page_end = page + page_size;
+    return page;
 }
 
 namespace detail {
@@ -0,0 +1,121 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main() {
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    xir::Module module;
+    auto u32_zero = module.create_constant_zero(Type::of<uint>());
+    auto u32_one = module.create_constant_one(Type::of<uint>());
+    auto u32_two = module.create_constant(Type::of<uint>(), std::array{2u}.data());
+    auto u32_four = module.create_constant(Type::of<uint>(), std::array{4u}.data());
+    auto f32_one = module.create_constant_one(Type::of<float>());
+    auto f32_two = module.create_constant(Type::of<float>(), std::array{2.f}.data());
+    auto f32_three = module.create_constant(Type::of<float>(), std::array{3.f}.data());
+
+    xir::Builder b;
+
+    // kernel {
+    //   scale = 2 * 3 + 1
+    //   a = float(tid * 4 + 1) * scale
+    //   if (tid % 2 == 0) {
+    //     buffer[tid] = a + float(4 * tid + 1) * scale + a * a
+    //   } else {
+    //     buffer[dispatch_id().x] = a * float(dispatch_id().x * 4 + 0 + 1) + a * a
+    //   }
+    // }
+    auto kernel = module.create_kernel();
+    auto buffer = kernel->create_resource_argument(Type::of<Buffer<float>>());
+    b.set_insertion_point(kernel->create_body_block());
+    auto tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT, {xir::SPR_DispatchID::create(), u32_zero});
+    auto product = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {f32_two, f32_three});
+    auto scale = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {product, f32_one});
+    auto tid4 = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MUL, {tid, u32_four});
+    auto index = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_ADD, {tid4, u32_one});
+    auto index_float = b.static_cast_(Type::of<float>(), index);
+    auto a = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {index_float, scale});
+    auto parity = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MOD, {tid, u32_two});
+    auto branch = b.if_(b.call(Type::of<bool>(), xir::ArithmeticOp::BINARY_EQUAL, {parity, u32_zero}));
+    auto merge = branch->create_merge_block();
+
+    // recomputes the same expressions (with commuted operands) in a dominated block
+    b.set_insertion_point(branch->create_true_block());
+    auto true_tid4 = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MUL, {u32_four, tid});
+    auto true_index = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_ADD, {true_tid4, u32_one});
+    auto true_index_float = b.static_cast_(Type::of<float>(), true_index);
+    auto true_a = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {true_index_float, scale});
+    auto true_sum = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {a, true_a});
+    auto true_square = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {a, a});
+    auto true_result = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {true_sum, true_square});
+    auto true_write = b.call(xir::ResourceWriteOp::BUFFER_WRITE, {buffer, tid, true_result});
+    b.br(merge);
+
+    // re-reads the dispatch id and recomputes the index through a foldable + 0
+    b.set_insertion_point(branch->create_false_block());
+    auto false_tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT, {xir::SPR_DispatchID::create(), u32_zero});
+    auto false_tid4 = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MUL, {false_tid, u32_four});
+    auto false_tid4_plus_zero = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_ADD, {false_tid4, u32_zero});
+    auto false_index = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_ADD, {false_tid4_plus_zero, u32_one});
+    auto false_index_float = b.static_cast_(Type::of<float>(), false_index);
+    auto false_product = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {a, false_index_float});
+    // a * a is also computed in the sibling branch, which does not dominate this one
+    auto false_square = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {a, a});
+    auto false_result = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {false_product, false_square});
+    auto false_write = b.call(xir::ResourceWriteOp::BUFFER_WRITE, {buffer, false_tid, false_result});
+    b.br(merge);
+    b.set_insertion_point(merge);
+    b.return_void();
+
+    auto fold_info = xir::const_fold_pass_run_on_function(&module, kernel);
+
+    // 2 * 3 + 1 is folded into 7, and the integer + 0 is simplified away
+    LUISA_ASSERT(fold_info.folded_instructions.size() == 3u, "Expected exactly three folded instructions.");
+    auto folded_constant = [&](xir::Instruction *inst) noexcept -> xir::Constant * {
+        auto iter = fold_info.folded_instructions.find(inst);
+        if (iter == fold_info.folded_instructions.end() ||
+            iter->second->derived_value_tag() != xir::DerivedValueTag::CONSTANT) { return nullptr; }
+        return static_cast<xir::Constant *>(iter->second);
+    };
+    auto folded_product = folded_constant(product);
+    auto folded_scale = folded_constant(scale);
+    LUISA_ASSERT(folded_product != nullptr && folded_product->as<float>() == 6.f, "2 * 3 should be folded into 6.");
+    LUISA_ASSERT(folded_scale != nullptr && folded_scale->as<float>() == 7.f, "6 + 1 should be folded into 7.");
+    LUISA_ASSERT(fold_info.folded_instructions.contains(false_tid4_plus_zero) &&
+                     fold_info.folded_instructions.at(false_tid4_plus_zero) == false_tid4,
+                 "x + 0 should be simplified into x.");
+    LUISA_ASSERT(a->operand(1) == folded_scale && true_a->operand(1) == folded_scale,
+                 "The uses of scale should be replaced with the folded constant.");
+
+    auto gvn_info = xir::gvn_pass_run_on_function(kernel);
+
+    // each recomputation is mapped to the dominating instruction
+    auto eliminated_into = [&](xir::Instruction *inst, xir::Instruction *existing) noexcept {
+        auto iter = gvn_info.eliminated_instructions.find(inst);
+        return iter != gvn_info.eliminated_instructions.end() && iter->second == existing;
+    };
+    LUISA_ASSERT(gvn_info.eliminated_instructions.size() == 8u, "Expected exactly eight eliminated instructions.");
+    LUISA_ASSERT(eliminated_into(true_tid4, tid4) &&
+                     eliminated_into(true_index, index) &&
+                     eliminated_into(true_index_float, index_float) &&
+                     eliminated_into(true_a, a),
+                 "The recomputed index math in the true branch should be eliminated.");
+    LUISA_ASSERT(eliminated_into(false_tid, tid) &&
+                     eliminated_into(false_tid4, tid4) &&
+                     eliminated_into(false_index, index) &&
+                     eliminated_into(false_index_float, index_float),
+                 "The recomputed index math in the false branch should be eliminated.");
+    LUISA_ASSERT(!gvn_info.eliminated_instructions.contains(true_square) &&
+                     !gvn_info.eliminated_instructions.contains(false_square),
+                 "Expressions in sibling branches should not be merged.");
+
+    // the users now refer to the surviving instructions
+    LUISA_ASSERT(true_sum->operand(0) == a && true_sum->operand(1) == a, "Expected a + a in the true branch.");
+    LUISA_ASSERT(false_product->operand(0) == a && false_product->operand(1) == index_float,
+                 "Expected a * float(index) in the false branch.");
+    LUISA_ASSERT(true_write->operand(1) == tid && false_write->operand(1) == tid,
+                 "Both writes should use the dispatch id extracted in the entry block.");
+}
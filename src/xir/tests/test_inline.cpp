@@ -0,0 +1,82 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main() {
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    xir::Module module;
+    auto u32_zero = module.create_constant_zero(Type::of<uint>());
+    auto f32_two = module.create_constant(Type::of<float>(), std::array{2.f}.data());
+
+    xir::Builder b;
+
+    // callable scale(x) { return x * 2 }
+    auto scale = module.create_callable(Type::of<float>());
+    scale->set_name("scale");
+    auto x = scale->create_value_argument(Type::of<float>());
+    b.set_insertion_point(scale->create_body_block());
+    b.return_(b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {x, f32_two}));
+
+    // kernel {
+    //   v = float(dispatch_id().x)
+    //   outline { s = scale(v); v = s; t = s + s }
+    //   buffer[dispatch_id().x] = scale(t)
+    // }
+    auto kernel = module.create_kernel();
+    auto buffer = kernel->create_resource_argument(Type::of<Buffer<float>>());
+    b.set_insertion_point(kernel->create_body_block());
+    auto v = b.alloca_local(Type::of<float>());
+    auto tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT, {xir::SPR_DispatchID::create(), u32_zero});
+    b.store(v, b.static_cast_(Type::of<float>(), tid));
+    auto outline = b.outline();
+    b.set_insertion_point(outline->create_target_block());
+    auto s = b.call(Type::of<float>(), scale, {b.load(Type::of<float>(), v)});
+    b.store(v, s);
+    auto t = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {s, s});
+    auto merge = outline->create_merge_block();
+    b.br(merge);
+    b.set_insertion_point(merge);
+    auto r = b.call(Type::of<float>(), scale, {t});
+    b.call(xir::ResourceWriteOp::BUFFER_WRITE, {buffer, tid, r});
+    b.return_void();
+
+    LUISA_INFO("Before outline and inline:\n{}", xir::xir_to_text_translate(&module, true));
+
+    auto outline_info = xir::outline_pass_run_on_module(&module);
+    LUISA_INFO("After outline:\n{}", xir::xir_to_text_translate(&module, true));
+    LUISA_ASSERT(outline_info.outlines.size() == 1u, "The outline region should be outlined.");
+    auto outlined = outline_info.outlines.begin()->second;
+    // v is passed by reference and t is written back through a reference argument
+    LUISA_ASSERT(outlined->arguments().size() == 2u &&
+                     outlined->arguments()[0]->is_reference() &&
+                     outlined->arguments()[1]->is_reference(),
+                 "Unexpected arguments of the outlined function.");
+    LUISA_ASSERT(static_cast<xir::CallableFunction *>(outlined)->is_noinline(),
+                 "The outlined function should be marked noinline.");
+
+    // nothing is inlined with a zero budget
+    auto no_inline_info = xir::inline_pass_run_on_module(&module, 0u);
+    LUISA_ASSERT(no_inline_info.inlined_calls.empty(), "No call should be inlined.");
+
+    auto inline_info = xir::inline_pass_run_on_module(&module);
+    static_cast<void>(xir::dce_pass_run_on_module(&module));
+    LUISA_INFO("After inline:\n{}", xir::xir_to_text_translate(&module, true));
+    // scale is inlined into both callers, while the outlined function is kept although it is small
+    LUISA_ASSERT(inline_info.inlined_calls.size() == 2u, "Unexpected number of inlined calls.");
+    for (auto [_, callee] : inline_info.inlined_calls) {
+        LUISA_ASSERT(callee == scale, "Only the calls to scale should be inlined.");
+    }
+    LUISA_ASSERT(inline_info.removed_functions.size() == 1u &&
+                     inline_info.removed_functions.contains(scale),
+                 "Only scale should be removed.");
+    auto function_count = 0u;
+    for (auto &&f : module.functions()) {
+        static_cast<void>(f);
+        function_count++;
+    }
+    LUISA_ASSERT(function_count == 2u, "The kernel and the outlined function should remain.");
+}
@@ -0,0 +1,72 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+int main() {
+
+    Kernel1D kernel = [](BufferFloat out, ImageFloat image, BindlessVar heap, Float4x4 m) noexcept {
+        auto i = dispatch_id().x;
+        auto slot = i % 4u;
+        auto sum = def(0.f);
+        auto j = def(0u);
+        $loop {
+            // the bindless queries and the matrix math are invariant and executed on every iteration
+            auto n = heap.tex2d(slot).size().x;
+            auto w = (m * make_float4(cast<float>(i), 1.f, 0.f, 1.f)).x;
+            auto base = heap.buffer<float>(slot).read(0u);
+            $if (j >= n) { $break; };
+            sum += heap.buffer<float>(slot).read(j) * w + base;
+            j += 1u;
+        };
+        $for (k, 8u) {
+            // texture size queries are safe to execute speculatively
+            $if (k % 2u == 0u) {
+                auto size = image.size();
+                sum += cast<float>(size.x * size.y);
+            };
+        };
+        out.write(i, sum);
+    };
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    auto module = xir::ast_to_xir_translate(kernel.function()->function(), {});
+    static_cast<void>(xir::dce_pass_run_on_module(module));
+    static_cast<void>(xir::mem2reg_pass_run_on_module(module));
+    static_cast<void>(xir::gvn_pass_run_on_module(module));
+    LUISA_INFO("Before LICM:\n{}", xir::xir_to_text_translate(module, true));
+
+    auto licm_info = xir::licm_pass_run_on_module(module);
+    LUISA_INFO("After LICM:\n{}", xir::xir_to_text_translate(module, true));
+    LUISA_INFO("Hoisted {} loop-invariant instruction(s).", licm_info.hoisted_instructions.size());
+
+    auto kernel_function = &module->functions().front();
+    auto loop_info = xir::compute_loop_info(kernel_function);
+    LUISA_ASSERT(loop_info.loops().size() == 2u && loop_info.top_level_loops().size() == 2u,
+                 "Unexpected loop structure.");
+    kernel_function->definition()->traverse_instructions([&](xir::Instruction *inst) noexcept {
+        auto in_loop = loop_info.loop(inst->parent_block()) != nullptr;
+        switch (inst->derived_instruction_tag()) {
+            case xir::DerivedInstructionTag::RESOURCE_QUERY: {
+                LUISA_ASSERT(!in_loop, "Resource queries should be hoisted out of the loops.");
+                break;
+            }
+            case xir::DerivedInstructionTag::ARITHMETIC: {
+                if (static_cast<xir::ArithmeticInst *>(inst)->op() == xir::ArithmeticOp::MATRIX_LINALG_MUL) {
+                    LUISA_ASSERT(!in_loop, "Matrix math should be hoisted out of the loop.");
+                }
+                break;
+            }
+            case xir::DerivedInstructionTag::RESOURCE_READ: {
+                // only the read at a constant index is invariant
+                auto index = inst->operand(2);
+                LUISA_ASSERT(in_loop == (index->derived_value_tag() != xir::DerivedValueTag::CONSTANT),
+                             "Only invariant resource reads should be hoisted.");
+                break;
+            }
+            default: break;
+        }
+    });
+}
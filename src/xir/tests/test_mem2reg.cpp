@@ -0,0 +1,141 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+[[nodiscard]] static xir::Value *incoming_from(xir::PhiInst *phi, xir::BasicBlock *block) noexcept {
+    for (auto i = 0u; i < phi->incoming_count(); i++) {
+        if (auto incoming = phi->incoming(i); incoming.block == block) { return incoming.value; }
+    }
+    return nullptr;
+}
+
+int main() {
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    xir::Module module;
+    auto u32_zero = module.create_constant_zero(Type::of<uint>());
+    auto u32_one = module.create_constant_one(Type::of<uint>());
+    auto u32_two = module.create_constant(Type::of<uint>(), std::array{2u}.data());
+    auto u32_eight = module.create_constant(Type::of<uint>(), std::array{8u}.data());
+    auto f32_one = module.create_constant_one(Type::of<float>());
+    auto f32_two = module.create_constant(Type::of<float>(), std::array{2.f}.data());
+
+    xir::Builder b;
+
+    // kernel {
+    //   sum = 1; n = tid; arr: float[2]
+    //   for (; n < 8; n += 1) {
+    //     sum *= 2
+    //     if (n % 2 == 0) { sum += 1 }
+    //   }
+    //   arr[tid % 2] = sum
+    //   buffer[tid] = arr[0] + float(n)
+    // }
+    auto kernel = module.create_kernel();
+    auto buffer = kernel->create_resource_argument(Type::of<Buffer<float>>());
+    auto entry = kernel->create_body_block();
+    b.set_insertion_point(entry);
+    auto tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT, {xir::SPR_DispatchID::create(), u32_zero});
+    auto sum = b.alloca_local(Type::of<float>());
+    auto n = b.alloca_local(Type::of<uint>());
+    auto arr = b.alloca_local(Type::of<std::array<float, 2>>());
+    b.store(sum, f32_one);
+    b.store(n, tid);
+    auto loop = b.loop();
+    auto loop_merge = loop->create_merge_block();
+    auto prepare = loop->create_prepare_block();
+    auto body = loop->create_body_block();
+    auto update = loop->create_update_block();
+    b.set_insertion_point(prepare);
+    auto cond = b.call(Type::of<bool>(), xir::ArithmeticOp::BINARY_LESS, {b.load(Type::of<uint>(), n), u32_eight});
+    b.cond_br(cond, body, loop_merge);
+    b.set_insertion_point(body);
+    auto doubled = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {b.load(Type::of<float>(), sum), f32_two});
+    b.store(sum, doubled);
+    auto parity = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MOD, {b.load(Type::of<uint>(), n), u32_two});
+    auto branch = b.if_(b.call(Type::of<bool>(), xir::ArithmeticOp::BINARY_EQUAL, {parity, u32_zero}));
+    auto if_merge = branch->create_merge_block();
+    auto if_true = branch->create_true_block();
+    b.set_insertion_point(if_true);
+    auto incremented = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {b.load(Type::of<float>(), sum), f32_one});
+    b.store(sum, incremented);
+    b.br(if_merge);
+    auto if_false = branch->create_false_block();
+    b.set_insertion_point(if_false);
+    b.br(if_merge);
+    b.set_insertion_point(if_merge);
+    b.br(update);
+    b.set_insertion_point(update);
+    auto next = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_ADD, {b.load(Type::of<uint>(), n), u32_one});
+    b.store(n, next);
+    b.br(prepare);
+    b.set_insertion_point(loop_merge);
+    auto slot = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MOD, {tid, u32_two});
+    auto arr_store = b.store(b.gep(Type::of<float>(), arr, {slot}), b.load(Type::of<float>(), sum));
+    auto element = b.load(Type::of<float>(), b.gep(Type::of<float>(), arr, {u32_zero}));
+    auto n_float = b.static_cast_(Type::of<float>(), b.load(Type::of<uint>(), n));
+    auto result = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {element, n_float});
+    b.call(xir::ResourceWriteOp::BUFFER_WRITE, {buffer, tid, result});
+    b.return_void();
+
+    auto info = xir::mem2reg_pass_run_on_function(&module, kernel);
+
+    // the scalar variables are promoted, while the array accessed through GEPs stays in memory
+    LUISA_ASSERT(info.promoted_allocas.size() == 2u &&
+                     info.promoted_allocas.contains(sum) &&
+                     info.promoted_allocas.contains(n),
+                 "Only sum and n should be promoted.");
+    auto alloca_count = 0u;
+    auto load_count = 0u;
+    auto store_count = 0u;
+    kernel->traverse_instructions([&](xir::Instruction *inst) noexcept {
+        switch (inst->derived_instruction_tag()) {
+            case xir::DerivedInstructionTag::ALLOCA: alloca_count++; break;
+            case xir::DerivedInstructionTag::LOAD: load_count++; break;
+            case xir::DerivedInstructionTag::STORE: store_count++; break;
+            default: break;
+        }
+    });
+    LUISA_ASSERT(alloca_count == 1u && load_count == 1u && store_count == 1u,
+                 "Only arr and its load and store should remain.");
+
+    // sum is merged at the loop header and after the if; n only at the loop header
+    LUISA_ASSERT(info.inserted_phis.size() == 3u, "Expected exactly three phis.");
+    xir::PhiInst *sum_header = nullptr;
+    xir::PhiInst *n_header = nullptr;
+    xir::PhiInst *sum_if = nullptr;
+    for (auto phi : info.inserted_phis) {
+        if (phi->parent_block() == prepare && phi->type() == Type::of<float>()) {
+            sum_header = phi;
+        } else if (phi->parent_block() == prepare && phi->type() == Type::of<uint>()) {
+            n_header = phi;
+        } else if (phi->parent_block() == if_merge && phi->type() == Type::of<float>()) {
+            sum_if = phi;
+        }
+    }
+    LUISA_ASSERT(sum_header != nullptr && n_header != nullptr && sum_if != nullptr,
+                 "Phis are inserted at unexpected blocks.");
+    LUISA_ASSERT(sum_header->incoming_count() == 2u &&
+                     incoming_from(sum_header, entry) == f32_one &&
+                     incoming_from(sum_header, update) == sum_if,
+                 "sum should merge 1 from the entry and the if result from the update block.");
+    LUISA_ASSERT(n_header->incoming_count() == 2u &&
+                     incoming_from(n_header, entry) == tid &&
+                     incoming_from(n_header, update) == next,
+                 "n should merge tid from the entry and n + 1 from the update block.");
+    LUISA_ASSERT(sum_if->incoming_count() == 2u &&
+                     incoming_from(sum_if, if_true) == incremented &&
+                     incoming_from(sum_if, if_false) == doubled,
+                 "sum after the if should merge sum * 2 + 1 and sum * 2.");
+
+    // the loads are replaced with the reaching definitions
+    LUISA_ASSERT(cond->operand(0) == n_header && parity->operand(0) == n_header && next->operand(0) == n_header,
+                 "The loads of n in the loop should use the header phi.");
+    LUISA_ASSERT(doubled->operand(0) == sum_header && incremented->operand(0) == doubled,
+                 "The loads of sum in the loop should use the latest definitions.");
+    LUISA_ASSERT(arr_store->value() == sum_header && n_float->operand(0) == n_header,
+                 "The loads after the loop should use the header phis.");
+}
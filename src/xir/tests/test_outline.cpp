@@ -0,0 +1,163 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+// runs the outline pass on hand-built regions, including a nested one and one that cannot be outlined
+static void test_outline_pass() noexcept {
+
+    xir::Module module;
+    auto u32_zero = module.create_constant_zero(Type::of<uint>());
+    auto u32_two = module.create_constant(Type::of<uint>(), std::array{2u}.data());
+    auto f32_one = module.create_constant_one(Type::of<float>());
+    auto f32_two = module.create_constant(Type::of<float>(), std::array{2.f}.data());
+
+    xir::Builder b;
+
+    // kernel {
+    //   v = float(tid)
+    //   outline {
+    //     if (tid % 2 == 0) { v *= 2 }
+    //     outline { v += 1 }
+    //     t = v + 1
+    //   }
+    //   outline { sync_block() }
+    //   buffer[tid] = t
+    // }
+    auto kernel = module.create_kernel();
+    auto buffer = kernel->create_resource_argument(Type::of<Buffer<float>>());
+    b.set_insertion_point(kernel->create_body_block());
+    auto tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT, {xir::SPR_DispatchID::create(), u32_zero});
+    auto v = b.alloca_local(Type::of<float>());
+    b.store(v, b.static_cast_(Type::of<float>(), tid));
+
+    auto outer = b.outline();
+    b.set_insertion_point(outer->create_target_block());
+    auto parity = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MOD, {tid, u32_two});
+    auto branch = b.if_(b.call(Type::of<bool>(), xir::ArithmeticOp::BINARY_EQUAL, {parity, u32_zero}));
+    auto if_merge = branch->create_merge_block();
+    b.set_insertion_point(branch->create_true_block());
+    b.store(v, b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_MUL, {b.load(Type::of<float>(), v), f32_two}));
+    b.br(if_merge);
+    b.set_insertion_point(branch->create_false_block());
+    b.br(if_merge);
+    b.set_insertion_point(if_merge);
+    auto inner = b.outline();
+    b.set_insertion_point(inner->create_target_block());
+    b.store(v, b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {b.load(Type::of<float>(), v), f32_one}));
+    auto inner_merge = inner->create_merge_block();
+    b.br(inner_merge);
+    b.set_insertion_point(inner_merge);
+    auto t = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {b.load(Type::of<float>(), v), f32_one});
+    auto outer_merge = outer->create_merge_block();
+    b.br(outer_merge);
+
+    b.set_insertion_point(outer_merge);
+    auto barrier = b.outline();
+    auto barrier_body = barrier->create_target_block();
+    b.set_insertion_point(barrier_body);
+    b.call(nullptr, xir::ThreadGroupOp::SYNCHRONIZE_BLOCK, {});
+    auto barrier_merge = barrier->create_merge_block();
+    b.br(barrier_merge);
+    b.set_insertion_point(barrier_merge);
+    auto write = b.call(xir::ResourceWriteOp::BUFFER_WRITE, {buffer, tid, t});
+    b.return_void();
+
+    auto info = xir::outline_pass_run_on_module(&module);
+
+    // both regions are outlined, the nested one from inside the outer callable,
+    // while the region with the barrier stays in the kernel
+    LUISA_ASSERT(info.outlines.size() == 2u && info.outlines.contains(outer) && info.outlines.contains(inner),
+                 "The outer and the nested regions should be outlined.");
+    LUISA_ASSERT(barrier->target_block() == barrier_body, "The region with the barrier should be left in place.");
+    auto outer_callee = info.outlines.at(outer);
+    auto inner_callee = info.outlines.at(inner);
+    for (auto f : {outer_callee, inner_callee}) {
+        LUISA_ASSERT(f->derived_function_tag() == xir::DerivedFunctionTag::CALLABLE &&
+                         static_cast<xir::CallableFunction *>(f)->is_noinline(),
+                     "Outlined regions should be marked noinline.");
+    }
+
+    // tid is passed by value, v by reference, and t is written back through a reference argument
+    LUISA_ASSERT(outer_callee->arguments().size() == 3u &&
+                     !outer_callee->arguments()[0]->is_reference() &&
+                     outer_callee->arguments()[1]->is_reference() &&
+                     outer_callee->arguments()[2]->is_reference(),
+                 "Unexpected arguments of the outer outlined function.");
+    LUISA_ASSERT(inner_callee->arguments().size() == 1u && inner_callee->arguments()[0]->is_reference(),
+                 "Unexpected arguments of the nested outlined function.");
+
+    // the outline instructions now call the new functions, and t is reloaded after the call
+    auto calls = [](xir::OutlineInst *outline, xir::Function *f) noexcept {
+        auto &&first = outline->target_block()->instructions().front();
+        return first.derived_instruction_tag() == xir::DerivedInstructionTag::CALL &&
+               static_cast<xir::CallInst &>(first).callee() == f;
+    };
+    LUISA_ASSERT(calls(outer, outer_callee) && calls(inner, inner_callee),
+                 "The outline instructions should call the outlined functions.");
+    auto computes_t = false;
+    outer_callee->definition()->traverse_instructions([&](xir::Instruction *inst) noexcept {
+        computes_t |= inst == t;
+    });
+    LUISA_ASSERT(computes_t, "t should be computed in the outer outlined function.");
+    auto written = write->operand(2);
+    LUISA_ASSERT(written->derived_value_tag() == xir::DerivedValueTag::INSTRUCTION &&
+                     static_cast<xir::Instruction *>(written)->derived_instruction_tag() == xir::DerivedInstructionTag::LOAD,
+                 "The write should use t loaded from the output variable.");
+
+    // the inliner keeps the small outlined functions out of their callers
+    auto inline_info = xir::inline_pass_run_on_module(&module);
+    LUISA_ASSERT(inline_info.inlined_calls.empty() && inline_info.removed_functions.empty(),
+                 "Outlined functions should not be inlined back.");
+}
+
+int main() {
+
+    Callable twice = [](Float x) noexcept {
+        return x * 2.f;
+    };
+
+    Kernel1D kernel = [&](BufferFloat out) noexcept {
+        auto i = dispatch_id().x;
+        auto x = def(cast<float>(i));
+        x = twice(x);
+        $outline {
+            x += 1.f;
+        };
+        out.write(i, x);
+    };
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    auto module = xir::ast_to_xir_translate(kernel.function()->function(), {});
+    auto count_callables = [&](bool noinline) noexcept {
+        auto count = 0u;
+        for (auto &&f : module->functions()) {
+            if (f.derived_function_tag() == xir::DerivedFunctionTag::CALLABLE &&
+                static_cast<xir::CallableFunction &>(f).is_noinline() == noinline) {
+                count++;
+            }
+        }
+        return count;
+    };
+    // only the callable created by $outline is marked noinline
+    LUISA_ASSERT(count_callables(true) == 1u && count_callables(false) == 1u,
+                 "Expected one noinline and one regular callable.");
+
+    // the mark survives serialization
+    auto text = xir::xir_to_text_translate(module, true);
+    LUISA_ASSERT(text.find("noinline callable") != luisa::string::npos, "The noinline mark is not printed.");
+    auto from_binary = xir::binary_to_xir_translate(xir::xir_to_binary_translate(module));
+    LUISA_ASSERT(from_binary != nullptr && xir::xir_to_text_translate(from_binary, true) == text,
+                 "Binary round trip mismatch.");
+
+    // the small regular callable is inlined, while the outlined one is kept although it is even smaller
+    auto inline_info = xir::inline_pass_run_on_module(module);
+    LUISA_ASSERT(inline_info.inlined_calls.size() == 1u, "Only the call to twice should be inlined.");
+    LUISA_ASSERT(count_callables(true) == 1u && count_callables(false) == 0u,
+                 "The outlined callable should be kept.");
+    LUISA_ASSERT(inline_info.removed_functions.size() == 1u, "Only twice should be removed.");
+
+    test_outline_pass();
+}
@@ -0,0 +1,130 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+[[nodiscard]] static luisa::string replace_first(luisa::string s, luisa::string_view from, luisa::string_view to) noexcept {
+    auto pos = s.find(from);
+    LUISA_ASSERT(pos != luisa::string::npos, "'{}' not found in the serialized module.", from);
+    return s.replace(pos, from.size(), to);
+}
+
+int main() {
+
+    Callable lerp = [](Float a, Float b, Float t) noexcept {
+        return a * (1.f - t) + b * t;
+    };
+
+    Kernel1D kernel = [&](BufferFloat out, ImageFloat image, Float4x4 m) noexcept {
+        set_block_size(128u);
+        auto i = dispatch_id().x;
+        auto sum = def(0.f);
+        $for (k, 8u) {
+            $switch (cast<int>(k % 3u)) {
+                $case (0) { sum += lerp(sum, cast<float>(k), .5f); };
+                $case (1) { sum -= (m * make_float4(image.read(make_uint2(i, k)).xyz(), 1.f)).w; };
+                $default { $continue; };
+            };
+        };
+        $if (sum < 0.f) {
+            device_assert(i != 0u, "unexpected negative sum");
+            sum = 0.f;
+        };
+        out.write(i, sum);
+    };
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    auto module = xir::ast_to_xir_translate(kernel.function()->function(), {});
+    static_cast<void>(xir::dce_pass_run_on_module(module));
+    static_cast<void>(xir::mem2reg_pass_run_on_module(module));
+    auto text = xir::xir_to_text_translate(module, true);
+    LUISA_INFO("Original module:\n{}", text);
+
+    // the round trips should reproduce the module exactly, including the metadata
+    auto binary = xir::xir_to_binary_translate(module);
+    auto from_binary = xir::binary_to_xir_translate(binary);
+    LUISA_ASSERT(from_binary != nullptr, "Failed to load XIR binary.");
+    LUISA_ASSERT(xir::xir_to_text_translate(from_binary, true) == text, "Binary round trip mismatch.");
+    LUISA_ASSERT(xir::xir_to_binary_translate(from_binary) == binary, "Binary encoding is not deterministic.");
+
+    auto json = xir::xir_to_json_translate(module);
+    auto from_json = xir::json_to_xir_translate(json);
+    LUISA_ASSERT(from_json != nullptr, "Failed to load XIR JSON.");
+    LUISA_ASSERT(xir::xir_to_text_translate(from_json, true) == text, "JSON round trip mismatch.");
+    LUISA_ASSERT(xir::xir_to_json_translate(from_json) == json, "JSON encoding is not deterministic.");
+    LUISA_INFO("Serialized module: {} byte(s) in binary, {} byte(s) in JSON.", binary.size(), json.size());
+
+    // truncated data are rejected without aborting
+    auto stride = std::max<size_t>(binary.size() / 64u, 1u);
+    for (auto n = static_cast<size_t>(0u); n < binary.size(); n += stride) {
+        auto truncated = luisa::span<const std::byte>{binary.data(), n};
+        LUISA_ASSERT(xir::binary_to_xir_translate(truncated) == nullptr,
+                     "Truncated XIR binary ({} of {} byte(s)) should be rejected.", n, binary.size());
+    }
+    LUISA_ASSERT(xir::binary_to_xir_translate(luisa::span<const std::byte>{binary.data(), binary.size() - 1u}) == nullptr,
+                 "XIR binary missing the last byte should be rejected.");
+
+    // so are trailing data
+    auto padded = binary;
+    padded.emplace_back(std::byte{0u});
+    LUISA_ASSERT(xir::binary_to_xir_translate(padded) == nullptr, "XIR binary with trailing data should be rejected.");
+
+    // invalid type descriptions are rejected before they reach the type registry
+    auto replace_bytes = [](luisa::vector<std::byte> data, luisa::string_view from, luisa::string_view to) noexcept {
+        LUISA_ASSERT(from.size() == to.size(), "Replacements in the binary should keep the size.");
+        auto iter = std::search(data.begin(), data.end(), from.begin(), from.end(),
+                                [](std::byte b, char c) noexcept { return b == static_cast<std::byte>(c); });
+        LUISA_ASSERT(iter != data.end(), "'{}' not found in the serialized module.", from);
+        std::transform(to.begin(), to.end(), iter, [](char c) noexcept { return static_cast<std::byte>(c); });
+        return data;
+    };
+    LUISA_ASSERT(xir::binary_to_xir_translate(replace_bytes(binary, "vector<float,4>", "vector<float,5>")) == nullptr,
+                 "XIR binary with an invalid vector type should be rejected.");
+    LUISA_ASSERT(xir::binary_to_xir_translate(replace_bytes(binary, "matrix<4>", "matrix<0>")) == nullptr,
+                 "XIR binary with an invalid matrix type should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"vector<float,4>\"", "\"vector<float,5>\"")) == nullptr,
+                 "XIR JSON with an invalid vector type should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"matrix<4>\"", "\"struct<0,int>\"")) == nullptr,
+                 "XIR JSON with a zero struct alignment should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"vector<float,4>\"", "\"vector<float,4>junk\"")) == nullptr,
+                 "XIR JSON with junk after a type description should be rejected.");
+
+    // so are unknown names, missing fields, and documents that are not JSON
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"tag\": \"kernel\"", "\"tag\": \"kernal\"")) == nullptr,
+                 "XIR JSON with an unknown function tag should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"tag\": \"arithmetic\"", "\"tag\": \"arithmetics\"")) == nullptr,
+                 "XIR JSON with an unknown instruction should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"op\": \"", "\"op\": \"no_such_")) == nullptr,
+                 "XIR JSON with an unknown operation should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(replace_first(json, "\"body\":", "\"bodies\":")) == nullptr,
+                 "XIR JSON missing a field should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(luisa::string_view{json}.substr(0u, json.size() / 2u)) == nullptr,
+                 "Truncated XIR JSON should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate("not json") == nullptr, "Invalid JSON should be rejected.");
+
+    // ids of the wrong kind are rejected, e.g., a branch to an instruction instead of a block
+    xir::Module bad_module;
+    auto bad_kernel = bad_module.create_kernel();
+    auto bad_out = bad_kernel->create_resource_argument(Type::of<Buffer<uint>>());
+    xir::Builder b;
+    b.set_insertion_point(bad_kernel->create_body_block());
+    auto tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT,
+                      {xir::SPR_DispatchID::create(), bad_module.create_constant_zero(Type::of<uint>())});
+    b.call(xir::ResourceWriteOp::BUFFER_WRITE, {bad_out, tid, tid});
+    auto exit = b.br();
+    b.set_insertion_point(exit->create_target_block());
+    b.return_void();
+    LUISA_ASSERT(xir::binary_to_xir_translate(xir::xir_to_binary_translate(&bad_module)) != nullptr,
+                 "The well-formed module should be loaded.");
+    exit->set_operand(xir::BranchInst::operand_index_target, tid);
+    LUISA_ASSERT(xir::binary_to_xir_translate(xir::xir_to_binary_translate(&bad_module)) == nullptr,
+                 "XIR binary with a branch to a non-block should be rejected.");
+    LUISA_ASSERT(xir::json_to_xir_translate(xir::xir_to_json_translate(&bad_module)) == nullptr,
+                 "XIR JSON with a branch to a non-block should be rejected.");
+
+    // data written by other versions are rejected
+    binary[4] = static_cast<std::byte>(0xffu);
+    LUISA_ASSERT(xir::binary_to_xir_translate(binary) == nullptr, "Incompatible XIR binary should be rejected.");
+}
@@ -0,0 +1,113 @@
+#include <luisa/luisa-compute.h>
+
+using namespace luisa;
+using namespace luisa::compute;
+
+struct Pair {
+    uint a;
+    float b;
+};
+
+struct Nested {
+    Pair pair;
+    float w;
+};
+
+LUISA_STRUCT(Pair, a, b) {};
+LUISA_STRUCT(Nested, pair, w) {};
+
+int main() {
+
+    xir::Pool pool;
+    xir::PoolGuard guard{&pool};
+
+    xir::Module module;
+    auto u32_zero = module.create_constant_zero(Type::of<uint>());
+    auto u32_one = module.create_constant_one(Type::of<uint>());
+    auto u32_four = module.create_constant(Type::of<uint>(), std::array{4u}.data());
+    auto f32_one = module.create_constant_one(Type::of<float>());
+    auto pair_constant = module.create_constant(Type::of<Pair>(), std::array{Pair{7u, 2.f}}.data());
+
+    xir::Builder b;
+
+    // kernel {
+    //   n: Nested; n.pair.b = 1; x = n.pair.b
+    //   q: Pair; q = Pair{7, 2}; y = q.b
+    //   arr: float[4]; arr[tid % 4] = x; z = arr[0]
+    //   buffer[tid] = x + y + z
+    // }
+    auto kernel = module.create_kernel();
+    auto buffer = kernel->create_resource_argument(Type::of<Buffer<float>>());
+    b.set_insertion_point(kernel->create_body_block());
+    auto tid = b.call(Type::of<uint>(), xir::ArithmeticOp::EXTRACT, {xir::SPR_DispatchID::create(), u32_zero});
+    auto n = b.alloca_local(Type::of<Nested>());
+    b.store(b.gep(Type::of<float>(), n, {u32_zero, u32_one}), f32_one);
+    auto x = b.load(Type::of<float>(), b.gep(Type::of<float>(), n, {u32_zero, u32_one}));
+    auto q = b.alloca_local(Type::of<Pair>());
+    b.store(q, pair_constant);
+    auto y = b.load(Type::of<float>(), b.gep(Type::of<float>(), q, {u32_one}));
+    auto arr = b.alloca_local(Type::of<std::array<float, 4>>());
+    auto dynamic_index = b.call(Type::of<uint>(), xir::ArithmeticOp::BINARY_MOD, {tid, u32_four});
+    b.store(b.gep(Type::of<float>(), arr, {dynamic_index}), x);
+    auto z = b.load(Type::of<float>(), b.gep(Type::of<float>(), arr, {u32_zero}));
+    auto xy = b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {x, y});
+    b.call(xir::ResourceWriteOp::BUFFER_WRITE, {buffer, tid, b.call(Type::of<float>(), xir::ArithmeticOp::BINARY_ADD, {xy, z})});
+    b.return_void();
+
+    auto info = xir::sroa_pass_run_on_function(&module, kernel);
+
+    // n is split into the only accessed field n.pair, which is further split into n.pair.b;
+    // q is split into both fields as it is stored as a whole; arr is dynamically indexed and kept
+    LUISA_ASSERT(info.split_allocas.size() == 3u, "Expected n, n.pair and q to be split.");
+    LUISA_ASSERT(info.split_allocas.contains(n) && info.split_allocas.at(n).size() == 1u,
+                 "n should be split into n.pair only.");
+    auto n_pair = info.split_allocas.at(n).front();
+    LUISA_ASSERT(n_pair->type() == Type::of<Pair>() && info.split_allocas.contains(n_pair) &&
+                     info.split_allocas.at(n_pair).size() == 1u,
+                 "n.pair should be split into n.pair.b only.");
+    auto n_pair_b = info.split_allocas.at(n_pair).front();
+    LUISA_ASSERT(n_pair_b->type() == Type::of<float>(), "Unexpected type of n.pair.b.");
+    LUISA_ASSERT(info.split_allocas.contains(q) && info.split_allocas.at(q).size() == 2u,
+                 "q should be split into both fields.");
+    auto q_a = info.split_allocas.at(q)[0];
+    auto q_b = info.split_allocas.at(q)[1];
+    LUISA_ASSERT(q_a->type() == Type::of<uint>() && q_b->type() == Type::of<float>(),
+                 "Unexpected types of the fields of q.");
+    LUISA_ASSERT(!info.split_allocas.contains(arr), "The dynamically indexed array should be kept.");
+
+    // the field accesses now go to the scalar alloca's directly
+    LUISA_ASSERT(x->variable() == n_pair_b, "x should be loaded from n.pair.b.");
+    LUISA_ASSERT(y->variable() == q_b, "y should be loaded from q.b.");
+
+    // exactly the scalar fields and the array remain, and the whole-aggregate
+    // store is replaced by per-field stores of the split constant
+    auto alloca_count = 0u;
+    luisa::vector<xir::StoreInst *> stores;
+    kernel->traverse_instructions([&](xir::Instruction *inst) noexcept {
+        switch (inst->derived_instruction_tag()) {
+            case xir::DerivedInstructionTag::ALLOCA: {
+                auto alloca = static_cast<xir::AllocaInst *>(inst);
+                LUISA_ASSERT(alloca == n_pair_b || alloca == q_a || alloca == q_b || alloca == arr,
+                             "Unexpected remaining alloca.");
+                alloca_count++;
+                break;
+            }
+            case xir::DerivedInstructionTag::STORE: {
+                stores.emplace_back(static_cast<xir::StoreInst *>(inst));
+                break;
+            }
+            default: break;
+        }
+    });
+    LUISA_ASSERT(alloca_count == 4u, "Expected n.pair.b, q.a, q.b and arr to remain.");
+    LUISA_ASSERT(stores.size() == 4u, "Expected stores to n.pair.b, q.a, q.b and arr.");
+    LUISA_ASSERT(stores[0]->variable() == n_pair_b && stores[0]->value() == f32_one,
+                 "n.pair.b should be stored 1.");
+    LUISA_ASSERT(stores[1]->variable() == q_a && stores[1]->value()->derived_value_tag() == xir::DerivedValueTag::CONSTANT &&
+                     static_cast<xir::Constant *>(stores[1]->value())->as<uint>() == 7u,
+                 "q.a should be stored 7.");
+    LUISA_ASSERT(stores[2]->variable() == q_b && stores[2]->value()->derived_value_tag() == xir::DerivedValueTag::CONSTANT &&
+                     static_cast<xir::Constant *>(stores[2]->value())->as<float>() == 2.f,
+                 "q.b should be stored 2.");
+    LUISA_ASSERT(static_cast<xir::GEPInst *>(stores[3]->variable())->base() == arr, "arr should still be stored through a GEP.");
+}
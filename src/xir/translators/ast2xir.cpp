@@ -1147,7 +1147,9 @@ public:
                     return kernel;
                 }
                 case ASTFunction::Tag::CALLABLE: {
-                    return _module->create_callable(f.return_type());
+                    auto callable = _module->create_callable(f.return_type());
+                    callable->set_noinline(f.outlined());
+                    return callable;
                 }
                 case ASTFunction::Tag::RASTER_STAGE: LUISA_NOT_IMPLEMENTED();
             }
@@ -0,0 +1,226 @@
+#include <limits>
+
+#include <luisa/core/logging.h>
+#include <luisa/xir/translators/binary2xir.h>
+
+#include "serialized_module.h"
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+// reads the encoding written by the `BinaryWriter` in xir2binary.cpp. Reads past the end or of
+// invalid encodings mark the reader as failed instead of aborting, after which all reads return
+// zeros (and hence empty lists), so that the caller can simply check `failed()` and bail out.
+class BinaryReader {
+
+private:
+    luisa::span<const std::byte> _data;
+    size_t _offset{0u};
+    bool _failed{false};
+
+public:
+    explicit BinaryReader(luisa::span<const std::byte> data) noexcept : _data{data} {}
+
+    void fail(luisa::string_view reason) noexcept {
+        if (!_failed) {
+            LUISA_WARNING_WITH_LOCATION("Malformed XIR binary at offset {}: {}.", _offset, reason);
+            _failed = true;
+        }
+    }
+
+    [[nodiscard]] bool failed() const noexcept { return _failed; }
+
+    [[nodiscard]] uint32_t read_u8() noexcept {
+        if (_failed) { return 0u; }
+        if (_offset >= _data.size()) {
+            fail("unexpected end of data");
+            return 0u;
+        }
+        return static_cast<uint32_t>(_data[_offset++]);
+    }
+
+    [[nodiscard]] uint32_t read_u32() noexcept {
+        auto x = 0u;
+        for (auto i = 0u; i < 4u; i++) { x |= read_u8() << (i * 8u); }
+        return x;
+    }
+
+    [[nodiscard]] uint64_t read_uint() noexcept {
+        auto x = static_cast<uint64_t>(0u);
+        for (auto shift = 0u;; shift += 7u) {
+            if (shift >= 64u) {
+                fail("invalid varint");
+                return 0u;
+            }
+            auto byte = read_u8();
+            x |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+            if ((byte & 0x80u) == 0u) { break; }
+        }
+        return x;
+    }
+
+    [[nodiscard]] uint32_t read_u32_uint() noexcept {
+        auto x = read_uint();
+        if (x > std::numeric_limits<uint32_t>::max()) {
+            fail("integer out of range");
+            return 0u;
+        }
+        return static_cast<uint32_t>(x);
+    }
+
+    [[nodiscard]] int64_t read_int() noexcept {
+        auto x = read_uint();
+        return static_cast<int64_t>(x >> 1u) ^ -static_cast<int64_t>(x & 1u);
+    }
+
+    [[nodiscard]] size_t read_size() noexcept {
+        auto size = read_uint();
+        // every element takes at least one byte, so larger sizes must be corrupted
+        if (size > _data.size() - _offset) {
+            fail("invalid size");
+            return 0u;
+        }
+        return static_cast<size_t>(size);
+    }
+
+    // reads an enum encoded in a byte, which must be in [first, last]
+    template<typename T>
+    [[nodiscard]] T read_tag(T first, T last) noexcept {
+        auto x = read_u8();
+        if (x < static_cast<uint32_t>(first) || x > static_cast<uint32_t>(last)) {
+            fail("invalid tag");
+            return first;
+        }
+        return static_cast<T>(x);
+    }
+
+    [[nodiscard]] luisa::span<const std::byte> read_bytes(size_t size) noexcept {
+        if (_failed) { return {}; }
+        if (size > _data.size() - _offset) {
+            fail("unexpected end of data");
+            return {};
+        }
+        auto bytes = _data.subspan(_offset, size);
+        _offset += size;
+        return bytes;
+    }
+
+    [[nodiscard]] luisa::string read_string() noexcept {
+        auto bytes = read_bytes(read_size());
+        return luisa::string{reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+    }
+
+    [[nodiscard]] luisa::vector<uint32_t> read_ids() noexcept {
+        luisa::vector<uint32_t> ids(read_size());
+        for (auto &id : ids) { id = read_u32_uint(); }
+        return ids;
+    }
+
+    [[nodiscard]] luisa::vector<SerializedMetadata> read_metadata() noexcept {
+        luisa::vector<SerializedMetadata> list(read_size());
+        for (auto &m : list) {
+            m.tag = read_tag(DerivedMetadataTag::NAME, DerivedMetadataTag::COMMENT);
+            m.text = read_string();
+            m.line = m.tag == DerivedMetadataTag::LOCATION ? static_cast<int>(read_int()) : -1;
+        }
+        return list;
+    }
+
+    [[nodiscard]] bool eof() const noexcept { return _offset == _data.size(); }
+};
+
+}// namespace detail
+
+Module *binary_to_xir_translate(luisa::span<const std::byte> data) noexcept {
+    detail::BinaryReader r{data};
+    if (data.size() < 8u || r.read_u32() != detail::serialized_module_magic) {
+        LUISA_WARNING_WITH_LOCATION("Invalid XIR binary.");
+        return nullptr;
+    }
+    if (auto version = r.read_u32(); version != detail::serialized_module_version) {
+        LUISA_WARNING_WITH_LOCATION("Unsupported XIR binary version {} (expected {}).",
+                                    version, detail::serialized_module_version);
+        return nullptr;
+    }
+    detail::SerializedModule m;
+    m.types.resize(r.read_size());
+    for (auto &t : m.types) {
+        t.is_custom = r.read_u8() != 0u;
+        t.description = r.read_string();
+    }
+    if (r.failed()) { return nullptr; }
+    m.constants.resize(r.read_size());
+    for (auto &c : m.constants) {
+        c.type = r.read_u32_uint();
+        // the size of the data is given by the type, whose description is validated without parsing it into a type
+        auto size = detail::serialized_constant_type_size(m, c.type);
+        if (r.failed() || !size) {
+            r.fail("invalid constant type");
+            return nullptr;
+        }
+        auto bytes = r.read_bytes(*size);
+        c.data.assign(bytes.begin(), bytes.end());
+        c.metadata = r.read_metadata();
+    }
+    m.special_registers.resize(r.read_size());
+    for (auto &tag : m.special_registers) {
+        tag = r.read_tag(DerivedSpecialRegisterTag::THREAD_ID, DerivedSpecialRegisterTag::DISPATCH_SIZE);
+    }
+    m.functions.resize(r.read_size());
+    for (auto &f : m.functions) {
+        f.tag = r.read_tag(DerivedFunctionTag::KERNEL, DerivedFunctionTag::EXTERNAL);
+        f.type = r.read_u32_uint();
+        f.block_size = KernelFunction::default_block_size;
+        f.noinline = false;
+        if (f.tag == DerivedFunctionTag::KERNEL) {
+            for (auto i = 0u; i < 3u; i++) { f.block_size[i] = r.read_u32_uint(); }
+        } else if (f.tag == DerivedFunctionTag::CALLABLE) {
+            f.noinline = r.read_u8() != 0u;
+        }
+        f.metadata = r.read_metadata();
+    }
+    for (auto &f : m.functions) {
+        f.arguments.resize(r.read_size());
+        for (auto &a : f.arguments) {
+            a.tag = r.read_tag(DerivedArgumentTag::VALUE, DerivedArgumentTag::RESOURCE);
+            a.type = r.read_u32_uint();
+            a.metadata = r.read_metadata();
+        }
+        f.blocks.resize(r.read_size());
+        auto instruction_count = static_cast<size_t>(0u);
+        for (auto &b : f.blocks) {
+            b.instruction_count = r.read_u32_uint();
+            b.metadata = r.read_metadata();
+            instruction_count += b.instruction_count;
+        }
+        f.body_block = r.read_u32_uint();
+        // every instruction takes at least one byte
+        if (instruction_count > data.size()) {
+            r.fail("invalid instruction count");
+            return nullptr;
+        }
+        f.instructions.resize(instruction_count);
+        for (auto &inst : f.instructions) {
+            // sentinels and autodiff instructions are never serialized
+            inst.tag = r.read_tag(DerivedInstructionTag::IF, DerivedInstructionTag::INTRINSIC);
+            if (inst.tag == DerivedInstructionTag::AUTO_DIFF) { r.fail("unsupported instruction"); }
+            inst.op = r.read_u32_uint();
+            inst.type = r.read_u32_uint();
+            inst.operands = r.read_ids();
+            inst.merge_block = r.read_u32_uint();
+            inst.blocks = r.read_ids();
+            inst.case_values.resize(r.read_size());
+            for (auto &v : inst.case_values) { v = static_cast<int>(r.read_int()); }
+            inst.text = r.read_string();
+            inst.metadata = r.read_metadata();
+        }
+    }
+    m.metadata = r.read_metadata();
+    if (!r.failed() && !r.eof()) { r.fail("trailing data"); }
+    if (r.failed()) { return nullptr; }
+    // the references, tags, and types are validated by the deserializer
+    return detail::deserialize_module(m);
+}
+
+}// namespace luisa::compute::xir
@@ -1,3 +1,296 @@
-//
-// Created by Mike on 2024/11/10.
-//
+#include <limits>
+
+#include <yyjson.h>
+#include <luisa/core/logging.h>
+#include <luisa/xir/translators/json2xir.h>
+
+#include "serialized_module.h"
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+// reads the encoding written by the `JSONWriter` in xir2json.cpp. Missing fields, values of unexpected
+// kinds and unknown names mark the reader as failed instead of aborting, after which the reads return
+// defaults, so that the caller can simply check `failed()` and bail out (like the `BinaryReader`).
+class JSONReader {
+
+private:
+    bool _failed{false};
+
+public:
+    void fail(luisa::string_view reason) noexcept {
+        if (!_failed) {
+            LUISA_WARNING_WITH_LOCATION("Malformed XIR JSON: {}.", reason);
+            _failed = true;
+        }
+    }
+
+    [[nodiscard]] bool failed() const noexcept { return _failed; }
+
+private:
+    [[nodiscard]] yyjson_val *_get(yyjson_val *obj, const char *key) noexcept {
+        auto v = yyjson_obj_get(obj, key);
+        if (v == nullptr) { fail(luisa::format("missing field '{}'", key)); }
+        return v;
+    }
+
+    [[nodiscard]] yyjson_val *_get_array(yyjson_val *obj, const char *key) noexcept {
+        auto v = _get(obj, key);
+        if (v != nullptr && !yyjson_is_arr(v)) {
+            fail(luisa::format("field '{}' is not an array", key));
+            return nullptr;
+        }
+        return v;
+    }
+
+    [[nodiscard]] uint32_t _as_uint(yyjson_val *v) noexcept {
+        if (!yyjson_is_uint(v) || yyjson_get_uint(v) > std::numeric_limits<uint32_t>::max()) {
+            fail("expected an unsigned integer");
+            return 0u;
+        }
+        return static_cast<uint32_t>(yyjson_get_uint(v));
+    }
+
+    [[nodiscard]] luisa::string_view _as_string(yyjson_val *v) noexcept {
+        if (!yyjson_is_str(v)) {
+            fail("expected a string");
+            return {};
+        }
+        return luisa::string_view{yyjson_get_str(v), yyjson_get_len(v)};
+    }
+
+    [[nodiscard]] uint32_t _get_uint(yyjson_val *obj, const char *key) noexcept { return _as_uint(_get(obj, key)); }
+    [[nodiscard]] luisa::string_view _get_string(yyjson_val *obj, const char *key) noexcept { return _as_string(_get(obj, key)); }
+
+    // looks up a name with one of the `serialized_*_from_name` functions
+    template<typename T>
+    [[nodiscard]] T _lookup(luisa::optional<T> value, luisa::string_view kind, luisa::string_view name) noexcept {
+        if (!value) {
+            fail(luisa::format("unknown {} '{}'", kind, name));
+            return T{};
+        }
+        return *value;
+    }
+
+    template<typename F>
+    void _for_each(yyjson_val *arr, F &&f) noexcept {
+        size_t index, count;
+        yyjson_val *item;
+        yyjson_arr_foreach(arr, index, count, item) {
+            if (_failed) { return; }
+            f(item);
+        }
+    }
+
+    [[nodiscard]] luisa::vector<uint32_t> _get_ids(yyjson_val *obj, const char *key) noexcept {
+        luisa::vector<uint32_t> ids;
+        if (auto arr = yyjson_obj_get(obj, key)) {
+            if (!yyjson_is_arr(arr)) {
+                fail(luisa::format("field '{}' is not an array", key));
+                return ids;
+            }
+            ids.reserve(yyjson_arr_size(arr));
+            _for_each(arr, [&](yyjson_val *v) noexcept { ids.emplace_back(_as_uint(v)); });
+        }
+        return ids;
+    }
+
+    [[nodiscard]] luisa::vector<SerializedMetadata> _get_metadata(yyjson_val *obj) noexcept {
+        luisa::vector<SerializedMetadata> list;
+        auto arr = yyjson_obj_get(obj, "metadata");
+        if (arr == nullptr) { return list; }
+        if (!yyjson_is_arr(arr)) {
+            fail("field 'metadata' is not an array");
+            return list;
+        }
+        _for_each(arr, [&](yyjson_val *m) noexcept {
+            if (auto name = yyjson_obj_get(m, "name")) {
+                list.emplace_back(SerializedMetadata{DerivedMetadataTag::NAME, luisa::string{_as_string(name)}, -1});
+            } else if (auto file = yyjson_obj_get(m, "location")) {
+                auto line = yyjson_obj_get(m, "line");
+                if (line != nullptr && !yyjson_is_int(line)) { fail("invalid location line"); }
+                list.emplace_back(SerializedMetadata{DerivedMetadataTag::LOCATION, luisa::string{_as_string(file)},
+                                                     line == nullptr ? -1 : yyjson_get_int(line)});
+            } else if (auto comment = yyjson_obj_get(m, "comment")) {
+                list.emplace_back(SerializedMetadata{DerivedMetadataTag::COMMENT, luisa::string{_as_string(comment)}, -1});
+            } else {
+                fail("unknown metadata");
+            }
+        });
+        return list;
+    }
+
+    [[nodiscard]] uint8_t _hex_digit(char c) noexcept {
+        if (c >= '0' && c <= '9') { return static_cast<uint8_t>(c - '0'); }
+        if (c >= 'a' && c <= 'f') { return static_cast<uint8_t>(c - 'a' + 10); }
+        if (c >= 'A' && c <= 'F') { return static_cast<uint8_t>(c - 'A' + 10); }
+        fail("invalid hex digit");
+        return 0u;
+    }
+
+    [[nodiscard]] SerializedInstruction _read_instruction(yyjson_val *obj) noexcept {
+        SerializedInstruction inst{};
+        auto tag = _get_string(obj, "tag");
+        inst.tag = _lookup(serialized_instruction_tag_from_name(tag), "instruction", tag);
+        if (auto op = yyjson_obj_get(obj, "op")) {
+            auto name = _as_string(op);
+            inst.op = _lookup(serialized_op_from_name(inst.tag, name), "operation", name);
+        }
+        inst.type = _get_uint(obj, "type");
+        inst.operands = _get_ids(obj, "operands");
+        if (auto merge = yyjson_obj_get(obj, "merge")) { inst.merge_block = _as_uint(merge); }
+        inst.blocks = _get_ids(obj, "blocks");
+        if (auto cases = yyjson_obj_get(obj, "cases")) {
+            if (!yyjson_is_arr(cases)) { fail("field 'cases' is not an array"); }
+            _for_each(cases, [&](yyjson_val *v) noexcept {
+                if (!yyjson_is_int(v)) { fail("expected an integer case value"); }
+                inst.case_values.emplace_back(yyjson_get_int(v));
+            });
+        }
+        if (auto text = yyjson_obj_get(obj, "text")) { inst.text = _as_string(text); }
+        inst.metadata = _get_metadata(obj);
+        return inst;
+    }
+
+    // the ids in the JSON are informative, but we still check that they match the implied ones
+    void _check_id(yyjson_val *obj, uint32_t &next_id) noexcept {
+        if (auto id = _get_uint(obj, "id"); !_failed && id != next_id) {
+            fail(luisa::format("unexpected value id {} (expected {})", id, next_id));
+        }
+        next_id++;
+    }
+
+    void _read_function_body(SerializedFunction &f, yyjson_val *obj, uint32_t &next_id) noexcept {
+        _for_each(_get_array(obj, "arguments"), [&](yyjson_val *a) noexcept {
+            _check_id(a, next_id);
+            auto tag = _get_string(a, "tag");
+            f.arguments.emplace_back(SerializedArgument{
+                .tag = _lookup(serialized_argument_tag_from_name(tag), "argument tag", tag),
+                .type = _get_uint(a, "type"),
+                .metadata = _get_metadata(a),
+            });
+        });
+        if (f.tag == DerivedFunctionTag::EXTERNAL) { return; }
+        f.body_block = _get_uint(obj, "body");
+        auto blocks = _get_array(obj, "blocks");
+        _for_each(blocks, [&](yyjson_val *b) noexcept {
+            _check_id(b, next_id);
+            f.blocks.emplace_back(SerializedBasicBlock{
+                .instruction_count = static_cast<uint32_t>(yyjson_arr_size(_get_array(b, "instructions"))),
+                .metadata = _get_metadata(b),
+            });
+        });
+        _for_each(blocks, [&](yyjson_val *b) noexcept {
+            _for_each(_get_array(b, "instructions"), [&](yyjson_val *inst) noexcept {
+                _check_id(inst, next_id);
+                f.instructions.emplace_back(_read_instruction(inst));
+            });
+        });
+    }
+
+public:
+    [[nodiscard]] SerializedModule read(yyjson_val *root) noexcept {
+        SerializedModule m;
+        m.metadata = _get_metadata(root);
+        _for_each(_get_array(root, "types"), [&](yyjson_val *t) noexcept {
+            if (auto custom = yyjson_is_obj(t) ? yyjson_obj_get(t, "custom") : nullptr) {
+                m.types.emplace_back(SerializedType{luisa::string{_as_string(custom)}, true});
+            } else {
+                m.types.emplace_back(SerializedType{luisa::string{_as_string(t)}, false});
+            }
+        });
+        auto next_id = 1u;
+        _for_each(_get_array(root, "constants"), [&](yyjson_val *c) noexcept {
+            _check_id(c, next_id);
+            auto hex = _get_string(c, "data");
+            if (hex.size() % 2u != 0u) { fail("invalid constant data"); }
+            luisa::vector<std::byte> data(hex.size() / 2u);
+            for (auto i = 0u; i < data.size(); i++) {
+                data[i] = static_cast<std::byte>((_hex_digit(hex[i * 2u]) << 4u) | _hex_digit(hex[i * 2u + 1u]));
+            }
+            m.constants.emplace_back(SerializedConstant{
+                .type = _get_uint(c, "type"),
+                .data = std::move(data),
+                .metadata = _get_metadata(c),
+            });
+        });
+        _for_each(_get_array(root, "special_registers"), [&](yyjson_val *s) noexcept {
+            _check_id(s, next_id);
+            auto tag = _get_string(s, "tag");
+            m.special_registers.emplace_back(_lookup(serialized_special_register_tag_from_name(tag), "special register", tag));
+        });
+        auto functions = _get_array(root, "functions");
+        _for_each(functions, [&](yyjson_val *f) noexcept {
+            _check_id(f, next_id);
+            auto tag = _get_string(f, "tag");
+            auto &&sf = m.functions.emplace_back(SerializedFunction{
+                .tag = _lookup(serialized_function_tag_from_name(tag), "function tag", tag),
+                .type = _get_uint(f, "type"),
+                .block_size = KernelFunction::default_block_size,
+                .noinline = false,
+                .body_block = 0u,
+                .arguments = {},
+                .blocks = {},
+                .instructions = {},
+                .metadata = _get_metadata(f),
+            });
+            if (auto block_size = yyjson_obj_get(f, "block_size")) {
+                if (!yyjson_is_arr(block_size) || yyjson_arr_size(block_size) != 3u) {
+                    fail("invalid kernel block size");
+                    return;
+                }
+                for (auto i = 0u; i < 3u; i++) { sf.block_size[i] = _as_uint(yyjson_arr_get(block_size, i)); }
+            }
+            if (auto noinline = yyjson_obj_get(f, "noinline")) {
+                if (!yyjson_is_bool(noinline)) { fail("invalid callable noinline flag"); }
+                sf.noinline = yyjson_get_bool(noinline);
+            }
+        });
+        auto index = 0u;
+        _for_each(functions, [&](yyjson_val *f) noexcept {
+            _read_function_body(m.functions[index++], f, next_id);
+        });
+        return m;
+    }
+};
+
+}// namespace detail
+
+Module *json_to_xir_translate(luisa::string_view json) noexcept {
+    yyjson_alc alc{
+        .malloc = [](void *, size_t size) noexcept { return luisa::detail::allocator_allocate(size, 16u); },
+        .realloc = [](void *, void *ptr, size_t, size_t size) noexcept { return luisa::detail::allocator_reallocate(ptr, size, 16u); },
+        .free = [](void *, void *ptr) noexcept { luisa::detail::allocator_deallocate(ptr, 16u); },
+        .ctx = nullptr,
+    };
+    yyjson_read_err err{};
+    auto doc = yyjson_read_opts(const_cast<char *>(json.data()), json.size(), YYJSON_READ_NOFLAG, &alc, &err);
+    if (doc == nullptr) {
+        LUISA_WARNING_WITH_LOCATION("Failed to parse XIR JSON at position {}: {}.", err.pos, err.msg);
+        return nullptr;
+    }
+    auto root = yyjson_doc_get_root(doc);
+    auto format = yyjson_is_obj(root) ? yyjson_obj_get(root, "format") : nullptr;
+    auto version = yyjson_is_obj(root) ? yyjson_obj_get(root, "version") : nullptr;
+    if (format == nullptr || !yyjson_equals_str(format, "xir")) {
+        LUISA_WARNING_WITH_LOCATION("Invalid XIR JSON.");
+        yyjson_doc_free(doc);
+        return nullptr;
+    }
+    if (version == nullptr || !yyjson_is_uint(version) ||
+        yyjson_get_uint(version) != detail::serialized_module_version) {
+        LUISA_WARNING_WITH_LOCATION("Unsupported XIR JSON version (expected {}).",
+                                    detail::serialized_module_version);
+        yyjson_doc_free(doc);
+        return nullptr;
+    }
+    detail::JSONReader r;
+    auto m = r.read(root);
+    yyjson_doc_free(doc);
+    if (r.failed()) { return nullptr; }
+    // the references, tags, and types are validated by the deserializer
+    return detail::deserialize_module(m);
+}
+
+}// namespace luisa::compute::xir
@@ -0,0 +1,1097 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <limits>
+
+#include <luisa/core/logging.h>
+#include <luisa/core/stl/unordered_map.h>
+#include <luisa/ast/type.h>
+#include <luisa/xir/builder.h>
+#include <luisa/xir/metadata/comment.h>
+#include <luisa/xir/metadata/location.h>
+#include <luisa/xir/metadata/name.h>
+
+#include "serialized_module.h"
+
+namespace luisa::compute::xir::detail {
+
+[[nodiscard]] static luisa::vector<SerializedMetadata> serialize_metadata_list(const MetadataMixin *object) noexcept {
+    luisa::vector<SerializedMetadata> list;
+    for (auto &&m : object->metadata_list()) {
+        switch (m.derived_metadata_tag()) {
+            case DerivedMetadataTag::NAME: {
+                auto &&name = static_cast<const NameMD &>(m).name();
+                list.emplace_back(SerializedMetadata{m.derived_metadata_tag(), luisa::string{name}, -1});
+                break;
+            }
+            case DerivedMetadataTag::LOCATION: {
+                auto &&location = static_cast<const LocationMD &>(m);
+                auto file = location.file().string();
+                list.emplace_back(SerializedMetadata{m.derived_metadata_tag(), luisa::string{file}, location.line()});
+                break;
+            }
+            case DerivedMetadataTag::COMMENT: {
+                auto &&comment = static_cast<const CommentMD &>(m).comment();
+                list.emplace_back(SerializedMetadata{m.derived_metadata_tag(), luisa::string{comment}, -1});
+                break;
+            }
+        }
+    }
+    return list;
+}
+
+static void deserialize_metadata_list(MetadataMixin *object, luisa::span<const SerializedMetadata> list) noexcept {
+    // metadata are inserted at the front of the list, so we create them in reverse order
+    for (auto iter = list.rbegin(); iter != list.rend(); ++iter) {
+        switch (iter->tag) {
+            case DerivedMetadataTag::NAME: object->create_metadata<NameMD>()->set_name(iter->text); break;
+            case DerivedMetadataTag::LOCATION: object->create_metadata<LocationMD>()->set_location(iter->text, iter->line); break;
+            case DerivedMetadataTag::COMMENT: object->create_metadata<CommentMD>()->set_comment(iter->text); break;
+            default: break;// rejected by the validation
+        }
+    }
+}
+
+// collects all blocks of the function, including the merge blocks that are not reachable
+static void serialize_collect_blocks(FunctionDefinition *f, luisa::vector<BasicBlock *> &blocks) noexcept {
+    luisa::unordered_set<BasicBlock *> visited;
+    luisa::vector<BasicBlock *> stack{f->body_block()};
+    visited.emplace(f->body_block());
+    auto visit = [&](BasicBlock *block) noexcept {
+        if (block != nullptr && visited.emplace(block).second) { stack.emplace_back(block); }
+    };
+    while (!stack.empty()) {
+        auto block = stack.back();
+        stack.pop_back();
+        blocks.emplace_back(block);
+        for (auto &&inst : block->instructions()) {
+            for (auto op : inst.operand_uses()) {
+                if (auto v = op->value(); v != nullptr && v->derived_value_tag() == DerivedValueTag::BASIC_BLOCK) {
+                    visit(static_cast<BasicBlock *>(v));
+                }
+            }
+            if (auto merge = inst.control_flow_merge()) { visit(merge->merge_block()); }
+            switch (inst.derived_instruction_tag()) {
+                case DerivedInstructionTag::LOOP: {
+                    auto loop = static_cast<LoopInst *>(&inst);
+                    visit(loop->body_block());
+                    visit(loop->update_block());
+                    break;
+                }
+                case DerivedInstructionTag::PHI: {
+                    auto phi = static_cast<PhiInst *>(&inst);
+                    for (auto i = 0u; i < phi->incoming_count(); i++) { visit(phi->incoming(i).block); }
+                    break;
+                }
+                default: break;
+            }
+        }
+    }
+}
+
+[[nodiscard]] static uint32_t serialized_instruction_op(const Instruction *inst) noexcept {
+    switch (inst->derived_instruction_tag()) {
+        case DerivedInstructionTag::ALLOCA: return static_cast<uint32_t>(static_cast<const AllocaInst *>(inst)->space());
+        case DerivedInstructionTag::ATOMIC: return static_cast<uint32_t>(static_cast<const AtomicInst *>(inst)->op());
+        case DerivedInstructionTag::ARITHMETIC: return static_cast<uint32_t>(static_cast<const ArithmeticInst *>(inst)->op());
+        case DerivedInstructionTag::THREAD_GROUP: return static_cast<uint32_t>(static_cast<const ThreadGroupInst *>(inst)->op());
+        case DerivedInstructionTag::RESOURCE_QUERY: return static_cast<uint32_t>(static_cast<const ResourceQueryInst *>(inst)->op());
+        case DerivedInstructionTag::RESOURCE_READ: return static_cast<uint32_t>(static_cast<const ResourceReadInst *>(inst)->op());
+        case DerivedInstructionTag::RESOURCE_WRITE: return static_cast<uint32_t>(static_cast<const ResourceWriteInst *>(inst)->op());
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_READ: return static_cast<uint32_t>(static_cast<const RayQueryObjectReadInst *>(inst)->op());
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: return static_cast<uint32_t>(static_cast<const RayQueryObjectWriteInst *>(inst)->op());
+        case DerivedInstructionTag::CAST: return static_cast<uint32_t>(static_cast<const CastInst *>(inst)->op());
+        case DerivedInstructionTag::INTRINSIC: return static_cast<uint32_t>(static_cast<const IntrinsicInst *>(inst)->op());
+        default: break;
+    }
+    return 0u;
+}
+
+[[nodiscard]] static luisa::string serialized_instruction_text(const Instruction *inst) noexcept {
+    switch (inst->derived_instruction_tag()) {
+        case DerivedInstructionTag::UNREACHABLE: return luisa::string{static_cast<const UnreachableInst *>(inst)->message()};
+        case DerivedInstructionTag::ASSERT: return luisa::string{static_cast<const AssertInst *>(inst)->message()};
+        case DerivedInstructionTag::ASSUME: return luisa::string{static_cast<const AssumeInst *>(inst)->message()};
+        case DerivedInstructionTag::PRINT: return luisa::string{static_cast<const PrintInst *>(inst)->format()};
+        default: break;
+    }
+    return {};
+}
+
+class ModuleSerializer {
+
+private:
+    SerializedModule _module;
+    luisa::unordered_map<const Value *, uint32_t> _value_ids;
+    luisa::unordered_map<const Type *, uint32_t> _type_ids;
+    uint32_t _next_id{1u};
+
+private:
+    uint32_t _assign_id(const Value *value) noexcept {
+        auto [iter, first] = _value_ids.try_emplace(value, _next_id);
+        LUISA_ASSERT(first, "Value is serialized more than once.");
+        return _next_id++;
+    }
+
+    [[nodiscard]] uint32_t _value_id(const Value *value) const noexcept {
+        if (value == nullptr) { return 0u; }
+        auto iter = _value_ids.find(value);
+        LUISA_ASSERT(iter != _value_ids.end(), "Value is not defined in the module being serialized.");
+        return iter->second;
+    }
+
+    // custom types nested in other types are referred to by name in the descriptions, so they
+    // are serialized as well for the deserializer to register them before the enclosing types
+    void _serialize_nested_custom_types(const Type *type) noexcept {
+        if (type == nullptr) { return; }
+        if (type->is_custom()) {
+            static_cast<void>(_type_id(type));
+        } else if (type->is_structure()) {
+            for (auto m : type->members()) { _serialize_nested_custom_types(m); }
+        } else if (type->is_array() || type->is_buffer()) {
+            _serialize_nested_custom_types(type->element());
+        }
+    }
+
+    [[nodiscard]] uint32_t _type_id(const Type *type) noexcept {
+        if (type == nullptr) { return 0u; }
+        if (!type->is_custom() && !_type_ids.contains(type)) { _serialize_nested_custom_types(type); }
+        auto [iter, first] = _type_ids.try_emplace(type, static_cast<uint32_t>(_module.types.size() + 1u));
+        if (first) {
+            _module.types.emplace_back(SerializedType{
+                .description = luisa::string{type->description()},
+                .is_custom = type->is_custom(),
+            });
+        }
+        return iter->second;
+    }
+
+    void _collect_special_registers(FunctionDefinition *f) noexcept {
+        luisa::vector<BasicBlock *> blocks;
+        serialize_collect_blocks(f, blocks);
+        for (auto block : blocks) {
+            for (auto &&inst : block->instructions()) {
+                for (auto op : inst.operand_uses()) {
+                    if (auto v = op->value(); v != nullptr &&
+                                              v->derived_value_tag() == DerivedValueTag::SPECIAL_REGISTER &&
+                                              !_value_ids.contains(v)) {
+                        _assign_id(v);
+                        auto tag = static_cast<const SpecialRegister *>(v)->derived_special_register_tag();
+                        _module.special_registers.emplace_back(tag);
+                    }
+                }
+            }
+        }
+    }
+
+    void _serialize_instruction(SerializedFunction &sf, Instruction *inst) noexcept {
+        auto &&si = sf.instructions.emplace_back(SerializedInstruction{
+            .tag = inst->derived_instruction_tag(),
+            .op = serialized_instruction_op(inst),
+            .type = _type_id(inst->type()),
+            .operands = {},
+            .merge_block = 0u,
+            .blocks = {},
+            .case_values = {},
+            .text = serialized_instruction_text(inst),
+            .metadata = serialize_metadata_list(inst),
+        });
+        si.operands.reserve(inst->operand_count());
+        for (auto op : inst->operand_uses()) { si.operands.emplace_back(_value_id(op->value())); }
+        if (auto merge = inst->control_flow_merge()) { si.merge_block = _value_id(merge->merge_block()); }
+        switch (si.tag) {
+            case DerivedInstructionTag::LOOP: {
+                auto loop = static_cast<LoopInst *>(inst);
+                si.blocks.emplace_back(_value_id(loop->body_block()));
+                si.blocks.emplace_back(_value_id(loop->update_block()));
+                break;
+            }
+            case DerivedInstructionTag::PHI: {
+                auto phi = static_cast<PhiInst *>(inst);
+                for (auto i = 0u; i < phi->incoming_count(); i++) {
+                    si.blocks.emplace_back(_value_id(phi->incoming(i).block));
+                }
+                break;
+            }
+            case DerivedInstructionTag::SWITCH: {
+                auto values = static_cast<SwitchInst *>(inst)->case_values();
+                si.case_values.assign(values.begin(), values.end());
+                break;
+            }
+            case DerivedInstructionTag::AUTO_DIFF: {
+                LUISA_ERROR_WITH_LOCATION("Serialization of auto-diff instructions is not implemented.");
+            }
+            default: break;
+        }
+    }
+
+    void _serialize_function_body(SerializedFunction &sf, Function *f) noexcept {
+        for (auto arg : f->arguments()) {
+            _assign_id(arg);
+            sf.arguments.emplace_back(SerializedArgument{
+                .tag = arg->derived_argument_tag(),
+                .type = _type_id(arg->type()),
+                .metadata = serialize_metadata_list(arg),
+            });
+        }
+        auto def = f->definition();
+        if (def == nullptr) { return; }
+        luisa::vector<BasicBlock *> blocks;
+        serialize_collect_blocks(def, blocks);
+        for (auto block : blocks) {
+            _assign_id(block);
+            auto instruction_count = 0u;
+            for (auto &&inst : block->instructions()) {
+                static_cast<void>(inst);
+                instruction_count++;
+            }
+            sf.blocks.emplace_back(SerializedBasicBlock{
+                .instruction_count = instruction_count,
+                .metadata = serialize_metadata_list(block),
+            });
+        }
+        sf.body_block = _value_id(def->body_block());
+        // assign ids to all instructions first since operands may refer to later definitions (e.g., in phi nodes)
+        for (auto block : blocks) {
+            for (auto &&inst : block->instructions()) { _assign_id(&inst); }
+        }
+        for (auto block : blocks) {
+            for (auto &&inst : block->instructions()) { _serialize_instruction(sf, &inst); }
+        }
+    }
+
+public:
+    [[nodiscard]] SerializedModule serialize(Module *module) && noexcept {
+        for (auto &&c : module->constants()) {
+            _assign_id(&c);
+            auto data = static_cast<const std::byte *>(c.data());
+            _module.constants.emplace_back(SerializedConstant{
+                .type = _type_id(c.type()),
+                .data = luisa::vector<std::byte>(data, data + c.type()->size()),
+                .metadata = serialize_metadata_list(&c),
+            });
+        }
+        for (auto &&f : module->functions()) {
+            if (auto def = f.definition()) { _collect_special_registers(def); }
+        }
+        for (auto &&f : module->functions()) {
+            _assign_id(&f);
+            auto block_size = f.derived_function_tag() == DerivedFunctionTag::KERNEL ?
+                                  static_cast<KernelFunction &>(f).block_size() :
+                                  KernelFunction::default_block_size;
+            auto noinline = f.derived_function_tag() == DerivedFunctionTag::CALLABLE &&
+                            static_cast<CallableFunction &>(f).is_noinline();
+            _module.functions.emplace_back(SerializedFunction{
+                .tag = f.derived_function_tag(),
+                .type = _type_id(f.type()),
+                .block_size = block_size,
+                .noinline = noinline,
+                .body_block = 0u,
+                .arguments = {},
+                .blocks = {},
+                .instructions = {},
+                .metadata = serialize_metadata_list(&f),
+            });
+        }
+        auto index = 0u;
+        for (auto &&f : module->functions()) {
+            _serialize_function_body(_module.functions[index++], &f);
+        }
+        _module.metadata = serialize_metadata_list(module);
+        return std::move(_module);
+    }
+};
+
+SerializedModule serialize_module(const Module *module) noexcept {
+    return ModuleSerializer{}.serialize(const_cast<Module *>(module));
+}
+
+// the shape of a type decoded from its description, i.e., what the deserializer needs to know about
+// a type before handing its description to `Type::from`, which aborts on invalid descriptions
+struct SerializedTypeShape {
+    enum struct Kind {
+        VOID,
+        SCALAR,
+        VECTOR,
+        MATRIX,
+        ARRAY,
+        STRUCTURE,
+        BUFFER,
+        TEXTURE,
+        BINDLESS_ARRAY,
+        ACCEL,
+        CUSTOM,
+    };
+    Kind kind;
+    luisa::string_view scalar;// the name of scalar types
+    size_t size;
+    size_t alignment;
+    bool plain;         // plain data that constants may hold: scalars, vectors, matrices, and aggregates of them
+    bool has_attributes;// structures with member attributes, which buffers cannot hold
+
+    [[nodiscard]] bool is_resource() const noexcept {
+        return kind == Kind::BUFFER || kind == Kind::TEXTURE || kind == Kind::BINDLESS_ARRAY || kind == Kind::ACCEL;
+    }
+};
+
+// mirrors `TypeRegistry::_decode` in src/ast/type.cpp, but reports invalid descriptions instead of aborting
+class SerializedTypeParser {
+
+private:
+    static constexpr auto max_depth = 64u;
+    const luisa::unordered_set<luisa::string> &_custom_names;
+    luisa::string_view _desc;
+    bool _failed{false};
+
+private:
+    [[nodiscard]] static bool _is_identifier_char(char c) noexcept {
+        auto u = static_cast<unsigned char>(c);
+        return isalnum(u) || c == '_';
+    }
+
+    [[nodiscard]] luisa::string_view _read_identifier() noexcept {
+        auto i = 0u;
+        for (; i < _desc.size() && _is_identifier_char(_desc[i]); i++) {}
+        auto t = _desc.substr(0u, i);
+        _desc = _desc.substr(i);
+        return t;
+    }
+
+    [[nodiscard]] size_t _read_number() noexcept {
+        auto number = static_cast<size_t>(0u);
+        auto result = std::from_chars(_desc.data(), _desc.data() + _desc.size(), number);
+        if (result.ec != std::errc{}) {
+            _failed = true;
+            return 0u;
+        }
+        _desc = _desc.substr(result.ptr - _desc.data());
+        return number;
+    }
+
+    [[nodiscard]] bool _try_match(char c) noexcept {
+        if (!_desc.starts_with(c)) { return false; }
+        _desc = _desc.substr(1u);
+        return true;
+    }
+
+    void _match(char c) noexcept {
+        if (!_try_match(c)) { _failed = true; }
+    }
+
+    [[nodiscard]] luisa::string_view _split() noexcept {
+        auto balance = 0u;
+        auto i = 0u;
+        for (; i < _desc.size(); i++) {
+            if (auto c = _desc[i]; c == '<') {
+                balance++;
+            } else if (c == '>') {
+                if (balance == 0u) { break; }
+                if (--balance == 0u) {
+                    i++;
+                    break;
+                }
+            } else if (c == ',' && balance == 0u) {
+                break;
+            }
+        }
+        if (balance != 0u) { _failed = true; }
+        auto t = _desc.substr(0u, i);
+        _desc = _desc.substr(i);
+        return t;
+    }
+
+    // [key] or [key(value)]; returns false if there is no attribute
+    [[nodiscard]] bool _attribute() noexcept {
+        if (!_try_match('[')) { return false; }
+        static_cast<void>(_read_identifier());
+        if (_try_match('(')) {
+            static_cast<void>(_read_identifier());
+            _match(')');
+        }
+        _match(']');
+        return true;
+    }
+
+    [[nodiscard]] luisa::optional<SerializedTypeShape> _element(uint32_t depth) noexcept {
+        if (_failed) { return luisa::nullopt; }
+        return SerializedTypeParser{_custom_names}.parse(_split(), depth + 1u);
+    }
+
+    [[nodiscard]] luisa::optional<SerializedTypeShape> _parse(uint32_t depth) noexcept {
+        using Kind = SerializedTypeShape::Kind;
+        using namespace std::string_view_literals;
+        if (depth > max_depth) { return luisa::nullopt; }
+        if (_desc == "void"sv) { return SerializedTypeShape{Kind::VOID, {}, 0u, 0u, false, false}; }
+        // nested custom types are found by name in the type registry, where the deserializer registers them first
+        if (_custom_names.contains(luisa::string{_desc})) {
+            return SerializedTypeShape{Kind::CUSTOM, {}, Type::custom_struct_size, Type::custom_struct_alignment, false, false};
+        }
+        auto identifier = _read_identifier();
+        static constexpr std::array<std::pair<luisa::string_view, size_t>, 12u> scalars{{
+            {"bool"sv, 1u}, {"byte"sv, 1u}, {"ubyte"sv, 1u}, {"short"sv, 2u}, {"ushort"sv, 2u}, {"int"sv, 4u},
+            {"uint"sv, 4u}, {"long"sv, 8u}, {"ulong"sv, 8u}, {"half"sv, 2u}, {"float"sv, 4u}, {"double"sv, 8u},
+        }};
+        auto shape = SerializedTypeShape{Kind::VOID, {}, 0u, 0u, false, false};
+        if (auto iter = std::find_if(scalars.cbegin(), scalars.cend(),
+                                     [identifier](auto s) noexcept { return s.first == identifier; });
+            iter != scalars.cend()) {
+            shape = {Kind::SCALAR, iter->first, iter->second, iter->second, true, false};
+        } else if (identifier == "vector"sv) {
+            _match('<');
+            auto elem = _element(depth);
+            _match(',');
+            auto n = _read_number();
+            _match('>');
+            if (!elem || elem->kind != Kind::SCALAR || n < 2u || n > 4u) { return luisa::nullopt; }
+            auto alignment = std::min(elem->size * (n == 3u ? 4u : n), static_cast<size_t>(16u));
+            shape = {Kind::VECTOR, {}, luisa::align(elem->size * n, alignment), alignment, true, false};
+        } else if (identifier == "matrix"sv) {
+            _match('<');
+            auto n = _read_number();
+            _match('>');
+            switch (n) {
+                case 2u: shape = {Kind::MATRIX, {}, sizeof(float2x2), alignof(float2x2), true, false}; break;
+                case 3u: shape = {Kind::MATRIX, {}, sizeof(float3x3), alignof(float3x3), true, false}; break;
+                case 4u: shape = {Kind::MATRIX, {}, sizeof(float4x4), alignof(float4x4), true, false}; break;
+                default: return luisa::nullopt;
+            }
+        } else if (identifier == "array"sv) {
+            _match('<');
+            auto elem = _element(depth);
+            _match(',');
+            auto n = _read_number();
+            _match('>');
+            if (!elem || elem->kind == Kind::VOID || elem->kind == Kind::BUFFER || elem->kind == Kind::TEXTURE ||
+                (n != 0u && elem->size > std::numeric_limits<uint32_t>::max() / n)) { return luisa::nullopt; }
+            shape = {Kind::ARRAY, {}, elem->size * n, elem->alignment, elem->plain, false};
+        } else if (identifier == "struct"sv) {
+            _match('<');
+            auto alignment = _read_number();
+            auto size = static_cast<size_t>(0u);
+            auto max_member_alignment = static_cast<size_t>(0u);
+            auto plain = true;
+            auto has_attributes = false;
+            while (!_failed && _try_match(',')) {
+                has_attributes |= _attribute();
+                auto member = _element(depth);
+                if (!member || member->kind == Kind::VOID || member->kind == Kind::BUFFER || member->kind == Kind::TEXTURE) {
+                    return luisa::nullopt;
+                }
+                max_member_alignment = std::max(max_member_alignment, member->alignment);
+                size = luisa::align(size, member->alignment) + member->size;
+                if (size > std::numeric_limits<uint32_t>::max()) { return luisa::nullopt; }
+                plain &= member->plain;
+            }
+            _match('>');
+            if (alignment == 0u || alignment > 16u || std::bit_floor(alignment) != alignment ||
+                alignment < max_member_alignment) { return luisa::nullopt; }
+            shape = {Kind::STRUCTURE, {}, luisa::align(size, alignment), alignment, plain, has_attributes};
+        } else if (identifier == "buffer"sv) {
+            while (!_failed && _attribute()) {}
+            _match('<');
+            auto elem = _element(depth);
+            _match('>');
+            if (!elem || elem->kind == Kind::BUFFER || elem->kind == Kind::TEXTURE || elem->has_attributes) {
+                return luisa::nullopt;
+            }
+            shape = {Kind::BUFFER, {}, 8u, 8u, false, false};
+        } else if (identifier == "texture"sv) {
+            while (!_failed && _attribute()) {}
+            _match('<');
+            auto dimension = _read_number();
+            _match(',');
+            auto elem = _element(depth);
+            _match('>');
+            if (!elem || (dimension != 2u && dimension != 3u) || elem->kind != Kind::SCALAR ||
+                (elem->scalar != "int"sv && elem->scalar != "uint"sv && elem->scalar != "float"sv)) {
+                return luisa::nullopt;
+            }
+            shape = {Kind::TEXTURE, {}, 8u, 8u, false, false};
+        } else if (identifier == "bindless_array"sv) {
+            shape = {Kind::BINDLESS_ARRAY, {}, 8u, 8u, false, false};
+        } else if (identifier == "accel"sv) {
+            shape = {Kind::ACCEL, {}, 8u, 8u, false, false};
+        } else {
+            return luisa::nullopt;
+        }
+        // junk after the description
+        if (_failed || !_desc.empty()) { return luisa::nullopt; }
+        return shape;
+    }
+
+public:
+    explicit SerializedTypeParser(const luisa::unordered_set<luisa::string> &custom_names) noexcept
+        : _custom_names{custom_names} {}
+
+    [[nodiscard]] luisa::optional<SerializedTypeShape> parse(luisa::string_view desc, uint32_t depth = 0u) noexcept {
+        _desc = desc;
+        _failed = false;
+        return _parse(depth);
+    }
+};
+
+// mirrors the name checks of `TypeRegistry::custom_type`
+[[nodiscard]] static bool serialized_custom_type_name_valid(luisa::string_view name) noexcept {
+    using namespace std::string_view_literals;
+    static constexpr std::array reserved_names{
+        "void"sv, "bool"sv, "byte"sv, "ubyte"sv, "short"sv, "ushort"sv, "int"sv, "uint"sv, "long"sv,
+        "ulong"sv, "half"sv, "float"sv, "double"sv, "accel"sv, "bindless_array"sv};
+    static constexpr std::array reserved_prefixes{
+        "vector<"sv, "matrix<"sv, "array<"sv, "struct<"sv, "buffer<"sv, "texture<"sv};
+    return !name.empty() &&
+           !isdigit(static_cast<unsigned char>(name.front())) &&
+           std::all_of(name.cbegin(), name.cend(), [](char c) noexcept {
+               return isalnum(static_cast<unsigned char>(c)) || c == '_';
+           }) &&
+           std::none_of(reserved_names.cbegin(), reserved_names.cend(),
+                        [name](auto r) noexcept { return name == r; }) &&
+           std::none_of(reserved_prefixes.cbegin(), reserved_prefixes.cend(),
+                        [name](auto p) noexcept { return name.starts_with(p); });
+}
+
+[[nodiscard]] static luisa::unordered_set<luisa::string> serialized_custom_type_names(const SerializedModule &m) noexcept {
+    luisa::unordered_set<luisa::string> names;
+    for (auto &&t : m.types) {
+        if (t.is_custom) { names.emplace(t.description); }
+    }
+    return names;
+}
+
+// decodes the type table, with nullopt for invalid entries
+[[nodiscard]] static luisa::vector<luisa::optional<SerializedTypeShape>> serialized_type_shapes(const SerializedModule &m) noexcept {
+    auto custom_names = serialized_custom_type_names(m);
+    SerializedTypeParser parser{custom_names};
+    luisa::vector<luisa::optional<SerializedTypeShape>> shapes;
+    shapes.reserve(m.types.size());
+    for (auto &&t : m.types) {
+        if (t.is_custom) {
+            shapes.emplace_back(serialized_custom_type_name_valid(t.description) ?
+                                    luisa::make_optional(SerializedTypeShape{SerializedTypeShape::Kind::CUSTOM, {},
+                                                                             Type::custom_struct_size,
+                                                                             Type::custom_struct_alignment,
+                                                                             false, false}) :
+                                    luisa::nullopt);
+        } else {
+            shapes.emplace_back(parser.parse(t.description));
+        }
+    }
+    return shapes;
+}
+
+luisa::optional<size_t> serialized_constant_type_size(const SerializedModule &m, uint32_t type) noexcept {
+    if (type == 0u || type > m.types.size()) { return luisa::nullopt; }
+    auto &&t = m.types[type - 1u];
+    if (t.is_custom) { return luisa::nullopt; }
+    auto custom_names = serialized_custom_type_names(m);
+    auto shape = SerializedTypeParser{custom_names}.parse(t.description);
+    if (!shape || !shape->plain) { return luisa::nullopt; }
+    return shape->size;
+}
+
+// the number of operations (or address spaces) of instructions with one, and 0 for the other instructions
+[[nodiscard]] static uint32_t serialized_op_count(DerivedInstructionTag tag) noexcept {
+    auto count = [](auto last) noexcept { return static_cast<uint32_t>(last) + 1u; };
+    switch (tag) {
+        case DerivedInstructionTag::ALLOCA: return count(AllocSpace::SHARED);
+        case DerivedInstructionTag::ATOMIC: return count(AtomicOp::FETCH_MAX);
+        case DerivedInstructionTag::ARITHMETIC: return count(ArithmeticOp::EXTRACT);
+        case DerivedInstructionTag::THREAD_GROUP: return count(ThreadGroupOp::SYNCHRONIZE_BLOCK);
+        case DerivedInstructionTag::RESOURCE_QUERY: return count(ResourceQueryOp::RAY_TRACING_QUERY_ANY_MOTION_BLUR);
+        case DerivedInstructionTag::RESOURCE_READ: return count(ResourceReadOp::DEVICE_ADDRESS_READ);
+        case DerivedInstructionTag::RESOURCE_WRITE: return count(ResourceWriteOp::INDIRECT_DISPATCH_SET_COUNT);
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_READ: return count(RayQueryObjectReadOp::RAY_QUERY_OBJECT_IS_TERMINATED);
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: return count(RayQueryObjectWriteOp::RAY_QUERY_OBJECT_PROCEED);
+        case DerivedInstructionTag::CAST: return count(CastOp::BITWISE_CAST);
+        case DerivedInstructionTag::INTRINSIC: return count(IntrinsicOp::AUTODIFF_DETACH);
+        default: break;
+    }
+    return 0u;
+}
+
+// the operands that refer to basic blocks, and the minimum operand count of the instruction
+struct SerializedBlockOperands {
+    uint32_t first;
+    uint32_t last;// inclusive; ~0u for all the remaining operands
+    uint32_t min_operand_count;
+};
+
+[[nodiscard]] static luisa::optional<SerializedBlockOperands> serialized_block_operands(DerivedInstructionTag tag) noexcept {
+    switch (tag) {
+        case DerivedInstructionTag::BRANCH: [[fallthrough]];
+        case DerivedInstructionTag::BREAK: [[fallthrough]];
+        case DerivedInstructionTag::CONTINUE: [[fallthrough]];
+        case DerivedInstructionTag::OUTLINE: return SerializedBlockOperands{0u, 0u, 1u};
+        case DerivedInstructionTag::IF: [[fallthrough]];
+        case DerivedInstructionTag::CONDITIONAL_BRANCH: return SerializedBlockOperands{1u, 2u, 3u};
+        case DerivedInstructionTag::LOOP: [[fallthrough]];
+        case DerivedInstructionTag::SIMPLE_LOOP: [[fallthrough]];
+        case DerivedInstructionTag::RAY_QUERY_LOOP: return SerializedBlockOperands{0u, 0u, 1u};
+        case DerivedInstructionTag::SWITCH: return SerializedBlockOperands{1u, ~0u, 2u};
+        case DerivedInstructionTag::RAY_QUERY_DISPATCH: return SerializedBlockOperands{1u, 3u, 4u};
+        default: break;
+    }
+    return luisa::nullopt;
+}
+
+bool validate_serialized_module(const SerializedModule &m) noexcept {
+    auto fail = [](luisa::string_view reason) noexcept {
+        LUISA_WARNING_WITH_LOCATION("Malformed XIR module: {}.", reason);
+        return false;
+    };
+    using Kind = SerializedTypeShape::Kind;
+    auto valid_metadata = [](luisa::span<const SerializedMetadata> list) noexcept {
+        return std::all_of(list.begin(), list.end(), [](auto &&md) noexcept {
+            return static_cast<uint32_t>(md.tag) <= static_cast<uint32_t>(DerivedMetadataTag::COMMENT);
+        });
+    };
+    if (!valid_metadata(m.metadata)) { return fail("invalid module metadata"); }
+    auto shapes = serialized_type_shapes(m);
+    if (std::any_of(shapes.cbegin(), shapes.cend(), [](auto &&s) noexcept { return !s.has_value(); })) {
+        return fail("invalid type description");
+    }
+    // index 0 is void
+    auto shape = [&](uint32_t type) noexcept -> const SerializedTypeShape * {
+        static constexpr auto void_shape = SerializedTypeShape{Kind::VOID, {}, 0u, 0u, false, false};
+        if (type == 0u) { return &void_shape; }
+        return type <= shapes.size() ? &*shapes[type - 1u] : nullptr;
+    };
+    for (auto &&c : m.constants) {
+        auto s = shape(c.type);
+        if (s == nullptr || !s->plain || s->size != c.data.size() || !valid_metadata(c.metadata)) {
+            return fail("invalid constant");
+        }
+    }
+    for (auto tag : m.special_registers) {
+        if (static_cast<uint32_t>(tag) > static_cast<uint32_t>(DerivedSpecialRegisterTag::DISPATCH_SIZE)) {
+            return fail("invalid special register");
+        }
+    }
+    auto first_function = static_cast<size_t>(1u) + m.constants.size() + m.special_registers.size();
+    auto end_function = first_function + m.functions.size();
+    auto value_count = end_function;
+    for (auto &&f : m.functions) {
+        if (static_cast<uint32_t>(f.tag) > static_cast<uint32_t>(DerivedFunctionTag::EXTERNAL)) {
+            return fail("invalid function tag");
+        }
+        if (shape(f.type) == nullptr || !valid_metadata(f.metadata)) { return fail("invalid function"); }
+        if (f.tag == DerivedFunctionTag::KERNEL) {
+            auto thread_count = static_cast<uint64_t>(f.block_size.x) * f.block_size.y * f.block_size.z;
+            if (thread_count < 32u || thread_count > 1024u || thread_count % 32u != 0u) {
+                return fail("invalid kernel block size");
+            }
+        }
+        for (auto &&a : f.arguments) {
+            auto s = shape(a.type);
+            auto valid = s != nullptr && s->kind != Kind::VOID;
+            switch (a.tag) {
+                case DerivedArgumentTag::VALUE: valid = valid && !s->is_resource() && s->kind != Kind::CUSTOM; break;
+                case DerivedArgumentTag::REFERENCE: valid = valid && !s->is_resource(); break;
+                case DerivedArgumentTag::RESOURCE: valid = valid && s->is_resource(); break;
+                default: valid = false; break;
+            }
+            if (!valid || !valid_metadata(a.metadata)) { return fail("invalid argument"); }
+        }
+        auto first_argument = value_count;
+        auto first_block = first_argument + f.arguments.size();
+        auto end_block = first_block + f.blocks.size();
+        value_count = end_block + f.instructions.size();
+        if (f.tag == DerivedFunctionTag::EXTERNAL) {
+            if (!f.blocks.empty() || !f.instructions.empty()) { return fail("external function with a body"); }
+            continue;
+        }
+        auto instruction_count = static_cast<size_t>(0u);
+        for (auto &&b : f.blocks) {
+            if (!valid_metadata(b.metadata)) { return fail("invalid block metadata"); }
+            instruction_count += b.instruction_count;
+        }
+        if (instruction_count != f.instructions.size()) { return fail("instruction count mismatch"); }
+        auto valid_block = [&](uint32_t id, bool optional) noexcept {
+            return (optional && id == 0u) || (id >= first_block && id < end_block);
+        };
+        // values are constants, special registers, and the arguments and instructions of the current function
+        auto valid_value = [&](uint32_t id) noexcept {
+            return id < first_function ||
+                   (id >= first_argument && id < first_block) ||
+                   (id >= end_block && id < value_count);
+        };
+        if (!valid_block(f.body_block, false)) { return fail("invalid function body block"); }
+        for (auto &&inst : f.instructions) {
+            if (inst.tag == DerivedInstructionTag::SENTINEL ||
+                inst.tag == DerivedInstructionTag::AUTO_DIFF ||
+                static_cast<uint32_t>(inst.tag) > static_cast<uint32_t>(DerivedInstructionTag::INTRINSIC)) {
+                return fail("unsupported instruction");
+            }
+            if (auto op_count = serialized_op_count(inst.tag); op_count != 0u && inst.op >= op_count) {
+                return fail("invalid instruction operation");
+            }
+            auto block_operands = serialized_block_operands(inst.tag);
+            if (block_operands && inst.operands.size() < block_operands->min_operand_count) {
+                return fail("missing instruction operands");
+            }
+            auto is_block_operand = [&](size_t i) noexcept {
+                return block_operands && i >= block_operands->first && i <= block_operands->last;
+            };
+            auto valid = shape(inst.type) != nullptr &&
+                         valid_metadata(inst.metadata) &&
+                         valid_block(inst.merge_block, true) &&
+                         std::all_of(inst.blocks.cbegin(), inst.blocks.cend(),
+                                     [&](auto id) noexcept { return valid_block(id, false); });
+            for (auto i = 0u; valid && i < inst.operands.size(); i++) {
+                auto id = inst.operands[i];
+                if (is_block_operand(i)) {
+                    valid = valid_block(id, true);
+                } else if (i == 0u && inst.tag == DerivedInstructionTag::CALL) {
+                    valid = id >= first_function && id < end_function;
+                } else {
+                    valid = id == 0u || valid_value(id);
+                }
+            }
+            switch (inst.tag) {
+                case DerivedInstructionTag::PHI: valid = valid && inst.blocks.size() == inst.operands.size(); break;
+                case DerivedInstructionTag::LOOP: valid = valid && inst.blocks.size() == 2u; break;
+                case DerivedInstructionTag::SWITCH: valid = valid && inst.operands.size() == SwitchInst::operand_index_case_block_offset + inst.case_values.size(); break;
+                case DerivedInstructionTag::CALL: valid = valid && !inst.operands.empty(); break;
+                default: break;
+            }
+            if (!valid) { return fail("invalid instruction"); }
+        }
+    }
+    return true;
+}
+
+// returns nullptr for instructions that cannot be deserialized
+[[nodiscard]] static Instruction *deserialize_instruction_shell(const SerializedInstruction &si, const Type *type) noexcept {
+    auto pool = Pool::current();
+    auto text = luisa::string{si.text};
+    switch (si.tag) {
+        case DerivedInstructionTag::IF: return pool->create<IfInst>();
+        case DerivedInstructionTag::SWITCH: {
+            auto inst = pool->create<SwitchInst>();
+            inst->set_case_count(si.case_values.size());
+            for (auto i = 0u; i < si.case_values.size(); i++) { inst->set_case_value(i, si.case_values[i]); }
+            return inst;
+        }
+        case DerivedInstructionTag::LOOP: return pool->create<LoopInst>();
+        case DerivedInstructionTag::SIMPLE_LOOP: return pool->create<SimpleLoopInst>();
+        case DerivedInstructionTag::BRANCH: return pool->create<BranchInst>();
+        case DerivedInstructionTag::CONDITIONAL_BRANCH: return pool->create<ConditionalBranchInst>();
+        case DerivedInstructionTag::UNREACHABLE: return pool->create<UnreachableInst>(std::move(text));
+        case DerivedInstructionTag::BREAK: return pool->create<BreakInst>();
+        case DerivedInstructionTag::CONTINUE: return pool->create<ContinueInst>();
+        case DerivedInstructionTag::RETURN: return pool->create<ReturnInst>();
+        case DerivedInstructionTag::RASTER_DISCARD: return pool->create<RasterDiscardInst>();
+        case DerivedInstructionTag::PHI: return pool->create<PhiInst>(type);
+        case DerivedInstructionTag::ALLOCA: return pool->create<AllocaInst>(type, static_cast<AllocSpace>(si.op));
+        case DerivedInstructionTag::LOAD: return pool->create<LoadInst>(type);
+        case DerivedInstructionTag::STORE: return pool->create<StoreInst>();
+        case DerivedInstructionTag::GEP: return pool->create<GEPInst>(type);
+        case DerivedInstructionTag::ATOMIC: return pool->create<AtomicInst>(type, static_cast<AtomicOp>(si.op));
+        case DerivedInstructionTag::ARITHMETIC: return pool->create<ArithmeticInst>(type, static_cast<ArithmeticOp>(si.op));
+        case DerivedInstructionTag::THREAD_GROUP: return pool->create<ThreadGroupInst>(type, static_cast<ThreadGroupOp>(si.op));
+        case DerivedInstructionTag::RESOURCE_QUERY: return pool->create<ResourceQueryInst>(type, static_cast<ResourceQueryOp>(si.op));
+        case DerivedInstructionTag::RESOURCE_READ: return pool->create<ResourceReadInst>(type, static_cast<ResourceReadOp>(si.op));
+        case DerivedInstructionTag::RESOURCE_WRITE: return pool->create<ResourceWriteInst>(static_cast<ResourceWriteOp>(si.op));
+        case DerivedInstructionTag::RAY_QUERY_LOOP: return pool->create<RayQueryLoopInst>();
+        case DerivedInstructionTag::RAY_QUERY_DISPATCH: return pool->create<RayQueryDispatchInst>();
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_READ: return pool->create<RayQueryObjectReadInst>(type, static_cast<RayQueryObjectReadOp>(si.op));
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: return pool->create<RayQueryObjectWriteInst>(static_cast<RayQueryObjectWriteOp>(si.op));
+        case DerivedInstructionTag::CALL: return pool->create<CallInst>(type);
+        case DerivedInstructionTag::CAST: return pool->create<CastInst>(type, static_cast<CastOp>(si.op));
+        case DerivedInstructionTag::PRINT: return pool->create<PrintInst>(std::move(text));
+        case DerivedInstructionTag::CLOCK: return pool->create<ClockInst>();
+        case DerivedInstructionTag::ASSERT: return pool->create<AssertInst>(nullptr, std::move(text));
+        case DerivedInstructionTag::ASSUME: return pool->create<AssumeInst>(nullptr, std::move(text));
+        case DerivedInstructionTag::OUTLINE: return pool->create<OutlineInst>();
+        case DerivedInstructionTag::INTRINSIC: return pool->create<IntrinsicInst>(type, static_cast<IntrinsicOp>(si.op));
+        default: break;
+    }
+    return nullptr;
+}
+
+class ModuleDeserializer {
+
+private:
+    const SerializedModule &_m;
+    luisa::vector<const Type *> _types;
+    luisa::vector<Value *> _values;
+    bool _failed{false};
+
+private:
+    // the module is validated before deserialization, so these only guard against inconsistencies
+    // between the validation and the deserializer, and never abort
+    void _fail(luisa::string_view reason) noexcept {
+        if (!_failed) {
+            LUISA_WARNING_WITH_LOCATION("Malformed XIR module: {}.", reason);
+            _failed = true;
+        }
+    }
+
+    [[nodiscard]] const Type *_type(uint32_t index) noexcept {
+        if (index >= _types.size()) {
+            _fail("invalid type index");
+            return nullptr;
+        }
+        return _types[index];
+    }
+
+    [[nodiscard]] Value *_value(uint32_t id) noexcept {
+        if (id >= _values.size()) {
+            _fail("invalid value id");
+            return nullptr;
+        }
+        return _values[id];
+    }
+
+    [[nodiscard]] BasicBlock *_block(uint32_t id) noexcept {
+        auto value = _value(id);
+        if (value != nullptr && value->derived_value_tag() != DerivedValueTag::BASIC_BLOCK) {
+            _fail("value id does not refer to a basic block");
+            return nullptr;
+        }
+        return static_cast<BasicBlock *>(value);
+    }
+
+    void _deserialize_function_body(Function *f, const SerializedFunction &sf) noexcept {
+        for (auto &&sa : sf.arguments) {
+            auto type = _type(sa.type);
+            if (type == nullptr) {
+                _fail("void argument");
+                return;
+            }
+            auto arg = [&]() noexcept -> Argument * {
+                switch (sa.tag) {
+                    case DerivedArgumentTag::VALUE: return f->create_value_argument(type);
+                    case DerivedArgumentTag::REFERENCE: return f->create_reference_argument(type);
+                    case DerivedArgumentTag::RESOURCE: return f->create_resource_argument(type);
+                }
+                return nullptr;
+            }();
+            if (arg == nullptr) {
+                _fail("invalid argument tag");
+                return;
+            }
+            deserialize_metadata_list(arg, sa.metadata);
+            _values.emplace_back(arg);
+        }
+        auto def = f->definition();
+        if (def == nullptr) {
+            if (!sf.blocks.empty() || !sf.instructions.empty()) { _fail("external function with a body"); }
+            return;
+        }
+        auto first_block = _values.size();
+        for (auto &&sb : sf.blocks) {
+            auto block = Pool::current()->create<BasicBlock>();
+            deserialize_metadata_list(block, sb.metadata);
+            _values.emplace_back(block);
+        }
+        def->set_body_block(_block(sf.body_block));
+        auto first_instruction = _values.size();
+        for (auto &&si : sf.instructions) {
+            auto inst = deserialize_instruction_shell(si, _type(si.type));
+            if (inst == nullptr) {
+                _fail("unsupported instruction");
+                return;
+            }
+            deserialize_metadata_list(inst, si.metadata);
+            _values.emplace_back(inst);
+        }
+        // resolve the operands now that all values of the function are created
+        luisa::fixed_vector<Value *, 16u> operands;
+        for (auto i = 0u; i < sf.instructions.size() && !_failed; i++) {
+            auto &&si = sf.instructions[i];
+            auto inst = static_cast<Instruction *>(_values[first_instruction + i]);
+            operands.clear();
+            for (auto id : si.operands) { operands.emplace_back(_value(id)); }
+            if (si.tag == DerivedInstructionTag::PHI) {
+                if (si.blocks.size() != operands.size()) {
+                    _fail("phi node incoming count mismatch");
+                    return;
+                }
+                auto phi = static_cast<PhiInst *>(inst);
+                phi->set_incoming_count(operands.size());
+                for (auto j = 0u; j < operands.size(); j++) { phi->set_incoming(j, operands[j], _block(si.blocks[j])); }
+            } else {
+                inst->set_operands(operands);
+            }
+            if (si.tag == DerivedInstructionTag::LOOP) {
+                if (si.blocks.size() != 2u) {
+                    _fail("loop instructions should have a body and an update block");
+                    return;
+                }
+                auto loop = static_cast<LoopInst *>(inst);
+                loop->set_body_block(_block(si.blocks[0]));
+                loop->set_update_block(_block(si.blocks[1]));
+            }
+            if (auto merge = inst->control_flow_merge()) {
+                merge->set_merge_block(_block(si.merge_block));
+            }
+        }
+        if (_failed) { return; }
+        // finally, link the instructions into the blocks, which also registers the uses of the operands
+        auto index = first_instruction;
+        for (auto b = 0u; b < sf.blocks.size(); b++) {
+            auto block = static_cast<BasicBlock *>(_values[first_block + b]);
+            for (auto n = 0u; n < sf.blocks[b].instruction_count; n++) {
+                if (index >= _values.size()) {
+                    _fail("instruction count mismatch");
+                    return;
+                }
+                auto inst = static_cast<Instruction *>(_values[index++]);
+                block->instructions().tail_sentinel()->insert_before_self(inst);
+            }
+        }
+        if (index != _values.size()) { _fail("instruction count mismatch"); }
+    }
+
+public:
+    explicit ModuleDeserializer(const SerializedModule &m) noexcept : _m{m} {}
+
+    [[nodiscard]] Module *deserialize() && noexcept {
+        // the type descriptions are only handed to the type registry after they are validated
+        if (!validate_serialized_module(_m)) { return nullptr; }
+        _types.resize(_m.types.size() + 1u, nullptr);
+        // custom types first, so that the descriptions of other types can refer to them by name
+        for (auto i = 0u; i < _m.types.size(); i++) {
+            if (auto &&t = _m.types[i]; t.is_custom) { _types[i + 1u] = Type::custom(t.description); }
+        }
+        for (auto i = 0u; i < _m.types.size(); i++) {
+            if (auto &&t = _m.types[i]; !t.is_custom) { _types[i + 1u] = Type::from(t.description); }
+        }
+        auto module = Pool::current()->create<Module>();
+        // constants and functions are inserted at the front of the lists, so we create them in reverse order
+        auto constant_count = _m.constants.size();
+        auto register_count = _m.special_registers.size();
+        auto function_count = _m.functions.size();
+        _values.resize(1u + constant_count + register_count + function_count, nullptr);
+        for (auto i = constant_count; i > 0u; i--) {
+            auto &&sc = _m.constants[i - 1u];
+            auto type = _type(sc.type);
+            if (type == nullptr || type->size() != sc.data.size()) {
+                _fail("invalid data size for constant");
+                return nullptr;
+            }
+            auto c = module->create_constant(type, sc.data.data());
+            deserialize_metadata_list(c, sc.metadata);
+            _values[i] = c;
+        }
+        for (auto i = 0u; i < register_count; i++) {
+            _values[1u + constant_count + i] = SpecialRegister::create(_m.special_registers[i]);
+        }
+        for (auto i = function_count; i > 0u; i--) {
+            auto &&sf = _m.functions[i - 1u];
+            auto f = [&]() noexcept -> Function * {
+                switch (sf.tag) {
+                    case DerivedFunctionTag::KERNEL: {
+                        auto kernel = module->create_kernel();
+                        kernel->set_block_size(sf.block_size);
+                        return kernel;
+                    }
+                    case DerivedFunctionTag::CALLABLE: {
+                        auto callable = module->create_callable(_type(sf.type));
+                        callable->set_noinline(sf.noinline);
+                        return callable;
+                    }
+                    case DerivedFunctionTag::EXTERNAL: return module->create_external_function(_type(sf.type));
+                }
+                return nullptr;
+            }();
+            if (f == nullptr) {
+                _fail("invalid function tag");
+                return nullptr;
+            }
+            deserialize_metadata_list(f, sf.metadata);
+            _values[constant_count + register_count + i] = f;
+        }
+        auto first_function = 1u + constant_count + register_count;
+        for (auto i = 0u; i < function_count && !_failed; i++) {
+            auto f = static_cast<Function *>(_values[first_function + i]);
+            _deserialize_function_body(f, _m.functions[i]);
+        }
+        if (_failed) { return nullptr; }
+        deserialize_metadata_list(module, _m.metadata);
+        return module;
+    }
+};
+
+Module *deserialize_module(const SerializedModule &m) noexcept {
+    return ModuleDeserializer{m}.deserialize();
+}
+
+luisa::string_view serialized_op_name(DerivedInstructionTag tag, uint32_t op) noexcept {
+    using namespace std::string_view_literals;
+    switch (tag) {
+        case DerivedInstructionTag::ALLOCA: return static_cast<AllocSpace>(op) == AllocSpace::SHARED ? "shared"sv : "local"sv;
+        case DerivedInstructionTag::ATOMIC: return to_string(static_cast<AtomicOp>(op));
+        case DerivedInstructionTag::ARITHMETIC: return to_string(static_cast<ArithmeticOp>(op));
+        case DerivedInstructionTag::THREAD_GROUP: return to_string(static_cast<ThreadGroupOp>(op));
+        case DerivedInstructionTag::RESOURCE_QUERY: return to_string(static_cast<ResourceQueryOp>(op));
+        case DerivedInstructionTag::RESOURCE_READ: return to_string(static_cast<ResourceReadOp>(op));
+        case DerivedInstructionTag::RESOURCE_WRITE: return to_string(static_cast<ResourceWriteOp>(op));
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_READ: return to_string(static_cast<RayQueryObjectReadOp>(op));
+        case DerivedInstructionTag::RAY_QUERY_OBJECT_WRITE: return to_string(static_cast<RayQueryObjectWriteOp>(op));
+        case DerivedInstructionTag::CAST: return to_string(static_cast<CastOp>(op));
+        case DerivedInstructionTag::INTRINSIC: return to_string(static_cast<IntrinsicOp>(op));
+        default: break;
+    }
+    return {};
+}
+
+luisa::optional<uint32_t> serialized_op_from_name(DerivedInstructionTag tag, luisa::string_view name) noexcept {
+    // the *_op_from_string functions abort on unknown names, so we search the names of the valid codes instead
+    for (auto op = 0u; op < serialized_op_count(tag); op++) {
+        if (serialized_op_name(tag, op) == name) { return op; }
+    }
+    return luisa::nullopt;
+}
+
+luisa::optional<DerivedInstructionTag> serialized_instruction_tag_from_name(luisa::string_view name) noexcept {
+    for (auto i = 0u; i <= static_cast<uint32_t>(DerivedInstructionTag::INTRINSIC); i++) {
+        if (auto tag = static_cast<DerivedInstructionTag>(i); to_string(tag) == name) { return tag; }
+    }
+    return luisa::nullopt;
+}
+
+luisa::optional<DerivedSpecialRegisterTag> serialized_special_register_tag_from_name(luisa::string_view name) noexcept {
+    for (auto i = 0u; i <= static_cast<uint32_t>(DerivedSpecialRegisterTag::DISPATCH_SIZE); i++) {
+        if (auto tag = static_cast<DerivedSpecialRegisterTag>(i); to_string(tag) == name) { return tag; }
+    }
+    return luisa::nullopt;
+}
+
+luisa::string_view serialized_function_tag_name(DerivedFunctionTag tag) noexcept {
+    using namespace std::string_view_literals;
+    switch (tag) {
+        case DerivedFunctionTag::KERNEL: return "kernel"sv;
+        case DerivedFunctionTag::CALLABLE: return "callable"sv;
+        case DerivedFunctionTag::EXTERNAL: return "external"sv;
+    }
+    return "unknown"sv;
+}
+
+luisa::optional<DerivedFunctionTag> serialized_function_tag_from_name(luisa::string_view name) noexcept {
+    if (name == "kernel") { return DerivedFunctionTag::KERNEL; }
+    if (name == "callable") { return DerivedFunctionTag::CALLABLE; }
+    if (name == "external") { return DerivedFunctionTag::EXTERNAL; }
+    return luisa::nullopt;
+}
+
+luisa::string_view serialized_argument_tag_name(DerivedArgumentTag tag) noexcept {
+    using namespace std::string_view_literals;
+    switch (tag) {
+        case DerivedArgumentTag::VALUE: return "value"sv;
+        case DerivedArgumentTag::REFERENCE: return "reference"sv;
+        case DerivedArgumentTag::RESOURCE: return "resource"sv;
+    }
+    return "unknown"sv;
+}
+
+luisa::optional<DerivedArgumentTag> serialized_argument_tag_from_name(luisa::string_view name) noexcept {
+    if (name == "value") { return DerivedArgumentTag::VALUE; }
+    if (name == "reference") { return DerivedArgumentTag::REFERENCE; }
+    if (name == "resource") { return DerivedArgumentTag::RESOURCE; }
+    return luisa::nullopt;
+}
+
+}// namespace luisa::compute::xir::detail
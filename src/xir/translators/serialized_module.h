@@ -0,0 +1,104 @@
+#pragma once
+
+#include <luisa/core/stl/optional.h>
+#include <luisa/core/stl/string.h>
+#include <luisa/core/stl/vector.h>
+#include <luisa/xir/special_register.h>
+#include <luisa/xir/module.h>
+
+namespace luisa::compute::xir::detail {
+
+// A flat and pointer-free representation of a module, shared by the binary and
+// the JSON translators. Values are referred to by ids, where 0 denotes null:
+// - ids [1, n] are the constants, the special registers, and the functions of the
+//   module, in this order;
+// - the following ids are assigned to the arguments, the basic blocks, and the
+//   instructions of each function, function by function.
+// Types are referred to by 1-based indices into the type table, where 0 denotes void.
+
+static constexpr auto serialized_module_magic = static_cast<uint32_t>(0x52495843u);// "CXIR"
+static constexpr auto serialized_module_version = static_cast<uint32_t>(2u);
+
+struct SerializedMetadata {
+    DerivedMetadataTag tag;
+    luisa::string text;// the name, the file of the location, or the comment
+    int line;          // the line of the location
+};
+
+struct SerializedType {
+    luisa::string description;
+    bool is_custom;
+};
+
+struct SerializedConstant {
+    uint32_t type;
+    luisa::vector<std::byte> data;
+    luisa::vector<SerializedMetadata> metadata;
+};
+
+struct SerializedArgument {
+    DerivedArgumentTag tag;
+    uint32_t type;
+    luisa::vector<SerializedMetadata> metadata;
+};
+
+struct SerializedBasicBlock {
+    uint32_t instruction_count;
+    luisa::vector<SerializedMetadata> metadata;
+};
+
+struct SerializedInstruction {
+    DerivedInstructionTag tag;
+    uint32_t op;// the operation, or the address space of allocas
+    uint32_t type;
+    luisa::vector<uint32_t> operands;// the incoming values for phi nodes
+    uint32_t merge_block;            // control flow merges only
+    luisa::vector<uint32_t> blocks;  // the body and update blocks of loops, or the incoming blocks of phi nodes
+    luisa::vector<int> case_values;  // switches only
+    luisa::string text;              // the message of unreachable/assert/assume, or the format of print
+    luisa::vector<SerializedMetadata> metadata;
+};
+
+struct SerializedFunction {
+    DerivedFunctionTag tag;
+    uint32_t type;
+    luisa::uint3 block_size;// kernels only
+    bool noinline;          // callables only
+    uint32_t body_block;    // 0 for external functions
+    luisa::vector<SerializedArgument> arguments;
+    luisa::vector<SerializedBasicBlock> blocks;
+    luisa::vector<SerializedInstruction> instructions;// grouped by blocks
+    luisa::vector<SerializedMetadata> metadata;
+};
+
+struct SerializedModule {
+    luisa::vector<SerializedType> types;
+    luisa::vector<SerializedConstant> constants;
+    luisa::vector<DerivedSpecialRegisterTag> special_registers;
+    luisa::vector<SerializedFunction> functions;
+    luisa::vector<SerializedMetadata> metadata;
+};
+
+[[nodiscard]] SerializedModule serialize_module(const Module *module) noexcept;
+// Checks everything the deserializer relies on, so that modules read from untrusted data are rejected
+// instead of aborting: the grammar of the type descriptions, the type and data of the constants, the
+// tags, and the ids and their kinds (values, blocks of the current function, or functions).
+// Logs the first problem found and returns false if the module is malformed.
+[[nodiscard]] bool validate_serialized_module(const SerializedModule &m) noexcept;
+// Returns the size of a valid type that constants may have, i.e., plain data, or nullopt otherwise.
+// Readers use it to know the size of the constant data before the module is complete and validated.
+[[nodiscard]] luisa::optional<size_t> serialized_constant_type_size(const SerializedModule &m, uint32_t type) noexcept;
+// Returns nullptr if the module is malformed.
+[[nodiscard]] Module *deserialize_module(const SerializedModule &m) noexcept;
+
+// names for the human-readable (JSON) encoding; the lookups return nullopt for unknown names
+[[nodiscard]] luisa::string_view serialized_op_name(DerivedInstructionTag tag, uint32_t op) noexcept;
+[[nodiscard]] luisa::optional<uint32_t> serialized_op_from_name(DerivedInstructionTag tag, luisa::string_view name) noexcept;
+[[nodiscard]] luisa::optional<DerivedInstructionTag> serialized_instruction_tag_from_name(luisa::string_view name) noexcept;
+[[nodiscard]] luisa::optional<DerivedSpecialRegisterTag> serialized_special_register_tag_from_name(luisa::string_view name) noexcept;
+[[nodiscard]] luisa::string_view serialized_function_tag_name(DerivedFunctionTag tag) noexcept;
+[[nodiscard]] luisa::optional<DerivedFunctionTag> serialized_function_tag_from_name(luisa::string_view name) noexcept;
+[[nodiscard]] luisa::string_view serialized_argument_tag_name(DerivedArgumentTag tag) noexcept;
+[[nodiscard]] luisa::optional<DerivedArgumentTag> serialized_argument_tag_from_name(luisa::string_view name) noexcept;
+
+}// namespace luisa::compute::xir::detail
@@ -0,0 +1,123 @@
+#include <luisa/xir/translators/xir2binary.h>
+
+#include "serialized_module.h"
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+// integers are written as LEB128 varints, and strings and byte arrays are prefixed with their sizes
+class BinaryWriter {
+
+private:
+    luisa::vector<std::byte> _data;
+
+public:
+    void write_u8(uint32_t x) noexcept { _data.emplace_back(static_cast<std::byte>(x)); }
+
+    void write_u32(uint32_t x) noexcept {
+        for (auto i = 0u; i < 4u; i++) { write_u8((x >> (i * 8u)) & 0xffu); }
+    }
+
+    void write_uint(uint64_t x) noexcept {
+        while (x >= 0x80u) {
+            write_u8(static_cast<uint32_t>(x & 0x7fu) | 0x80u);
+            x >>= 7u;
+        }
+        write_u8(static_cast<uint32_t>(x));
+    }
+
+    void write_int(int64_t x) noexcept {
+        // zigzag encoding so that small negative numbers are also short
+        write_uint((static_cast<uint64_t>(x) << 1u) ^ static_cast<uint64_t>(x >> 63));
+    }
+
+    void write_bytes(luisa::span<const std::byte> bytes) noexcept {
+        _data.insert(_data.end(), bytes.begin(), bytes.end());
+    }
+
+    void write_string(luisa::string_view s) noexcept {
+        write_uint(s.size());
+        write_bytes(luisa::span{reinterpret_cast<const std::byte *>(s.data()), s.size()});
+    }
+
+    void write_ids(luisa::span<const uint32_t> ids) noexcept {
+        write_uint(ids.size());
+        for (auto id : ids) { write_uint(id); }
+    }
+
+    void write_metadata(luisa::span<const SerializedMetadata> list) noexcept {
+        write_uint(list.size());
+        for (auto &&m : list) {
+            write_u8(static_cast<uint32_t>(m.tag));
+            write_string(m.text);
+            if (m.tag == DerivedMetadataTag::LOCATION) { write_int(m.line); }
+        }
+    }
+
+    [[nodiscard]] auto data() && noexcept { return std::move(_data); }
+};
+
+}// namespace detail
+
+luisa::vector<std::byte> xir_to_binary_translate(const Module *module) noexcept {
+    auto m = detail::serialize_module(module);
+    detail::BinaryWriter w;
+    w.write_u32(detail::serialized_module_magic);
+    w.write_u32(detail::serialized_module_version);
+    w.write_uint(m.types.size());
+    for (auto &&t : m.types) {
+        w.write_u8(t.is_custom ? 1u : 0u);
+        w.write_string(t.description);
+    }
+    w.write_uint(m.constants.size());
+    for (auto &&c : m.constants) {
+        // the size of the data is implied by the type
+        w.write_uint(c.type);
+        w.write_bytes(c.data);
+        w.write_metadata(c.metadata);
+    }
+    w.write_uint(m.special_registers.size());
+    for (auto tag : m.special_registers) { w.write_u8(static_cast<uint32_t>(tag)); }
+    w.write_uint(m.functions.size());
+    for (auto &&f : m.functions) {
+        w.write_u8(static_cast<uint32_t>(f.tag));
+        w.write_uint(f.type);
+        if (f.tag == DerivedFunctionTag::KERNEL) {
+            for (auto i = 0u; i < 3u; i++) { w.write_uint(f.block_size[i]); }
+        } else if (f.tag == DerivedFunctionTag::CALLABLE) {
+            w.write_u8(f.noinline ? 1u : 0u);
+        }
+        w.write_metadata(f.metadata);
+    }
+    for (auto &&f : m.functions) {
+        w.write_uint(f.arguments.size());
+        for (auto &&a : f.arguments) {
+            w.write_u8(static_cast<uint32_t>(a.tag));
+            w.write_uint(a.type);
+            w.write_metadata(a.metadata);
+        }
+        w.write_uint(f.blocks.size());
+        for (auto &&b : f.blocks) {
+            w.write_uint(b.instruction_count);
+            w.write_metadata(b.metadata);
+        }
+        w.write_uint(f.body_block);
+        for (auto &&inst : f.instructions) {
+            w.write_u8(static_cast<uint32_t>(inst.tag));
+            w.write_uint(inst.op);
+            w.write_uint(inst.type);
+            w.write_ids(inst.operands);
+            w.write_uint(inst.merge_block);
+            w.write_ids(inst.blocks);
+            w.write_uint(inst.case_values.size());
+            for (auto v : inst.case_values) { w.write_int(v); }
+            w.write_string(inst.text);
+            w.write_metadata(inst.metadata);
+        }
+    }
+    w.write_metadata(m.metadata);
+    return std::move(w).data();
+}
+
+}// namespace luisa::compute::xir
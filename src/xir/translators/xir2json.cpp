@@ -1,27 +1,204 @@
-#include <yyjson.h>
-#include <luisa/xir/translators/xir2json.h>
-
-namespace luisa::compute::xir {
-
-luisa::string xir_to_json_translate(const Module *module) noexcept {
-    yyjson_alc alc{
-        .malloc = [](void *, size_t size) noexcept { return luisa::detail::allocator_allocate(size, 16u); },
-        .realloc = [](void *, void *ptr, size_t, size_t size) noexcept { return luisa::detail::allocator_reallocate(ptr, size, 16u); },
-        .free = [](void *, void *ptr) noexcept { luisa::detail::allocator_deallocate(ptr, 16u); },
-        .ctx = nullptr,
-    };
-    auto doc = yyjson_mut_doc_new(&alc);
-    auto arr = yyjson_mut_arr(doc);
-    auto str1 = yyjson_mut_str(doc, "hello");
-    auto str2 = yyjson_mut_str(doc, "world");
-    yyjson_mut_arr_append(arr, str1);
-    yyjson_mut_arr_append(arr, str2);
-    yyjson_mut_doc_set_root(doc, arr);
-    auto size = static_cast<size_t>(0u);
-    auto json = yyjson_mut_write(doc, YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END, &size);
-    auto result = luisa::string{json, size};
-    yyjson_mut_doc_free(doc);
-    return result;
-}
-
-}// namespace luisa::compute::xir
\ No newline at end of file
+#include <yyjson.h>
+#include <luisa/core/logging.h>
+#include <luisa/xir/translators/xir2json.h>
+
+#include "serialized_module.h"
+
+namespace luisa::compute::xir {
+
+namespace detail {
+
+// The JSON encoding mirrors the binary one, but spells out the ids of the values and the
+// names of the tags and operations so that the result is readable and diffable. It looks like:
+// {
+//   "format": "xir", "version": 2,
+//   "types": ["float", {"custom": "LC_RayQueryAll"}, ...],
+//   "constants": [{"id": 1, "type": 1, "data": "0000803f"}, ...],
+//   "special_registers": [{"id": 2, "tag": "dispatch_id"}, ...],
+//   "functions": [{"id": 3, "tag": "kernel", "type": 0, "block_size": [64, 1, 1],
+//                  "arguments": [{"id": 4, "tag": "value", "type": 1}, ...],
+//                  "body": 5,
+//                  "blocks": [{"id": 5, "instructions": [{"id": 6, "tag": "arithmetic", "op": "binary_add",
+//                                                         "type": 1, "operands": [4, 1]}, ...]}, ...]}, ...]
+// }
+// Callables kept out of line are marked with "noinline": true.
+// Metadata are listed in optional "metadata" arrays, e.g., [{"name": "x"}, {"location": "a.cpp", "line": 1}].
+class JSONWriter {
+
+private:
+    yyjson_mut_doc *_doc;
+
+private:
+    void _add_string(yyjson_mut_val *obj, const char *key, luisa::string_view s) noexcept {
+        yyjson_mut_obj_add_strncpy(_doc, obj, key, s.data(), s.size());
+    }
+
+    void _add_ids(yyjson_mut_val *obj, const char *key, luisa::span<const uint32_t> ids) noexcept {
+        auto arr = yyjson_mut_arr(_doc);
+        for (auto id : ids) { yyjson_mut_arr_add_uint(_doc, arr, id); }
+        yyjson_mut_obj_add_val(_doc, obj, key, arr);
+    }
+
+    void _add_metadata(yyjson_mut_val *obj, luisa::span<const SerializedMetadata> list) noexcept {
+        if (list.empty()) { return; }
+        auto arr = yyjson_mut_arr(_doc);
+        for (auto &&m : list) {
+            auto item = yyjson_mut_obj(_doc);
+            switch (m.tag) {
+                case DerivedMetadataTag::NAME: _add_string(item, "name", m.text); break;
+                case DerivedMetadataTag::LOCATION: {
+                    _add_string(item, "location", m.text);
+                    yyjson_mut_obj_add_int(_doc, item, "line", m.line);
+                    break;
+                }
+                case DerivedMetadataTag::COMMENT: _add_string(item, "comment", m.text); break;
+            }
+            yyjson_mut_arr_append(arr, item);
+        }
+        yyjson_mut_obj_add_val(_doc, obj, "metadata", arr);
+    }
+
+    [[nodiscard]] yyjson_mut_val *_write_instruction(const SerializedInstruction &inst, uint32_t id) noexcept {
+        auto obj = yyjson_mut_obj(_doc);
+        yyjson_mut_obj_add_uint(_doc, obj, "id", id);
+        _add_string(obj, "tag", to_string(inst.tag));
+        if (auto op = serialized_op_name(inst.tag, inst.op); !op.empty()) { _add_string(obj, "op", op); }
+        yyjson_mut_obj_add_uint(_doc, obj, "type", inst.type);
+        _add_ids(obj, "operands", inst.operands);
+        if (inst.merge_block != 0u) { yyjson_mut_obj_add_uint(_doc, obj, "merge", inst.merge_block); }
+        if (!inst.blocks.empty()) { _add_ids(obj, "blocks", inst.blocks); }
+        if (inst.tag == DerivedInstructionTag::SWITCH) {
+            auto cases = yyjson_mut_arr(_doc);
+            for (auto v : inst.case_values) { yyjson_mut_arr_add_int(_doc, cases, v); }
+            yyjson_mut_obj_add_val(_doc, obj, "cases", cases);
+        }
+        if (!inst.text.empty()) { _add_string(obj, "text", inst.text); }
+        _add_metadata(obj, inst.metadata);
+        return obj;
+    }
+
+    [[nodiscard]] yyjson_mut_val *_write_function(const SerializedFunction &f, uint32_t function_id, uint32_t &next_id) noexcept {
+        auto obj = yyjson_mut_obj(_doc);
+        yyjson_mut_obj_add_uint(_doc, obj, "id", function_id);
+        _add_string(obj, "tag", serialized_function_tag_name(f.tag));
+        yyjson_mut_obj_add_uint(_doc, obj, "type", f.type);
+        if (f.tag == DerivedFunctionTag::KERNEL) {
+            auto block_size = yyjson_mut_arr(_doc);
+            for (auto i = 0u; i < 3u; i++) { yyjson_mut_arr_add_uint(_doc, block_size, f.block_size[i]); }
+            yyjson_mut_obj_add_val(_doc, obj, "block_size", block_size);
+        } else if (f.tag == DerivedFunctionTag::CALLABLE && f.noinline) {
+            yyjson_mut_obj_add_bool(_doc, obj, "noinline", true);
+        }
+        _add_metadata(obj, f.metadata);
+        auto args = yyjson_mut_arr(_doc);
+        for (auto &&a : f.arguments) {
+            auto arg = yyjson_mut_obj(_doc);
+            yyjson_mut_obj_add_uint(_doc, arg, "id", next_id++);
+            _add_string(arg, "tag", serialized_argument_tag_name(a.tag));
+            yyjson_mut_obj_add_uint(_doc, arg, "type", a.type);
+            _add_metadata(arg, a.metadata);
+            yyjson_mut_arr_append(args, arg);
+        }
+        yyjson_mut_obj_add_val(_doc, obj, "arguments", args);
+        if (f.tag == DerivedFunctionTag::EXTERNAL) { return obj; }
+        yyjson_mut_obj_add_uint(_doc, obj, "body", f.body_block);
+        auto blocks = yyjson_mut_arr(_doc);
+        auto instruction_id = next_id + static_cast<uint32_t>(f.blocks.size());
+        auto instruction_index = 0u;
+        for (auto &&b : f.blocks) {
+            auto block = yyjson_mut_obj(_doc);
+            yyjson_mut_obj_add_uint(_doc, block, "id", next_id++);
+            _add_metadata(block, b.metadata);
+            auto instructions = yyjson_mut_arr(_doc);
+            for (auto i = 0u; i < b.instruction_count; i++) {
+                auto inst = _write_instruction(f.instructions[instruction_index++], instruction_id++);
+                yyjson_mut_arr_append(instructions, inst);
+            }
+            yyjson_mut_obj_add_val(_doc, block, "instructions", instructions);
+            yyjson_mut_arr_append(blocks, block);
+        }
+        yyjson_mut_obj_add_val(_doc, obj, "blocks", blocks);
+        next_id = instruction_id;
+        return obj;
+    }
+
+public:
+    explicit JSONWriter(yyjson_mut_doc *doc) noexcept : _doc{doc} {}
+
+    [[nodiscard]] yyjson_mut_val *write(const SerializedModule &m) noexcept {
+        auto root = yyjson_mut_obj(_doc);
+        yyjson_mut_obj_add_str(_doc, root, "format", "xir");
+        yyjson_mut_obj_add_uint(_doc, root, "version", serialized_module_version);
+        _add_metadata(root, m.metadata);
+        auto types = yyjson_mut_arr(_doc);
+        for (auto &&t : m.types) {
+            if (t.is_custom) {
+                auto custom = yyjson_mut_obj(_doc);
+                _add_string(custom, "custom", t.description);
+                yyjson_mut_arr_append(types, custom);
+            } else {
+                yyjson_mut_arr_add_strncpy(_doc, types, t.description.data(), t.description.size());
+            }
+        }
+        yyjson_mut_obj_add_val(_doc, root, "types", types);
+        auto next_id = 1u;
+        auto constants = yyjson_mut_arr(_doc);
+        for (auto &&c : m.constants) {
+            auto constant = yyjson_mut_obj(_doc);
+            yyjson_mut_obj_add_uint(_doc, constant, "id", next_id++);
+            yyjson_mut_obj_add_uint(_doc, constant, "type", c.type);
+            luisa::string hex;
+            hex.reserve(c.data.size() * 2u);
+            for (auto b : c.data) {
+                constexpr auto digits = "0123456789abcdef";
+                hex.push_back(digits[static_cast<uint32_t>(b) >> 4u]);
+                hex.push_back(digits[static_cast<uint32_t>(b) & 0xfu]);
+            }
+            _add_string(constant, "data", hex);
+            _add_metadata(constant, c.metadata);
+            yyjson_mut_arr_append(constants, constant);
+        }
+        yyjson_mut_obj_add_val(_doc, root, "constants", constants);
+        auto special_registers = yyjson_mut_arr(_doc);
+        for (auto tag : m.special_registers) {
+            auto sreg = yyjson_mut_obj(_doc);
+            yyjson_mut_obj_add_uint(_doc, sreg, "id", next_id++);
+            _add_string(sreg, "tag", to_string(tag));
+            yyjson_mut_arr_append(special_registers, sreg);
+        }
+        yyjson_mut_obj_add_val(_doc, root, "special_registers", special_registers);
+        auto first_function_id = next_id;
+        next_id += static_cast<uint32_t>(m.functions.size());
+        auto functions = yyjson_mut_arr(_doc);
+        for (auto i = 0u; i < m.functions.size(); i++) {
+            auto f = _write_function(m.functions[i], first_function_id + i, next_id);
+            yyjson_mut_arr_append(functions, f);
+        }
+        yyjson_mut_obj_add_val(_doc, root, "functions", functions);
+        return root;
+    }
+};
+
+}// namespace detail
+
+luisa::string xir_to_json_translate(const Module *module) noexcept {
+    yyjson_alc alc{
+        .malloc = [](void *, size_t size) noexcept { return luisa::detail::allocator_allocate(size, 16u); },
+        .realloc = [](void *, void *ptr, size_t, size_t size) noexcept { return luisa::detail::allocator_reallocate(ptr, size, 16u); },
+        .free = [](void *, void *ptr) noexcept { luisa::detail::allocator_deallocate(ptr, 16u); },
+        .ctx = nullptr,
+    };
+    auto m = detail::serialize_module(module);
+    auto doc = yyjson_mut_doc_new(&alc);
+    auto root = detail::JSONWriter{doc}.write(m);
+    yyjson_mut_doc_set_root(doc, root);
+    auto size = static_cast<size_t>(0u);
+    auto json = yyjson_mut_write_opts(doc, YYJSON_WRITE_PRETTY | YYJSON_WRITE_NEWLINE_AT_END, &alc, &size, nullptr);
+    LUISA_ASSERT(json != nullptr, "Failed to write XIR JSON.");
+    auto result = luisa::string{json, size};
+    alc.free(alc.ctx, json);
+    yyjson_mut_doc_free(doc);
+    return result;
+}
+
+}// namespace luisa::compute::xir
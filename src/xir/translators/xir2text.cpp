@@ -607,7 +607,11 @@ private:
         }
         switch (f->derived_function_tag()) {
             case DerivedFunctionTag::KERNEL: _main << "kernel " << _value_ident(f); break;
-            case DerivedFunctionTag::CALLABLE: _main << "callable " << _value_ident(f) << ": " << _type_ident(f->type()); break;
+            case DerivedFunctionTag::CALLABLE: {
+                if (static_cast<const CallableFunction *>(f)->is_noinline()) { _main << "noinline "; }
+                _main << "callable " << _value_ident(f) << ": " << _type_ident(f->type());
+                break;
+            }
             case DerivedFunctionTag::EXTERNAL: _main << "external " << _value_ident(f) << ": " << _type_ident(f->type()); break;
         }
         _main << " (";